@@ -0,0 +1,141 @@
+#include "bench.h"
+
+// Rótulo atual (repetido em cada linha)
+static char report_label[64];
+
+static FILE *open_output(const char *prefix, const char *ext)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s.%s", prefix, ext);
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+    }
+    return f;
+}
+
+// mkdir -p do diretório que contém prefix
+static void make_parent_dirs(const char *prefix)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s", prefix);
+    for (char *p = path + 1; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+}
+
+int bench_report_open(bench_report_t *report, const char *prefix,
+                      const char *label)
+{
+    memset(report, 0, sizeof(*report));
+    snprintf(report_label, sizeof(report_label), "%s", label);
+
+    make_parent_dirs(prefix);
+    report->csv = open_output(prefix, "csv");
+    report->json = open_output(prefix, "json");
+    if (report->csv == NULL || report->json == NULL) {
+        bench_report_close(report);
+        return -1;
+    }
+
+    fputs("[\n", report->json);
+    return 0;
+}
+
+void bench_report_close(bench_report_t *report)
+{
+    if (report->json != NULL) {
+        fputs(report->rows > 0 ? "\n]\n" : "]\n", report->json);
+        fclose(report->json);
+        report->json = NULL;
+    }
+    if (report->csv != NULL) {
+        fclose(report->csv);
+        report->csv = NULL;
+    }
+}
+
+void bench_row_begin(bench_report_t *report)
+{
+    report->nfields = 0;
+    bench_field_str(report, "label", report_label);
+}
+
+static char *next_field(bench_report_t *report, const char *key, int quoted)
+{
+    if (report->nfields == BENCH_MAX_FIELDS) {
+        fprintf(stderr, "bench: campos demais (%s ignorado)\n", key);
+        return NULL;
+    }
+    int i = report->nfields++;
+    report->keys[i] = key;
+    report->quoted[i] = quoted;
+    return report->values[i];
+}
+
+void bench_field_str(bench_report_t *report, const char *key,
+                     const char *value)
+{
+    char *dst = next_field(report, key, 1);
+    if (dst != NULL) {
+        snprintf(dst, sizeof(report->values[0]), "%s", value);
+    }
+}
+
+void bench_field_u64(bench_report_t *report, const char *key, uint64_t value)
+{
+    char *dst = next_field(report, key, 0);
+    if (dst != NULL) {
+        snprintf(dst, sizeof(report->values[0]), "%llu",
+                 (unsigned long long) value);
+    }
+}
+
+void bench_field_f64(bench_report_t *report, const char *key, double value)
+{
+    char *dst = next_field(report, key, 0);
+    if (dst != NULL) {
+        snprintf(dst, sizeof(report->values[0]), "%.6f", value);
+    }
+}
+
+void bench_field_latency(bench_report_t *report,
+                         const latency_snapshot_t *snap)
+{
+    bench_field_u64(report, "lat_count", snap->count);
+    bench_field_u64(report, "p50_ns", latency_percentile(snap, 0.50));
+    bench_field_u64(report, "p99_ns", latency_percentile(snap, 0.99));
+    bench_field_u64(report, "p999_ns", latency_percentile(snap, 0.999));
+    bench_field_u64(report, "max_ns", snap->max);
+}
+
+void bench_row_end(bench_report_t *report)
+{
+    if (report->rows == 0) {
+        for (int i = 0; i < report->nfields; i++) {
+            fprintf(report->csv, "%s%s", i ? "," : "", report->keys[i]);
+        }
+        fputc('\n', report->csv);
+    }
+
+    for (int i = 0; i < report->nfields; i++) {
+        fprintf(report->csv, "%s%s", i ? "," : "", report->values[i]);
+    }
+    fputc('\n', report->csv);
+
+    fputs(report->rows > 0 ? ",\n  {" : "  {", report->json);
+    for (int i = 0; i < report->nfields; i++) {
+        const char *q = report->quoted[i] ? "\"" : "";
+        fprintf(report->json, "%s\"%s\": %s%s%s", i ? ", " : "",
+                report->keys[i], q, report->values[i], q);
+    }
+    fputc('}', report->json);
+
+    fflush(report->csv);
+    fflush(report->json);
+    report->rows++;
+}
@@ -0,0 +1,44 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "common.h"
+#include "latency.h"
+
+// Utilitários comuns dos benchmarks (make bench).
+//
+// Cada benchmark grava seus resultados em <prefixo>.csv e <prefixo>.json,
+// uma linha/objeto por configuração medida, para comparar execuções entre
+// commits. As colunas são definidas pela primeira linha gravada.
+
+#define BENCH_MAX_FIELDS 24
+
+typedef struct {
+    FILE *csv;
+    FILE *json;
+    int rows;
+
+    // Linha em construção
+    int nfields;
+    const char *keys[BENCH_MAX_FIELDS];
+    char values[BENCH_MAX_FIELDS][64];
+    int quoted[BENCH_MAX_FIELDS];
+} bench_report_t;
+
+// Abre <prefix>.csv e <prefix>.json (criando o diretório, se preciso).
+// label identifica a execução (ex.: hash do commit) e vai em toda linha.
+int bench_report_open(bench_report_t *report, const char *prefix,
+                      const char *label);
+void bench_report_close(bench_report_t *report);
+
+void bench_row_begin(bench_report_t *report);
+void bench_field_str(bench_report_t *report, const char *key,
+                     const char *value);
+void bench_field_u64(bench_report_t *report, const char *key, uint64_t value);
+void bench_field_f64(bench_report_t *report, const char *key, double value);
+
+// Acrescenta n e p50/p99/p99.9/máx (ns) de um histograma de latência
+void bench_field_latency(bench_report_t *report,
+                         const latency_snapshot_t *snap);
+void bench_row_end(bench_report_t *report);
+
+#endif // BENCH_H
@@ -0,0 +1,363 @@
+#include "bench.h"
+#include "gorilla.h"
+#include "tsdb.h"
+
+#include <math.h>
+
+// Benchmark do codec de compressão (gorilla.c):
+//
+//   série     blocos do histórico (TSDB_CHUNK_MAX pontos de um sensor):
+//             vazão de codificação/decodificação e bytes por amostra sobre
+//             as leituras que sensor_process produz (sensor_simulate por
+//             tipo, a 1 Hz e 10 Hz com o jitter de agendamento do sampler),
+//             além de um sensor lento (passeio aleatório quantizado) e de
+//             um sensor travado, para delimitar os extremos
+//   quadros   formato do transporte fifo-gorilla: lotes de uma frota no
+//             estilo do sensor_host (todos os sensores no mesmo instante,
+//             IDs em sequência) e amostras avulsas como as do sensor_process
+//
+// A razão de compressão é dada contra as colunas sem compressão (12 B por
+// amostra no histórico) e contra o registro sensor_data_t do FIFO. Toda
+// decodificação é conferida contra a entrada.
+//
+// Resultados em <prefixo>_series.* e <prefixo>_frames.*
+
+#define SERIES_POINTS (TSDB_CHUNK_MAX * 64)
+#define FLEET_SENSORS 200
+#define FLEET_ROUNDS 64
+#define FRAME_SAMPLES 101 // Como o transporte: cabe em PIPE_BUF no pior caso
+#define FRAME_HEADER_BYTES 8
+#define JITTER_NS 50000 // ± atraso de despertar do sampler
+
+typedef enum { STREAM_SIMULATED, STREAM_SLOW, STREAM_STUCK } stream_kind_t;
+
+typedef struct {
+    const char *name;
+    stream_kind_t kind;
+    sensor_type_t type;
+    double rate_hz;
+} stream_t;
+
+static uint32_t next_rng(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static int64_t jitter(uint32_t *rng)
+{
+    return (int64_t) (next_rng(rng) % (2 * JITTER_NS + 1)) - JITTER_NS;
+}
+
+static void generate_series(const stream_t *stream, int64_t *ts, float *values,
+                            uint32_t n)
+{
+    uint32_t rng = 2024;
+    int64_t period = (int64_t) (1e9 / stream->rate_hz);
+    int64_t t0 = (int64_t) 1760000000 * 1000000000LL;
+    float base = sensor_base_value(stream->type);
+    float level = base;
+    for (uint32_t i = 0; i < n; i++) {
+        ts[i] = t0 + (int64_t) i * period + jitter(&rng);
+        switch (stream->kind) {
+        case STREAM_SIMULATED:
+            values[i] = sensor_simulate(base, &rng);
+            break;
+        case STREAM_SLOW:
+            // Passos de ±0.01 em 1 de cada 8 leituras, resolução 0.01
+            if (next_rng(&rng) % 8 == 0) {
+                level += next_rng(&rng) % 2 ? 0.01f : -0.01f;
+            }
+            values[i] = (float) ((double) lroundf(level * 100.0f) / 100.0);
+            break;
+        case STREAM_STUCK:
+            values[i] = base;
+            break;
+        }
+    }
+}
+
+static void check_series(const int64_t *ts, const float *values,
+                         const int64_t *ts_out, const float *values_out,
+                         uint32_t n, const char *name)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (ts[i] != ts_out[i] ||
+            memcmp(&values[i], &values_out[i], sizeof(float)) != 0) {
+            fprintf(stderr, "%s: decodificação diverge no ponto %u\n", name,
+                    i);
+            exit(1);
+        }
+    }
+}
+
+static void run_series(bench_report_t *report, const stream_t *stream,
+                       uint64_t total)
+{
+    static int64_t ts[SERIES_POINTS];
+    static float values[SERIES_POINTS];
+    static int64_t ts_out[TSDB_CHUNK_MAX];
+    static float values_out[TSDB_CHUNK_MAX];
+    static uint8_t encoded[SERIES_POINTS / TSDB_CHUNK_MAX]
+                          [GORILLA_MAX_BYTES(TSDB_CHUNK_MAX,
+                                             GORILLA_SERIES_MAX_BITS)];
+    size_t sizes[SERIES_POINTS / TSDB_CHUNK_MAX];
+    uint32_t nchunks = SERIES_POINTS / TSDB_CHUNK_MAX;
+
+    generate_series(stream, ts, values, SERIES_POINTS);
+
+    // Tamanho e conferência numa passada; depois só o tempo
+    uint64_t bytes = 0;
+    for (uint32_t c = 0; c < nchunks; c++) {
+        sizes[c] = gorilla_encode_series(
+            ts + c * TSDB_CHUNK_MAX, values + c * TSDB_CHUNK_MAX,
+            TSDB_CHUNK_MAX, encoded[c], sizeof(encoded[c]));
+        if (sizes[c] == 0 ||
+            gorilla_decode_series(encoded[c], sizes[c], TSDB_CHUNK_MAX, ts_out,
+                                  values_out) == -1) {
+            fprintf(stderr, "%s: bloco %u não codificou\n", stream->name, c);
+            exit(1);
+        }
+        check_series(ts + c * TSDB_CHUNK_MAX, values + c * TSDB_CHUNK_MAX,
+                     ts_out, values_out, TSDB_CHUNK_MAX, stream->name);
+        bytes += sizes[c];
+    }
+
+    uint64_t encoded_samples = 0;
+    uint64_t start = monotonic_ns();
+    while (encoded_samples < total) {
+        for (uint32_t c = 0; c < nchunks; c++) {
+            gorilla_encode_series(ts + c * TSDB_CHUNK_MAX,
+                                  values + c * TSDB_CHUNK_MAX, TSDB_CHUNK_MAX,
+                                  encoded[c], sizeof(encoded[c]));
+        }
+        encoded_samples += SERIES_POINTS;
+    }
+    double encode_s = (double) (monotonic_ns() - start) / 1e9;
+
+    uint64_t decoded_samples = 0;
+    start = monotonic_ns();
+    while (decoded_samples < total) {
+        for (uint32_t c = 0; c < nchunks; c++) {
+            gorilla_decode_series(encoded[c], sizes[c], TSDB_CHUNK_MAX, ts_out,
+                                  values_out);
+        }
+        decoded_samples += SERIES_POINTS;
+    }
+    double decode_s = (double) (monotonic_ns() - start) / 1e9;
+
+    double per_sample = (double) bytes / SERIES_POINTS;
+    double raw = sizeof(int64_t) + sizeof(float);
+    double encode_rate = (double) encoded_samples / encode_s;
+    double decode_rate = (double) decoded_samples / decode_s;
+    printf("%-16s %5.0f %8.2f %8.2f %8.2f %12.0f %12.0f %8.1f %8.1f\n",
+           stream->name, stream->rate_hz, per_sample, raw / per_sample,
+           (double) sizeof(sensor_data_t) / per_sample, encode_rate,
+           decode_rate, encode_rate * raw / 1e6, decode_rate * raw / 1e6);
+
+    bench_row_begin(report);
+    bench_field_str(report, "stream", stream->name);
+    bench_field_f64(report, "rate_hz", stream->rate_hz);
+    bench_field_u64(report, "chunk_samples", TSDB_CHUNK_MAX);
+    bench_field_f64(report, "bytes_per_sample", per_sample);
+    bench_field_f64(report, "ratio_columns", raw / per_sample);
+    bench_field_f64(report, "ratio_record",
+                    (double) sizeof(sensor_data_t) / per_sample);
+    bench_field_f64(report, "encode_samples_per_sec", encode_rate);
+    bench_field_f64(report, "decode_samples_per_sec", decode_rate);
+    bench_field_f64(report, "encode_mb_per_sec", encode_rate * raw / 1e6);
+    bench_field_f64(report, "decode_mb_per_sec", decode_rate * raw / 1e6);
+    bench_row_end(report);
+}
+
+// ---------------------------------------------------------------------------
+// Quadros do transporte
+
+// Frota do sensor_host: cada rodada lê todos os sensores no mesmo tique
+static void generate_fleet(sensor_data_t *samples, double rate_hz)
+{
+    uint32_t rng = 99;
+    uint64_t period = (uint64_t) (1e9 / rate_hz);
+    uint64_t t0 = 5000000000ULL;
+    for (uint32_t r = 0; r < FLEET_ROUNDS; r++) {
+        uint64_t tick = t0 + r * period + (uint64_t) (jitter(&rng) + JITTER_NS);
+        for (uint32_t s = 0; s < FLEET_SENSORS; s++) {
+            sensor_type_t type = (sensor_type_t) (s % SENSOR_TYPE_COUNT);
+            samples[r * FLEET_SENSORS + s] = (sensor_data_t){
+                .sensor_id = (int) s + 1,
+                .type = type,
+                .value = sensor_simulate(sensor_base_value(type), &rng),
+                .timestamp = (time_t) (1760000000 + tick / 1000000000ULL),
+                .active = 1,
+                .t_created = tick + s * 200, // Leitura sequencial da frota
+            };
+        }
+    }
+}
+
+static void check_samples(const sensor_data_t *in, const sensor_data_t *out,
+                          uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (in[i].sensor_id != out[i].sensor_id || in[i].type != out[i].type ||
+            in[i].timestamp != out[i].timestamp ||
+            in[i].active != out[i].active ||
+            in[i].t_created != out[i].t_created ||
+            memcmp(&in[i].value, &out[i].value, sizeof(float)) != 0) {
+            fprintf(stderr, "Quadro: decodificação diverge na amostra %u\n",
+                    i);
+            exit(1);
+        }
+    }
+}
+
+static void run_frames(bench_report_t *report, const char *name,
+                       double rate_hz, uint32_t per_frame, uint64_t total)
+{
+    enum { NSAMPLES = FLEET_SENSORS * FLEET_ROUNDS };
+    static sensor_data_t samples[NSAMPLES];
+    static sensor_data_t decoded[FRAME_SAMPLES];
+    static uint8_t frame[GORILLA_MAX_BYTES(FRAME_SAMPLES,
+                                           GORILLA_SAMPLE_MAX_BITS)];
+    generate_fleet(samples, rate_hz);
+
+    uint64_t bytes = 0;
+    uint32_t frames = 0;
+    for (uint32_t i = 0; i < NSAMPLES; i += per_frame) {
+        uint32_t n = NSAMPLES - i < per_frame ? NSAMPLES - i : per_frame;
+        size_t size =
+            gorilla_encode_samples(samples + i, n, frame, sizeof(frame));
+        if (size == 0 ||
+            gorilla_decode_samples(frame, size, n, decoded) == -1) {
+            fprintf(stderr, "%s: quadro %u não codificou\n", name, frames);
+            exit(1);
+        }
+        check_samples(samples + i, decoded, n);
+        bytes += FRAME_HEADER_BYTES + size;
+        frames++;
+    }
+
+    uint64_t encoded_samples = 0;
+    uint64_t decoded_samples = 0;
+    uint64_t encode_ns = 0;
+    uint64_t decode_ns = 0;
+    while (encoded_samples < total) {
+        for (uint32_t i = 0; i < NSAMPLES; i += per_frame) {
+            uint32_t n = NSAMPLES - i < per_frame ? NSAMPLES - i : per_frame;
+            uint64_t t0 = monotonic_ns();
+            size_t size =
+                gorilla_encode_samples(samples + i, n, frame, sizeof(frame));
+            uint64_t t1 = monotonic_ns();
+            gorilla_decode_samples(frame, size, n, decoded);
+            decode_ns += monotonic_ns() - t1;
+            encode_ns += t1 - t0;
+            encoded_samples += n;
+            decoded_samples += n;
+        }
+    }
+
+    double per_sample = (double) bytes / NSAMPLES;
+    double raw = sizeof(sensor_data_t);
+    double encode_rate = (double) encoded_samples / ((double) encode_ns / 1e9);
+    double decode_rate = (double) decoded_samples / ((double) decode_ns / 1e9);
+    printf("%-16s %5.0f %6u %8.2f %8.2f %12.0f %12.0f %8.1f %8.1f\n", name,
+           rate_hz, per_frame, per_sample, raw / per_sample, encode_rate,
+           decode_rate, encode_rate * raw / 1e6, decode_rate * raw / 1e6);
+
+    bench_row_begin(report);
+    bench_field_str(report, "stream", name);
+    bench_field_f64(report, "rate_hz", rate_hz);
+    bench_field_u64(report, "sensors", FLEET_SENSORS);
+    bench_field_u64(report, "samples_per_frame", per_frame);
+    bench_field_f64(report, "bytes_per_sample", per_sample);
+    bench_field_f64(report, "ratio_record", raw / per_sample);
+    bench_field_f64(report, "encode_samples_per_sec", encode_rate);
+    bench_field_f64(report, "decode_samples_per_sec", decode_rate);
+    bench_field_f64(report, "encode_mb_per_sec", encode_rate * raw / 1e6);
+    bench_field_f64(report, "decode_mb_per_sec", decode_rate * raw / 1e6);
+    bench_row_end(report);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Uso: %s [-n amostras] [-o prefixo] [-l rótulo]\n",
+            prog);
+    fprintf(stderr, "\n  -n  amostras codificadas por configuração "
+                    "(padrão: 2000000)\n");
+    fprintf(stderr, "  -o  grava <prefixo>_series.* e <prefixo>_frames.* "
+                    "(padrão: bench_results/codec)\n");
+    fprintf(stderr, "  -l  rótulo da execução, ex. hash do commit "
+                    "(padrão: local)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t samples = 2000000;
+    const char *prefix = "bench_results/codec";
+    const char *label = "local";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:o:l:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            samples = strtoull(optarg, NULL, 10);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (samples == 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    char path[512];
+    bench_report_t report;
+
+    snprintf(path, sizeof(path), "%s_series", prefix);
+    if (bench_report_open(&report, path, label) == -1) {
+        exit(1);
+    }
+    static const stream_t streams[] = {
+        {"temperatura", STREAM_SIMULATED, SENSOR_TEMPERATURE, 1},
+        {"temperatura", STREAM_SIMULATED, SENSOR_TEMPERATURE, 10},
+        {"umidade", STREAM_SIMULATED, SENSOR_HUMIDITY, 1},
+        {"pressao", STREAM_SIMULATED, SENSOR_PRESSURE, 1},
+        {"pressao", STREAM_SIMULATED, SENSOR_PRESSURE, 10},
+        {"lento", STREAM_SLOW, SENSOR_TEMPERATURE, 1},
+        {"travado", STREAM_STUCK, SENSOR_PRESSURE, 1},
+    };
+    printf("%-16s %5s %8s %8s %8s %12s %12s %8s %8s\n", "série", "Hz", "B/am",
+           "x col", "x reg", "cod am/s", "dec am/s", "cod MB/s", "dec MB/s");
+    for (size_t s = 0; s < sizeof(streams) / sizeof(streams[0]); s++) {
+        run_series(&report, &streams[s], samples);
+    }
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n\n", path, path);
+
+    snprintf(path, sizeof(path), "%s_frames", prefix);
+    if (bench_report_open(&report, path, label) == -1) {
+        exit(1);
+    }
+    printf("%-16s %5s %6s %8s %8s %12s %12s %8s %8s\n", "quadros", "Hz",
+           "am/qd", "B/am", "x reg", "cod am/s", "dec am/s", "cod MB/s",
+           "dec MB/s");
+    run_frames(&report, "sensor_host", 1, FRAME_SAMPLES, samples);
+    run_frames(&report, "sensor_host", 10, FRAME_SAMPLES, samples);
+    run_frames(&report, "sensor_host", 10, 16, samples);
+    run_frames(&report, "sensor_process", 1, 1, samples);
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n", path, path);
+    return 0;
+}
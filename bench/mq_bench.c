@@ -0,0 +1,253 @@
+#include "bench.h"
+#include "telemetry.h"
+
+// Benchmark do custo por amostra do canal da fila POSIX no sensor:
+//
+//   sem_fila  só a geração da amostra e a medição (referência)
+//   texto     o canal antigo: snprintf "SENSOR-%d:%.2f" + mq_send por
+//             amostra, fila de 10 mensagens de MAX_MESSAGE_SIZE
+//   resumo    o canal atual (telemetry.h): janela acumulada por amostra e
+//             um resumo binário por sensor a cada intervalo
+//
+// Um produtor simula os sensores intercalados, com o relógio da amostra
+// avançando à taxa pedida (como t_created no sensor_process), então os
+// resumos saem na proporção real de um por sensor e intervalo. Para medir só
+// o lado do sensor, a fila é esvaziada fora da cronometragem sempre que
+// enche (um consumidor que acompanha; no sistema a fila antiga de 10
+// mensagens enchia e as leituras eram descartadas com EAGAIN). Cada amostra
+// é cronometrada (percentis) e o custo médio inclui as duas leituras de
+// relógio, presentes também na referência.
+
+#define BENCH_MQ_NAME "/sensor_mq_bench"
+#define TEXT_MQ_DEPTH 10 // Fila antiga (mq_maxmsg = 10)
+
+typedef enum { M_NONE = 0, M_TEXT, M_SUMMARY, M_COUNT } bench_mode_t;
+
+static const char *const mode_names[M_COUNT] = {"sem_fila", "texto",
+                                                "resumo"};
+
+typedef struct {
+    bench_mode_t mode;
+    uint32_t sensors;
+    double rate_hz;       // Por sensor (tempo simulado)
+    uint32_t interval_ms; // Resumo
+    uint64_t samples;
+
+    mqd_t mq;
+    size_t msgsize;
+    long depth;
+    long queued;
+    uint64_t received;
+} mq_run_t;
+
+// Esvazia a fila (fora da cronometragem)
+static void drain_queue(mq_run_t *run)
+{
+    char buf[MAX_MESSAGE_SIZE];
+    while (mq_receive(run->mq, buf, run->msgsize, NULL) >= 0) {
+        run->received++;
+    }
+    run->queued = 0;
+}
+
+static int open_queue(mq_run_t *run)
+{
+    run->msgsize = run->mode == M_TEXT ? MAX_MESSAGE_SIZE
+                                       : sizeof(telemetry_msg_t);
+    long depth = run->mode == M_TEXT ? TEXT_MQ_DEPTH : TELEMETRY_MQ_DEPTH;
+    mq_unlink(BENCH_MQ_NAME);
+    struct mq_attr attr = {
+        .mq_flags = 0, .mq_maxmsg = depth, .mq_msgsize = (long) run->msgsize};
+    run->mq = mq_open(BENCH_MQ_NAME, O_CREAT | O_EXCL | O_RDWR | O_NONBLOCK,
+                      0600, &attr);
+    if (run->mq == (mqd_t) -1 && errno == EINVAL) {
+        attr.mq_maxmsg = TELEMETRY_MQ_DEPTH_MIN;
+        run->mq = mq_open(BENCH_MQ_NAME,
+                          O_CREAT | O_EXCL | O_RDWR | O_NONBLOCK, 0600, &attr);
+    }
+    if (run->mq == (mqd_t) -1) {
+        perror("mq_open");
+        return -1;
+    }
+    run->depth = attr.mq_maxmsg;
+    return 0;
+}
+
+static void run_mode(bench_report_t *report, mq_run_t *run)
+{
+    if (run->mode != M_NONE && open_queue(run) == -1) {
+        exit(1);
+    }
+    run->queued = 0;
+    run->received = 0;
+
+    telemetry_window_t *windows =
+        calloc(run->sensors, sizeof(telemetry_window_t));
+    latency_hist_t *hist = calloc(1, sizeof(latency_hist_t));
+    if (windows == NULL || hist == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    for (uint32_t s = 0; s < run->sensors; s++) {
+        telemetry_window_init(&windows[s], (int) s + 1, SENSOR_TEMPERATURE,
+                              run->interval_ms, 0);
+    }
+
+    uint64_t period_ns = (uint64_t) (1e9 / run->rate_hz);
+    uint32_t rng = 12345;
+    uint64_t sent = 0, eagain = 0, bytes = 0;
+    uint64_t elapsed = 0;
+    for (uint64_t i = 0; i < run->samples; i++) {
+        uint32_t s = (uint32_t) (i % run->sensors);
+        uint64_t t_sample = (i / run->sensors) * period_ns;
+        float value = sensor_simulate(25.0f, &rng);
+
+        uint64_t t0 = monotonic_ns();
+        if (run->mode == M_TEXT) {
+            char msg[MAX_MESSAGE_SIZE];
+            snprintf(msg, sizeof(msg), "SENSOR-%u:%.2f", s + 1, value);
+            size_t len = strlen(msg) + 1;
+            if (mq_send(run->mq, msg, len, 0) == 0) {
+                sent++;
+                bytes += len;
+                run->queued++;
+            } else {
+                eagain++;
+            }
+        } else if (run->mode == M_SUMMARY &&
+                   telemetry_window_add(&windows[s], value, t_sample)) {
+            if (telemetry_window_flush(&windows[s], run->mq, t_sample) == 0) {
+                sent++;
+                bytes += sizeof(telemetry_msg_t);
+                run->queued++;
+            } else {
+                eagain++;
+            }
+        }
+        uint64_t t1 = monotonic_ns();
+        latency_hist_record(hist, t1 - t0);
+        elapsed += t1 - t0;
+
+        if (run->queued == run->depth) {
+            drain_queue(run);
+        }
+    }
+
+    if (run->mode != M_NONE) {
+        drain_queue(run);
+        mq_close(run->mq);
+        mq_unlink(BENCH_MQ_NAME);
+    }
+
+    static latency_snapshot_t snap;
+    memset(&snap, 0, sizeof(snap));
+    latency_hist_add(&snap, hist);
+    double ns_per_sample = (double) elapsed / (double) run->samples;
+    double simulated_s = (double) (run->samples / run->sensors) *
+                         (double) period_ns / 1e9;
+
+    printf("%-9s %7u %7.0f %6u %9.1f %8.0f %8.0f %10llu %10llu %10llu %8.2f\n",
+           mode_names[run->mode], run->sensors, run->rate_hz,
+           run->mode == M_SUMMARY ? run->interval_ms : 0, ns_per_sample,
+           (double) latency_percentile(&snap, 0.99),
+           (double) latency_percentile(&snap, 0.999),
+           (unsigned long long) sent, (unsigned long long) eagain,
+           (unsigned long long) run->received,
+           (double) bytes / (double) run->samples);
+
+    bench_row_begin(report);
+    bench_field_str(report, "mode", mode_names[run->mode]);
+    bench_field_u64(report, "sensors", run->sensors);
+    bench_field_f64(report, "rate_hz", run->rate_hz);
+    bench_field_u64(report, "interval_ms",
+                    run->mode == M_SUMMARY ? run->interval_ms : 0);
+    bench_field_u64(report, "samples", run->samples);
+    bench_field_f64(report, "simulated_s", simulated_s);
+    bench_field_f64(report, "ns_per_sample", ns_per_sample);
+    bench_field_u64(report, "messages_sent", sent);
+    bench_field_u64(report, "eagain", eagain);
+    bench_field_u64(report, "messages_received",
+                    run->received);
+    bench_field_f64(report, "mq_bytes_per_sample",
+                    (double) bytes / (double) run->samples);
+    bench_field_latency(report, &snap);
+    bench_row_end(report);
+
+    free(windows);
+    free(hist);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Uso: %s [-n amostras] [-o prefixo] [-l rótulo]\n",
+            prog);
+    fprintf(stderr, "\n  -n  amostras por configuração (padrão: 500000)\n");
+    fprintf(stderr, "  -o  prefixo dos resultados (padrão: "
+                    "bench_results/mq)\n");
+    fprintf(stderr, "  -l  rótulo da execução, ex. hash do commit "
+                    "(padrão: local)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t samples = 500000;
+    const char *prefix = "bench_results/mq";
+    const char *label = "local";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:o:l:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            samples = strtoull(optarg, NULL, 10);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (samples == 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    bench_report_t report;
+    if (bench_report_open(&report, prefix, label) == -1) {
+        exit(1);
+    }
+
+    // Sensores × taxa por sensor; o resumo em 100 ms e no padrão (1 s)
+    static const struct {
+        uint32_t sensors;
+        double rate_hz;
+    } fleets[] = {{5, 10.0}, {5, 1000.0}, {64, 100.0}};
+    static const uint32_t intervals[] = {100, TELEMETRY_INTERVAL_MS};
+
+    printf("%-9s %7s %7s %6s %9s %8s %8s %10s %10s %10s %8s\n", "modo",
+           "sensores", "Hz", "ms", "ns/am", "p99", "p99.9", "enviadas",
+           "EAGAIN", "recebidas", "B/am");
+    for (size_t f = 0; f < sizeof(fleets) / sizeof(fleets[0]); f++) {
+        mq_run_t run = {.sensors = fleets[f].sensors,
+                        .rate_hz = fleets[f].rate_hz,
+                        .samples = samples};
+        run.mode = M_NONE;
+        run_mode(&report, &run);
+        run.mode = M_TEXT;
+        run_mode(&report, &run);
+        run.mode = M_SUMMARY;
+        for (size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]);
+             i++) {
+            run.interval_ms = intervals[i];
+            run_mode(&report, &run);
+        }
+    }
+
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n", prefix, prefix);
+    return 0;
+}
@@ -0,0 +1,435 @@
+#include "bench.h"
+#include "net.h"
+#include "transport.h"
+
+#include <poll.h>
+
+// Vazão e perda da ingestão pela rede (net.h) em 127.0.0.1 contra o FIFO
+// local, com os mesmos escritores (sample_writer_*) e o mesmo caminho de
+// recepção do data_processor:
+//
+//   fifo          registros sensor_data_t no FIFO_SENSOR_DATA
+//   fifo-gorilla  quadros compactados no mesmo FIFO
+//   udp           datagramas (recvmmsg, epoll)
+//   tcp           quadros num fluxo por escritor (epoll)
+//
+// Os escritores são processos que enviam lotes de uma frota simulada (-b
+// amostras por envio), sem limite de taxa ou a -r amostras/s cada; cada
+// amostra leva em timestamp a sequência do seu sensor. O receptor, no
+// processo principal, confere por sensor lacunas e sequências fora de
+// ordem, e mede a latência envio → recebimento (t_created, mesmo relógio).
+// Perdidas = entregues ao transporte - recebidas; no UDP sem limite de taxa
+// o receptor mais lento que os escritores perde datagramas, e as lacunas
+// de sequência dos quadros (quadros_perd) mostram a perda do lado dele.
+//
+// Usa o FIFO de produção: não execute com o sensor_system ativo.
+
+#define BENCH_SENSORS_PER_WRITER 64
+#define BENCH_MAX_WRITERS 16
+#define BENCH_MAX_SENSORS (BENCH_SENSORS_PER_WRITER * BENCH_MAX_WRITERS)
+#define BENCH_MAX_BATCH 4096
+#define BENCH_PORT 7790
+#define IDLE_TIMEOUT_MS 300 // Sem dados após os escritores saírem: fim
+#define FIFO_STAGING (64 * 1024)
+
+typedef struct {
+    transport_mode_t mode;
+    const char *name;
+} bench_mode_t;
+
+static const bench_mode_t modes[] = {
+    {TRANSPORT_FIFO, "fifo"},
+    {TRANSPORT_FIFO_GORILLA, "fifo-gorilla"},
+    {TRANSPORT_UDP, "udp"},
+    {TRANSPORT_TCP, "tcp"},
+};
+
+// Contadores dos escritores (memória comum)
+typedef struct {
+    _Atomic uint64_t sent;    // Entregues ao transporte
+    _Atomic uint64_t dropped; // Recusadas no envio (rede sem espaço)
+    _Atomic int failed;
+} shared_t;
+
+static shared_t *shared;
+
+// Estado do receptor
+typedef struct {
+    uint64_t last_seq[BENCH_MAX_SENSORS];
+    uint64_t received;
+    uint64_t gaps;      // Amostras que faltaram numa sequência
+    uint64_t reordered; // Sequência repetida ou voltando
+    uint64_t bytes;
+    uint64_t last_ns; // Última amostra recebida
+    latency_hist_t hist;
+} receiver_t;
+
+static void writer_main(transport_mode_t mode, int index, uint64_t count,
+                        uint32_t batch, uint32_t rate)
+{
+    sample_writer_t writer;
+    if (sample_writer_open(&writer, mode, "NET_BENCH") == -1) {
+        atomic_store(&shared->failed, 1);
+        exit(1);
+    }
+
+    static sensor_data_t items[BENCH_MAX_BATCH];
+    uint64_t seq[BENCH_SENSORS_PER_WRITER] = {0};
+    uint64_t deadline = monotonic_ns();
+    uint64_t done = 0;
+    uint64_t sent = 0;
+    int s = 0;
+    while (done < count) {
+        uint32_t n = count - done < batch ? (uint32_t) (count - done) : batch;
+        uint64_t now = monotonic_ns();
+        for (uint32_t i = 0; i < n; i++) {
+            items[i] = (sensor_data_t){
+                .type = (sensor_type_t) (s % SENSOR_TYPE_COUNT),
+                .sensor_id = index * BENCH_SENSORS_PER_WRITER + s,
+                .value = 20.0f + (float) (seq[s] % 50) * 0.1f,
+                .timestamp = (time_t) ++seq[s],
+                .active = 1,
+                .t_created = now,
+            };
+            s = (s + 1) % BENCH_SENSORS_PER_WRITER;
+        }
+        uint32_t published;
+        int handled = sample_writer_send_batch(&writer, items, n, &published);
+        if (handled == -1) {
+            perror("Erro ao enviar");
+            atomic_store(&shared->failed, 1);
+            break;
+        }
+        sent += published;
+        done += n;
+
+        if (rate > 0) {
+            deadline += (uint64_t) n * 1000000000ull / rate;
+            struct timespec ts = {
+                .tv_sec = (time_t) (deadline / 1000000000ull),
+                .tv_nsec = (long) (deadline % 1000000000ull)};
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+    }
+
+    atomic_fetch_add(&shared->sent, sent);
+    atomic_fetch_add(&shared->dropped,
+                     writer.overload.drops[OVERLOAD_DROPPED_NEWEST]);
+    sample_writer_close(&writer);
+    exit(0);
+}
+
+static void check_samples(receiver_t *rx, const sensor_data_t *items,
+                          uint32_t n)
+{
+    uint64_t now = monotonic_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        const sensor_data_t *d = &items[i];
+        if (d->sensor_id < 0 || d->sensor_id >= BENCH_MAX_SENSORS) {
+            continue;
+        }
+        uint64_t seq = (uint64_t) d->timestamp;
+        uint64_t *last = &rx->last_seq[d->sensor_id];
+        if (seq <= *last) {
+            rx->reordered++;
+        } else {
+            rx->gaps += seq - *last - 1;
+            *last = seq;
+        }
+        latency_hist_record(&rx->hist, now > d->t_created
+                                           ? now - d->t_created
+                                           : 0);
+    }
+    rx->received += n;
+    rx->last_ns = now;
+}
+
+// FIFO: o mesmo laço de leitura da produtora do data_processor
+static int receive_fifo(receiver_t *rx, int fd, char *staging, size_t *fill,
+                        sensor_data_t *out, int timeout_ms)
+{
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return 0;
+    }
+    ssize_t r = read(fd, staging + *fill, FIFO_STAGING - *fill);
+    if (r <= 0) {
+        return 0;
+    }
+    *fill += (size_t) r;
+    rx->bytes += (uint64_t) r;
+
+    int got = 0;
+    for (;;) {
+        uint32_t records;
+        size_t consumed;
+        int more = sample_stream_parse(staging, *fill, out, NET_POLL_SAMPLES,
+                                       &records, &consumed);
+        if (more == -1) {
+            fprintf(stderr, "Quadro inválido no FIFO\n");
+            *fill = 0;
+            return -1;
+        }
+        check_samples(rx, out, records);
+        got += (int) records;
+        memmove(staging, staging + consumed, *fill - consumed);
+        *fill -= consumed;
+        if (!more) {
+            return got;
+        }
+    }
+}
+
+static int run(bench_report_t *report, const bench_mode_t *mode, int nwriters,
+               uint64_t count, uint32_t batch, uint32_t rate, const char *addr)
+{
+    memset(shared, 0, sizeof(*shared));
+    receiver_t *rx = calloc(1, sizeof(*rx));
+    sensor_data_t *out = malloc(NET_POLL_SAMPLES * sizeof(sensor_data_t));
+    char *staging = malloc(FIFO_STAGING);
+    if (rx == NULL || out == NULL || staging == NULL) {
+        perror("Erro ao alocar receptor");
+        exit(1);
+    }
+
+    int net = mode->mode == TRANSPORT_UDP || mode->mode == TRANSPORT_TCP;
+    int fifo_fd = -1;
+    net_receiver_t *net_rx = NULL;
+    if (net) {
+        net_rx = net_receiver_open(addr);
+        if (net_rx == NULL) {
+            perror("Erro ao escutar na rede");
+            exit(1);
+        }
+    } else {
+        // Com o leitor aberto, os escritores conectam sem ponto de encontro
+        if (mkfifo(FIFO_SENSOR_DATA, 0666) == -1 && errno != EEXIST) {
+            perror("Erro ao criar FIFO");
+            exit(1);
+        }
+        fifo_fd = open(FIFO_SENSOR_DATA, O_RDWR);
+        if (fifo_fd == -1) {
+            perror("Erro ao abrir FIFO");
+            exit(1);
+        }
+    }
+
+    uint64_t start = monotonic_ns();
+    pid_t writers[BENCH_MAX_WRITERS];
+    fflush(stdout);
+    for (int w = 0; w < nwriters; w++) {
+        writers[w] = fork();
+        if (writers[w] == 0) {
+            writer_main(mode->mode, w, count, batch, rate);
+        }
+    }
+
+    int running = nwriters;
+    uint64_t idle_since = 0;
+    size_t fill = 0;
+    while (running > 0 || idle_since == 0 ||
+           monotonic_ns() - idle_since < IDLE_TIMEOUT_MS * 1000000ull) {
+        int got;
+        if (net) {
+            got = net_receiver_poll(net_rx, out, NET_POLL_SAMPLES, 10);
+            if (got > 0) {
+                check_samples(rx, out, (uint32_t) got);
+            }
+        } else {
+            got = receive_fifo(rx, fifo_fd, staging, &fill, out, 10);
+        }
+        while (running > 0 && waitpid(-1, NULL, WNOHANG) > 0) {
+            running--;
+        }
+        if (got > 0 || running > 0) {
+            idle_since = 0;
+        } else if (idle_since == 0) {
+            idle_since = monotonic_ns();
+        }
+        if (running == 0 &&
+            rx->received >= atomic_load(&shared->sent)) {
+            break; // Tudo chegou
+        }
+    }
+
+    net_stats_t stats = {0};
+    if (net) {
+        net_receiver_stats(net_rx, &stats);
+        rx->bytes = stats.bytes;
+        net_receiver_close(net_rx);
+    } else {
+        close(fifo_fd);
+    }
+
+    uint64_t sent = atomic_load(&shared->sent);
+    uint64_t dropped = atomic_load(&shared->dropped);
+    uint64_t lost = sent > rx->received ? sent - rx->received : 0;
+    double elapsed = (double) ((rx->last_ns > start ? rx->last_ns : start) -
+                               start) /
+                     1e9;
+    double rate_rx = elapsed > 0 ? (double) rx->received / elapsed : 0.0;
+    double loss_pct =
+        sent + dropped > 0
+            ? 100.0 * (double) (lost + dropped) / (double) (sent + dropped)
+            : 0.0;
+    double bytes_per_sample =
+        rx->received > 0 ? (double) rx->bytes / (double) rx->received : 0.0;
+
+    latency_snapshot_t snap;
+    memset(&snap, 0, sizeof(snap));
+    latency_hist_add(&snap, &rx->hist);
+    int ok = !atomic_load(&shared->failed) && rx->received > 0;
+
+    printf("%-12s %4d %6u %9u %9llu %9llu %7llu %7llu %6.2f %6llu %11.0f "
+           "%6.1f %9.1f %9.1f%s\n",
+           mode->name, nwriters, batch, rate,
+           (unsigned long long) sent, (unsigned long long) rx->received,
+           (unsigned long long) dropped, (unsigned long long) lost, loss_pct,
+           (unsigned long long) stats.lost, rate_rx, bytes_per_sample,
+           (double) latency_percentile(&snap, 0.50) / 1000.0,
+           (double) latency_percentile(&snap, 0.99) / 1000.0,
+           ok ? "" : " FALHA");
+
+    bench_row_begin(report);
+    bench_field_str(report, "transport", mode->name);
+    bench_field_u64(report, "writers", (uint64_t) nwriters);
+    bench_field_u64(report, "batch", batch);
+    bench_field_u64(report, "rate_per_writer", rate);
+    bench_field_u64(report, "sent", sent);
+    bench_field_u64(report, "received", rx->received);
+    bench_field_u64(report, "send_dropped", dropped);
+    bench_field_u64(report, "lost", lost);
+    bench_field_f64(report, "loss_pct", loss_pct);
+    bench_field_u64(report, "frames_lost", stats.lost);
+    bench_field_u64(report, "gaps", rx->gaps);
+    bench_field_u64(report, "reordered", rx->reordered);
+    bench_field_f64(report, "samples_per_s", rate_rx);
+    bench_field_f64(report, "bytes_per_sample", bytes_per_sample);
+    bench_field_latency(report, &snap);
+    bench_row_end(report);
+
+    free(staging);
+    free(out);
+    free(rx);
+    return ok;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s [-w escritores] [-n amostras] [-b lote] [-r taxa] "
+            "[-p porta] [-o prefixo] [-l rótulo]\n",
+            prog);
+    fprintf(stderr, "\n  -w  processos escritores, %d sensores cada; mede 1 e "
+                    "w (padrão: 4, máx. %d)\n",
+            BENCH_SENSORS_PER_WRITER, BENCH_MAX_WRITERS);
+    fprintf(stderr, "  -n  amostras por escritor (padrão: 200000)\n");
+    fprintf(stderr, "  -b  amostras por envio (padrão: 256, máx. %d)\n",
+            BENCH_MAX_BATCH);
+    fprintf(stderr, "  -r  amostras/s por escritor; mede também sem limite "
+                    "(padrão: 100000)\n");
+    fprintf(stderr, "  -p  porta UDP/TCP em 127.0.0.1 (padrão: %d)\n",
+            BENCH_PORT);
+    fprintf(stderr, "  -o  prefixo dos resultados (padrão: "
+                    "bench_results/net)\n");
+    fprintf(stderr, "  -l  rótulo da execução, ex. hash do commit "
+                    "(padrão: local)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int nwriters = 4;
+    uint64_t count = 200000;
+    uint32_t batch = 256;
+    uint32_t rate = 100000;
+    unsigned port = BENCH_PORT;
+    const char *prefix = "bench_results/net";
+    const char *label = "local";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "w:n:b:r:p:o:l:h")) != -1) {
+        switch (opt) {
+        case 'w':
+            nwriters = atoi(optarg);
+            break;
+        case 'n':
+            count = strtoull(optarg, NULL, 10);
+            break;
+        case 'b':
+            batch = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            rate = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            port = (unsigned) strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (nwriters < 1 || nwriters > BENCH_MAX_WRITERS || count == 0 ||
+        batch == 0 || batch > BENCH_MAX_BATCH || port == 0 || port > 65535) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    rendezvous_t *rv = rendezvous_open();
+    if (rv == NULL) {
+        exit(1);
+    }
+    if (atomic_load(&rv->reader_ready)) {
+        fprintf(stderr, "Erro: há um data_processor ativo; encerre o "
+                        "sistema antes (ou make clean-all)\n");
+        exit(1);
+    }
+    rendezvous_close(rv);
+
+    // Escritores herdam o endereço (net_addr_default)
+    char addr[32];
+    snprintf(addr, sizeof(addr), "127.0.0.1:%u", port);
+    setenv(NET_ADDR_ENV, addr, 1);
+
+    shared = mmap(NULL, sizeof(shared_t), PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("Erro ao mapear memória comum");
+        exit(1);
+    }
+
+    bench_report_t report;
+    if (bench_report_open(&report, prefix, label) == -1) {
+        exit(1);
+    }
+
+    printf("%llu amostras por escritor, %d sensores cada, em %s; taxa 0 = "
+           "sem limite; latência em us\n\n",
+           (unsigned long long) count, BENCH_SENSORS_PER_WRITER, addr);
+    printf("%-12s %4s %6s %9s %9s %9s %7s %7s %6s %6s %11s %6s %9s %9s\n",
+           "transporte", "esc", "lote", "taxa/esc", "enviadas", "recebidas",
+           "recus", "perd", "perd%", "q_perd", "amostras/s", "B/am", "p50",
+           "p99");
+    int ok = 1;
+    int writer_counts[2] = {1, nwriters};
+    uint32_t rates[2] = {0, rate};
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (int r = 0; r < (rate > 0 ? 2 : 1); r++) {
+            for (int w = 0; w < (nwriters > 1 ? 2 : 1); w++) {
+                ok &= run(&report, &modes[m], writer_counts[w], count, batch,
+                          rates[r], addr);
+            }
+        }
+    }
+    unlink(FIFO_SENSOR_DATA);
+
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n", prefix, prefix);
+    return ok ? 0 : 1;
+}
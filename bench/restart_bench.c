@@ -0,0 +1,599 @@
+#include "bench.h"
+#include "overload.h"
+#include "ring.h"
+#include "transport.h"
+#include "tsdb.h"
+
+#include <dirent.h>
+#include <limits.h>
+
+// Verificação do reinício do data_processor sem perda (transport.h): o
+// segmento de ingestão real (SHM_NAME e o ponto de encontro) com sensores
+// publicando em sequência enquanto o processador é trocado várias vezes.
+//
+//   entrega  uma nova instância parte com a anterior ativa e assume os rings
+//            (a anterior recebe SIGTERM e entrega)
+//   queda    a instância ativa morre com SIGKILL e outra parte após uma
+//            pausa (o reinício pelo supervisor): os rings enchem e os
+//            escritores passam à fila local
+//   layout   como entrega, alternando o número de shards: o segmento é
+//            recriado e as amostras pendentes, copiadas
+//   historico  como entrega, com o data_processor de verdade (ao lado deste
+//            binário) gravando o histórico num diretório temporário, sem
+//            sincronizar durante a troca e com blocos cheios gravados entre
+//            trocas (o intervalo cresce para isso); a conferência é feita
+//            nos segmentos gravados, que devem estar todos selados (os
+//            tempos de entrega não são medidos)
+//
+// Os escritores são processos com sample_writer_* (BLOCK, fila local
+// padrão); cada amostra leva em timestamp a sequência do seu sensor. O
+// processador é um consumidor mínimo em processo próprio que confere, por
+// sensor, que a sequência chega sem lacunas nem repetições. Ao final:
+// enviadas = recebidas + descartadas contadas, e perdidas é o resto. Na
+// entrega e no layout qualquer perda ou lacuna é uma falha (saída 1); na
+// queda perde-se no máximo o que a instância morta tinha retirado.
+//
+// Usa os nomes de produção: não execute com o sensor_system ativo.
+
+#define BENCH_SENSORS_PER_WRITER 8
+#define BENCH_MAX_WRITERS 16
+#define BENCH_MAX_SENSORS (BENCH_SENSORS_PER_WRITER * BENCH_MAX_WRITERS)
+#define BENCH_MAX_RESTARTS 64
+#define BENCH_RING_CAPACITY 128 // Padrão de ring_capacity (system_config)
+#define DRAIN_TIMEOUT_MS 3000
+
+typedef enum {
+    R_HANDOFF = 0,
+    R_CRASH,
+    R_LAYOUT,
+    R_HISTORY,
+    R_COUNT
+} restart_mode_t;
+
+static const char *const mode_names[R_COUNT] = {"entrega", "queda",
+                                                "layout", "historico"};
+
+// Memória comum a escritores, processadores e ao processo principal
+typedef struct {
+    _Atomic int writers_stop;
+    _Atomic uint64_t sent;
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t backlog_peak;
+
+    // Um processador por vez escreve aqui
+    uint64_t last_seq[BENCH_MAX_SENSORS];
+    _Atomic uint64_t received;
+    _Atomic uint64_t gaps;       // Amostras que faltaram numa sequência
+    _Atomic uint64_t duplicates; // Sequência repetida ou voltando
+
+    // Por troca: espera pela anterior e janela sem leitor
+    _Atomic int takeovers;
+    uint64_t wait_ns[BENCH_MAX_RESTARTS];
+    uint64_t gap_ns[BENCH_MAX_RESTARTS];
+    uint64_t pending;
+    uint64_t lost;
+    _Atomic uint64_t reader_down_ns; // Instante em que o leitor saiu
+} shared_t;
+
+static shared_t *shared;
+static volatile sig_atomic_t processor_running = 1;
+
+// Modo historico: binário do data_processor e diretório do histórico
+static char processor_path[PATH_MAX];
+static char tsdb_dir[TSDB_PATH_LEN];
+
+static void stop_processor(int sig)
+{
+    (void) sig;
+    processor_running = 0;
+}
+
+static void writer_main(int index, uint32_t period_us)
+{
+    sample_writer_t writer;
+    if (sample_writer_open(&writer, TRANSPORT_SHM, "RESTART_BENCH") == -1) {
+        exit(1);
+    }
+
+    uint64_t seq = 0;
+    uint64_t deadline = monotonic_ns();
+    uint64_t peak = 0;
+    while (!atomic_load(&shared->writers_stop)) {
+        seq++;
+        for (int s = 0; s < BENCH_SENSORS_PER_WRITER; s++) {
+            sensor_data_t data = {
+                .type = SENSOR_TEMPERATURE,
+                .sensor_id = index * BENCH_SENSORS_PER_WRITER + s,
+                .value = (float) seq,
+                .timestamp = (time_t) seq,
+                .active = 1,
+                .t_created = monotonic_ns(),
+            };
+            while (sample_writer_send(&writer, &data) == -1 &&
+                   errno == EAGAIN) {
+                // BLOCK com o leitor presente e o ring cheio: de novo
+            }
+            atomic_fetch_add(&shared->sent, 1);
+        }
+        uint64_t backlog = sample_writer_backlog(&writer);
+        peak = backlog > peak ? backlog : peak;
+
+        deadline += (uint64_t) period_us * 1000;
+        struct timespec ts = {.tv_sec = (time_t) (deadline / 1000000000ull),
+                              .tv_nsec = (long) (deadline % 1000000000ull)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+
+    // Esvaziar a fila local antes de sair
+    uint32_t published;
+    while (sample_writer_backlog(&writer) > 0) {
+        sample_writer_send_batch(&writer, NULL, 0, &published);
+    }
+    uint64_t dropped = 0;
+    for (int r = 0; r < OVERLOAD_DROP_COUNT; r++) {
+        dropped += writer.overload.drops[r];
+    }
+    sample_writer_close(&writer);
+    atomic_fetch_add(&shared->dropped, dropped);
+    uint64_t old = atomic_load(&shared->backlog_peak);
+    while (peak > old &&
+           !atomic_compare_exchange_weak(&shared->backlog_peak, &old, peak)) {
+    }
+    exit(0);
+}
+
+static void check_sample(const sensor_data_t *data)
+{
+    uint64_t seq = (uint64_t) data->timestamp;
+    uint64_t *last = &shared->last_seq[data->sensor_id];
+    if (seq <= *last) {
+        atomic_fetch_add(&shared->duplicates, 1);
+        return;
+    }
+    if (seq > *last + 1) {
+        atomic_fetch_add(&shared->gaps, seq - *last - 1);
+    }
+    *last = seq;
+    atomic_fetch_add(&shared->received, 1);
+}
+
+// Consumidor mínimo com a mesma partida e saída do data_processor
+static void processor_main(uint32_t nshards)
+{
+    signal(SIGTERM, stop_processor);
+    uint64_t start = monotonic_ns();
+
+    rendezvous_t *rv = rendezvous_open();
+    rendezvous_set_reader(rv, 0);
+    overload_config_t overload;
+    overload_parse("block", &overload);
+    sample_shm_takeover_t info;
+    sample_shm_t *shm = sample_shm_acquire(
+        ring_round_capacity(BENCH_RING_CAPACITY), nshards, &overload, 0,
+        &info);
+    if (shm == NULL) {
+        perror("Erro ao assumir os rings");
+        exit(1);
+    }
+    rendezvous_set_reader(rv, 1);
+
+    // Janela sem leitor: da saída da anterior (ou da partida, se ela
+    // morreu) até agora
+    uint64_t now = monotonic_ns();
+    uint64_t down = atomic_exchange(&shared->reader_down_ns, 0);
+    int t = atomic_load(&shared->takeovers);
+    if (t < BENCH_MAX_RESTARTS && info.generation > 1) {
+        shared->wait_ns[t] = info.wait_ns;
+        shared->gap_ns[t] = now - (down != 0 && down < now ? down : start);
+        shared->pending += info.pending;
+        shared->lost += info.lost;
+        atomic_store(&shared->takeovers, t + 1);
+    }
+
+    sensor_data_t data;
+    uint32_t rr = 0;
+    while (processor_running) {
+        int got = 0;
+        for (uint32_t s = 0; s < shm->nshards; s++) {
+            while (ring_try_pop(sample_shm_ring(shm, s), &data)) {
+                check_sample(&data);
+                got = 1;
+            }
+        }
+        if (!got &&
+            ring_pop(sample_shm_ring(shm, rr++ % shm->nshards), &data, 5) ==
+                0) {
+            check_sample(&data);
+        }
+    }
+
+    // Saída em ordem: sem leitor, depois a entrega dos rings
+    rendezvous_set_reader(rv, 0);
+    atomic_store(&shared->reader_down_ns, monotonic_ns());
+    sample_shm_release(shm);
+    sample_shm_destroy(shm);
+    rendezvous_close(rv);
+    exit(0);
+}
+
+static pid_t start_processor(uint32_t nshards)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        processor_main(nshards);
+    }
+    return pid;
+}
+
+// data_processor de verdade (modo historico), com o log no diretório do
+// histórico
+static pid_t start_data_processor(uint32_t nshards)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    char shards[16];
+    char spec[TSDB_PATH_LEN + 32];
+    char log[TSDB_PATH_LEN + 32];
+    snprintf(shards, sizeof(shards), "%u", nshards);
+    snprintf(spec, sizeof(spec), "dir=%s,segment=256K,sync=60000",
+             tsdb_dir);
+    snprintf(log, sizeof(log), "%s/data_processor.log", tsdb_dir);
+    int fd = open(log, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd != -1) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+    }
+    execl(processor_path, "data_processor", "-s", shards, "-o", "block",
+          "-P", spec, "-S", "run_s=0", (char *) NULL);
+    perror(processor_path);
+    _exit(127);
+}
+
+// Aguarda o data_processor esvaziar os rings: o que ficar neles na saída
+// é da próxima instância, e aqui não há próxima
+static void wait_rings_empty(uint64_t deadline)
+{
+    while (monotonic_ns() < deadline) {
+        sample_shm_t *shm = (sample_shm_t *) sample_shm_open_readonly();
+        uint32_t depth = 0;
+        for (uint32_t s = 0; shm != NULL && s < shm->nshards; s++) {
+            depth += ring_depth(sample_shm_ring(shm, s));
+        }
+        sample_shm_close(shm);
+        if (shm != NULL && depth == 0) {
+            return;
+        }
+        msleep(5);
+    }
+}
+
+// Confere o histórico gravado pelas instâncias como se fosse o consumidor:
+// cada amostra uma vez e em ordem por sensor. Retorna os segmentos que
+// ficaram sem selar ou ilegíveis.
+static uint64_t check_history(void)
+{
+    char **paths;
+    int n = tsdb_list_segments(tsdb_dir, &paths);
+    if (n < 0) {
+        return 1;
+    }
+
+    uint64_t bad = 0;
+    int64_t ts[TSDB_CHUNK_MAX];
+    float values[TSDB_CHUNK_MAX];
+    for (int i = 0; i < n; i++) {
+        tsdb_segment_t seg;
+        if (tsdb_segment_open(&seg, paths[i]) == -1) {
+            bad++;
+            continue;
+        }
+        bad += atomic_load(&seg.header->sealed) == 0;
+        uint32_t chunks = tsdb_segment_chunks(&seg);
+        for (uint32_t k = 0; k < chunks; k++) {
+            const tsdb_index_t *entry = tsdb_segment_index(&seg, k);
+            int count = tsdb_chunk_read(&seg, entry, ts, values);
+            for (int j = 0; j < count; j++) {
+                sensor_data_t data = {.sensor_id = entry->sensor_id,
+                                      .timestamp = (time_t) values[j]};
+                check_sample(&data);
+            }
+            bad += count < 0;
+        }
+        tsdb_segment_close(&seg);
+    }
+    tsdb_list_free(paths, n);
+    return bad;
+}
+
+// Apaga o diretório do histórico (segmentos, trava e log)
+static void remove_history(void)
+{
+    DIR *dir = opendir(tsdb_dir);
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            char path[TSDB_PATH_LEN + 256];
+            snprintf(path, sizeof(path), "%s/%s", tsdb_dir, entry->d_name);
+            unlink(path);
+        }
+    }
+    closedir(dir);
+    rmdir(tsdb_dir);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static int run_mode(bench_report_t *report, restart_mode_t mode,
+                    int nwriters, uint32_t period_us, int restarts,
+                    uint32_t interval_ms, uint32_t pause_ms,
+                    uint32_t nshards)
+{
+    // Segmento novo a cada modo
+    shm_unlink(SHM_NAME);
+    memset(shared, 0, sizeof(*shared));
+    int real = mode == R_HISTORY;
+    if (real) {
+        snprintf(tsdb_dir, sizeof(tsdb_dir), "/tmp/restart_bench_XXXXXX");
+        if (mkdtemp(tsdb_dir) == NULL) {
+            perror("Erro ao criar diretório do histórico");
+            return 0;
+        }
+    }
+
+    if (real) {
+        // Cada instância grava blocos cheios antes de entregar
+        uint32_t full_ms = 2 * TSDB_CHUNK_MAX * period_us / 1000;
+        interval_ms = interval_ms > full_ms ? interval_ms : full_ms;
+    }
+
+    uint32_t shards = nshards;
+    pid_t processor =
+        real ? start_data_processor(shards) : start_processor(shards);
+    if (real) {
+        // A partida do data_processor é mais lenta: escritores depois dela
+        rendezvous_t *rv = rendezvous_open();
+        uint64_t deadline = monotonic_ns() + DRAIN_TIMEOUT_MS * 1000000ull;
+        while (rv != NULL && atomic_load(&rv->reader_ready) == 0 &&
+               monotonic_ns() < deadline) {
+            futex_wait(&rv->reader_ready, 0, 10);
+        }
+        rendezvous_close(rv);
+    }
+    pid_t writers[BENCH_MAX_WRITERS];
+    fflush(stdout);
+    for (int w = 0; w < nwriters; w++) {
+        writers[w] = fork();
+        if (writers[w] == 0) {
+            writer_main(w, period_us);
+        }
+    }
+
+    for (int r = 0; r < restarts; r++) {
+        msleep(interval_ms);
+        pid_t old = processor;
+        if (mode == R_CRASH) {
+            atomic_store(&shared->reader_down_ns, monotonic_ns());
+            kill(old, SIGKILL);
+            waitpid(old, NULL, 0);
+            msleep(pause_ms);
+        } else if (mode == R_LAYOUT) {
+            shards = shards == nshards ? nshards * 2 : nshards;
+        }
+        // Na entrega a nova instância pede a saída da anterior
+        processor =
+            real ? start_data_processor(shards) : start_processor(shards);
+        if (mode != R_CRASH) {
+            waitpid(old, NULL, 0);
+        }
+        if (real) {
+            atomic_fetch_add(&shared->takeovers, 1);
+        }
+    }
+    msleep(interval_ms);
+
+    atomic_store(&shared->writers_stop, 1);
+    for (int w = 0; w < nwriters; w++) {
+        waitpid(writers[w], NULL, 0);
+    }
+
+    // O último processador consome o que restou
+    uint64_t deadline = monotonic_ns() + DRAIN_TIMEOUT_MS * 1000000ull;
+    if (real) {
+        wait_rings_empty(deadline);
+    }
+    while (!real &&
+           atomic_load(&shared->received) + atomic_load(&shared->dropped) <
+               atomic_load(&shared->sent) &&
+           monotonic_ns() < deadline) {
+        msleep(5);
+    }
+    kill(processor, SIGTERM);
+    waitpid(processor, NULL, 0);
+    uint64_t unsealed = real ? check_history() : 0;
+
+    uint64_t sent = atomic_load(&shared->sent);
+    uint64_t received = atomic_load(&shared->received);
+    uint64_t dropped = atomic_load(&shared->dropped);
+    uint64_t lost = sent > received + dropped ? sent - received - dropped : 0;
+    uint64_t gaps = atomic_load(&shared->gaps);
+    uint64_t duplicates = atomic_load(&shared->duplicates);
+    int n = atomic_load(&shared->takeovers);
+    qsort(shared->wait_ns, (size_t) n, sizeof(uint64_t), cmp_u64);
+    qsort(shared->gap_ns, (size_t) n, sizeof(uint64_t), cmp_u64);
+    double wait_p50 = n > 0 ? (double) shared->wait_ns[n / 2] / 1e6 : 0.0;
+    double gap_p50 = n > 0 ? (double) shared->gap_ns[n / 2] / 1e6 : 0.0;
+    double gap_max = n > 0 ? (double) shared->gap_ns[n - 1] / 1e6 : 0.0;
+
+    int ok = mode == R_CRASH || (lost == 0 && gaps == 0 && duplicates == 0 &&
+                                 dropped == 0 && unsealed == 0);
+    printf("%-8s %6d %9llu %9llu %6llu %6llu %6llu %6llu %7llu %8.2f %8.2f "
+           "%8.2f %s\n",
+           mode_names[mode], n, (unsigned long long) sent,
+           (unsigned long long) received, (unsigned long long) dropped,
+           (unsigned long long) lost, (unsigned long long) gaps,
+           (unsigned long long) duplicates,
+           (unsigned long long) atomic_load(&shared->backlog_peak), wait_p50,
+           gap_p50, gap_max, ok ? "ok" : "FALHA");
+    if (real && !ok) {
+        printf("  histórico e log mantidos em %s (%llu segmentos sem selar)\n",
+               tsdb_dir, (unsigned long long) unsealed);
+    } else if (real) {
+        remove_history();
+    }
+
+    bench_row_begin(report);
+    bench_field_str(report, "mode", mode_names[mode]);
+    bench_field_u64(report, "writers", (uint64_t) nwriters);
+    bench_field_u64(report, "sensors",
+                    (uint64_t) nwriters * BENCH_SENSORS_PER_WRITER);
+    bench_field_u64(report, "period_us", period_us);
+    bench_field_u64(report, "restarts", (uint64_t) n);
+    bench_field_u64(report, "sent", sent);
+    bench_field_u64(report, "received", received);
+    bench_field_u64(report, "dropped", dropped);
+    bench_field_u64(report, "lost", lost);
+    bench_field_u64(report, "gaps", gaps);
+    bench_field_u64(report, "duplicates", duplicates);
+    bench_field_u64(report, "unsealed_segments", unsealed);
+    bench_field_u64(report, "pending_recovered", shared->pending);
+    bench_field_u64(report, "backlog_peak",
+                    atomic_load(&shared->backlog_peak));
+    bench_field_f64(report, "handoff_wait_p50_ms", wait_p50);
+    bench_field_f64(report, "no_reader_p50_ms", gap_p50);
+    bench_field_f64(report, "no_reader_max_ms", gap_max);
+    bench_field_u64(report, "ok", (uint64_t) ok);
+    bench_row_end(report);
+    return ok;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s [-w escritores] [-p período_us] [-r trocas] "
+            "[-i intervalo_ms] [-g pausa_ms] [-s shards] [-o prefixo] "
+            "[-l rótulo]\n",
+            prog);
+    fprintf(stderr, "\n  -w  processos escritores, %d sensores cada "
+                    "(padrão: 4, máx. %d)\n",
+            BENCH_SENSORS_PER_WRITER, BENCH_MAX_WRITERS);
+    fprintf(stderr, "  -p  período de cada sensor (padrão: 1000 us)\n");
+    fprintf(stderr, "  -r  trocas de processador por modo (padrão: 10)\n");
+    fprintf(stderr, "  -i  intervalo entre trocas (padrão: 100 ms)\n");
+    fprintf(stderr, "  -g  pausa sem processador na queda (padrão: 50 ms)\n");
+    fprintf(stderr, "  -s  shards (padrão: 2; o modo layout alterna com o "
+                    "dobro)\n");
+    fprintf(stderr, "  -o  prefixo dos resultados (padrão: "
+                    "bench_results/restart)\n");
+    fprintf(stderr, "  -l  rótulo da execução, ex. hash do commit "
+                    "(padrão: local)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    // O data_processor do modo historico fica ao lado deste binário
+    const char *slash = strrchr(argv[0], '/');
+    snprintf(processor_path, sizeof(processor_path), "%.*sdata_processor",
+             slash != NULL ? (int) (slash - argv[0] + 1) : 0, argv[0]);
+
+    int nwriters = 4;
+    uint32_t period_us = 1000;
+    int restarts = 10;
+    uint32_t interval_ms = 100;
+    uint32_t pause_ms = 50;
+    uint32_t nshards = 2;
+    const char *prefix = "bench_results/restart";
+    const char *label = "local";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "w:p:r:i:g:s:o:l:h")) != -1) {
+        switch (opt) {
+        case 'w':
+            nwriters = atoi(optarg);
+            break;
+        case 'p':
+            period_us = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            restarts = atoi(optarg);
+            break;
+        case 'i':
+            interval_ms = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'g':
+            pause_ms = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            nshards = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (nwriters < 1 || nwriters > BENCH_MAX_WRITERS || period_us == 0 ||
+        restarts < 1 || restarts > BENCH_MAX_RESTARTS || interval_ms == 0 ||
+        nshards < 1 || nshards * 2 > SAMPLE_MAX_SHARDS) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    rendezvous_t *rv = rendezvous_open();
+    if (rv == NULL) {
+        exit(1);
+    }
+    if (atomic_load(&rv->reader_ready)) {
+        fprintf(stderr, "Erro: há um data_processor ativo; encerre o "
+                        "sistema antes (ou make clean-all)\n");
+        exit(1);
+    }
+    rendezvous_close(rv);
+
+    shared = mmap(NULL, sizeof(shared_t), PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("Erro ao mapear memória comum");
+        exit(1);
+    }
+
+    bench_report_t report;
+    if (bench_report_open(&report, prefix, label) == -1) {
+        exit(1);
+    }
+
+    printf("%d escritores x %d sensores a cada %u us, %d trocas a cada "
+           "%u ms; tempos em ms\n\n",
+           nwriters, BENCH_SENSORS_PER_WRITER, period_us, restarts,
+           interval_ms);
+    printf("%-8s %6s %9s %9s %6s %6s %6s %6s %7s %8s %8s %8s\n", "modo",
+           "trocas", "enviadas", "recebidas", "desc", "perd", "lacuna",
+           "repet", "fila", "entrega", "s/leitor", "máx");
+    int ok = 1;
+    for (int m = 0; m < R_COUNT; m++) {
+        ok &= run_mode(&report, (restart_mode_t) m, nwriters, period_us,
+                       restarts, interval_ms, pause_ms, nshards);
+    }
+    shm_unlink(SHM_NAME);
+
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n", prefix, prefix);
+    return ok ? 0 : 1;
+}
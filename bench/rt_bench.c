@@ -0,0 +1,342 @@
+#include "bench.h"
+#include "ring.h"
+#include "rt.h"
+
+#include <sched.h>
+#include <sys/resource.h>
+
+// Benchmark do perfil de tempo real (rt.h): pior caso de latência com e sem
+// o perfil, com e sem carga concorrente na mesma CPU.
+//
+//   despertar  atraso do clock_nanosleep(TIMER_ABSTIME) da thread sensora em
+//              relação ao deadline (como o sampler do sensor_process)
+//   entrega    criação da amostra → retirada pela consumidora (ring com
+//              espera por futex) e atualização da tabela do sensor
+//
+// A consumidora grava numa tabela por sensor alocada sob demanda, como as
+// estatísticas do data_processor, e os IDs percorrem uma faixa ampla (uma
+// frota chegando): sem o perfil, a primeira escrita de cada página é uma
+// falha de página no caminho da amostra. O perfil aplica SCHED_FIFO às duas
+// threads, mlockall e a pré-carga da tabela, do ring e das pilhas. A carga
+// são processos SCHED_OTHER em laço que mapeiam e tocam memória.
+
+#define BENCH_RING_CAPACITY 1024
+#define BENCH_SENSORS 65536
+#define NOISE_CHUNK (4u << 20) // Memória tocada por volta da carga
+#define NOISE_SPIN_NS 2000000
+
+typedef struct {
+    uint64_t count;
+    double sum;
+    float min;
+    float max;
+    uint64_t last_ns;
+    char pad[32];
+} sensor_entry_t;
+
+typedef struct {
+    int rt;
+    int cpu;
+    uint32_t period_us;
+    uint64_t samples;
+    rt_profile_t profile;
+
+    sample_ring_t *ring;
+    size_t ring_size;
+    sensor_entry_t *table;
+
+    latency_hist_t *wake;
+    latency_hist_t *delivery;
+    _Atomic int sched_ok;    // Threads que ficaram em SCHED_FIFO
+    _Atomic uint64_t faults; // Falhas de página no laço das threads
+} rt_run_t;
+
+static void pin_cpu(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void apply_role(rt_run_t *run, rt_role_t role)
+{
+    pin_cpu(run->cpu);
+    if (run->rt) {
+        rt_apply_thread(&run->profile, role, -1, "RT_BENCH");
+        if ((sched_getscheduler(0) & ~SCHED_RESET_ON_FORK) == SCHED_FIFO) {
+            atomic_fetch_add(&run->sched_ok, 1);
+        }
+    }
+}
+
+// Falhas de página da thread chamadora (menores + maiores)
+static uint64_t thread_faults(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return (uint64_t) usage.ru_minflt + (uint64_t) usage.ru_majflt;
+}
+
+static void *sensor_thread(void *arg)
+{
+    rt_run_t *run = arg;
+    apply_role(run, RT_ROLE_SENSOR);
+    uint64_t faults = thread_faults();
+
+    uint64_t period = (uint64_t) run->period_us * 1000;
+    uint64_t deadline = monotonic_ns() + period;
+    uint32_t rng = 12345;
+    for (uint64_t i = 0; i < run->samples; i++) {
+        struct timespec ts = {.tv_sec = (time_t) (deadline / 1000000000ull),
+                              .tv_nsec = (long) (deadline % 1000000000ull)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        uint64_t now = monotonic_ns();
+        latency_hist_record(run->wake, now - deadline);
+
+        // Passo primo: IDs espalhados por toda a tabela
+        sensor_data_t data = {
+            .type = SENSOR_TEMPERATURE,
+            .sensor_id = (int) ((i * 4099u) % BENCH_SENSORS),
+            .value = sensor_simulate(25.0f, &rng),
+            .active = 1,
+            .t_created = monotonic_ns(),
+        };
+        ring_push(run->ring, &data, -1);
+
+        deadline += period;
+        if (deadline < now) {
+            deadline = now + period; // Atraso maior que o período: pular
+        }
+    }
+    atomic_fetch_add(&run->faults, thread_faults() - faults);
+    return NULL;
+}
+
+static void *consumer_thread(void *arg)
+{
+    rt_run_t *run = arg;
+    apply_role(run, RT_ROLE_CONSUMER);
+    uint64_t faults = thread_faults();
+
+    for (uint64_t i = 0; i < run->samples;) {
+        sensor_data_t data;
+        if (ring_pop(run->ring, &data, 100) != 0) {
+            continue;
+        }
+        sensor_entry_t *e = &run->table[data.sensor_id];
+        if (e->count == 0 || data.value < e->min) {
+            e->min = data.value;
+        }
+        if (e->count == 0 || data.value > e->max) {
+            e->max = data.value;
+        }
+        e->count++;
+        e->sum += data.value;
+        e->last_ns = monotonic_ns();
+        latency_hist_record(run->delivery, e->last_ns - data.t_created);
+        i++;
+    }
+    atomic_fetch_add(&run->faults, thread_faults() - faults);
+    return NULL;
+}
+
+// Processo de carga: laço de CPU e mapeamentos novos tocados página a página
+static void noise_loop(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+    volatile uint64_t x = 0;
+    for (;;) {
+        uint64_t until = monotonic_ns() + NOISE_SPIN_NS;
+        while (monotonic_ns() < until) {
+            x += until;
+        }
+        char *p = mmap(NULL, NOISE_CHUNK, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+            for (size_t off = 0; off < NOISE_CHUNK; off += 4096) {
+                p[off] = (char) off;
+            }
+            munmap(p, NOISE_CHUNK);
+        }
+    }
+}
+
+static void run_profile(bench_report_t *report, rt_run_t *run, int noise)
+{
+    pid_t noise_pids[8];
+    for (int i = 0; i < noise; i++) {
+        noise_pids[i] = fork();
+        if (noise_pids[i] == 0) {
+            noise_loop(run->cpu);
+        }
+    }
+
+    int locked = 0;
+    if (run->rt) {
+        locked = rt_lock_memory(&run->profile, "RT_BENCH") == 0;
+    }
+
+    // Tabela e ring novos a cada execução: sem o perfil, sob demanda
+    run->ring_size = ring_bytes(BENCH_RING_CAPACITY);
+    run->ring = mmap(NULL, run->ring_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    size_t table_size = BENCH_SENSORS * sizeof(sensor_entry_t);
+    run->table = mmap(NULL, table_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    run->wake = calloc(1, sizeof(latency_hist_t));
+    run->delivery = calloc(1, sizeof(latency_hist_t));
+    if (run->ring == MAP_FAILED || run->table == MAP_FAILED ||
+        run->wake == NULL || run->delivery == NULL) {
+        perror("Erro ao alocar");
+        exit(1);
+    }
+    ring_init(run->ring, BENCH_RING_CAPACITY);
+    if (run->rt && run->profile.lock_memory) {
+        rt_prefault(run->ring, run->ring_size, 1);
+        rt_prefault(run->table, table_size, 1);
+        rt_prefault(run->wake, sizeof(latency_hist_t), 1);
+        rt_prefault(run->delivery, sizeof(latency_hist_t), 1);
+    }
+    atomic_store(&run->sched_ok, 0);
+    atomic_store(&run->faults, 0);
+
+    pthread_t sensor, consumer;
+    if (pthread_create(&consumer, NULL, consumer_thread, run) != 0 ||
+        pthread_create(&sensor, NULL, sensor_thread, run) != 0) {
+        perror("Erro ao criar threads");
+        exit(1);
+    }
+    pthread_join(sensor, NULL);
+    pthread_join(consumer, NULL);
+
+    for (int i = 0; i < noise; i++) {
+        kill(noise_pids[i], SIGKILL);
+        waitpid(noise_pids[i], NULL, 0);
+    }
+    if (locked) {
+        munlockall();
+    }
+
+    uint64_t faults = atomic_load(&run->faults);
+    const char *profile = run->rt ? "rt" : "padrao";
+    const char *load = noise > 0 ? "com_carga" : "sem_carga";
+    int sched_ok = atomic_load(&run->sched_ok) == 2;
+
+    static latency_snapshot_t snap;
+    const latency_hist_t *hists[2] = {run->wake, run->delivery};
+    static const char *const metric_names[2] = {"despertar", "entrega"};
+    for (int m = 0; m < 2; m++) {
+        memset(&snap, 0, sizeof(snap));
+        latency_hist_add(&snap, hists[m]);
+        printf("%-7s %-10s %-10s %9.1f %9.1f %9.1f %9.1f %7llu %5s %5s\n",
+               profile, load, metric_names[m],
+               (double) latency_percentile(&snap, 0.50) / 1e3,
+               (double) latency_percentile(&snap, 0.99) / 1e3,
+               (double) latency_percentile(&snap, 0.999) / 1e3,
+               (double) snap.max / 1e3, (unsigned long long) faults,
+               run->rt ? (sched_ok ? "sim" : "NAO") : "-",
+               run->rt ? (locked ? "sim" : "NAO") : "-");
+
+        bench_row_begin(report);
+        bench_field_str(report, "profile", profile);
+        bench_field_str(report, "load", load);
+        bench_field_str(report, "metric", metric_names[m]);
+        bench_field_u64(report, "period_us", run->period_us);
+        bench_field_u64(report, "sched_fifo", (uint64_t) sched_ok);
+        bench_field_u64(report, "mlocked", (uint64_t) locked);
+        bench_field_u64(report, "page_faults", faults);
+        bench_field_latency(report, &snap);
+        bench_row_end(report);
+    }
+
+    munmap(run->ring, run->ring_size);
+    munmap(run->table, table_size);
+    free(run->wake);
+    free(run->delivery);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s [-n amostras] [-p período_us] [-c cpu] [-j carga] "
+            "[-o prefixo] [-l rótulo]\n",
+            prog);
+    fprintf(stderr, "\n  -n  amostras por configuração (padrão: 4000)\n");
+    fprintf(stderr, "  -p  período da thread sensora (padrão: 500 us)\n");
+    fprintf(stderr, "  -c  CPU de todas as threads e da carga (padrão: 0)\n");
+    fprintf(stderr, "  -j  processos de carga (padrão: 2, máx. 8)\n");
+    fprintf(stderr, "  -o  prefixo dos resultados (padrão: "
+                    "bench_results/rt)\n");
+    fprintf(stderr, "  -l  rótulo da execução, ex. hash do commit "
+                    "(padrão: local)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    rt_run_t run = {.period_us = 500, .samples = 4000};
+    int noise = 2;
+    const char *prefix = "bench_results/rt";
+    const char *label = "local";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:p:c:j:o:l:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            run.samples = strtoull(optarg, NULL, 10);
+            break;
+        case 'p':
+            run.period_us = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'c':
+            run.cpu = atoi(optarg);
+            break;
+        case 'j':
+            noise = atoi(optarg);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (run.samples == 0 || run.period_us == 0 || run.cpu < 0 ||
+        run.cpu >= CPU_SETSIZE || noise < 1 || noise > 8) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    // Papéis do perfil padrão (rt_profile_default), sem afinidade própria:
+    // o benchmark fixa todas as threads na CPU pedida
+    rt_profile_default(&run.profile);
+    run.profile.enabled = 1;
+
+    bench_report_t report;
+    if (bench_report_open(&report, prefix, label) == -1) {
+        exit(1);
+    }
+
+    printf("Latências em us; falhas = falhas de página nas threads "
+           "medidas\n\n");
+    printf("%-7s %-10s %-10s %9s %9s %9s %9s %7s %5s %5s\n", "perfil",
+           "carga", "medida", "p50", "p99", "p99.9", "máx", "falhas", "fifo",
+           "mlock");
+    // Sem o perfil primeiro: mlockall e mallopt valem para o processo
+    for (int rt = 0; rt <= 1; rt++) {
+        run.rt = rt;
+        run_profile(&report, &run, 0);
+        run_profile(&report, &run, noise);
+    }
+
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n", prefix, prefix);
+    return 0;
+}
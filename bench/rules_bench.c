@@ -0,0 +1,467 @@
+#include "bench.h"
+#include "ring.h"
+#include "rules.h"
+
+// Benchmark do motor de regras de alarme (rules.c):
+//
+//   vazão     amostras/s e avaliações (amostra, regra)/s de rule_engine_eval
+//             variando o número de regras e o tamanho do lote, sobre uma
+//             frota simulada (mesma geração de valores dos sensores)
+//   detecção  latência da criação da amostra que viola a regra até o alarme
+//             chegar ao leitor da fila POSIX, no caminho do data_processor:
+//             ring → consumidor em lote → regras → mq_send. Uma thread
+//             mantém a fila cheia de mensagens comuns (prioridade 0), como
+//             as leituras que os sensores publicam; compara o alarme com
+//             MQ_PRIO_ALARM e com prioridade 0.
+//
+// Resultados em <prefixo>_throughput.* e <prefixo>_latency.*
+
+#define BENCH_MQ_NAME "/sensor_rules_bench_mq"
+#define BENCH_MQ_DEPTH 10 // Limite padrão sem privilégios (msg_max)
+#define BENCH_RING_CAPACITY 128 // Padrão de ring_capacity (system_config)
+#define BENCH_SENSORS 1000
+#define BENCH_SAMPLES (1u << 16)
+#define POLL_TIMEOUT_MS 10
+
+// Detecção: uma violação a cada tantas amostras, produzidas em rajadas
+// pequenas com pausa (fluxo contínuo, sem fila acumulada no ring)
+#define VIOLATION_EVERY 256
+#define PRODUCER_BURST 16
+#define PRODUCER_PAUSE_NS 50000
+// Trabalho do leitor por mensagem (log, parsing) que faz a fila acumular
+#define RECEIVER_WORK_NS 5000
+
+typedef struct {
+    uint64_t t_created;
+    uint32_t alarm; // 1 = alarme, 0 = mensagem comum
+    char text[52];
+} bench_msg_t;
+
+// ---------------------------------------------------------------------------
+// Vazão
+
+// Gera n regras variando tipo, espécie e opções; limites próximos do ruído
+// dos sensores para que as janelas e transições sejam exercitadas
+static void build_rules(rule_table_t *table, uint32_t n)
+{
+    static const char *const templates[] = {
+        "temperatura above %.2f hyst 0.5 nofm 2 5",
+        "umidade below %.2f nofm 3 5",
+        "pressao above %.2f hyst 0.2",
+        "* rate %.0f",
+        "temperatura below %.2f",
+        "* stuck %.0f eps 0.001",
+    };
+    static const float base[] = {26.5f, 58.0f, 1014.5f, 400.0f, 23.0f, 10.0f};
+    static const float step[] = {0.05f, -0.05f, 0.05f, 10.0f, -0.05f, 1.0f};
+    size_t ntemplates = sizeof(templates) / sizeof(templates[0]);
+
+    memset(table, 0, sizeof(*table));
+    for (uint32_t i = 0; i < n; i++) {
+        size_t k = i % ntemplates;
+        char line[128];
+        snprintf(line, sizeof(line), templates[k],
+                 (double) (base[k] + step[k] * (float) (i / ntemplates)));
+        if (rules_add(table, line) == -1) {
+            fprintf(stderr, "Regra inválida: %s\n", line);
+            exit(1);
+        }
+    }
+}
+
+static void generate_samples(sensor_data_t *samples, uint32_t n)
+{
+    uint32_t rng = 12345;
+    for (uint32_t i = 0; i < n; i++) {
+        int id = (int) (i % BENCH_SENSORS) + 1;
+        sensor_type_t type = (sensor_type_t) (id % SENSOR_TYPE_COUNT);
+        samples[i] = (sensor_data_t){
+            .sensor_id = id,
+            .type = type,
+            .value = sensor_simulate(sensor_base_value(type), &rng),
+            .timestamp = (time_t) (i / BENCH_SENSORS),
+            .t_created = (uint64_t) i * 10000, // 10 ms por rodada da frota
+        };
+    }
+}
+
+static void count_event(const rule_event_t *event, void *ctx)
+{
+    (void) event;
+    (*(uint64_t *) ctx)++;
+}
+
+static void run_throughput(bench_report_t *report, const sensor_data_t *samples,
+                           uint64_t total, uint32_t nrules, uint32_t batch)
+{
+    static rule_table_t table;
+    build_rules(&table, nrules);
+
+    rule_engine_t engine;
+    if (rule_engine_init(&engine, &table, BENCH_SENSORS + 1) == -1) {
+        perror("rule_engine_init");
+        exit(1);
+    }
+
+    uint64_t events = 0;
+    uint64_t done = 0;
+    uint64_t start = monotonic_ns();
+    while (done < total) {
+        for (uint32_t i = 0; i + batch <= BENCH_SAMPLES && done < total;
+             i += batch) {
+            rule_engine_eval(&engine, samples + i, batch, count_event,
+                             &events);
+            done += batch;
+        }
+    }
+    double seconds = (double) (monotonic_ns() - start) / 1e9;
+
+    double rate = (double) done / seconds;
+    double evals = (double) engine.evaluations / seconds;
+    printf("%-6u %5u %14.0f %14.0f %10.2f %10llu\n", nrules, batch, rate,
+           evals, seconds * 1e9 / (double) engine.evaluations,
+           (unsigned long long) events);
+
+    bench_row_begin(report);
+    bench_field_u64(report, "rules", nrules);
+    bench_field_u64(report, "batch", batch);
+    bench_field_u64(report, "samples", done);
+    bench_field_u64(report, "evaluations", engine.evaluations);
+    bench_field_u64(report, "events", events);
+    bench_field_f64(report, "seconds", seconds);
+    bench_field_f64(report, "samples_per_sec", rate);
+    bench_field_f64(report, "evals_per_sec", evals);
+    bench_field_f64(report, "ns_per_eval",
+                    seconds * 1e9 / (double) engine.evaluations);
+    bench_row_end(report);
+
+    rule_engine_free(&engine);
+}
+
+// ---------------------------------------------------------------------------
+// Latência de detecção
+
+typedef struct {
+    unsigned priority; // Prioridade do alarme na fila
+    uint32_t alarms;   // Alarmes a medir
+
+    sample_ring_t *ring;
+    size_t ring_size;
+    mqd_t mq;
+    rule_table_t table;
+
+    _Atomic int stop;
+    uint64_t noise_received;
+    latency_hist_t *hist;
+} detect_run_t;
+
+static void deadline_in(struct timespec *ts, long ms)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_nsec += ms * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+// mq_send que desiste quando a execução termina; 0 se enviou
+static int send_until_stop(detect_run_t *run, const bench_msg_t *msg,
+                           unsigned priority)
+{
+    while (!atomic_load(&run->stop)) {
+        struct timespec deadline;
+        deadline_in(&deadline, POLL_TIMEOUT_MS);
+        if (mq_timedsend(run->mq, (const char *) msg, sizeof(*msg), priority,
+                         &deadline) == 0) {
+            return 0;
+        }
+        if (errno != ETIMEDOUT && errno != EINTR) {
+            perror("mq_timedsend");
+            exit(1);
+        }
+    }
+    return -1;
+}
+
+static void pause_ns(long ns)
+{
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = ns};
+    nanosleep(&ts, NULL);
+}
+
+static void spin_ns(uint64_t ns)
+{
+    uint64_t end = monotonic_ns() + ns;
+    while (monotonic_ns() < end) {
+    }
+}
+
+// Sensores: temperatura normal com uma leitura fora do limite de tempos em
+// tempos (a seguinte já volta ao normal)
+static void *detect_producer(void *arg)
+{
+    detect_run_t *run = (detect_run_t *) arg;
+    uint32_t rng = 777;
+    uint64_t seq = 0;
+    while (!atomic_load(&run->stop)) {
+        sensor_data_t burst[PRODUCER_BURST];
+        for (uint32_t i = 0; i < PRODUCER_BURST; i++, seq++) {
+            int violation = seq % VIOLATION_EVERY == VIOLATION_EVERY - 1;
+            burst[i] = (sensor_data_t){
+                .sensor_id = (int) (seq % 8) + 1,
+                .type = SENSOR_TEMPERATURE,
+                .value = violation ? 90.0f
+                                   : sensor_simulate(25.0f, &rng),
+                .timestamp = time(NULL),
+                .t_created = monotonic_ns(),
+            };
+        }
+        ring_push_batch(run->ring, burst, PRODUCER_BURST, POLL_TIMEOUT_MS);
+        pause_ns(PRODUCER_PAUSE_NS);
+    }
+    return NULL;
+}
+
+static void detect_emit(const rule_event_t *event, void *ctx)
+{
+    detect_run_t *run = (detect_run_t *) ctx;
+    if (!event->active) {
+        return;
+    }
+    bench_msg_t msg = {.t_created = event->t_created, .alarm = 1};
+    snprintf(msg.text, sizeof(msg.text), "ALARME:SENSOR-%d:%.2f",
+             event->sensor_id, (double) event->value);
+    send_until_stop(run, &msg, run->priority);
+}
+
+// Consumidor do data_processor: lote do ring → regras → alarmes na fila
+static void *detect_consumer(void *arg)
+{
+    detect_run_t *run = (detect_run_t *) arg;
+    rule_engine_t engine;
+    if (rule_engine_init(&engine, &run->table, 16) == -1) {
+        perror("rule_engine_init");
+        exit(1);
+    }
+
+    sensor_data_t batch[RULES_BATCH_MAX];
+    while (!atomic_load(&run->stop)) {
+        uint32_t n =
+            ring_pop_batch(run->ring, batch, RULES_BATCH_MAX, POLL_TIMEOUT_MS);
+        if (n == 0) {
+            continue;
+        }
+        rule_engine_eval(&engine, batch, n, detect_emit, run);
+    }
+
+    rule_engine_free(&engine);
+    return NULL;
+}
+
+// Leituras comuns publicadas na fila, mantendo-a cheia
+static void *detect_noise(void *arg)
+{
+    detect_run_t *run = (detect_run_t *) arg;
+    bench_msg_t msg = {.alarm = 0};
+    snprintf(msg.text, sizeof(msg.text), "SENSOR-1:TEMPERATURA:25.00");
+    while (send_until_stop(run, &msg, 0) == 0) {
+    }
+    return NULL;
+}
+
+// Leitor da fila (control_interface): mede os alarmes
+static void *detect_receiver(void *arg)
+{
+    detect_run_t *run = (detect_run_t *) arg;
+    uint32_t received = 0;
+    while (!atomic_load(&run->stop)) {
+        bench_msg_t msg;
+        struct timespec deadline;
+        deadline_in(&deadline, POLL_TIMEOUT_MS);
+        if (mq_timedreceive(run->mq, (char *) &msg, sizeof(msg), NULL,
+                            &deadline) != (ssize_t) sizeof(msg)) {
+            continue;
+        }
+        uint64_t now = monotonic_ns();
+        if (msg.alarm) {
+            latency_hist_record(run->hist, now - msg.t_created);
+            if (++received == run->alarms) {
+                atomic_store(&run->stop, 1);
+            }
+        } else {
+            run->noise_received++;
+        }
+        spin_ns(RECEIVER_WORK_NS);
+    }
+    return NULL;
+}
+
+static int run_detection(bench_report_t *report, unsigned priority,
+                         uint32_t alarms)
+{
+    static detect_run_t run;
+    memset(&run, 0, sizeof(run));
+    run.priority = priority;
+    run.alarms = alarms;
+    atomic_init(&run.stop, 0);
+    if (rules_add(&run.table, "temperatura above 60") == -1) {
+        return -1;
+    }
+
+    uint32_t capacity = ring_round_capacity(BENCH_RING_CAPACITY);
+    run.ring_size = ring_bytes(capacity);
+    run.ring = mmap(NULL, run.ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (run.ring == MAP_FAILED) {
+        perror("Erro ao mapear ring");
+        return -1;
+    }
+    ring_init(run.ring, capacity);
+
+    mq_unlink(BENCH_MQ_NAME);
+    struct mq_attr attr = {.mq_flags = 0,
+                           .mq_maxmsg = BENCH_MQ_DEPTH,
+                           .mq_msgsize = sizeof(bench_msg_t)};
+    run.mq = mq_open(BENCH_MQ_NAME, O_CREAT | O_EXCL | O_RDWR, 0600, &attr);
+    if (run.mq == (mqd_t) -1) {
+        perror("mq_open");
+        munmap(run.ring, run.ring_size);
+        return -1;
+    }
+
+    run.hist = calloc(1, sizeof(latency_hist_t));
+    if (run.hist == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+
+    pthread_t threads[4];
+    void *(*const bodies[4])(void *) = {detect_receiver, detect_noise,
+                                        detect_consumer, detect_producer};
+    uint64_t start = monotonic_ns();
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, bodies[i], &run);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = (double) (monotonic_ns() - start) / 1e9;
+
+    static latency_snapshot_t snap;
+    memset(&snap, 0, sizeof(snap));
+    latency_hist_add(&snap, run.hist);
+    free(run.hist);
+    mq_close(run.mq);
+    mq_unlink(BENCH_MQ_NAME);
+    munmap(run.ring, run.ring_size);
+
+    printf("%-10u %8llu %10llu %10.1f %10.1f %10.1f %10.1f\n", priority,
+           (unsigned long long) snap.count,
+           (unsigned long long) run.noise_received,
+           (double) latency_percentile(&snap, 0.50) / 1e3,
+           (double) latency_percentile(&snap, 0.99) / 1e3,
+           (double) latency_percentile(&snap, 0.999) / 1e3,
+           (double) snap.max / 1e3);
+
+    bench_row_begin(report);
+    bench_field_u64(report, "priority", priority);
+    bench_field_u64(report, "queue_depth", BENCH_MQ_DEPTH);
+    bench_field_u64(report, "noise_messages", run.noise_received);
+    bench_field_f64(report, "seconds", seconds);
+    bench_field_latency(report, &snap);
+    bench_row_end(report);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Uso: %s [-n amostras] [-a alarmes] [-o prefixo] "
+                    "[-l rótulo]\n",
+            prog);
+    fprintf(stderr, "\n  -n  amostras avaliadas por configuração de vazão "
+                    "(padrão: 2000000)\n");
+    fprintf(stderr, "  -a  alarmes medidos por prioridade (padrão: 1000)\n");
+    fprintf(stderr, "  -o  grava <prefixo>_throughput.* e "
+                    "<prefixo>_latency.* (padrão: bench_results/rules)\n");
+    fprintf(stderr, "  -l  rótulo da execução, ex. hash do commit "
+                    "(padrão: local)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t samples = 2000000;
+    uint32_t alarms = 1000;
+    const char *prefix = "bench_results/rules";
+    const char *label = "local";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:a:o:l:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            samples = strtoull(optarg, NULL, 10);
+            break;
+        case 'a':
+            alarms = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (samples == 0 || alarms == 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    char path[512];
+    bench_report_t report;
+
+    snprintf(path, sizeof(path), "%s_throughput", prefix);
+    if (bench_report_open(&report, path, label) == -1) {
+        exit(1);
+    }
+    sensor_data_t *fleet = malloc(BENCH_SAMPLES * sizeof(*fleet));
+    if (fleet == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    generate_samples(fleet, BENCH_SAMPLES);
+
+    static const uint32_t rule_counts[] = {1, 4, 16, 64};
+    static const uint32_t batches[] = {1, 16, 64};
+    printf("%-6s %5s %14s %14s %10s %10s\n", "regras", "lote", "amostras/s",
+           "avaliações/s", "ns/aval", "eventos");
+    for (size_t r = 0; r < sizeof(rule_counts) / sizeof(rule_counts[0]); r++) {
+        for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+            run_throughput(&report, fleet, samples, rule_counts[r],
+                           batches[b]);
+        }
+    }
+    free(fleet);
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n\n", path, path);
+
+    snprintf(path, sizeof(path), "%s_latency", prefix);
+    if (bench_report_open(&report, path, label) == -1) {
+        exit(1);
+    }
+    printf("%-10s %8s %10s %10s %10s %10s %10s\n", "prioridade", "alarmes",
+           "comuns", "p50 us", "p99 us", "p99.9 us", "máx us");
+    static const unsigned priorities[] = {MQ_PRIO_ALARM, 0};
+    for (size_t p = 0; p < sizeof(priorities) / sizeof(priorities[0]); p++) {
+        if (run_detection(&report, priorities[p], alarms) == -1) {
+            fprintf(stderr, "Falha na prioridade %u (pulando)\n",
+                    priorities[p]);
+        }
+    }
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n", path, path);
+    return 0;
+}
@@ -0,0 +1,532 @@
+#include "bench.h"
+#include "ring.h"
+
+#include <limits.h>
+
+// Benchmark dos transportes de amostras: vazão (mensagens/s) e percentis de
+// latência de envio → recebimento para
+//
+//   fifo     pipe do kernel (mesma implementação do FIFO_SENSOR_DATA)
+//   mq       fila de mensagens POSIX (como MQ_NAME)
+//   shm_sem  buffer circular em memória compartilhada com mutex + semáforos
+//            (o buffer original do data_processor, reproduzido aqui como
+//            referência)
+//   ring     ring lock-free com futex (ring.c), usado hoje pelo sistema
+//
+// variando tamanho da mensagem, produtores/consumidores e tamanho do lote.
+// Produtores e consumidores são threads; cada mensagem leva no início o
+// instante de envio (CLOCK_MONOTONIC). Combinações sem sentido para um
+// transporte são puladas: mq não tem envio em lote, o ring carrega apenas
+// sensor_data_t e lotes no pipe precisam caber em PIPE_BUF (escrita atômica).
+
+#define BENCH_MQ_NAME "/sensor_bench_mq"
+#define BENCH_MQ_DEPTH 10 // Limite padrão sem privilégios (msg_max)
+#define BENCH_RING_CAPACITY 128 // Padrão de ring_capacity (system_config)
+#define POLL_TIMEOUT_MS 10
+
+typedef enum { T_FIFO = 0, T_MQ, T_SHM_SEM, T_RING, T_COUNT } transport_t;
+
+static const char *const transport_names[T_COUNT] = {"fifo", "mq", "shm_sem",
+                                                     "ring"};
+
+// Buffer circular clássico: exclusão mútua + semáforos de vagas/itens
+typedef struct {
+    pthread_mutex_t mutex;
+    sem_t empty;
+    sem_t full;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t capacity;
+    uint32_t payload;
+    size_t bytes;
+    char data[];
+} sem_buffer_t;
+
+typedef struct {
+    transport_t transport;
+    uint32_t payload;
+    uint32_t producers;
+    uint32_t consumers;
+    uint32_t batch;
+    uint64_t messages;
+
+    int pipe_fd[2];
+    mqd_t mq;
+    sem_buffer_t *semq;
+    sample_ring_t *ring;
+    size_t ring_size;
+
+    _Atomic uint64_t consumed;
+} bench_run_t;
+
+typedef struct {
+    bench_run_t *run;
+    uint64_t count; // Mensagens a enviar (produtores)
+    latency_hist_t *hist;
+} worker_t;
+
+// ---------------------------------------------------------------------------
+// shm_sem
+
+static sem_buffer_t *sem_buffer_create(uint32_t capacity, uint32_t payload)
+{
+    size_t bytes = sizeof(sem_buffer_t) + (size_t) capacity * payload;
+    sem_buffer_t *q = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (q == MAP_FAILED) {
+        perror("Erro ao mapear buffer");
+        return NULL;
+    }
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&q->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    sem_init(&q->empty, 1, capacity);
+    sem_init(&q->full, 1, 0);
+    q->capacity = capacity;
+    q->payload = payload;
+    q->bytes = bytes;
+    return q;
+}
+
+static void sem_buffer_destroy(sem_buffer_t *q)
+{
+    pthread_mutex_destroy(&q->mutex);
+    sem_destroy(&q->empty);
+    sem_destroy(&q->full);
+    munmap(q, q->bytes);
+}
+
+// Insere n itens; cada rodada aguarda uma vaga e pega as demais livres sem
+// bloquear (reservar o lote inteiro antes de publicar travaria produtores
+// concorrentes que dividem as vagas)
+static void sem_buffer_put(sem_buffer_t *q, const char *items, uint32_t n)
+{
+    uint32_t done = 0;
+    while (done < n) {
+        while (sem_wait(&q->empty) == -1 && errno == EINTR) {
+        }
+        uint32_t k = 1;
+        while (done + k < n && sem_trywait(&q->empty) == 0) {
+            k++;
+        }
+
+        pthread_mutex_lock(&q->mutex);
+        for (uint32_t i = 0; i < k; i++) {
+            memcpy(q->data + (size_t) q->head * q->payload,
+                   items + (size_t) (done + i) * q->payload, q->payload);
+            q->head = (q->head + 1) % q->capacity;
+        }
+        pthread_mutex_unlock(&q->mutex);
+        for (uint32_t i = 0; i < k; i++) {
+            sem_post(&q->full);
+        }
+        done += k;
+    }
+}
+
+// Retira até max itens (o primeiro com espera limitada); 0 se o tempo esgotou
+static uint32_t sem_buffer_get(sem_buffer_t *q, char *out, uint32_t max)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += POLL_TIMEOUT_MS * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    if (sem_timedwait(&q->full, &deadline) == -1) {
+        return 0;
+    }
+    uint32_t n = 1;
+    while (n < max && sem_trywait(&q->full) == 0) {
+        n++;
+    }
+
+    pthread_mutex_lock(&q->mutex);
+    for (uint32_t i = 0; i < n; i++) {
+        memcpy(out + (size_t) i * q->payload,
+               q->data + (size_t) q->tail * q->payload, q->payload);
+        q->tail = (q->tail + 1) % q->capacity;
+    }
+    pthread_mutex_unlock(&q->mutex);
+    for (uint32_t i = 0; i < n; i++) {
+        sem_post(&q->empty);
+    }
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// Produtores e consumidores
+
+static inline void stamp(char *msg, uint64_t ns)
+{
+    memcpy(msg, &ns, sizeof(ns));
+}
+
+static inline void record(latency_hist_t *hist, const char *msg, uint64_t now)
+{
+    uint64_t sent;
+    memcpy(&sent, msg, sizeof(sent));
+    latency_hist_record(hist, now > sent ? now - sent : 0);
+}
+
+static void *producer(void *arg)
+{
+    worker_t *w = (worker_t *) arg;
+    bench_run_t *run = w->run;
+    uint32_t payload = run->payload;
+    char *buf = calloc(run->batch, payload);
+    if (buf == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+
+    uint64_t sent = 0;
+    while (sent < w->count) {
+        uint32_t n = run->batch;
+        if (w->count - sent < n) {
+            n = (uint32_t) (w->count - sent);
+        }
+        uint64_t now = monotonic_ns();
+        for (uint32_t i = 0; i < n; i++) {
+            stamp(buf + (size_t) i * payload, now);
+        }
+
+        switch (run->transport) {
+        case T_FIFO:
+            if (write(run->pipe_fd[1], buf, (size_t) n * payload) == -1) {
+                perror("write");
+                exit(1);
+            }
+            break;
+        case T_MQ:
+            while (mq_send(run->mq, buf, payload, 0) == -1) {
+                if (errno != EINTR) {
+                    perror("mq_send");
+                    exit(1);
+                }
+            }
+            break;
+        case T_SHM_SEM:
+            sem_buffer_put(run->semq, buf, n);
+            break;
+        case T_RING: {
+            sensor_data_t *items = (sensor_data_t *) buf;
+            for (uint32_t i = 0; i < n; i++) {
+                items[i].t_created = now;
+            }
+            ring_push_batch(run->ring, items, n, -1);
+            break;
+        }
+        default:
+            break;
+        }
+        sent += n;
+    }
+
+    free(buf);
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    worker_t *w = (worker_t *) arg;
+    bench_run_t *run = w->run;
+    uint32_t payload = run->payload;
+    char *buf = calloc(run->batch, payload);
+    if (buf == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+
+    while (atomic_load_explicit(&run->consumed, memory_order_relaxed) <
+           run->messages) {
+        uint32_t n = 0;
+
+        switch (run->transport) {
+        case T_FIFO: {
+            // Leituras e escritas são múltiplos de payload: nunca há
+            // mensagem partida entre consumidores
+            ssize_t r = read(run->pipe_fd[0], buf, (size_t) run->batch * payload);
+            if (r <= 0) {
+                free(buf);
+                return NULL; // EOF: produtores terminaram
+            }
+            n = (uint32_t) ((size_t) r / payload);
+            break;
+        }
+        case T_MQ: {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += POLL_TIMEOUT_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            if (mq_timedreceive(run->mq, buf, payload, NULL, &deadline) >= 0) {
+                n = 1;
+            }
+            break;
+        }
+        case T_SHM_SEM:
+            n = sem_buffer_get(run->semq, buf, run->batch);
+            break;
+        case T_RING: {
+            // Lote inteiro de uma vez, como sem_buffer_get
+            sensor_data_t *items = (sensor_data_t *) buf;
+            n = ring_pop_batch(run->ring, items, run->batch, POLL_TIMEOUT_MS);
+            for (uint32_t i = 0; i < n; i++) {
+                stamp(buf + (size_t) i * payload, items[i].t_created);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        uint64_t now = monotonic_ns();
+        for (uint32_t i = 0; i < n; i++) {
+            record(w->hist, buf + (size_t) i * payload, now);
+        }
+        atomic_fetch_add_explicit(&run->consumed, n, memory_order_relaxed);
+    }
+
+    free(buf);
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Execução de uma configuração
+
+static int transport_open(bench_run_t *run)
+{
+    switch (run->transport) {
+    case T_FIFO:
+        return pipe(run->pipe_fd);
+    case T_MQ: {
+        mq_unlink(BENCH_MQ_NAME);
+        struct mq_attr attr = {.mq_flags = 0,
+                               .mq_maxmsg = BENCH_MQ_DEPTH,
+                               .mq_msgsize = run->payload};
+        run->mq = mq_open(BENCH_MQ_NAME, O_CREAT | O_EXCL | O_RDWR, 0600,
+                          &attr);
+        if (run->mq == (mqd_t) -1) {
+            perror("mq_open");
+            return -1;
+        }
+        return 0;
+    }
+    case T_SHM_SEM:
+        run->semq = sem_buffer_create(BENCH_RING_CAPACITY, run->payload);
+        return run->semq == NULL ? -1 : 0;
+    case T_RING: {
+        uint32_t capacity = ring_round_capacity(BENCH_RING_CAPACITY);
+        run->ring_size = ring_bytes(capacity);
+        run->ring = mmap(NULL, run->ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (run->ring == MAP_FAILED) {
+            perror("Erro ao mapear ring");
+            return -1;
+        }
+        ring_init(run->ring, capacity);
+        return 0;
+    }
+    default:
+        return -1;
+    }
+}
+
+static void transport_close(bench_run_t *run)
+{
+    switch (run->transport) {
+    case T_FIFO:
+        close(run->pipe_fd[0]);
+        break;
+    case T_MQ:
+        mq_close(run->mq);
+        mq_unlink(BENCH_MQ_NAME);
+        break;
+    case T_SHM_SEM:
+        sem_buffer_destroy(run->semq);
+        break;
+    case T_RING:
+        munmap(run->ring, run->ring_size);
+        break;
+    default:
+        break;
+    }
+}
+
+static int supported(transport_t t, uint32_t payload, uint32_t batch)
+{
+    switch (t) {
+    case T_FIFO:
+        return (size_t) payload * batch <= PIPE_BUF;
+    case T_MQ:
+        return batch == 1;
+    case T_RING:
+        return payload == sizeof(sensor_data_t);
+    default:
+        return 1;
+    }
+}
+
+static int run_one(bench_run_t *run, bench_report_t *report)
+{
+    if (transport_open(run) == -1) {
+        return -1;
+    }
+    atomic_init(&run->consumed, 0);
+
+    worker_t producers[run->producers];
+    worker_t consumers[run->consumers];
+    pthread_t producer_threads[run->producers];
+    pthread_t consumer_threads[run->consumers];
+
+    uint64_t start = monotonic_ns();
+
+    for (uint32_t i = 0; i < run->consumers; i++) {
+        consumers[i].run = run;
+        consumers[i].count = 0;
+        consumers[i].hist = calloc(1, sizeof(latency_hist_t));
+        if (consumers[i].hist == NULL) {
+            perror("calloc");
+            exit(1);
+        }
+        pthread_create(&consumer_threads[i], NULL, consumer, &consumers[i]);
+    }
+    for (uint32_t i = 0; i < run->producers; i++) {
+        producers[i].run = run;
+        producers[i].count = run->messages / run->producers +
+                             (i < run->messages % run->producers ? 1 : 0);
+        producers[i].hist = NULL;
+        pthread_create(&producer_threads[i], NULL, producer, &producers[i]);
+    }
+
+    for (uint32_t i = 0; i < run->producers; i++) {
+        pthread_join(producer_threads[i], NULL);
+    }
+    if (run->transport == T_FIFO) {
+        close(run->pipe_fd[1]); // EOF para consumidores ainda bloqueados
+    }
+
+    static latency_snapshot_t snap;
+    memset(&snap, 0, sizeof(snap));
+    for (uint32_t i = 0; i < run->consumers; i++) {
+        pthread_join(consumer_threads[i], NULL);
+        latency_hist_add(&snap, consumers[i].hist);
+        free(consumers[i].hist);
+    }
+
+    double seconds = (double) (monotonic_ns() - start) / 1e9;
+    double rate = (double) run->messages / seconds;
+    transport_close(run);
+
+    printf("%-8s %6u %4u %4u %5u %12.0f %10.1f %10.1f %10.1f %10.1f\n",
+           transport_names[run->transport], run->payload, run->producers,
+           run->consumers, run->batch, rate,
+           (double) latency_percentile(&snap, 0.50) / 1e3,
+           (double) latency_percentile(&snap, 0.99) / 1e3,
+           (double) latency_percentile(&snap, 0.999) / 1e3,
+           (double) snap.max / 1e3);
+    fflush(stdout);
+
+    bench_row_begin(report);
+    bench_field_str(report, "transport", transport_names[run->transport]);
+    bench_field_u64(report, "payload", run->payload);
+    bench_field_u64(report, "producers", run->producers);
+    bench_field_u64(report, "consumers", run->consumers);
+    bench_field_u64(report, "batch", run->batch);
+    bench_field_u64(report, "messages", run->messages);
+    bench_field_f64(report, "seconds", seconds);
+    bench_field_f64(report, "msgs_per_sec", rate);
+    bench_field_latency(report, &snap);
+    bench_row_end(report);
+
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Uso: %s [-n mensagens] [-o prefixo] [-l rótulo]\n", prog);
+    fprintf(stderr, "\n  -n  mensagens por configuração (padrão: 200000)\n");
+    fprintf(stderr, "  -o  grava <prefixo>.csv e <prefixo>.json "
+                    "(padrão: bench_results/transport)\n");
+    fprintf(stderr, "  -l  rótulo da execução, ex. hash do commit "
+                    "(padrão: local)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t messages = 200000;
+    const char *prefix = "bench_results/transport";
+    const char *label = "local";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:o:l:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            messages = strtoull(optarg, NULL, 10);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (messages == 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    bench_report_t report;
+    if (bench_report_open(&report, prefix, label) == -1) {
+        exit(1);
+    }
+
+    static const uint32_t payloads[] = {sizeof(sensor_data_t), 256, 1024};
+    static const uint32_t topologies[][2] = {{1, 1}, {4, 1}, {4, 4}};
+    static const uint32_t batches[] = {1, 16, 64};
+
+    printf("%-8s %6s %4s %4s %5s %12s %10s %10s %10s %10s\n", "transp",
+           "bytes", "prod", "cons", "lote", "msgs/s", "p50 us", "p99 us",
+           "p99.9 us", "máx us");
+
+    for (int t = 0; t < T_COUNT; t++) {
+        for (size_t p = 0; p < sizeof(payloads) / sizeof(payloads[0]); p++) {
+            for (size_t k = 0; k < sizeof(topologies) / sizeof(topologies[0]);
+                 k++) {
+                for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]);
+                     b++) {
+                    if (!supported((transport_t) t, payloads[p], batches[b])) {
+                        continue;
+                    }
+                    bench_run_t run;
+                    memset(&run, 0, sizeof(run));
+                    run.transport = (transport_t) t;
+                    run.payload = payloads[p];
+                    run.producers = topologies[k][0];
+                    run.consumers = topologies[k][1];
+                    run.batch = batches[b];
+                    run.messages = messages;
+                    if (run_one(&run, &report) == -1) {
+                        fprintf(stderr, "Falha em %s (pulando)\n",
+                                transport_names[t]);
+                    }
+                }
+            }
+        }
+    }
+
+    bench_report_close(&report);
+    printf("\nResultados em %s.csv e %s.json\n", prefix, prefix);
+    return 0;
+}
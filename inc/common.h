@@ -1,7 +1,7 @@
 #ifndef COMMON_H
 #define COMMON_H
 
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
 
 #include <errno.h>
 #include <fcntl.h>
@@ -9,6 +9,8 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +30,14 @@ static inline void msleep(long milliseconds)
     nanosleep(&ts, NULL);
 }
 
+// Relógio monotônico em nanosegundos
+static inline uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
 // Cores para output (opcional)
 #define COLOR_RESET "\033[0m"
 #define COLOR_RED "\033[31m"
@@ -38,13 +48,21 @@ static inline void msleep(long milliseconds)
 #define COLOR_CYAN "\033[36m"
 
 // Constantes do sistema
-#define MAX_SENSORS 5
-#define BUFFER_SIZE 100
 #define MAX_MESSAGE_SIZE 256
 #define FIFO_SENSOR_DATA "/tmp/sensor_data_fifo"
 #define FIFO_CONTROL "/tmp/control_fifo"
 #define SHM_NAME "/sensor_system_shm"
+// Segmento em huge pages (perfil de tempo real): arquivo no hugetlbfs com o
+// nome do segmento, procurado pelos sensores quando não há o de /dev/shm
+#define SAMPLE_SHM_HUGETLB_PATH "/dev/hugepages/sensor_system_shm"
 #define MQ_NAME "/sensor_mq"
+#define MQ_PRIO_ALARM 10 // Alarmes passam à frente das leituras (prioridade 0)
+#define STATS_SHM_NAME "/sensor_stats_shm"
+#define LATENCY_SHM_NAME "/sensor_latency_shm"
+#define CONFIG_SHM_NAME "/sensor_config_shm"
+#define METRICS_SHM_NAME "/sensor_metrics_shm"
+#define RENDEZVOUS_SHM_NAME "/sensor_rendezvous_shm"
+#define HISTORY_SHM_NAME "/sensor_history_shm"
 
 // Tipos de sensores
 typedef enum {
@@ -61,29 +79,124 @@ typedef struct {
     float value;
     time_t timestamp;
     int active;
+    uint64_t t_created; // CLOCK_MONOTONIC (ns) na leitura do sensor
+    uint64_t t_ingest;  // CLOCK_MONOTONIC (ns) na entrada do data_processor
 } sensor_data_t;
 
 // Estrutura de controle
 typedef struct {
-    int command; // 0=stop, 1=start, 2=status, 3=shutdown
-    int sensor_id;
-    char message[MAX_MESSAGE_SIZE];
+    int command; // 0=stop, 1=start, 2=status, 3=shutdown, 4=latency,
+                 // 5=rate, 6=calibrate, 7=thresholds, 8=history
+    int sensor_id; // <= 0: todos os sensores (comandos 0, 1, 5, 6, 7)
+    float args[2]; // rate: Hz; calibrate: ganho, offset; thresholds: mín, máx;
+                   // history: passo em segundos (0 = leituras)
+    int64_t from_ns; // history: intervalo (ns do relógio de parede)
+    int64_t to_ns;
+    char message[MAX_MESSAGE_SIZE]; // history: FIFO de resposta ("" = log)
 } control_message_t;
 
-// Buffer circular para produtor-consumidor
-typedef struct {
-    sensor_data_t buffer[BUFFER_SIZE];
-    int read_pos;
-    int write_pos;
-    int count;
-    sem_t empty_slots;
-    sem_t full_slots;
-    pthread_mutex_t mutex;
-} circular_buffer_t;
-
 // Funções utilitárias
 void log_message(const char *color, const char *component, const char *message);
 const char *sensor_type_name(sensor_type_t type);
+float sensor_base_value(sensor_type_t type);
 void cleanup_resources(void);
 
+// Handshake de prontidão com o supervisor (main.c): a variável de ambiente
+// READY_FD_ENV traz a ponta de escrita de um pipe. notify_ready escreve um
+// byte e fecha o descritor; sem a variável (execução manual) não faz nada.
+// notify_ready_detach (opcional) tira o descritor do ambiente e o marca
+// close-on-exec, para que filhos criados antes de notify_ready não o herdem.
+#define READY_FD_ENV "SENSOR_READY_FD"
+void notify_ready_detach(void);
+void notify_ready(void);
+
+// Leitura simulada: valor base ± 2.5, com gerador xorshift32 por sensor
+// (estado de 4 bytes, sem estado global como rand())
+static inline float sensor_simulate(float base_value, uint32_t *rng_state)
+{
+    uint32_t x = *rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *rng_state = x;
+    return base_value + ((float) (x >> 8) / (float) (1u << 24)) * 5.0f - 2.5f;
+}
+
+// Futex compartilhado entre processos (palavra pode estar em memória
+// compartilhada). timeout_ms < 0 aguarda indefinidamente.
+// Retorna 0 se acordado, -1 com errno=ETIMEDOUT/EAGAIN/EINTR caso contrário.
+int futex_wait(_Atomic uint32_t *addr, uint32_t expected, long timeout_ms);
+int futex_wake(_Atomic uint32_t *addr, int count);
+
+// Instante de início do processo (campo 22 de /proc/<pid>/stat, em ticks
+// desde o boot), que distingue o processo de outro que reaproveite o pid;
+// 0 se ele não existir ou já tiver terminado (zumbi)
+uint64_t process_start_time(pid_t pid);
+
+// Envia sig a pid só se ele ainda for o processo iniciado em start_time
+// (pidfd: o sinal não pode ir a um processo que herdou o pid depois da
+// conferência). Retorna 0 se enviou, -1 caso contrário.
+int process_signal(pid_t pid, uint64_t start_time, int sig);
+
+// Segmentos de tabelas (estatísticas, latência, histórico recente): um
+// único escritor cria o segmento zerado, preenche o cabeçalho e publica a
+// magic (primeira palavra) por último; as consultas o abrem somente leitura
+// e conferem a magic e o total_bytes do cabeçalho contra o arquivo.
+static inline size_t shm_align(size_t value)
+{
+    return (value + 63) & ~(size_t) 63;
+}
+
+// Recria o segmento com total bytes (ftruncate zera). what completa as
+// mensagens de erro ("de estatísticas"). NULL em erro (com perror).
+void *shm_table_create(const char *name, size_t total, const char *what);
+void shm_table_publish(void *header, uint32_t magic);
+// total_offset = offsetof(cabeçalho, total_bytes); NULL se ausente/inválido
+void *shm_table_open(const char *name, size_t header_size, uint32_t magic,
+                     size_t total_offset);
+
+// Seqlock de escritor único: seq ímpar durante a escrita. O leitor repete a
+// cópia até seq não mudar; um escritor que morreu no meio não o trava para
+// sempre (após SEQLOCK_READ_ATTEMPTS a cópia vale como está):
+//
+//     int attempts = 0;
+//     uint32_t s;
+//     do {
+//         s = seqlock_read_begin(&seq, &attempts);
+//         ... cópia ...
+//     } while (!seqlock_read_end(&seq, s, &attempts));
+#define SEQLOCK_READ_ATTEMPTS 100000
+
+static inline uint32_t seqlock_write_begin(_Atomic uint32_t *seq)
+{
+    uint32_t s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return s;
+}
+
+static inline void seqlock_write_end(_Atomic uint32_t *seq, uint32_t start)
+{
+    atomic_store_explicit(seq, start + 2, memory_order_release);
+}
+
+static inline uint32_t seqlock_read_begin(const _Atomic uint32_t *seq,
+                                          int *attempts)
+{
+    uint32_t s;
+    while (((s = atomic_load_explicit(seq, memory_order_acquire)) & 1) &&
+           ++*attempts < SEQLOCK_READ_ATTEMPTS) {
+        // Escritor no meio da gravação
+    }
+    return s;
+}
+
+static inline int seqlock_read_end(const _Atomic uint32_t *seq,
+                                   uint32_t start, int *attempts)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(seq, memory_order_relaxed) == start ||
+           ++*attempts >= SEQLOCK_READ_ATTEMPTS;
+}
+
 #endif // COMMON_H
@@ -0,0 +1,92 @@
+#ifndef GORILLA_H
+#define GORILLA_H
+
+#include "common.h"
+
+// Compressão de séries de amostras no estilo Gorilla (Pelkonen et al., 2015).
+//
+// Inteiros (timestamps, IDs) são codificados como delta-do-delta: séries
+// regulares custam 1 bit por valor e o jitter de agendamento cabe nas faixas
+// curtas. Floats são codificados pelo XOR com o valor anterior: valor igual
+// custa 1 bit; se os bits significativos do XOR cabem na janela do anterior,
+// só eles vão; senão vai a nova janela (zeros à esquerda + tamanho).
+//
+//   delta-do-delta  '0'             igual
+//                   '10'   + 8 bits [-127, 128]
+//                   '110'  + 20 bits (±0.5 ms em ns)
+//                   '1110' + 32 bits
+//                   '1111' + 64 bits
+//
+// Dois formatos usam os mesmos primitivos:
+//   série    timestamps + valores de um sensor (blocos do histórico, tsdb.c)
+//   amostras sensor_data_t completos de vários sensores (quadros do
+//            transporte FIFO compactado e da rede); t_ingest não é
+//            transmitido
+
+// Pior caso por amostra, para dimensionar buffers
+#define GORILLA_SERIES_MAX_BITS 113   // 68 (tempo) + 45 (valor)
+#define GORILLA_SAMPLE_MAX_BITS 320   // id, tipo, ativo, 2 tempos, valor
+#define GORILLA_MAX_BYTES(n, bits) ((((size_t) (n) * (bits)) + 7) / 8 + 8)
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;   // Bytes
+    size_t bits;  // Bits escritos
+    int overflow; // 1 se algo não coube
+} gorilla_writer_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t bits; // Bits lidos
+    int error;   // 1 se leu além do fim
+} gorilla_reader_t;
+
+// Estado de uma coluna (o mesmo dos dois lados)
+typedef struct {
+    int64_t prev;
+    int64_t prev_delta;
+    uint32_t n;
+} gorilla_int_t;
+
+typedef struct {
+    uint32_t prev;
+    uint8_t leading;
+    uint8_t meaningful; // 0 = ainda sem janela
+    uint32_t n;
+} gorilla_float_t;
+
+void gorilla_writer_init(gorilla_writer_t *w, uint8_t *buf, size_t cap);
+void gorilla_reader_init(gorilla_reader_t *r, const uint8_t *buf, size_t len);
+
+// Bytes usados (último byte parcial incluso)
+static inline size_t gorilla_writer_bytes(const gorilla_writer_t *w)
+{
+    return (w->bits + 7) / 8;
+}
+
+void gorilla_put_int(gorilla_writer_t *w, gorilla_int_t *state, int64_t v);
+int64_t gorilla_get_int(gorilla_reader_t *r, gorilla_int_t *state);
+void gorilla_put_float(gorilla_writer_t *w, gorilla_float_t *state, float v);
+float gorilla_get_float(gorilla_reader_t *r, gorilla_float_t *state);
+
+// Série de n pontos; retorna os bytes escritos ou 0 se não couber em cap
+size_t gorilla_encode_series(const int64_t *ts, const float *values,
+                             uint32_t n, uint8_t *out, size_t cap);
+// Retorna 0 ou -1 se os dados estiverem truncados
+int gorilla_decode_series(const uint8_t *in, size_t len, uint32_t n,
+                          int64_t *ts, float *values);
+
+// Lote de amostras (qualquer mistura de sensores; comprime melhor com
+// amostras do mesmo instante e IDs em sequência)
+size_t gorilla_encode_samples(const sensor_data_t *items, uint32_t n,
+                              uint8_t *out, size_t cap);
+// Codifica o maior prefixo do lote que cabe em cap (quadros de tamanho
+// fixo); *count recebe quantas amostras entraram
+size_t gorilla_encode_samples_prefix(const sensor_data_t *items, uint32_t n,
+                                     uint8_t *out, size_t cap,
+                                     uint32_t *count);
+int gorilla_decode_samples(const uint8_t *in, size_t len, uint32_t n,
+                           sensor_data_t *out);
+
+#endif // GORILLA_H
@@ -0,0 +1,102 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "common.h"
+#include "stats.h"
+
+// Histórico recente por sensor em memória compartilhada (HISTORY_SHM_NAME),
+// para consultas de intervalo sem ir ao disco ("o que o sensor 3 leu nos
+// últimos 5 minutos?").
+//
+// Cada sensor com dados ocupa uma entrada de tamanho fixo, reservada na
+// primeira amostra (o mapa sensor_id → entrada fica no cabeçalho):
+//
+//   leituras   ring das últimas HISTORY_RAW_POINTS leituras (tempo, valor)
+//   1 s        HISTORY_SEC_BUCKETS baldes de 1 s (mín/máx/soma/contagem)
+//   1 min      HISTORY_MIN_BUCKETS baldes de 1 min
+//   1 h        HISTORY_HOUR_BUCKETS baldes de 1 h
+//
+// Os baldes são identificados pelo epoch (segundos, minutos ou horas do
+// relógio de parede) e indexados por epoch % quantidade, como as janelas de
+// stats.h: um balde antigo é reaproveitado quando o tempo dá a volta.
+//
+// Cada sensor tem um único escritor (o consumidor do seu shard), então a
+// gravação não usa locks; leitores copiam sob o seqlock da entrada e tentam
+// de novo se coincidirem com uma gravação, sem nunca atrasar o escritor. A
+// busca nas leituras é binária (tempos crescentes no ring): uma consulta
+// custa O(log n + k) para k linhas devolvidas.
+
+#define HISTORY_DEFAULT_SENSORS 4096 // Entradas do segmento
+#define HISTORY_RAW_POINTS 1024      // Potência de 2
+#define HISTORY_SEC_BUCKETS 600      // 10 min
+#define HISTORY_MIN_BUCKETS 720      // 12 h
+#define HISTORY_HOUR_BUCKETS 336     // 14 dias
+#define HISTORY_LEVELS 3
+#define HISTORY_QUERY_MAX 4096 // Linhas por consulta
+
+// Mesmo balde das janelas de stats.h (stats_bucket_add)
+typedef stats_bucket_t history_bucket_t;
+
+typedef struct {
+    _Atomic uint32_t seq; // Seqlock da entrada
+    int32_t sensor_id;
+    uint32_t type;     // sensor_type_t da última leitura
+    uint32_t reserved;
+    uint64_t head;     // Leituras gravadas desde o início
+    int64_t ts[HISTORY_RAW_POINTS]; // ns do relógio de parede
+    float values[HISTORY_RAW_POINTS];
+    history_bucket_t sec[HISTORY_SEC_BUCKETS];
+    history_bucket_t min[HISTORY_MIN_BUCKETS];
+    history_bucket_t hour[HISTORY_HOUR_BUCKETS];
+} history_slot_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity;     // sensor_id < capacity
+    uint32_t nslots;       // Entradas disponíveis
+    _Atomic uint32_t used; // Entradas já reservadas
+    _Atomic uint64_t overflow; // Amostras de sensores sem entrada livre
+    int64_t clock_offset;  // Relógio de parede - monotônico (ns)
+    uint64_t total_bytes;
+    uint64_t slots_offset;
+    // Mapa sensor_id → entrada + 1 (0 = sem entrada)
+    _Alignas(64) _Atomic uint32_t slot_of[];
+} history_shm_t;
+
+// Linha de resposta: uma leitura (count = 1) ou um balde agregado
+typedef struct {
+    int64_t t_ns; // Leitura ou início do balde
+    uint32_t count;
+    float min;
+    float max;
+    float avg;
+} history_row_t;
+
+typedef struct {
+    sensor_type_t type;
+    uint32_t rows;
+    uint32_t step_s; // Resolução usada (0 = leituras brutas)
+    int truncated;   // O intervalo tinha mais linhas que o limite
+} history_result_t;
+
+// data_processor: cria (recriando) o segmento. nslots = 0 usa o padrão.
+history_shm_t *history_shm_create(uint32_t capacity, uint32_t nslots);
+
+// Leitores: mapeia o segmento existente (somente leitura); NULL se ausente
+history_shm_t *history_shm_open(void);
+
+void history_shm_close(history_shm_t *shm);
+
+// Caminho quente (único escritor por sensor)
+void history_record(history_shm_t *shm, const sensor_data_t *data);
+
+// Consulta [from_ns, to_ns] (relógio de parede). step_s = 0 devolve as
+// leituras do ring; senão baldes de step_s segundos, montados a partir do
+// nível mais grosso que caiba no passo e alcance from_ns (o passo usado
+// pode ser maior que o pedido). Retorna 0 ou -1 se o sensor não tem
+// histórico.
+int history_query(const history_shm_t *shm, int sensor_id, int64_t from_ns,
+                  int64_t to_ns, uint32_t step_s, history_row_t *rows,
+                  uint32_t max_rows, history_result_t *result);
+
+#endif // HISTORY_H
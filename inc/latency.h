@@ -0,0 +1,96 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "common.h"
+
+// Histogramas de latência fim a fim (sensor → consumidor).
+//
+// Cada amostra carrega carimbos CLOCK_MONOTONIC (comum a todos os processos)
+// de criação e de ingestão; o consumidor acrescenta retirada e fim do
+// processamento e registra cada etapa em histogramas log-lineares (estilo
+// HDR): 32 sub-baldes por potência de 2, erro relativo < 3,2% de 1 ns a
+// ~18 min. Há uma tabela por consumidor (único escritor, contadores atômicos
+// relaxados) em memória compartilhada (LATENCY_SHM_NAME); leitores somam as
+// tabelas sob demanda.
+
+#define LATENCY_SUB_BITS 5
+#define LATENCY_SUB_COUNT (1u << LATENCY_SUB_BITS)
+#define LATENCY_MAX_EXP 39 // Valores acima de 2^40 ns são saturados
+#define LATENCY_BUCKETS \
+    ((LATENCY_MAX_EXP - LATENCY_SUB_BITS + 2) * LATENCY_SUB_COUNT)
+
+typedef enum {
+    LATENCY_CREATE_INGEST = 0, // Criação no sensor → entrada no ring/FIFO
+    LATENCY_INGEST_DEQUEUE,    // Espera na fila do shard
+    LATENCY_DEQUEUE_DONE,      // Processamento no consumidor
+    LATENCY_TOTAL,             // Criação → fim do processamento
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+    _Atomic uint64_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+// Tabela de um consumidor: etapa x tipo de sensor
+typedef struct {
+    latency_hist_t hist[LATENCY_STAGE_COUNT][SENSOR_TYPE_COUNT];
+} latency_table_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t ntables;
+    uint64_t total_bytes;
+    uint64_t table_offset;
+} latency_shm_t;
+
+// Cópia somada de um ou mais histogramas
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[LATENCY_BUCKETS];
+} latency_snapshot_t;
+
+// data_processor: cria (recriando) o segmento com ntables tabelas
+latency_shm_t *latency_shm_create(uint32_t ntables);
+
+// Leitores: mapeia o segmento existente (somente leitura); NULL se ausente
+latency_shm_t *latency_shm_open(void);
+
+void latency_shm_close(latency_shm_t *shm);
+
+static inline latency_table_t *latency_table(latency_shm_t *shm,
+                                             uint32_t index)
+{
+    return (latency_table_t *) ((char *) shm + shm->table_offset) + index;
+}
+
+const char *latency_stage_name(latency_stage_t stage);
+
+// Caminho quente (único escritor por tabela): registra todas as etapas de
+// uma amostra já processada. Carimbos ausentes (zero) são ignorados.
+void latency_record_sample(latency_table_t *table, const sensor_data_t *data,
+                           uint64_t t_dequeue, uint64_t t_done);
+
+// Histograma avulso (benchmarks, ferramentas): registro por único escritor
+// e soma em um snapshot (que deve começar zerado)
+void latency_hist_record(latency_hist_t *hist, uint64_t ns);
+void latency_hist_add(latency_snapshot_t *out, const latency_hist_t *hist);
+
+// Soma a etapa de todas as tabelas; type < 0 inclui todos os tipos
+void latency_collect(latency_shm_t *shm, latency_stage_t stage, int type,
+                     latency_snapshot_t *out);
+
+// Valor (ns) no quantil q em [0, 1]; 0 se vazio
+uint64_t latency_percentile(const latency_snapshot_t *snap, double q);
+
+// Resumo legível: n, p50/p99/p99.9/máx e média em microssegundos
+void latency_format(const latency_snapshot_t *snap, char *buf, size_t len);
+
+// Registra no log uma linha por etapa e o total por tipo de sensor
+void latency_log_summary(latency_shm_t *shm, const char *component);
+
+#endif // LATENCY_H
@@ -0,0 +1,90 @@
+#ifndef LIVE_CONFIG_H
+#define LIVE_CONFIG_H
+
+#include "common.h"
+
+// Configuração dinâmica por sensor em memória compartilhada
+// (CONFIG_SHM_NAME): habilitado, taxa de amostragem, calibração e limites de
+// alarme. A control_interface é a única escritora; sensores, hospedeiros e o
+// data_processor leem a entrada do sensor a cada iteração.
+//
+// Cada entrada é protegida por um seqlock: o leitor não bloqueia nem escreve
+// na linha do escritor. Se a entrada estiver em atualização, o leitor mantém
+// a configuração anterior e tenta de novo na próxima iteração, então a
+// leitura tem custo limitado (wait-free). seq == 0 significa "nunca
+// configurado": valem os padrões do processo.
+//
+// Qualquer processo cria o segmento se ele ainda não existir (tamanho fixo,
+// zerado pelo kernel), então a ordem de inicialização não importa.
+
+#define LIVE_CONFIG_MAX_SENSORS 65536 // sensor_id < LIVE_CONFIG_MAX_SENSORS
+
+#define LIVE_HAS_LOW 0x1u
+#define LIVE_HAS_HIGH 0x2u
+
+typedef struct {
+    _Atomic uint32_t seq;
+    uint32_t enabled;
+    float rate_hz; // 0 = taxa de linha de comando do processo
+    float gain;    // Calibração: valor * gain + offset
+    float offset;
+    float low; // Limites de alarme (válidos conforme flags)
+    float high;
+    uint32_t flags;
+} live_sensor_cfg_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity;
+    uint64_t total_bytes;
+    _Alignas(64) live_sensor_cfg_t sensors[];
+} live_config_t;
+
+// Cópia local lida pelos processos
+typedef struct {
+    uint32_t seq; // Última versão aplicada (0 = padrões)
+    int enabled;
+    float rate_hz;
+    float gain;
+    float offset;
+    float low;
+    float high;
+    uint32_t flags;
+} live_sensor_view_t;
+
+// Mapeia (criando se preciso) o segmento; NULL em erro
+live_config_t *live_config_open(void);
+void live_config_close(live_config_t *cfg);
+
+// Padrões: habilitado, taxa do processo, sem calibração nem limites
+void live_view_defaults(live_sensor_view_t *view);
+
+// Atualiza view se a entrada do sensor mudou desde view->seq. Retorna 1 se
+// a view mudou, 0 caso contrário (inclui entrada em atualização agora).
+int live_config_poll(live_config_t *cfg, int sensor_id,
+                     live_sensor_view_t *view);
+
+// Escritor (control_interface). sensor_id <= 0 aplica a todos os sensores.
+// A função recebe a entrada atual e a altera; ctx é repassado.
+typedef void (*live_config_edit_fn)(live_sensor_view_t *view, void *ctx);
+int live_config_edit(live_config_t *cfg, int sensor_id,
+                     live_config_edit_fn edit, void *ctx);
+
+// Aplica a calibração e verifica limites: retorna -1 abaixo, 1 acima, 0 ok
+static inline float live_calibrate(const live_sensor_view_t *view, float v)
+{
+    return v * view->gain + view->offset;
+}
+
+static inline int live_check_limits(const live_sensor_view_t *view, float v)
+{
+    if ((view->flags & LIVE_HAS_LOW) && v < view->low) {
+        return -1;
+    }
+    if ((view->flags & LIVE_HAS_HIGH) && v > view->high) {
+        return 1;
+    }
+    return 0;
+}
+
+#endif // LIVE_CONFIG_H
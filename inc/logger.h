@@ -0,0 +1,68 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "common.h"
+
+#include <stdarg.h>
+
+// Subsistema de log assíncrono.
+//
+// Quem chama apenas copia um registro binário de tamanho fixo (nível,
+// componente, timestamp, formato e argumentos) para um ring SPSC lock-free
+// da própria thread; não há formatação, alocação nem syscall no caminho
+// quente. Uma thread escritora em segundo plano formata os registros e os
+// escreve em lotes no stdout. Se o ring da thread estiver cheio ou o limite
+// de taxa for excedido, o registro é descartado e contado.
+//
+// Variáveis de ambiente:
+//   SENSOR_LOG_LEVEL  debug|info|warn|error (padrão: info)
+//   SENSOR_LOG_RATE   registros/s por thread (padrão: 1000, 0 = sem limite)
+
+typedef enum { LOG_DEBUG = 0, LOG_INFO, LOG_WARN, LOG_ERROR } log_level_t;
+
+#define LOG_MAX_ARGS 12
+#define LOG_STR_BYTES 256
+#define LOG_COMPONENT_BYTES 24
+#define LOG_RING_RECORDS 128
+#define LOG_MAX_THREADS 64
+
+// Argumento capturado: inteiros/ponteiros, ponto flutuante ou string copiada
+// para strbuf (deslocamento)
+typedef union {
+    long long i;
+    unsigned long long u;
+    double d;
+    uint16_t str_offset;
+} log_arg_t;
+
+typedef struct {
+    uint64_t timestamp_ns; // CLOCK_REALTIME
+    const char *color;
+    const char *fmt; // Deve ser literal (não é copiado)
+    uint8_t level;
+    uint8_t nargs;
+    uint16_t str_used;
+    char component[LOG_COMPONENT_BYTES];
+    log_arg_t args[LOG_MAX_ARGS];
+    char strbuf[LOG_STR_BYTES];
+} log_record_t;
+
+// Registra um evento. fmt segue printf (%d %i %u %x %o %c %f %g %e %s %p
+// com flags/largura/precisão e modificadores hh/h/l/ll/z/j); strings %s são
+// copiadas para o registro, então podem apontar para buffers temporários.
+void log_event(log_level_t level, const char *color, const char *component,
+               const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+void log_eventv(log_level_t level, const char *color, const char *component,
+                const char *fmt, va_list ap);
+
+// Nível mínimo registrado (eventos abaixo dele são descartados na origem)
+void log_set_level(log_level_t level);
+int log_enabled(log_level_t level);
+
+// Força a escrita de todos os registros pendentes
+void log_flush(void);
+
+// Total de registros descartados (ring cheio + limite de taxa)
+uint64_t log_dropped_total(void);
+
+#endif // LOGGER_H
@@ -0,0 +1,103 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "common.h"
+
+// Métricas ao vivo em memória compartilhada (METRICS_SHM_NAME). Cada
+// componente (ou thread) registra um slot próprio e publica contadores e
+// medidores nele; o sensor_top lê os slots diretamente, sem enviar comandos
+// nem tocar no caminho dos dados.
+//
+// Cada valor tem um único escritor (a thread dona do slot), então a
+// atualização é um load + store relaxados, sem instrução atômica de
+// leitura-modificação-escrita. Os leitores podem ver valores de instantes
+// ligeiramente diferentes entre campos, o que basta para monitoração.
+
+#define METRICS_MAX_SLOTS 256
+#define METRICS_NAME_LEN 32
+
+typedef enum {
+    METRIC_SAMPLES_SENT = 0, // Amostras publicadas no transporte
+    METRIC_SAMPLES_RECEIVED, // Amostras ingeridas/processadas
+    METRIC_SAMPLES_DROPPED,  // Amostras descartadas
+    METRIC_RING_FULL,        // Envios que encontraram o ring cheio
+    METRIC_MQ_SENT,          // Mensagens enviadas à fila POSIX
+    METRIC_MQ_DROPPED,       // mq_send com fila cheia (EAGAIN)
+    METRIC_MQ_RECEIVED,      // Mensagens recebidas da fila POSIX
+    METRIC_QUEUE_DEPTH,      // Medidor: ocupação do ring do consumidor
+    METRIC_ALARMS,           // Amostras fora dos limites configurados
+    METRIC_COMMANDS,         // Comandos de controle tratados
+    METRIC_CHILDREN_STARTED, // Processos filhos criados
+    METRIC_CHILD_EXITS,      // Processos filhos terminados
+    METRIC_RESTARTS,         // Componentes reiniciados após falha
+    METRIC_STARTUP_US,       // Partida da frota até todos conectados (µs)
+    METRIC_DROPPED_NEWEST,   // Sobrecarga: descartes por motivo, na ordem
+    METRIC_DROPPED_OLDEST,   // de overload_drop_t
+    METRIC_DROPPED_COALESCED,
+    METRIC_DROPPED_SAMPLED,
+    METRIC_OVERLOAD_EVENTS,  // Marca alta do ring cruzada
+    METRIC_RULE_ALARMS,      // Alarmes disparados pelas regras
+    METRIC_PERSISTED,        // Amostras entregues ao histórico
+    METRIC_PERSIST_DROPPED,  // Fora do histórico (ring de persistência cheio)
+    METRIC_BACKLOG,          // Medidor: fila local do sensor sem leitor
+    METRIC_NET_LOST,         // Quadros que faltaram na sequência (rede)
+    METRIC_COUNT
+} metric_id_t;
+
+typedef struct {
+    _Alignas(64) _Atomic int32_t owner; // PID dono (0 = livre)
+    _Atomic uint32_t ready;             // Nome e início válidos
+    char name[METRICS_NAME_LEN];
+    uint64_t started_ns;           // CLOCK_MONOTONIC do registro
+    _Atomic uint64_t last_seen_ns; // Última atualização (metrics_touch)
+    _Atomic uint64_t values[METRIC_COUNT];
+} metrics_slot_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t nslots;
+    uint64_t total_bytes;
+    metrics_slot_t slots[METRICS_MAX_SLOTS];
+} metrics_shm_t;
+
+// Registra um slot para o componente (mapeando o segmento na primeira
+// chamada do processo). Slots de processos mortos são reaproveitados.
+// Retorna NULL se o segmento ou os slots não estiverem disponíveis; as
+// funções de escrita aceitam NULL e não fazem nada.
+metrics_slot_t *metrics_register(const char *name);
+void metrics_unregister(metrics_slot_t *slot);
+
+// Leitor (sensor_top): mapeia somente leitura; NULL se não existir
+const metrics_shm_t *metrics_shm_open_readonly(void);
+void metrics_shm_close(const metrics_shm_t *shm);
+
+// Nome curto da métrica para exibição
+const char *metrics_name(metric_id_t id);
+
+static inline void metrics_add(metrics_slot_t *slot, metric_id_t id,
+                               uint64_t n)
+{
+    if (slot != NULL) {
+        uint64_t v =
+            atomic_load_explicit(&slot->values[id], memory_order_relaxed);
+        atomic_store_explicit(&slot->values[id], v + n, memory_order_relaxed);
+    }
+}
+
+static inline void metrics_set(metrics_slot_t *slot, metric_id_t id,
+                               uint64_t value)
+{
+    if (slot != NULL) {
+        atomic_store_explicit(&slot->values[id], value, memory_order_relaxed);
+    }
+}
+
+static inline void metrics_touch(metrics_slot_t *slot, uint64_t now_ns)
+{
+    if (slot != NULL) {
+        atomic_store_explicit(&slot->last_seen_ns, now_ns,
+                              memory_order_relaxed);
+    }
+}
+
+#endif // METRICS_H
@@ -0,0 +1,114 @@
+#ifndef NET_H
+#define NET_H
+
+#include "common.h"
+
+#include <netinet/in.h>
+
+// Ingestão pela rede: sensores em outros nós enviam amostras ao
+// data_processor por UDP (datagramas) ou TCP (fluxo de quadros).
+//
+// Cada quadro leva um cabeçalho net_frame_t seguido das amostras compactadas
+// com gorilla_encode_samples (independente da ordem de bytes do nó). Um
+// datagrama UDP é exatamente um quadro, de até NET_DATAGRAM_BYTES para não
+// fragmentar em enlaces Ethernet; no TCP os quadros vêm em sequência no
+// fluxo. O emissor escolhe um identificador ao abrir e numera seus quadros:
+// o receptor detecta por emissor quadros perdidos (lacuna na sequência) e
+// atrasados ou repetidos (sequência que volta).
+//
+// O receptor é não bloqueante e guiado por epoll: um socket UDP, lido em
+// rajadas com recvmmsg, e um socket TCP de escuta com as conexões aceitas,
+// todos na mesma porta. As amostras decodificadas seguem para os mesmos
+// rings de shard que as do FIFO.
+//
+// Endereço: SENSOR_NET_ADDR ("host:porta") ou NET_DEFAULT_ADDR, usado pelos
+// sensores para conectar e pelo data_processor para escutar (0.0.0.0:porta
+// aceita outros nós).
+
+#define NET_ADDR_ENV "SENSOR_NET_ADDR"
+#define NET_DEFAULT_ADDR "127.0.0.1:7700"
+
+#define NET_FRAME_MAGIC 0x3154454eu // "NET1"
+#define NET_FRAME_MAX_SAMPLES 256
+// Datagrama: payload UDP máximo num quadro Ethernet de 1500 bytes
+#define NET_DATAGRAM_BYTES 1472
+// Datagramas por recvmmsg e por sendmmsg
+#define NET_RECV_BATCH 64
+#define NET_SEND_BATCH 32
+// Amostras que cabem numa chamada a net_receiver_poll (pior caso)
+#define NET_POLL_SAMPLES (NET_RECV_BATCH * NET_FRAME_MAX_SAMPLES)
+#define NET_MAX_CONNECTIONS 256
+// Buffer de recepção pedido para o socket UDP (limitado por rmem_max)
+#define NET_RCVBUF_BYTES (4 * 1024 * 1024)
+// Conexão TCP perdida: no máximo uma tentativa de reconectar por intervalo
+#define NET_RECONNECT_MS 500
+
+// Cabeçalho de um quadro, campos em ordem de rede
+typedef struct {
+    uint32_t magic;
+    uint32_t sender; // Identificador do emissor (aleatório, por abertura)
+    uint32_t seq;    // Quadros do emissor, a partir de 0
+    uint16_t count;  // Amostras no quadro (1..NET_FRAME_MAX_SAMPLES)
+    uint16_t bytes;  // Bytes após o cabeçalho
+} net_frame_t;
+
+// Converte "host:porta" (nome ou IPv4); -1 se inválido ou não resolvido
+int net_addr_parse(const char *spec, struct sockaddr_in *addr);
+
+// SENSOR_NET_ADDR ou NET_DEFAULT_ADDR
+const char *net_addr_default(void);
+
+// Lado dos sensores
+typedef struct {
+    int fd;     // -1 = desconectado (TCP: reconecta no próximo envio)
+    int stream; // TCP
+    struct sockaddr_in addr;
+    uint32_t sender;
+    uint32_t seq;
+    uint64_t reconnect_ns; // Próxima tentativa de reconectar
+} net_sender_t;
+
+// Abre o socket para addr. No TCP tenta conectar até timeout_ms (recusado =
+// data_processor ainda não escuta). Retorna -1 em erro.
+int net_sender_open(net_sender_t *sender, const char *addr, int stream,
+                    long timeout_ms);
+
+// Envia n amostras em quadros (UDP: vários datagramas por sendmmsg). Retorna
+// quantas foram entregues ao kernel; o resto não pôde ser enviado (sem
+// receptor, buffer cheio ou conexão perdida) e se perdeu.
+uint32_t net_sender_send(net_sender_t *sender, const sensor_data_t *items,
+                         uint32_t n);
+void net_sender_close(net_sender_t *sender);
+
+// Lado do data_processor
+typedef struct {
+    uint64_t datagrams;   // Datagramas UDP recebidos
+    uint64_t frames;      // Quadros aceitos (UDP e TCP)
+    uint64_t samples;     // Amostras decodificadas
+    uint64_t bytes;       // Bytes recebidos
+    uint64_t lost;        // Quadros que faltaram na sequência de um emissor
+    uint64_t late;        // Quadros atrasados ou repetidos (aceitos)
+    uint64_t invalid;     // Datagramas ou quadros malformados (descartados)
+    uint64_t connections; // Conexões TCP aceitas
+    uint64_t senders;     // Emissores distintos vistos
+} net_stats_t;
+
+typedef struct net_receiver net_receiver_t;
+
+// Escuta UDP e TCP em addr; NULL em erro (errno do bind/listen)
+net_receiver_t *net_receiver_open(const char *addr);
+
+// Aguarda até timeout_ms e decodifica o que chegou em out (max >=
+// NET_POLL_SAMPLES). Retorna as amostras, 0 se nada chegou ou -1 em erro.
+// Amostras de um emissor saem na ordem em que os quadros chegaram.
+int net_receiver_poll(net_receiver_t *rx, sensor_data_t *out, uint32_t max,
+                      int timeout_ms);
+
+// Interrompe a espera de net_receiver_poll (encerramento, outra thread)
+void net_receiver_wake(net_receiver_t *rx);
+
+// Contadores acumulados (mesma thread de net_receiver_poll)
+void net_receiver_stats(const net_receiver_t *rx, net_stats_t *stats);
+void net_receiver_close(net_receiver_t *rx);
+
+#endif // NET_H
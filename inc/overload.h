@@ -0,0 +1,130 @@
+#ifndef OVERLOAD_H
+#define OVERLOAD_H
+
+#include "common.h"
+#include "ring.h"
+
+// Políticas de sobrecarga do ring de ingestão.
+//
+// Quando os consumidores ficam para trás, BLOCK faz o produtor esperar por
+// espaço (comportamento original: uma etapa lenta trava todos os sensores).
+// As demais políticas nunca bloqueiam e trocam fidelidade por fluxo:
+//   DROP_NEWEST  descarta a amostra que chega com o ring cheio
+//   DROP_OLDEST  retira a amostra mais antiga do ring para abrir espaço
+//   COALESCE     retém no produtor só a amostra mais recente de cada sensor
+//                e a publica quando houver espaço
+//   SAMPLE       acima da marca alta aceita cada amostra com probabilidade p
+//                (e descarta a nova se o ring ainda assim estiver cheio)
+//
+// A política vale para o segmento inteiro e é escolhida pelo data_processor;
+// os produtores (sensores e a thread do FIFO) a leem do cabeçalho. Cada
+// descarte é contado exatamente, por motivo, no shard em que ocorreu.
+
+typedef enum {
+    OVERLOAD_BLOCK = 0,
+    OVERLOAD_DROP_NEWEST,
+    OVERLOAD_DROP_OLDEST,
+    OVERLOAD_COALESCE,
+    OVERLOAD_SAMPLE,
+    OVERLOAD_POLICY_COUNT
+} overload_policy_t;
+
+// Motivos de descarte
+typedef enum {
+    OVERLOAD_DROPPED_NEWEST = 0, // Ring cheio: amostra nova descartada
+    OVERLOAD_DROPPED_OLDEST,     // Amostra antiga retirada do ring
+    OVERLOAD_DROPPED_COALESCED,  // Substituída por outra mais recente
+    OVERLOAD_DROPPED_SAMPLED,    // Rejeitada pela amostragem
+    OVERLOAD_DROP_COUNT
+} overload_drop_t;
+
+// Marcas padrão, em % da capacidade do ring
+#define OVERLOAD_HIGH_PCT 75
+#define OVERLOAD_LOW_PCT 25
+
+// Configuração publicada no cabeçalho do segmento de amostras
+typedef struct {
+    uint32_t policy;      // overload_policy_t
+    uint32_t sample_prob; // SAMPLE: probabilidade de aceitar, em 1/65536
+    uint32_t high_mark;   // Ocupação (amostras) que sinaliza sobrecarga
+    uint32_t low_mark;    // Ocupação em que a sobrecarga termina
+} overload_config_t;
+
+// Contadores por shard no segmento compartilhado. Os descartes têm vários
+// escritores (fetch_add, só no caminho de sobrecarga); o estado das marcas
+// tem um único escritor, o consumidor do shard.
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t drops[OVERLOAD_DROP_COUNT];
+    _Atomic uint32_t overloaded;  // 1 entre a marca alta e a baixa
+    _Atomic uint32_t high_events; // Vezes em que a marca alta foi cruzada
+} overload_shard_t;
+
+// Converte "block", "drop-newest", "drop-oldest", "coalesce" ou
+// "sample[:p]" (p em (0, 1], padrão 0.1); retorna -1 se inválido
+int overload_parse(const char *spec, overload_config_t *config);
+
+// Política padrão: variável de ambiente SENSOR_OVERLOAD ou BLOCK
+void overload_config_default(overload_config_t *config);
+
+// Marcas a partir da capacidade do ring
+void overload_set_marks(overload_config_t *config, uint32_t capacity);
+
+const char *overload_policy_name(overload_policy_t policy);
+const char *overload_drop_name(overload_drop_t reason);
+
+// Formata a política ("sample:0.25", "coalesce", ...)
+void overload_format(const overload_config_t *config, char *buf, size_t len);
+
+// Amostras retidas pela política COALESCE: tabela hash aberta por
+// sensor_id com no máximo uma amostra (a mais recente) por sensor. Cresce
+// sob demanda; um produtor com um único sensor usa uma entrada.
+typedef struct {
+    sensor_data_t *items;
+    uint8_t *state; // 0 = livre, 1 = ocupado, 2 = removido
+    uint32_t capacity; // Potência de 2 (0 = ainda não alocada)
+    uint32_t count;
+    uint32_t tombstones;
+} coalesce_table_t;
+
+// Insere ou substitui a amostra do sensor. Retorna 1 se substituiu uma
+// amostra retida (um descarte por coalescência), 0 se inseriu e -1 se
+// faltou memória.
+int coalesce_put(coalesce_table_t *table, const sensor_data_t *data);
+
+// Substitui a amostra retida do sensor, se houver: 1 se substituiu, 0 se o
+// sensor não tem amostra retida
+int coalesce_replace(coalesce_table_t *table, const sensor_data_t *data);
+
+// Chama publish para cada amostra retida, em ordem de slot, e remove as
+// que foram publicadas (publish retorna 1). Para na primeira recusa.
+// Retorna quantas foram publicadas.
+typedef int (*coalesce_publish_fn)(const sensor_data_t *data, void *ctx);
+uint32_t coalesce_drain(coalesce_table_t *table, coalesce_publish_fn publish,
+                        void *ctx);
+
+void coalesce_free(coalesce_table_t *table);
+
+// Estado de um produtor: gerador da amostragem, amostras retidas e
+// descartes feitos por ele (para as métricas do componente)
+typedef struct {
+    uint32_t rng;
+    coalesce_table_t pending;
+    uint64_t drops[OVERLOAD_DROP_COUNT];
+} overload_state_t;
+
+void overload_state_init(overload_state_t *state, uint32_t seed);
+void overload_state_free(overload_state_t *state);
+
+// SAMPLE: sorteia se a amostra entra (xorshift32)
+static inline int overload_sample_accept(overload_state_t *state,
+                                         uint32_t prob)
+{
+    uint32_t x = state->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state->rng = x;
+    return (x >> 16) < prob;
+}
+
+#endif // OVERLOAD_H
@@ -0,0 +1,109 @@
+#ifndef RING_H
+#define RING_H
+
+#include "common.h"
+
+#define CACHE_LINE_SIZE 64
+
+// sensor_id de um slot abandonado por um produtor morto (ring_recover);
+// nunca sai das funções de retirada (ring_try_pop, ring_pop_batch, ...)
+#define RING_SLOT_ABANDONED INT32_MIN
+
+// Bit da palavra futex que indica alguém dormindo nela; os eventos avançam a
+// palavra de RING_EVENT em RING_EVENT para não tocar nesse bit
+#define RING_SLEEPERS 1u
+#define RING_EVENT 2u
+
+// Bit de seq enquanto o produtor dono da reserva escreve o slot
+#define RING_SEQ_WRITING (1ull << 63)
+
+// Buffer circular lock-free limitado (MPMC) para amostras de sensores.
+//
+// Cada slot carrega um número de sequência: o produtor só escreve no slot
+// quando seq == posição, e o consumidor só lê quando seq == posição + 1.
+// Depois de reservar (CAS em head), o produtor confirma a posse de cada slot
+// com um CAS de posição para posição | RING_SEQ_WRITING antes de escrever:
+// se ring_recover tomou a reserva nesse meio tempo, o CAS falha, o produtor
+// não toca no slot e repete o envio em outra posição.
+// head/tail ficam em linhas de cache separadas para que produtores e
+// consumidores não disputem a mesma linha. Os futexes só são usados quando
+// o buffer está vazio (consumidores) ou cheio (produtores): quem vai dormir
+// liga RING_SLEEPERS na palavra, e só o primeiro evento seguinte paga a
+// syscall de wake (desligando o bit); os demais seguem sem syscall.
+//
+// A estrutura não contém ponteiros e pode ser colocada em memória
+// compartilhada entre processos.
+typedef struct {
+    _Atomic uint64_t seq;
+    sensor_data_t data;
+} ring_slot_t;
+
+typedef struct {
+    uint32_t capacity; // Sempre potência de 2
+    uint32_t mask;
+
+    // Próxima posição de escrita (produtores)
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t head;
+
+    // Próxima posição de leitura (consumidores)
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t tail;
+
+    // Palavras futex: bit 0 = RING_SLEEPERS, demais bits contam eventos
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint32_t not_empty;
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint32_t not_full;
+
+    _Alignas(CACHE_LINE_SIZE) ring_slot_t slots[];
+} sample_ring_t;
+
+// Arredonda para a próxima potência de 2
+uint32_t ring_round_capacity(uint32_t n);
+
+// Tamanho em bytes de um ring com a capacidade dada (já arredondada)
+size_t ring_bytes(uint32_t capacity);
+
+void ring_init(sample_ring_t *ring, uint32_t capacity);
+
+// Operações não bloqueantes: retornam 1 em caso de sucesso, 0 se cheio/vazio
+int ring_try_push(sample_ring_t *ring, const sensor_data_t *data);
+int ring_try_pop(sample_ring_t *ring, sensor_data_t *out);
+
+// Operações bloqueantes: timeout_ms < 0 aguarda indefinidamente.
+// Retornam 0 em caso de sucesso, -1 se o tempo esgotou.
+int ring_push(sample_ring_t *ring, const sensor_data_t *data, long timeout_ms);
+int ring_pop(sample_ring_t *ring, sensor_data_t *out, long timeout_ms);
+
+// Publica até n amostras com uma única reserva (um CAS em head para o lote
+// todo). A versão try retorna quantas couberam sem bloquear; a bloqueante
+// aguarda espaço e retorna menos que n apenas se o tempo esgotar.
+uint32_t ring_try_push_batch(sample_ring_t *ring, const sensor_data_t *items,
+                             uint32_t n);
+uint32_t ring_push_batch(sample_ring_t *ring, const sensor_data_t *items,
+                         uint32_t n, long timeout_ms);
+
+// Retira até max amostras com uma única reserva (um CAS em tail para o lote
+// todo). A versão try retorna quantas havia sem bloquear; a bloqueante
+// aguarda a primeira e retorna 0 apenas se o tempo esgotar.
+uint32_t ring_try_pop_batch(sample_ring_t *ring, sensor_data_t *out,
+                            uint32_t max);
+uint32_t ring_pop_batch(sample_ring_t *ring, sensor_data_t *out, uint32_t max,
+                        long timeout_ms);
+
+// Número aproximado de amostras no buffer
+uint32_t ring_depth(sample_ring_t *ring);
+
+// Acorda todos os processos/threads bloqueados (usado no encerramento)
+void ring_wake_all(sample_ring_t *ring);
+
+// Reparo depois que um consumidor morreu entre avançar tail e liberar o
+// slot: o slot continuaria ocupado e pararia os produtores na volta
+// seguinte. Libera esses slots (a amostra se perdeu com o consumidor).
+// Com grace_ms >= 0 também pula reservas de produtores mortos entre avançar
+// head e confirmar a posse (sem isso o consumidor veria o ring vazio para
+// sempre): a reserva que seguir sem confirmação após grace_ms é tomada e
+// marcada como vazia; um produtor vivo que só estava atrasado perde o CAS
+// de confirmação e repete o envio. Slots já confirmados nunca são tomados.
+// Só sem consumidores ativos. Retorna quantos slots liberou ou pulou, ou -1
+// se o ring não tem a capacidade esperada ou head/tail são incoerentes.
+int ring_recover(sample_ring_t *ring, uint32_t capacity, long grace_ms);
+
+#endif // RING_H
@@ -0,0 +1,73 @@
+#ifndef RT_H
+#define RT_H
+
+#include "common.h"
+
+// Perfil de tempo real (opcional: rt = on em config/system.conf).
+//
+// Cada papel (supervisor, sensores, produtora e consumidoras do
+// data_processor) tem política de escalonamento, prioridade e afinidade de
+// CPU próprias. O processo trava a memória (mlockall) e pré-carrega os
+// segmentos compartilhados e a pilha das threads de tempo real, para que
+// falhas de página na primeira escrita e swap não apareçam como picos de
+// latência; o ring de ingestão pode usar huge pages.
+//
+// Sem privilégio (CAP_SYS_NICE, CAP_IPC_LOCK ou limites em RLIMIT_RTPRIO e
+// RLIMIT_MEMLOCK) cada passo que falha é registrado uma vez e o componente
+// segue no escalonamento e na memória padrão.
+
+#define RT_PRIORITY_MAX 99
+#define RT_STACK_PREFAULT (256 * 1024) // Pilha pré-carregada por thread
+
+typedef enum {
+    RT_ROLE_SUPERVISOR = 0,
+    RT_ROLE_SENSOR,
+    RT_ROLE_PRODUCER,
+    RT_ROLE_CONSUMER,
+    RT_ROLE_COUNT
+} rt_role_t;
+
+// Política de um papel: "fifo:50", "rr:20@2-3", "other@0"
+typedef struct {
+    int policy;    // SCHED_OTHER, SCHED_FIFO ou SCHED_RR
+    int priority;  // 1..RT_PRIORITY_MAX (FIFO/RR)
+    uint64_t cpus; // Máscara de CPUs (0 = sem afinidade)
+} rt_thread_config_t;
+
+typedef struct {
+    int enabled;
+    int lock_memory; // mlockall + pré-carga de segmentos e pilhas
+    int hugepages;   // Ring de ingestão em huge pages
+    rt_thread_config_t roles[RT_ROLE_COUNT];
+} rt_profile_t;
+
+// Desligado; papéis em SCHED_FIFO com a produtora acima das consumidoras,
+// sensores abaixo e o supervisor por último
+void rt_profile_default(rt_profile_t *profile);
+
+// Converte "política[:prioridade][@cpus]" (cpus: "0-3,6"); -1 se inválido
+int rt_thread_parse(const char *spec, rt_thread_config_t *out);
+void rt_thread_format(const rt_thread_config_t *config, char *buf,
+                      size_t len);
+
+const char *rt_role_name(rt_role_t role);
+
+// Aplica o papel à thread chamadora: afinidade (index >= 0 escolhe a
+// index-ésima CPU da máscara, em rodízio; -1 usa a máscara toda), política
+// e prioridade, e pré-carrega a pilha. Filhos criados depois não herdam a
+// política (SCHED_RESET_ON_FORK). Retorna 0 se tudo foi aplicado (ou o
+// perfil está desligado) e -1 se caiu para o escalonamento padrão.
+int rt_apply_thread(const rt_profile_t *profile, rt_role_t role, int index,
+                    const char *component);
+
+// Trava a memória do processo (mlockall); sem privilégio ilimitado trava só
+// o que já está mapeado. Retorna -1 se não foi possível.
+int rt_lock_memory(const rt_profile_t *profile, const char *component);
+
+// Pré-carrega as páginas de um mapeamento (sem alterar o conteúdo)
+void rt_prefault(void *addr, size_t len, int writable);
+
+// Toca RT_STACK_PREFAULT bytes da pilha da thread chamadora
+void rt_prefault_stack(void);
+
+#endif // RT_H
@@ -0,0 +1,117 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "common.h"
+
+// Motor de regras de alarme sobre o fluxo de amostras.
+//
+// As regras vêm de um arquivo texto (uma por linha) e são compiladas na
+// carga para uma tabela plana (SoA): parâmetros numéricos em arrays por
+// campo e, para cada tipo de sensor, a lista de regras que valem para todos
+// os sensores do tipo. A avaliação é feita por lote: as amostras do lote são
+// agrupadas por tipo em arrays contíguos de valores e cada regra de limiar
+// compara o array inteiro em um laço sem desvios (vetorizável); só a
+// atualização de estado (histerese, janelas N-de-M) é escalar.
+//
+// Formato do arquivo ('#' inicia comentário):
+//
+//   <escopo> <regra> <parâmetros> [hyst H] [nofm N M] [name=rótulo]
+//
+//   escopo:  *  |  temperatura  |  umidade  |  pressao  |  id=N
+//   above L       valor > L        (com hyst: volta ao normal abaixo de L-H)
+//   below L       valor < L        (com hyst: volta ao normal acima de L+H)
+//   rate D        |Δvalor| / Δt > D por segundo entre amostras seguidas
+//   stuck S [eps E]  valor sem variar mais que E (padrão 0) por S segundos,
+//                 medidos pelo timestamp das amostras
+//   nofm N M      dispara quando a condição vale em N das últimas M
+//                 amostras (M <= 32) e volta quando vale em menos de N
+
+#define RULES_DEFAULT_PATH "config/rules.conf"
+#define RULES_MAX 64
+#define RULES_NAME_LEN 32
+#define RULES_BATCH_MAX 64
+
+typedef enum {
+    RULE_ABOVE = 0,
+    RULE_BELOW,
+    RULE_RATE,
+    RULE_STUCK,
+    RULE_KIND_COUNT
+} rule_kind_t;
+
+// Tabela compilada (somente leitura depois da carga; compartilhada entre
+// os consumidores)
+typedef struct {
+    uint32_t count;
+    uint8_t kind[RULES_MAX];
+    int8_t scope_type[RULES_MAX]; // -1 = todos os tipos
+    int32_t scope_id[RULES_MAX];  // 0 = todos os sensores
+    float threshold[RULES_MAX];   // above/below: limite; rate: Δ/s; stuck: s
+    float release[RULES_MAX];     // Limite de retorno (histerese) ou eps
+    uint8_t n[RULES_MAX];         // N-de-M (1-de-1 sem nofm)
+    uint8_t m[RULES_MAX];
+    char name[RULES_MAX][RULES_NAME_LEN];
+
+    // Programa por tipo: regras sem escopo de id aplicáveis ao tipo
+    uint8_t type_rules[SENSOR_TYPE_COUNT][RULES_MAX];
+    uint32_t type_count[SENSOR_TYPE_COUNT];
+
+    // Regras de um sensor específico (avaliadas por amostra)
+    uint8_t id_rules[RULES_MAX];
+    uint32_t id_count;
+} rule_table_t;
+
+// Estado de uma regra para um sensor
+typedef struct {
+    float last_value;
+    uint32_t window;    // Bits das últimas M avaliações (1 = condição)
+    uint64_t last_ns;   // t_created da amostra anterior (rate)
+    int64_t stuck_since; // timestamp desde o qual o valor não varia
+    uint8_t seen;
+    uint8_t active;
+} rule_state_t;
+
+// Estado por consumidor: uma entrada por (sensor, regra), alocada de uma
+// vez; as páginas só são ocupadas para os sensores vistos
+typedef struct {
+    const rule_table_t *table;
+    uint32_t max_sensors;
+    rule_state_t *states; // [sensor_id * table->count + regra]
+    uint64_t evaluations; // Pares (amostra, regra) avaliados
+} rule_engine_t;
+
+typedef struct {
+    uint32_t rule;
+    int active; // 1 = alarme disparou, 0 = voltou ao normal
+    int sensor_id;
+    sensor_type_t type;
+    float value;
+    uint64_t t_created; // Da amostra que mudou o estado
+} rule_event_t;
+
+typedef void (*rule_emit_fn)(const rule_event_t *event, void *ctx);
+
+// Carrega e compila o arquivo. Retorna 0 ou -1 (erro de leitura ou de
+// sintaxe, com a linha em stderr).
+int rules_load(rule_table_t *table, const char *path);
+
+// Compila uma regra a partir do texto de uma linha (mesmo formato do
+// arquivo); usado por rules_load e pelos benchmarks
+int rules_add(rule_table_t *table, const char *line);
+
+int rule_engine_init(rule_engine_t *engine, const rule_table_t *table,
+                     uint32_t max_sensors);
+void rule_engine_free(rule_engine_t *engine);
+
+// Avalia um lote (até RULES_BATCH_MAX amostras, na ordem de chegada) e
+// chama emit a cada mudança de estado de um alarme
+void rule_engine_eval(rule_engine_t *engine, const sensor_data_t *batch,
+                      uint32_t n, rule_emit_fn emit, void *ctx);
+
+const char *rule_kind_name(rule_kind_t kind);
+
+// Descrição curta da regra ("temperatura above 30 hyst 0.5 nofm 3 5")
+void rules_describe(const rule_table_t *table, uint32_t rule, char *buf,
+                    size_t len);
+
+#endif // RULES_H
@@ -0,0 +1,46 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "common.h"
+
+// Escalonador de amostragem por deadlines absolutos.
+//
+// Em vez de sleep(periodo) após o trabalho (que acumula deriva igual ao tempo
+// gasto em cada iteração), cada leitura tem um deadline absoluto em
+// CLOCK_MONOTONIC e o processo dorme com clock_nanosleep(TIMER_ABSTIME).
+// Deadlines já vencidos são contados como perdidos e pulados, sem rajadas de
+// recuperação. O atraso do despertar (jitter) é acumulado por Welford.
+
+#define SAMPLER_MAX_RATE_HZ 100000.0
+
+typedef struct {
+    uint64_t period_ns;
+    uint64_t next_deadline; // Absoluto, CLOCK_MONOTONIC
+
+    uint64_t wakeups;
+    uint64_t missed; // Períodos pulados por atraso
+
+    // Atraso do despertar em relação ao deadline (ns)
+    uint64_t jitter_min;
+    uint64_t jitter_max;
+    double jitter_mean;
+    double jitter_m2;
+} sampler_t;
+
+// Retorna -1 se a taxa estiver fora de (0, SAMPLER_MAX_RATE_HZ]
+int sampler_init(sampler_t *sampler, double rate_hz);
+
+// Altera a taxa a partir do próximo deadline
+int sampler_set_rate(sampler_t *sampler, double rate_hz);
+
+// Dorme até o próximo deadline. Retorna quantos deadlines foram perdidos
+// nesta espera (0 no caso normal) ou -1 se interrompido por sinal.
+int sampler_wait(sampler_t *sampler);
+
+// Zera as estatísticas de jitter/perdas (mantém o agendamento)
+void sampler_reset_stats(sampler_t *sampler);
+
+// Resumo legível: taxa, jitter min/médio/máx/desvio e deadlines perdidos
+void sampler_format_stats(const sampler_t *sampler, char *buf, size_t len);
+
+#endif // SAMPLER_H
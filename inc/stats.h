@@ -0,0 +1,124 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "common.h"
+
+// Estatísticas incrementais por sensor, calculadas pelos consumidores.
+//
+// Memória O(1) por sensor, em estrutura de arrays (SoA) indexada por
+// sensor_id: contagem, mínimo, máximo, média e variância (Welford), EWMA e
+// janelas deslizantes de 1 s, 10 s e 60 s (10 baldes de 1 s + 6 baldes de
+// 10 s). O segmento fica em memória compartilhada (STATS_SHM_NAME) para que
+// a control_interface consulte sem IPC com o data_processor.
+//
+// Cada tabela tem um único escritor (uma thread consumidora), então o
+// caminho quente não usa locks; leitores usam o seqlock por sensor e tentam
+// de novo se a leitura coincidir com uma atualização.
+
+#define STATS_MAX_SENSORS 65536
+#define STATS_EWMA_ALPHA 0.1f
+#define STATS_SEC_BUCKETS 10
+#define STATS_TENSEC_BUCKETS 6
+
+// Balde de janela: agregados de um intervalo identificado por epoch
+typedef struct {
+    uint32_t epoch;
+    uint32_t count;
+    float min;
+    float max;
+    double sum;
+} stats_bucket_t;
+
+// Acumula v no balde, reiniciando-o se ele ainda guarda outro intervalo
+static inline void stats_bucket_add(stats_bucket_t *bucket, uint32_t epoch,
+                                    float v)
+{
+    if (bucket->count == 0 || bucket->epoch != epoch) {
+        bucket->epoch = epoch;
+        bucket->count = 0;
+        bucket->min = v;
+        bucket->max = v;
+        bucket->sum = 0.0;
+    }
+    bucket->count++;
+    bucket->sum += v;
+    if (v < bucket->min) {
+        bucket->min = v;
+    }
+    if (v > bucket->max) {
+        bucket->max = v;
+    }
+}
+
+// Cabeçalho do segmento; as tabelas seguem a partir de table_offset
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity; // Sensores por tabela (sensor_id < capacity)
+    uint32_t ntables;
+    uint32_t reserved;
+    uint64_t total_bytes;
+    uint64_t table_offset;
+    uint64_t table_bytes;
+} stats_shm_t;
+
+// Visão de uma tabela (ponteiros para dentro do segmento)
+typedef struct {
+    uint32_t capacity;
+    _Atomic uint32_t *seq; // Seqlock por sensor
+    uint8_t *type;
+    uint64_t *count;
+    float *min;
+    float *max;
+    double *mean;
+    double *m2;
+    float *ewma;
+    float *last_value;
+    uint64_t *last_ns;
+    stats_bucket_t *sec;    // capacity * STATS_SEC_BUCKETS
+    stats_bucket_t *tensec; // capacity * STATS_TENSEC_BUCKETS
+} stats_table_t;
+
+typedef struct {
+    uint64_t count;
+    float min;
+    float max;
+    float avg;
+} stats_window_t;
+
+// Cópia consistente do estado de um sensor
+typedef struct {
+    sensor_type_t type;
+    uint64_t count;
+    float min;
+    float max;
+    double mean;
+    double m2;
+    double variance;
+    float ewma;
+    float last_value;
+    uint64_t last_ns;
+    stats_window_t win_1s;
+    stats_window_t win_10s;
+    stats_window_t win_60s;
+} stats_snapshot_t;
+
+// data_processor: cria (recriando) o segmento com ntables tabelas
+stats_shm_t *stats_shm_create(uint32_t capacity, uint32_t ntables);
+
+// Leitores: mapeia o segmento existente (somente leitura); NULL se ausente
+stats_shm_t *stats_shm_open(void);
+
+void stats_shm_close(stats_shm_t *shm);
+
+void stats_table_view(stats_shm_t *shm, uint32_t index, stats_table_t *table);
+
+// Caminho quente (único escritor por tabela)
+void stats_update(stats_table_t *table, const sensor_data_t *data,
+                  uint64_t now_ns);
+
+// Consulta um sensor combinando todas as tabelas. Retorna 0 se houver dados
+// do sensor, -1 caso contrário.
+int stats_query(stats_shm_t *shm, int sensor_id, uint64_t now_ns,
+                stats_snapshot_t *out);
+
+#endif // STATS_H
@@ -0,0 +1,75 @@
+#ifndef SYSTEM_CONFIG_H
+#define SYSTEM_CONFIG_H
+
+#include "common.h"
+#include "rt.h"
+
+// Dimensionamento do sistema na partida: ring de ingestão, shards, pool de
+// consumidores, frota de sensores, fila de telemetria, tempo de execução e
+// perfil de tempo real.
+//
+// Camadas, cada uma sobrepondo a anterior:
+//
+//   padrões      system_config_default
+//   arquivo      -C arquivo, SENSOR_CONFIG ou SYSTEM_CONFIG_DEFAULT_PATH
+//                (o padrão é opcional; um arquivo pedido precisa existir)
+//   linha de     -S chave=valor e as opções de cada programa (-s, -n, ...)
+//   comando
+//
+// O arquivo tem uma atribuição "chave = valor" por linha e comentários com
+// '#'; as chaves estão em config/system.conf. O sensor_system repassa o
+// arquivo aos componentes por SENSOR_CONFIG.
+
+#define SYSTEM_CONFIG_DEFAULT_PATH "config/system.conf"
+#define SYSTEM_CONFIG_ENV "SENSOR_CONFIG"
+// O sensor_host agenda as leituras em ticks de 1 ms
+#define SENSOR_HOST_MAX_RATE_HZ 1000.0
+
+typedef struct {
+    // data_processor
+    uint32_t ring_capacity; // Amostras por shard (arredondado p/ pot. de 2)
+    uint32_t shards;        // 0 = um por core
+    uint32_t consumers;     // Consumidores na partida (0 = um por shard)
+    int adaptive;           // Pool adaptativo entre consumers_min e _max
+    uint32_t consumers_min;
+    uint32_t consumers_max;     // 0 = número de shards
+    uint32_t adapt_interval_ms; // Período de observação do pool
+    uint32_t grow_depth_pct;    // Ocupação média dos rings que faz crescer
+    uint32_t shrink_depth_pct;  // ... abaixo da qual pode encolher
+    uint32_t grow_busy_pct;     // Utilização média dos consumidores
+    uint32_t shrink_busy_pct;
+    int net_ingest; // Recebe sensores pela rede em SENSOR_NET_ADDR (net.h)
+
+    // sensor_manager
+    uint32_t sensors;    // Frota (0 = 4 processos ou 1000 hospedados)
+    int host_mode;       // Sensores em processos hospedeiros
+    uint32_t host_procs; // 0 = um por core
+    double sensor_rate_hz;
+    uint32_t sensor_backlog; // Fila local sem data_processor (0 = nenhuma)
+
+    // Todos
+    uint32_t mq_depth; // Fila de telemetria (0 = TELEMETRY_MQ_DEPTH)
+    uint32_t run_s;    // Encerramento automático (0 = até SIGTERM)
+    rt_profile_t rt;   // rt, rt_mlock, rt_hugepages, rt_<papel>
+} system_config_t;
+
+void system_config_default(system_config_t *config);
+
+// Aplica uma atribuição "chave=valor" (arquivo ou -S). Retorna -1 se a chave
+// não existe ou o valor é inválido.
+int system_config_set(system_config_t *config, const char *assignment);
+
+// Carrega o arquivo sobre os valores atuais. path NULL usa SENSOR_CONFIG ou
+// o padrão (ausente = nada a fazer). Retorna -1 em erro, com a linha em
+// stderr; também recusa sensor_rate_hz acima de SENSOR_HOST_MAX_RATE_HZ
+// com host_mode.
+int system_config_load(system_config_t *config, const char *path);
+
+// Procura -C em argv sem consumir as opções (o arquivo é carregado antes
+// das demais, que o sobrepõem). NULL se ausente.
+const char *system_config_arg(int argc, char *argv[]);
+
+void system_config_format(const system_config_t *config, char *buf,
+                          size_t len);
+
+#endif // SYSTEM_CONFIG_H
@@ -0,0 +1,120 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "common.h"
+
+// Canal de telemetria na fila POSIX (MQ_NAME): mensagens binárias de tamanho
+// fixo, em baixa taxa. As amostras seguem pelo ring/FIFO; a fila leva só
+//
+//   resumos   mín/máx/média/contagem de cada sensor por intervalo
+//             (prioridade MQ_PRIO_SUMMARY)
+//   eventos   fora de banda, à frente dos resumos já enfileirados: partida,
+//             parada e reconfiguração de sensores (MQ_PRIO_EVENT) e
+//             mudanças de estado dos alarmes (MQ_PRIO_ALARM)
+//
+// O sensor acumula a janela no caminho quente sem chamadas de sistema (a
+// amostra já traz o instante da leitura) e envia um resumo quando o
+// intervalo vence. Com a fila cheia o resumo não é perdido: a janela
+// continua aberta e cobre também o intervalo seguinte.
+
+#define TELEMETRY_MAGIC 0x314d4c54u // "TLM1"
+#define TELEMETRY_MQ_DEPTH 64       // Profundidade pedida para a fila
+#define TELEMETRY_MQ_DEPTH_MIN 10   // msg_max padrão sem privilégios
+#define TELEMETRY_INTERVAL_MS 1000  // Padrão, sobreposto por SENSOR_SUMMARY_MS
+#define TELEMETRY_NAME_LEN 16
+
+#define MQ_PRIO_SUMMARY 0
+#define MQ_PRIO_EVENT 5 // Abaixo dos alarmes (MQ_PRIO_ALARM)
+
+typedef enum { TELEMETRY_SUMMARY = 1, TELEMETRY_EVENT } telemetry_kind_t;
+
+typedef enum {
+    TELEMETRY_EVENT_ALARM_ON = 1,
+    TELEMETRY_EVENT_ALARM_OFF,
+    TELEMETRY_EVENT_SENSOR_START,
+    TELEMETRY_EVENT_SENSOR_STOP,
+    TELEMETRY_EVENT_SENSOR_CONFIG,
+} telemetry_event_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t kind;  // telemetry_kind_t
+    uint16_t event; // telemetry_event_t (eventos)
+    int32_t sensor_id;
+    uint32_t type;      // sensor_type_t
+    int64_t t_start_ns; // Relógio de parede: início da janela ou do evento
+    int64_t t_end_ns;
+    uint32_t count; // Resumo: amostras na janela
+    float min;
+    float max;
+    float value; // Resumo: média; evento: valor da amostra ou taxa
+    char name[TELEMETRY_NAME_LEN]; // Alarmes: nome da regra
+} telemetry_msg_t;
+
+_Static_assert(sizeof(telemetry_msg_t) == 64, "telemetry_msg_t: 64 bytes");
+
+// Janela de um sensor (um único escritor)
+typedef struct {
+    int sensor_id;
+    sensor_type_t type;
+    uint64_t interval_ns; // 0 = resumos desligados
+    uint64_t start_ns;    // CLOCK_MONOTONIC
+    uint64_t due_ns;
+    uint32_t count;
+    float min;
+    float max;
+    double sum;
+    uint64_t sent;
+    uint64_t deferred; // Envios adiados por fila cheia
+} telemetry_window_t;
+
+// Intervalo padrão (ms): SENSOR_SUMMARY_MS ou TELEMETRY_INTERVAL_MS
+uint32_t telemetry_interval_default(void);
+
+// Cria ou abre a fila com os atributos do canal (flags: O_RDONLY/O_WRONLY e
+// O_NONBLOCK). depth vale só na criação (0 = TELEMETRY_MQ_DEPTH). Uma fila
+// antiga com outro tamanho de mensagem é recriada.
+mqd_t telemetry_mq_open(int flags, uint32_t depth);
+
+void telemetry_window_init(telemetry_window_t *w, int sensor_id,
+                           sensor_type_t type, uint32_t interval_ms,
+                           uint64_t now_ns);
+
+// Caminho quente: acumula a amostra; retorna 1 se o intervalo venceu
+static inline int telemetry_window_add(telemetry_window_t *w, float value,
+                                       uint64_t now_ns)
+{
+    if (w->count == 0) {
+        w->min = value;
+        w->max = value;
+    } else {
+        w->min = value < w->min ? value : w->min;
+        w->max = value > w->max ? value : w->max;
+    }
+    w->count++;
+    w->sum += value;
+    return w->interval_ns != 0 && now_ns >= w->due_ns;
+}
+
+// Envia o resumo da janela (sem bloquear) e abre a próxima. Fila cheia
+// (retorna -1, errno EAGAIN) mantém a janela e adia a tentativa por um
+// intervalo. Retorna 0 também com a janela vazia (nada a enviar).
+int telemetry_window_flush(telemetry_window_t *w, mqd_t mq, uint64_t now_ns);
+
+// Evento fora de banda; name pode ser NULL. Retorna o de mq_send.
+int telemetry_send_event(mqd_t mq, telemetry_event_t event, int sensor_id,
+                         sensor_type_t type, float value, const char *name,
+                         unsigned priority);
+
+// Monta a mensagem de evento sem enviar (para quem mantém pendentes)
+void telemetry_event_init(telemetry_msg_t *msg, telemetry_event_t event,
+                          int sensor_id, sensor_type_t type, float value,
+                          const char *name);
+
+// Valida uma mensagem recebida (tamanho e assinatura)
+int telemetry_msg_valid(const telemetry_msg_t *msg, ssize_t bytes);
+
+// Texto de uma linha para logs
+void telemetry_format(const telemetry_msg_t *msg, char *buf, size_t len);
+
+#endif // TELEMETRY_H
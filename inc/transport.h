@@ -0,0 +1,302 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "common.h"
+#include "metrics.h"
+#include "net.h"
+#include "overload.h"
+#include "ring.h"
+
+// Transporte de amostras entre sensor_process e data_processor.
+//
+// No modo SHM o data_processor cria em SHM_NAME um segmento com cabeçalho +
+// um ring lock-free por shard (um shard por consumidor); cada sensor mapeia
+// o segmento e publica as amostras diretamente no ring do seu shard, escolhido
+// por hash do sensor_id (sem write/read e sem cópias pelo kernel). Assim cada
+// sensor é consumido por uma única thread, na ordem de publicação. A espera
+// quando o ring está vazio/cheio usa futexes compartilhados entre processos.
+// O FIFO nomeado continua disponível como modo alternativo, com registros
+// sensor_data_t ou, no modo fifo-gorilla, quadros de amostras compactadas
+// (gorilla.h); o data_processor aceita os dois misturados no mesmo FIFO.
+// Nos modos udp e tcp (net.h) os sensores podem estar em outro nó: as
+// amostras vão em quadros compactados e numerados ao data_processor, que as
+// recebe com net_ingest ligado e as distribui pelos mesmos rings.
+//
+// Com o ring cheio, o produtor segue a política de sobrecarga gravada no
+// cabeçalho pelo data_processor (overload.h); os descartes são contados por
+// shard no próprio cabeçalho.
+//
+// O segmento sobrevive ao data_processor: ao sair ele entrega os rings,
+// com o que ainda não consumiu, à próxima instância, que os retoma se o
+// layout for compatível (versão, capacidade e shards) e copia as amostras
+// para um segmento novo se não for. Uma instância que encontra outra ativa
+// pede que ela saia (SIGTERM) e aguarda a entrega; se a anterior morreu,
+// os rings são reparados antes (ring_recover). Enquanto não há leitor os
+// sensores usam o ring só como buffer, sem aplicar a política de
+// sobrecarga, e guardam numa fila local o que não couber: um reinício ou
+// uma troca de versão do data_processor não perde amostras.
+//
+// A conexão não depende de tentativas periódicas: um pequeno segmento de
+// encontro (RENDEZVOUS_SHM_NAME), que qualquer processo cria se não existir,
+// contém um futex que o data_processor marca quando passa a aceitar
+// amostras. Sensores dormem nesse futex e conectam assim que são acordados.
+
+#define SAMPLE_SHM_MAGIC 0x534e5352u // "RSNS"
+#define SAMPLE_MAX_SHARDS 64
+// Layout do segmento; um segmento de outra versão não é retomado
+#define SAMPLE_SHM_VERSION 4
+// Espera pela entrega de uma instância anterior ainda ativa
+#define SAMPLE_SHM_HANDOFF_TIMEOUT_MS 5000
+// Fila local padrão de cada escritor (sample_writer_set_backlog)
+#define SAMPLE_WRITER_BACKLOG 4096
+
+typedef enum {
+    TRANSPORT_SHM = 0,
+    TRANSPORT_FIFO,
+    TRANSPORT_FIFO_GORILLA,
+    TRANSPORT_UDP,
+    TRANSPORT_TCP
+} transport_mode_t;
+
+// Quadro do modo fifo-gorilla: cabeçalho + gorilla_encode_samples, escrito
+// com um único write() de até PIPE_BUF bytes (atômico, nunca intercalado).
+// O magic não é um sensor_type_t válido, o que distingue o quadro de um
+// registro sensor_data_t no início de cada escrita.
+#define SAMPLE_FRAME_MAGIC 0x314c5247u // "GRL1"
+
+typedef struct {
+    uint32_t magic;
+    uint16_t count; // Amostras no quadro
+    uint16_t bytes; // Bytes após o cabeçalho
+} sample_frame_t;
+
+// Leitor do FIFO: separa o início de buf (fill bytes) em amostras, de
+// registros ou de quadros. Para num registro/quadro incompleto ou quando out
+// enche; *consumed recebe os bytes usados. Retorna 1 se parou por falta de
+// espaço em out (há mais a separar), 0 se os dados acabaram e -1 se
+// encontrou um quadro inválido.
+int sample_stream_parse(const char *buf, size_t fill, sensor_data_t *out,
+                        uint32_t max, uint32_t *count, size_t *consumed);
+
+// Páginas que sustentam o segmento
+typedef enum {
+    SAMPLE_SHM_PAGES_NORMAL = 0,
+    SAMPLE_SHM_PAGES_THP,     // /dev/shm com madvise(MADV_HUGEPAGE)
+    SAMPLE_SHM_PAGES_HUGETLB, // SAMPLE_SHM_HUGETLB_PATH (nr_hugepages)
+} sample_shm_pages_t;
+
+// Estado do segmento entre execuções do data_processor
+typedef enum {
+    SAMPLE_SHM_ACTIVE = 1, // Um data_processor (owner) consome os rings
+    SAMPLE_SHM_HANDOFF,    // O dono saiu em ordem; os rings esperam o próximo
+    SAMPLE_SHM_RETIRED,    // Substituído por outro: escritores devem remapear
+} sample_shm_state_t;
+
+// Cabeçalho do segmento compartilhado; o ring do shard i começa em
+// ring_offset + i * ring_stride. magic, ready, version e state ficam nessa
+// posição em todas as versões.
+typedef struct {
+    uint32_t magic;
+    _Atomic uint32_t ready; // 1 quando os rings estão inicializados
+    uint32_t version;       // SAMPLE_SHM_VERSION
+    _Atomic uint32_t state; // sample_shm_state_t (futex)
+    _Atomic int32_t owner;  // pid do data_processor em ACTIVE
+    uint32_t generation;    // Instâncias que já assumiram o segmento
+    // Início do dono (process_start_time): o pid sozinho pode ter sido
+    // reaproveitado por outro processo depois de uma queda
+    _Atomic uint64_t owner_start;
+    uint64_t total_bytes;
+    uint64_t ring_offset;
+    uint64_t ring_stride;
+    uint32_t nshards;
+    uint32_t capacity; // Capacidade de cada ring
+    uint32_t pages;    // sample_shm_pages_t
+    overload_config_t overload;
+    overload_shard_t overload_shards[SAMPLE_MAX_SHARDS];
+} sample_shm_t;
+
+// Ponto de encontro sensores ↔ data_processor
+typedef struct {
+    uint32_t magic;
+    _Atomic uint32_t reader_ready;    // 1: data_processor aceitando (futex)
+    _Atomic uint32_t sensors_started; // Sensores conectados (futex)
+    uint32_t reserved;
+} rendezvous_t;
+
+// Lado escritor (sensores)
+typedef struct {
+    transport_mode_t mode;
+    int fifo_fd;
+    sample_shm_t *shm;
+    size_t shm_bytes;
+    // Shards na conexão, para o agrupamento do chamador; o envio usa os do
+    // segmento atual. 1 no modo FIFO (o data_processor distribui).
+    uint32_t nshards;
+    rendezvous_t *rendezvous;
+    overload_state_t overload;
+    // Fila local, circular e alocada no primeiro uso: o que não coube no
+    // ring enquanto o data_processor estava ausente, na ordem de chegada
+    sensor_data_t *backlog;
+    uint32_t backlog_capacity;
+    uint32_t backlog_head;
+    uint32_t backlog_count;
+    int32_t dead_owner; // data_processor que morreu sem entregar os rings
+    uint64_t dead_owner_start;
+    net_sender_t net;   // Modos udp e tcp
+} sample_writer_t;
+
+// Partida do data_processor sobre o segmento (sample_shm_acquire)
+typedef struct {
+    int adopted;         // Rings de uma instância anterior retomados
+    int replaced;        // Layout incompatível: pendentes copiados
+    int crashed;         // A anterior morreu sem entregar
+    int requested;       // A anterior estava ativa e recebeu SIGTERM
+    uint32_t generation; // Instâncias que já usaram o segmento
+    uint64_t pending;    // Amostras nos rings ao assumir
+    uint64_t lost;       // Slots de um consumidor ou produtor morto, sem
+                         // espaço na cópia ou de rings irrecuperáveis
+    int lost_unknown;    // Rings ilegíveis: perdas além de lost sem contagem
+    uint64_t wait_ns;    // Espera pela entrega da anterior
+} sample_shm_takeover_t;
+
+// Shard de um sensor: hash multiplicativo reduzido por multiplicação, para
+// distribuir bem IDs consecutivos ou em passos regulares
+static inline uint32_t sample_shard_of(int sensor_id, uint32_t nshards)
+{
+    uint32_t h = (uint32_t) sensor_id * 2654435761u;
+    return (uint32_t) (((uint64_t) h * nshards) >> 32);
+}
+
+// Converte "shm"/"fifo"/"fifo-gorilla"/"udp"/"tcp"; retorna -1 se inválido
+int transport_mode_parse(const char *name, transport_mode_t *mode);
+
+// Modo padrão: variável de ambiente SENSOR_TRANSPORT ou SHM
+transport_mode_t transport_mode_default(void);
+
+const char *transport_mode_name(transport_mode_t mode);
+
+// Lado do data_processor: cria (recriando se existir) o segmento com nshards
+// rings da capacidade dada e a política de sobrecarga (marcas calculadas
+// aqui) e marca-o como pronto, ACTIVE em nome deste processo. hugepages
+// tenta o hugetlbfs e, sem páginas reservadas, huge pages transparentes; o
+// resultado fica em shm->pages.
+sample_shm_t *sample_shm_create(uint32_t capacity, uint32_t nshards,
+                                const overload_config_t *overload,
+                                int hugepages);
+
+// Partida do data_processor: retoma o segmento deixado pela instância
+// anterior (pedindo a saída dela se ainda estiver ativa) quando o layout é o
+// mesmo, com os rings e o que eles ainda contêm; senão cria um segmento
+// novo, copia para ele as amostras pendentes do antigo e marca o antigo como
+// RETIRED. O segmento volta ACTIVE em nome deste processo. NULL em erro
+// (errno = EBUSY se a anterior não entregou no prazo).
+sample_shm_t *sample_shm_acquire(uint32_t capacity, uint32_t nshards,
+                                 const overload_config_t *overload,
+                                 int hugepages, sample_shm_takeover_t *info);
+
+// Encerramento do data_processor, com os consumidores já parados: entrega o
+// segmento (HANDOFF) à próxima instância. Continua mapeado; produtores
+// ainda ativos podem publicar até sample_shm_destroy.
+void sample_shm_release(sample_shm_t *shm);
+
+const char *sample_shm_pages_name(sample_shm_pages_t pages);
+void sample_shm_destroy(sample_shm_t *shm);
+
+// Leitura do segmento por monitores (sensor_top); NULL se não existir
+const sample_shm_t *sample_shm_open_readonly(void);
+void sample_shm_close(const sample_shm_t *shm);
+
+static inline sample_ring_t *sample_shm_ring(sample_shm_t *shm, uint32_t shard)
+{
+    return (sample_ring_t *) ((char *) shm + shm->ring_offset +
+                              shard * shm->ring_stride);
+}
+
+// Publica n amostras do shard segundo a política do segmento. Retorna
+// quantas foram tratadas (publicadas, descartadas ou retidas) e em
+// *published quantas entraram no ring; só BLOCK trata menos que n (ring
+// cheio até o timeout). Antes, publica o que state ainda retém (COALESCE).
+uint32_t sample_shm_offer(sample_shm_t *shm, uint32_t shard,
+                          const sensor_data_t *items, uint32_t n,
+                          overload_state_t *state, long timeout_ms,
+                          uint32_t *published);
+
+// Descartes acumulados do shard por motivo
+static inline uint64_t sample_shm_drops(const sample_shm_t *shm,
+                                        uint32_t shard,
+                                        overload_drop_t reason)
+{
+    return atomic_load_explicit(&shm->overload_shards[shard].drops[reason],
+                                memory_order_relaxed);
+}
+
+// Segmento de encontro (criado se não existir); NULL em erro
+rendezvous_t *rendezvous_open(void);
+void rendezvous_close(rendezvous_t *rv);
+
+// data_processor: 1 ao passar a aceitar amostras, 0 ao deixar de aceitar
+void rendezvous_set_reader(rendezvous_t *rv, int ready);
+
+// Sensores conectados até agora; quem inicia uma frota aguarda até que o
+// contador alcance target (0 se alcançou, -1 no timeout)
+uint32_t rendezvous_sensors(rendezvous_t *rv);
+int rendezvous_wait_sensors(rendezvous_t *rv, uint32_t target,
+                            long timeout_ms);
+
+// Lado dos sensores. sample_writer_open aguarda o data_processor no ponto de
+// encontro (até 10 s); nos modos de rede conecta a net_addr_default() (tcp:
+// até 10 s; udp não espera, e o que for enviado sem receptor se perde e
+// conta como descarte). sample_writer_send retorna quantas amostras publicou
+// (1, ou mais se amostras retidas pela política de sobrecarga ou pela fila
+// local saíram junto), 0 se a política descartou ou reteve a amostra e -1
+// com errno=EAGAIN se, com a política BLOCK, o ring continuar cheio após
+// 100 ms (o chamador decide se tenta de novo). Sem data_processor a amostra
+// vai para o ring ou para a fila local e só se perde com as duas cheias.
+int sample_writer_open(sample_writer_t *writer, transport_mode_t mode,
+                       const char *component);
+// No modo SHM as amostras recebem t_ingest no momento da publicação; nos
+// modos FIFO e de rede o data_processor carimba ao receber.
+int sample_writer_send(sample_writer_t *writer, sensor_data_t *data);
+
+// Capacidade da fila local (padrão SAMPLE_WRITER_BACKLOG; 0 = sem fila).
+// Vale se chamada antes do primeiro envio.
+void sample_writer_set_backlog(sample_writer_t *writer, uint32_t capacity);
+
+// Amostras na fila local
+static inline uint32_t sample_writer_backlog(const sample_writer_t *writer)
+{
+    return writer->backlog_count;
+}
+
+// Shard em que o sensor deve ser agrupado antes de sample_writer_send_batch
+static inline uint32_t sample_writer_shard(const sample_writer_t *writer,
+                                           int sensor_id)
+{
+    return sample_shard_of(sensor_id, writer->nshards);
+}
+
+// Envia um lote: no modo SHM uma reserva no ring por sequência de amostras
+// consecutivas do mesmo shard (agrupe por sample_writer_shard para lotes
+// grandes); no modo FIFO em blocos de até PIPE_BUF bytes (escritas atômicas,
+// sem intercalar com outros sensores); nos modos de rede em quadros
+// (net_sender_send). Retorna quantas amostras do início
+// do lote foram tratadas (ver sample_shm_offer), com as publicadas em
+// *published, ou -1 em erro.
+int sample_writer_send_batch(sample_writer_t *writer, sensor_data_t *items,
+                             uint32_t n, uint32_t *published);
+void sample_writer_close(sample_writer_t *writer);
+
+// Conta nsensors como iniciados no ponto de encontro (após conectar)
+void sample_writer_announce(sample_writer_t *writer, uint32_t nsensors);
+
+// Copia os descartes feitos pelo produtor para as métricas do componente
+static inline void overload_report(const overload_state_t *state,
+                                   metrics_slot_t *metrics)
+{
+    for (int r = 0; r < OVERLOAD_DROP_COUNT; r++) {
+        metrics_set(metrics, (metric_id_t) (METRIC_DROPPED_NEWEST + r),
+                    state->drops[r]);
+    }
+}
+
+#endif // TRANSPORT_H
@@ -0,0 +1,163 @@
+#ifndef TSDB_H
+#define TSDB_H
+
+#include "common.h"
+
+// Histórico das amostras em arquivos de segmento mapeados em memória.
+//
+// Cada segmento tem tamanho fixo (pré-alocado) e é escrito só por anexação:
+//
+//   [cabeçalho 4 KiB][blocos de dados →  ...  ← entradas do índice]
+//
+// Um bloco guarda amostras de um único sensor: em colunas, os timestamps
+// (int64, ns do relógio de parede) seguidos dos valores (float), ou
+// comprimidas com gorilla.h (padrão; um bloco que não encolhe fica em
+// colunas). Os blocos crescem a partir do cabeçalho e o índice (uma entrada
+// de tamanho fixo por bloco, com sensor, intervalo de tempo e mínimo/máximo)
+// cresce a partir do fim do arquivo; o segmento está cheio quando os dois se
+// encontram. Um leitor percorre o índice e só toca as páginas dos blocos que
+// interessam.
+//
+// O escritor (uma thread do data_processor) acumula as amostras de cada
+// sensor em memória e grava um bloco quando ele enche ou no ciclo de
+// sincronização, que também faz fdatasync. Só então o cabeçalho passa a
+// contar os blocos como duráveis (synced_chunks); um segmento não selado
+// encontrado na partida (queda do processo) é cortado nesse ponto e selado.
+// Segmentos são trocados por tamanho ou idade e os mais antigos apagados
+// quando o diretório passa do limite de bytes ou de idade.
+
+#define TSDB_MAGIC "SENSTSDB"
+#define TSDB_VERSION 1
+#define TSDB_HEADER_SIZE 4096
+#define TSDB_CHUNK_MAX 256 // Amostras por bloco
+#define TSDB_PATH_LEN 256
+#define TSDB_DEFAULT_DIR "data/tsdb"
+
+// Codificação do bloco
+#define TSDB_ENC_RAW 0     // Colunas sem compressão
+#define TSDB_ENC_GORILLA 1 // gorilla_encode_series
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t file_size;
+    uint64_t seq;        // Número do segmento (ordem de criação)
+    int64_t created_ns;  // Relógio de parede na criação
+    _Atomic uint32_t sealed;        // 1 = não recebe mais blocos
+    _Atomic uint32_t nchunks;       // Blocos visíveis (índice válido)
+    _Atomic uint32_t synced_chunks; // Blocos já persistidos (fdatasync)
+    uint32_t reserved;
+    _Atomic uint64_t data_end;      // Fim dos dados (offset no arquivo)
+    _Atomic uint64_t nsamples;
+    _Atomic int64_t t_min;
+    _Atomic int64_t t_max;
+} tsdb_header_t;
+
+// Entrada do índice: a entrada k fica em file_size - (k + 1) * sizeof
+typedef struct {
+    uint64_t offset; // Início do bloco no arquivo
+    uint32_t bytes;  // Tamanho do bloco
+    int32_t sensor_id;
+    uint16_t count;  // Amostras no bloco
+    uint8_t type;    // sensor_type_t
+    uint8_t encoding;
+    float v_min;
+    int64_t t_min;
+    int64_t t_max;
+    float v_max;
+    uint32_t reserved;
+} tsdb_index_t;
+
+typedef struct {
+    char dir[TSDB_PATH_LEN];
+    uint64_t segment_bytes; // Tamanho de cada segmento
+    uint64_t max_bytes;     // Retenção: total do diretório (0 = sem limite)
+    uint32_t max_age_s;     // Retenção: idade dos segmentos (0 = sem limite)
+    uint32_t rotate_s;      // Troca o segmento após este tempo aberto
+    uint32_t sync_ms;       // Ciclo de gravação + fdatasync (0 = a cada lote)
+    uint32_t codec;         // TSDB_ENC_*
+    int enabled;
+} tsdb_config_t;
+
+// Padrões, sobrepostos por SENSOR_TSDB (mesmo formato de tsdb_config_parse)
+void tsdb_config_default(tsdb_config_t *config);
+
+// "off" ou lista "chave=valor" separada por vírgulas: dir=, segment=,
+// keep= (K/M/G), age=, rotate= (s/m/h/d), sync= (ms) e codec=raw|gorilla.
+// Retorna -1 se inválida.
+int tsdb_config_parse(const char *spec, tsdb_config_t *config);
+void tsdb_config_format(const tsdb_config_t *config, char *buf, size_t len);
+
+typedef struct tsdb_writer tsdb_writer_t;
+
+typedef struct {
+    uint64_t samples;  // Amostras gravadas em blocos
+    uint64_t chunks;
+    uint64_t segments; // Segmentos criados
+    uint64_t removed;  // Segmentos apagados pela retenção
+    // Blocos descartados sem segmento aberto (falha ao criar; nova tentativa
+    // no próximo ciclo de sincronização)
+    uint64_t dropped_samples;
+    uint64_t dropped_chunks;
+    uint64_t syncs;
+    uint64_t sync_ns_max; // Maior ciclo de sincronização
+    uint64_t sync_ns_total;
+} tsdb_stats_t;
+
+// Abre o diretório (criando-o), trava-o para este escritor (aguardando até
+// 5 s por um anterior que ainda fecha), recupera segmentos interrompidos,
+// aplica a retenção e cria um segmento novo. NULL em erro (com perror).
+tsdb_writer_t *tsdb_writer_open(const tsdb_config_t *config,
+                                uint32_t max_sensors);
+
+// Acumula amostras; blocos cheios vão para o segmento (sem sincronizar)
+void tsdb_writer_append(tsdb_writer_t *writer, const sensor_data_t *items,
+                        uint32_t n);
+
+// Ciclo de sincronização: grava os blocos parciais e faz fdatasync se o
+// ciclo venceu (ou sempre, com force). Retorna 1 se sincronizou.
+int tsdb_writer_tick(tsdb_writer_t *writer, uint64_t now_ns, int force);
+
+void tsdb_writer_stats(const tsdb_writer_t *writer, tsdb_stats_t *out);
+
+// Grava o que resta, sincroniza e sela o segmento atual
+void tsdb_writer_close(tsdb_writer_t *writer);
+
+// Leitura (ferramentas): mapeamento somente leitura, páginas sob demanda
+typedef struct {
+    int fd;
+    const char *map;
+    size_t size;
+    const tsdb_header_t *header;
+} tsdb_segment_t;
+
+int tsdb_segment_open(tsdb_segment_t *seg, const char *path);
+void tsdb_segment_close(tsdb_segment_t *seg);
+
+static inline const tsdb_index_t *tsdb_segment_index(const tsdb_segment_t *seg,
+                                                     uint32_t k)
+{
+    return (const tsdb_index_t *) (seg->map + seg->size -
+                                   (size_t) (k + 1) * sizeof(tsdb_index_t));
+}
+
+// Blocos visíveis agora (o escritor pode estar anexando)
+static inline uint32_t tsdb_segment_chunks(const tsdb_segment_t *seg)
+{
+    return atomic_load_explicit(
+        &((tsdb_header_t *) seg->header)->nchunks, memory_order_acquire);
+}
+
+// Lê um bloco (qualquer codificação) em arrays de TSDB_CHUNK_MAX posições.
+// Retorna a quantidade de amostras ou -1 se o bloco estiver corrompido.
+int tsdb_chunk_read(const tsdb_segment_t *seg, const tsdb_index_t *entry,
+                    int64_t *timestamps, float *values);
+
+// Nomes dos segmentos do diretório em ordem de criação (caminhos
+// completos, alocados; liberar com tsdb_list_free). Retorna a quantidade
+// ou -1.
+int tsdb_list_segments(const char *dir, char ***paths);
+void tsdb_list_free(char **paths, int n);
+
+#endif // TSDB_H
@@ -1,15 +1,14 @@
 #include "common.h"
+#include "logger.h"
 
-// Função para log com cores
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// Função para log com cores. Apenas enfileira o registro no ring da thread;
+// a formatação e a escrita ficam com a thread escritora (logger.c).
 void log_message(const char *color, const char *component, const char *message)
 {
-    time_t now = time(NULL);
-    char *time_str = ctime(&now);
-    time_str[strlen(time_str) - 1] = '\0'; // Remove newline
-
-    printf("%s[%s] %s%s %s%s\n", color, time_str, COLOR_CYAN, component,
-           COLOR_RESET, message);
-    fflush(stdout);
+    log_event(LOG_INFO, color, component, "%s", message);
 }
 
 // Retorna nome do tipo de sensor
@@ -27,6 +26,21 @@ const char *sensor_type_name(sensor_type_t type)
     }
 }
 
+// Valor base da simulação por tipo de sensor
+float sensor_base_value(sensor_type_t type)
+{
+    switch (type) {
+    case SENSOR_TEMPERATURE:
+        return 25.0f; // 25°C
+    case SENSOR_HUMIDITY:
+        return 60.0f; // 60%
+    case SENSOR_PRESSURE:
+        return 1013.25f; // hPa
+    default:
+        return 0.0f;
+    }
+}
+
 // Cleanup de recursos (chamado no exit)
 void cleanup_resources(void)
 {
@@ -36,7 +50,177 @@ void cleanup_resources(void)
 
     // Remove memória compartilhada
     shm_unlink(SHM_NAME);
+    unlink(SAMPLE_SHM_HUGETLB_PATH);
+    shm_unlink(STATS_SHM_NAME);
+    shm_unlink(LATENCY_SHM_NAME);
+    shm_unlink(CONFIG_SHM_NAME);
+    shm_unlink(METRICS_SHM_NAME);
+    shm_unlink(RENDEZVOUS_SHM_NAME);
+    shm_unlink(HISTORY_SHM_NAME);
 
     // Remove fila de mensagens
     mq_unlink(MQ_NAME);
 }
+
+// Descritor de prontidão retirado do ambiente (-1 = nenhum)
+static int ready_fd = -1;
+
+void notify_ready_detach(void)
+{
+    const char *value = getenv(READY_FD_ENV);
+    if (value == NULL) {
+        return;
+    }
+    ready_fd = atoi(value);
+    unsetenv(READY_FD_ENV); // Não repassar aos processos filhos
+    fcntl(ready_fd, F_SETFD, FD_CLOEXEC);
+}
+
+void notify_ready(void)
+{
+    notify_ready_detach();
+    int fd = ready_fd;
+    if (fd < 0) {
+        return;
+    }
+    ready_fd = -1;
+
+    char byte = 1;
+    if (write(fd, &byte, 1) != 1) {
+        perror("Erro ao sinalizar prontidão");
+    }
+    close(fd);
+}
+
+// Aguarda enquanto *addr == expected (FUTEX_WAIT sem FUTEX_PRIVATE_FLAG para
+// funcionar também em memória compartilhada entre processos)
+int futex_wait(_Atomic uint32_t *addr, uint32_t expected, long timeout_ms)
+{
+    struct timespec ts;
+    struct timespec *tsp = NULL;
+
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+        tsp = &ts;
+    }
+
+    if (syscall(SYS_futex, (uint32_t *) addr, FUTEX_WAIT, expected, tsp, NULL,
+                0) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+// Acorda até count threads/processos aguardando em addr
+int futex_wake(_Atomic uint32_t *addr, int count)
+{
+    return (int) syscall(SYS_futex, (uint32_t *) addr, FUTEX_WAKE, count, NULL,
+                         NULL, 0);
+}
+
+uint64_t process_start_time(pid_t pid)
+{
+    char path[64];
+    char buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int) pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return 0;
+    }
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) {
+        return 0;
+    }
+    buf[n] = '\0';
+
+    // O nome (campo 2) pode ter espaços e parênteses: contar a partir do
+    // último ')', que precede o campo 3
+    char *p = strrchr(buf, ')');
+    if (p == NULL || p[1] != ' ' || p[2] == 'Z') {
+        return 0;
+    }
+    for (int field = 2; p != NULL && field < 22; field++) {
+        p = strchr(p + 1, ' ');
+    }
+    return p != NULL ? strtoull(p + 1, NULL, 10) : 0;
+}
+
+int process_signal(pid_t pid, uint64_t start_time, int sig)
+{
+    int pidfd = (int) syscall(SYS_pidfd_open, pid, 0);
+    if (pidfd == -1) {
+        return -1;
+    }
+    int rc = -1;
+    if (start_time != 0 && process_start_time(pid) == start_time) {
+        rc = (int) syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0);
+    }
+    close(pidfd);
+    return rc == 0 ? 0 : -1;
+}
+
+void *shm_table_create(const char *name, size_t total, const char *what)
+{
+    char msg[128];
+    shm_unlink(name);
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd == -1) {
+        snprintf(msg, sizeof(msg), "Erro ao criar memória %s", what);
+        perror(msg);
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t) total) == -1) {
+        snprintf(msg, sizeof(msg), "Erro ao definir tamanho da memória %s",
+                 what);
+        perror(msg);
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        snprintf(msg, sizeof(msg), "Erro ao mapear memória %s", what);
+        perror(msg);
+        return NULL;
+    }
+    return map;
+}
+
+void shm_table_publish(void *header, uint32_t magic)
+{
+    atomic_thread_fence(memory_order_release);
+    *(uint32_t *) header = magic;
+}
+
+void *shm_table_open(const char *name, size_t header_size, uint32_t magic,
+                     size_t total_offset)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t) header_size) {
+        close(fd);
+        return NULL;
+    }
+
+    char *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    uint64_t total;
+    memcpy(&total, map + total_offset, sizeof(total));
+    if (*(const uint32_t *) map != magic || total > (uint64_t) st.st_size) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    return map;
+}
@@ -1,91 +1,586 @@
 #include "common.h"
+#include "history.h"
+#include "latency.h"
+#include "live_config.h"
+#include "logger.h"
+#include "metrics.h"
+#include "stats.h"
+#include "system_config.h"
+#include "telemetry.h"
 
-// Variável de condição para sincronização
-pthread_cond_t data_ready = PTHREAD_COND_INITIALIZER;
-pthread_mutex_t cond_mutex = PTHREAD_MUTEX_INITIALIZER;
-volatile int new_data_available = 0;
+#include <math.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
 
-// Thread para ler mensagens da fila POSIX
-void *message_reader_thread(void *arg)
-{
-    mqd_t mq = *(mqd_t *) arg;
-    char component[] = "MSG_READER";
+// Interface de controle orientada a eventos: uma única thread espera em
+// epoll pela fila de telemetria (telemetry.h), pelo FIFO de controle e por um
+// signalfd (SIGTERM/SIGINT). A cada despertar a fila é drenada até EAGAIN e
+// as mensagens são entregues em lote à thread de processamento por troca de
+// buffers (double buffering): um lock por lote, não por mensagem.
+//
+// Comandos de reconfiguração (stop/start/rate/calibrate/thresholds) são
+// gravados no segmento de configuração dinâmica (live_config.h); sensores e
+// o data_processor aplicam a mudança na próxima iteração, sem reinício.
+// Consultas de histórico (history) leem o segmento do histórico recente
+// (history.h) e respondem pelo FIFO indicado pelo cliente (sensor_ctl).
+
+#define MSG_BATCH_MAX 256      // Mensagens por lote entregue ao worker
+#define CONTROL_READ_MAX 16    // Comandos lidos por read() do FIFO
+#define RATE_REPORT_NS 5000000000ull
 
-    log_message(COLOR_CYAN, component, "Thread leitora de mensagens iniciada");
+typedef struct {
+    uint32_t count;
+    unsigned priorities[MSG_BATCH_MAX];
+    telemetry_msg_t messages[MSG_BATCH_MAX];
+} msg_batch_t;
 
-    char buffer[MAX_MESSAGE_SIZE];
-    unsigned int priority;
+// Troca de lotes entre a thread de eventos e o worker. O worker processa
+// `ready` enquanto a thread de eventos enche `filling`; quando ready é
+// devolvido vazio, os dois são trocados.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready_cond; // Há lote para o worker (ou encerramento)
+    pthread_cond_t free_cond;  // O worker devolveu o lote
+    msg_batch_t *filling;
+    msg_batch_t *ready;
+    int ready_full; // ready contém um lote não processado
+    int stopping;
+} batch_exchange_t;
 
-    while (1) {
-        ssize_t bytes_read =
-            mq_receive(mq, buffer, MAX_MESSAGE_SIZE, &priority);
+static msg_batch_t batch_buffers[2];
+static batch_exchange_t exchange = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .ready_cond = PTHREAD_COND_INITIALIZER,
+    .free_cond = PTHREAD_COND_INITIALIZER,
+    .filling = &batch_buffers[0],
+    .ready = &batch_buffers[1],
+};
+
+// Entrega o lote em preenchimento, se o worker estiver livre. Com wait != 0
+// aguarda o worker (usado quando o lote encheu).
+static void exchange_publish(int wait)
+{
+    if (exchange.filling->count == 0) {
+        return;
+    }
 
-        if (bytes_read >= 0) {
-            buffer[bytes_read] = '\0';
+    pthread_mutex_lock(&exchange.lock);
+    while (wait && exchange.ready_full) {
+        pthread_cond_wait(&exchange.free_cond, &exchange.lock);
+    }
+    if (!exchange.ready_full) {
+        msg_batch_t *tmp = exchange.ready;
+        exchange.ready = exchange.filling;
+        exchange.filling = tmp;
+        exchange.filling->count = 0;
+        exchange.ready_full = 1;
+        pthread_cond_signal(&exchange.ready_cond);
+    }
+    pthread_mutex_unlock(&exchange.lock);
+}
 
-            // Sinalizar com variável de condição
-            pthread_mutex_lock(&cond_mutex);
-            new_data_available = 1;
-            pthread_cond_signal(&data_ready);
-            pthread_mutex_unlock(&cond_mutex);
+// Drena a fila de telemetria até EAGAIN
+static void drain_message_queue(mqd_t mq, uint64_t *received,
+                                uint64_t *invalid)
+{
+    for (;;) {
+        if (exchange.filling->count == MSG_BATCH_MAX) {
+            exchange_publish(1);
+        }
 
-            char msg[512];
-            int len =
-                snprintf(msg, sizeof(msg), "Mensagem recebida: %s", buffer);
-            if (len >= (int) sizeof(msg) - 1) {
-                // Mensagem truncada, adicionar indicador
-                msg[sizeof(msg) - 4] = '.';
-                msg[sizeof(msg) - 3] = '.';
-                msg[sizeof(msg) - 2] = '.';
-                msg[sizeof(msg) - 1] = '\0';
+        // A fila entrega primeiro as mensagens de maior prioridade: alarmes
+        // do data_processor e eventos chegam antes dos resumos enfileirados
+        uint32_t index = exchange.filling->count;
+        telemetry_msg_t *slot = &exchange.filling->messages[index];
+        ssize_t bytes = mq_receive(mq, (char *) slot, sizeof(*slot),
+                                   &exchange.filling->priorities[index]);
+        if (bytes == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                perror("Erro ao receber mensagem");
             }
-            log_message(COLOR_CYAN, component, msg);
-        } else if (errno != EAGAIN) {
-            perror("Erro ao receber mensagem");
             break;
         }
 
-        msleep(100); // 100ms
+        if (!telemetry_msg_valid(slot, bytes)) {
+            (*invalid)++;
+            continue;
+        }
+        exchange.filling->count++;
+        (*received)++;
     }
 
-    return NULL;
+    exchange_publish(0);
 }
 
-// Thread para processar dados quando disponíveis (usando variável de condição)
+// Worker: processa lotes inteiros entregues pela thread de eventos
 void *data_processor_thread(void *arg __attribute__((unused)))
 {
     char component[] = "DATA_PROC_THREAD";
 
     log_message(COLOR_MAGENTA, component, "Thread processadora iniciada");
 
-    while (1) {
-        // Aguardar sinal de variável de condição
-        pthread_mutex_lock(&cond_mutex);
+    uint64_t processed = 0, batches = 0;
+    uint64_t last_processed = 0, last_batches = 0;
+    uint64_t last_report = monotonic_ns();
+
+    pthread_mutex_lock(&exchange.lock);
+    for (;;) {
+        while (!exchange.ready_full && !exchange.stopping) {
+            pthread_cond_wait(&exchange.ready_cond, &exchange.lock);
+        }
+        if (!exchange.ready_full) {
+            break; // Encerrando e sem lote pendente
+        }
+        msg_batch_t *batch = exchange.ready;
+        pthread_mutex_unlock(&exchange.lock);
 
-        while (!new_data_available) {
-            pthread_cond_wait(&data_ready, &cond_mutex);
+        // Processar o lote fora do lock
+        char text[160];
+        for (uint32_t i = 0; i < batch->count; i++) {
+            const telemetry_msg_t *msg = &batch->messages[i];
+            telemetry_format(msg, text, sizeof(text));
+            if (msg->kind == TELEMETRY_SUMMARY) {
+                log_event(LOG_DEBUG, COLOR_CYAN, component, "Resumo: %s",
+                          text);
+            } else if (batch->priorities[i] >= MQ_PRIO_ALARM) {
+                log_event(LOG_WARN, COLOR_RED, component, "Alarme: %s", text);
+            } else {
+                log_event(LOG_INFO, COLOR_CYAN, component, "Evento: %s",
+                          text);
+            }
         }
+        processed += batch->count;
+        batches++;
 
-        new_data_available = 0;
-        pthread_mutex_unlock(&cond_mutex);
+        uint64_t now = monotonic_ns();
+        if (now - last_report >= RATE_REPORT_NS) {
+            double elapsed = (double) (now - last_report) / 1e9;
+            uint64_t n = processed - last_processed;
+            uint64_t b = batches - last_batches;
+            log_event(LOG_INFO, COLOR_MAGENTA, component,
+                      "%.1f mensagens/s (lotes de %.1f em média, último: %s)",
+                      (double) n / elapsed, b ? (double) n / (double) b : 0.0,
+                      text);
+            last_processed = processed;
+            last_batches = batches;
+            last_report = now;
+        }
 
-        // Processar dados
-        log_message(COLOR_MAGENTA, component,
-                    "Processando novos dados disponíveis");
+        pthread_mutex_lock(&exchange.lock);
+        batch->count = 0;
+        exchange.ready_full = 0;
+        pthread_cond_signal(&exchange.free_cond);
     }
+    pthread_mutex_unlock(&exchange.lock);
 
+    log_event(LOG_INFO, COLOR_YELLOW, component,
+              "Thread processadora encerrada (%llu mensagens em %llu lotes)",
+              (unsigned long long) processed, (unsigned long long) batches);
     return NULL;
 }
 
+#define STATUS_MAX_LINES 32 // Sensores listados num status geral
+
+static void log_sensor_stats(int sensor_id, const stats_snapshot_t *snap)
+{
+    log_event(LOG_INFO, COLOR_GREEN, "STATUS",
+              "Sensor-%d %s: n=%llu min=%.2f max=%.2f média=%.3f "
+              "desvio=%.3f ewma=%.2f último=%.2f",
+              sensor_id, sensor_type_name(snap->type),
+              (unsigned long long) snap->count, snap->min, snap->max,
+              snap->mean, sqrt(snap->variance), snap->ewma, snap->last_value);
+    log_event(LOG_INFO, COLOR_GREEN, "STATUS",
+              "Sensor-%d janelas: 1s n=%llu média=%.2f [%.2f, %.2f] | "
+              "10s n=%llu média=%.2f | 60s n=%llu média=%.2f",
+              sensor_id, (unsigned long long) snap->win_1s.count,
+              snap->win_1s.avg, snap->win_1s.min, snap->win_1s.max,
+              (unsigned long long) snap->win_10s.count, snap->win_10s.avg,
+              (unsigned long long) snap->win_60s.count, snap->win_60s.avg);
+}
+
+// Comando de status: lê as estatísticas publicadas pelo data_processor.
+// sensor_id <= 0 lista os sensores com dados (limitado a STATUS_MAX_LINES).
+static void report_status(int sensor_id)
+{
+    stats_shm_t *shm = stats_shm_open();
+    if (shm == NULL) {
+        log_message(COLOR_YELLOW, "STATUS",
+                    "Estatísticas indisponíveis (data_processor ativo?)");
+        return;
+    }
+
+    uint64_t now = monotonic_ns();
+    stats_snapshot_t snap;
+
+    if (sensor_id > 0) {
+        if (stats_query(shm, sensor_id, now, &snap) == 0) {
+            log_sensor_stats(sensor_id, &snap);
+        } else {
+            log_event(LOG_INFO, COLOR_YELLOW, "STATUS",
+                      "Sensor-%d sem dados", sensor_id);
+        }
+    } else {
+        int listed = 0, with_data = 0;
+        for (uint32_t id = 0; id < shm->capacity; id++) {
+            if (stats_query(shm, (int) id, now, &snap) != 0) {
+                continue;
+            }
+            with_data++;
+            if (listed < STATUS_MAX_LINES) {
+                log_sensor_stats((int) id, &snap);
+                listed++;
+            }
+        }
+        log_event(LOG_INFO, COLOR_GREEN, "STATUS",
+                  "%d sensores com dados (%d listados)", with_data, listed);
+    }
+
+    stats_shm_close(shm);
+}
+
+// Comando de latência: percentis por etapa do pipeline sensor → consumidor
+static void report_latency(void)
+{
+    latency_shm_t *shm = latency_shm_open();
+    if (shm == NULL) {
+        log_message(COLOR_YELLOW, "STATUS",
+                    "Latências indisponíveis (data_processor ativo?)");
+        return;
+    }
+    latency_log_summary(shm, "STATUS");
+    latency_shm_close(shm);
+}
+
+#define REPLY_TIMEOUT_MS 1000 // Espera máxima por um cliente lento
+
+// Escreve tudo no FIFO de resposta (não bloqueante), esperando por espaço
+// até o prazo; retorna -1 se o cliente sumiu ou não leu a tempo
+static int reply_write(int fd, const char *buf, size_t len, uint64_t deadline)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n > 0) {
+            buf += n;
+            len -= (size_t) n;
+            continue;
+        }
+        if (n == -1 && errno != EAGAIN && errno != EINTR) {
+            return -1;
+        }
+        uint64_t now = monotonic_ns();
+        if (now >= deadline) {
+            return -1;
+        }
+        struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+        poll(&pfd, 1, (int) ((deadline - now) / 1000000 + 1));
+    }
+    return 0;
+}
+
+// Abre o FIFO de resposta do cliente. O caminho chega pelo FIFO de
+// controle, que qualquer usuário local escreve: sem seguir links e só se
+// for um FIFO, para a resposta não sobrescrever um arquivo qualquer.
+static int reply_open(const char *reply)
+{
+    // O cliente já abriu a ponta de leitura; senão ENXIO e vai ao log
+    int fd = open(reply, O_WRONLY | O_NONBLOCK | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        log_event(LOG_WARN, COLOR_YELLOW, "HISTORY",
+                  "FIFO de resposta %s indisponível: %s", reply,
+                  strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISFIFO(st.st_mode)) {
+        log_event(LOG_WARN, COLOR_YELLOW, "HISTORY",
+                  "Resposta recusada: %s não é um FIFO", reply);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Consulta de histórico: linhas CSV no FIFO de resposta do cliente ou, sem
+// ele, as primeiras linhas no log
+static void report_history(const control_message_t *cmd)
+{
+    static history_row_t rows[HISTORY_QUERY_MAX];
+    const char *reply = cmd->message;
+
+    int fd = -1;
+    if (memchr(reply, '\0', sizeof(cmd->message)) == NULL) {
+        log_event(LOG_WARN, COLOR_YELLOW, "HISTORY",
+                  "Caminho de resposta sem terminação: resposta no log");
+        reply = "";
+    }
+    if (reply[0] != '\0') {
+        fd = reply_open(reply);
+    }
+
+    // Passo em segundos: negativo, NaN ou acima de uint32 não converte
+    int valid_step = cmd->args[0] >= 0.0f && cmd->args[0] < 4294967296.0f;
+    history_result_t result = {0};
+    history_shm_t *shm = valid_step ? history_shm_open() : NULL;
+    uint64_t start = monotonic_ns();
+    int found = shm != NULL &&
+                history_query(shm, cmd->sensor_id, cmd->from_ns, cmd->to_ns,
+                              (uint32_t) cmd->args[0], rows, HISTORY_QUERY_MAX,
+                              &result) == 0;
+    double query_us = (double) (monotonic_ns() - start) / 1e3;
+    history_shm_close(shm);
+
+    char summary[160];
+    if (!valid_step) {
+        snprintf(summary, sizeof(summary), "Passo inválido: %.2f",
+                 cmd->args[0]);
+    } else if (shm == NULL) {
+        snprintf(summary, sizeof(summary),
+                 "Histórico indisponível (data_processor ativo?)");
+    } else if (!found) {
+        snprintf(summary, sizeof(summary), "Sensor-%d sem histórico recente",
+                 cmd->sensor_id);
+    } else {
+        char step[32];
+        if (result.step_s == 0) {
+            snprintf(step, sizeof(step), "leituras");
+        } else {
+            snprintf(step, sizeof(step), "baldes de %u s", result.step_s);
+        }
+        snprintf(summary, sizeof(summary),
+                 "Sensor-%d %s: %u linhas (%s%s), consulta em %.1f us",
+                 cmd->sensor_id, sensor_type_name(result.type), result.rows,
+                 step, result.truncated ? ", truncado" : "", query_us);
+    }
+    log_event(LOG_INFO, COLOR_GREEN, "HISTORY", "%s", summary);
+
+    if (fd == -1) {
+        for (uint32_t i = 0; i < result.rows && i < STATUS_MAX_LINES; i++) {
+            const history_row_t *r = &rows[i];
+            log_event(LOG_INFO, COLOR_GREEN, "HISTORY",
+                      "Sensor-%d %lld n=%u [%.2f, %.2f] média=%.3f",
+                      cmd->sensor_id, (long long) r->t_ns, r->count, r->min,
+                      r->max, r->avg);
+        }
+        return;
+    }
+
+    // Cabeçalho e linhas CSV, acumulados e escritos em blocos
+    char text[8192];
+    size_t len = (size_t) snprintf(text, sizeof(text), "# %s\n%s", summary,
+                                   found ? "# inicio_ns,n,min,max,media\n"
+                                         : "");
+    uint64_t deadline = monotonic_ns() + REPLY_TIMEOUT_MS * 1000000ull;
+    int failed = 0;
+    uint32_t i = 0;
+    do {
+        for (; i < result.rows && len + 96 < sizeof(text); i++) {
+            const history_row_t *r = &rows[i];
+            len += (size_t) snprintf(text + len, sizeof(text) - len,
+                                     "%lld,%u,%.3f,%.3f,%.3f\n",
+                                     (long long) r->t_ns, r->count, r->min,
+                                     r->max, r->avg);
+        }
+        failed = reply_write(fd, text, len, deadline) == -1;
+        len = 0;
+    } while (i < result.rows && !failed);
+
+    if (failed) {
+        log_event(LOG_WARN, COLOR_YELLOW, "HISTORY",
+                  "Resposta para %s interrompida (cliente não leu a tempo)",
+                  reply);
+    }
+    close(fd);
+}
+
+// Segmento de configuração dinâmica (esta interface é a única escritora)
+static live_config_t *live_config = NULL;
+
+// Contadores ao vivo da thread de eventos (sensor_top)
+static metrics_slot_t *metrics = NULL;
+
+static void edit_enabled(live_sensor_view_t *view, void *ctx)
+{
+    view->enabled = *(const int *) ctx;
+}
+
+static void edit_rate(live_sensor_view_t *view, void *ctx)
+{
+    view->rate_hz = ((const float *) ctx)[0];
+}
+
+static void edit_calibration(live_sensor_view_t *view, void *ctx)
+{
+    view->gain = ((const float *) ctx)[0];
+    view->offset = ((const float *) ctx)[1];
+}
+
+// NAN desativa o limite correspondente
+static void edit_thresholds(live_sensor_view_t *view, void *ctx)
+{
+    const float *args = (const float *) ctx;
+    view->flags &= ~(LIVE_HAS_LOW | LIVE_HAS_HIGH);
+    if (!isnan(args[0])) {
+        view->low = args[0];
+        view->flags |= LIVE_HAS_LOW;
+    }
+    if (!isnan(args[1])) {
+        view->high = args[1];
+        view->flags |= LIVE_HAS_HIGH;
+    }
+}
+
+static void apply_live_config(const control_message_t *cmd)
+{
+    if (live_config == NULL) {
+        log_event(LOG_WARN, COLOR_YELLOW, "CONTROL",
+                  "Configuração dinâmica indisponível");
+        return;
+    }
+
+    live_config_edit_fn edit;
+    int enabled = cmd->command == 1;
+    void *ctx = (void *) cmd->args;
+    switch (cmd->command) {
+    case 0:
+    case 1:
+        edit = edit_enabled;
+        ctx = &enabled;
+        break;
+    case 5:
+        if (!(cmd->args[0] >= 0.0f)) {
+            log_event(LOG_WARN, COLOR_YELLOW, "CONTROL",
+                      "Taxa inválida: %.2f", cmd->args[0]);
+            return;
+        }
+        edit = edit_rate;
+        break;
+    case 6:
+        if (isnan(cmd->args[0]) || isnan(cmd->args[1])) {
+            log_event(LOG_WARN, COLOR_YELLOW, "CONTROL",
+                      "Calibração inválida");
+            return;
+        }
+        edit = edit_calibration;
+        break;
+    default:
+        edit = edit_thresholds;
+        break;
+    }
+
+    if (live_config_edit(live_config, cmd->sensor_id, edit, ctx) != 0) {
+        log_event(LOG_WARN, COLOR_YELLOW, "CONTROL",
+                  "Sensor inválido: %d", cmd->sensor_id);
+        return;
+    }
+
+    char target[32];
+    if (cmd->sensor_id > 0) {
+        snprintf(target, sizeof(target), "Sensor-%d", cmd->sensor_id);
+    } else {
+        snprintf(target, sizeof(target), "todos os sensores");
+    }
+    log_event(LOG_INFO, COLOR_GREEN, "CONTROL",
+              "Configuração aplicada a %s (comando %d, args=%.2f, %.2f)",
+              target, cmd->command, cmd->args[0], cmd->args[1]);
+}
+
+// Trata um comando do FIFO; retorna 1 para encerrar
+static int handle_command(const control_message_t *cmd)
+{
+    log_event(LOG_INFO, COLOR_GREEN, "CONTROL",
+              "Comando recebido: %d (sensor=%d)", cmd->command,
+              cmd->sensor_id);
+    metrics_add(metrics, METRIC_COMMANDS, 1);
+
+    switch (cmd->command) {
+    case 0: // Stop
+    case 1: // Start
+    case 5: // Taxa de amostragem
+    case 6: // Calibração
+    case 7: // Limites de alarme
+        apply_live_config(cmd);
+        break;
+    case 2: // Status
+        report_status(cmd->sensor_id);
+        break;
+    case 3: // Shutdown
+        return 1;
+    case 4: // Latência
+        report_latency();
+        break;
+    case 8: // Histórico
+        report_history(cmd);
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+// Lê todos os comandos disponíveis (registros menores que PIPE_BUF chegam
+// inteiros); retorna 1 se algum pediu encerramento
+static int drain_control_fifo(int control_fd)
+{
+    control_message_t cmds[CONTROL_READ_MAX];
+    for (;;) {
+        ssize_t bytes = read(control_fd, cmds, sizeof(cmds));
+        if (bytes == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                perror("Erro ao ler FIFO de controle");
+            }
+            return 0;
+        }
+
+        size_t n = (size_t) bytes / sizeof(control_message_t);
+        for (size_t i = 0; i < n; i++) {
+            if (handle_command(&cmds[i])) {
+                return 1;
+            }
+        }
+        if ((size_t) bytes < sizeof(cmds)) {
+            return 0; // FIFO esvaziado
+        }
+    }
+}
+
+static int epoll_add(int epfd, int fd)
+{
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
 int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
 {
     log_message(COLOR_BLUE, "CONTROL", "Iniciando interface de controle");
 
-    // Criar/Abrir fila de mensagens POSIX
-    struct mq_attr attr = {
-        .mq_flags = 0, .mq_maxmsg = 10, .mq_msgsize = MAX_MESSAGE_SIZE};
+    // SIGTERM/SIGINT passam a ser eventos do loop (signalfd). Bloquear antes
+    // de criar threads para que todas herdem a máscara.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd == -1) {
+        perror("Erro ao criar signalfd");
+        exit(1);
+    }
 
-    mqd_t mq = mq_open(MQ_NAME, O_CREAT | O_RDONLY, 0666, &attr);
+    // Criar/Abrir fila de telemetria (não bloqueante: drenada até EAGAIN),
+    // com a profundidade da configuração do sistema (SENSOR_CONFIG)
+    system_config_t config;
+    system_config_default(&config);
+    if (system_config_load(&config, NULL) == -1) {
+        exit(1);
+    }
+    mqd_t mq = telemetry_mq_open(O_RDONLY | O_NONBLOCK, config.mq_depth);
     if (mq == (mqd_t) -1) {
         perror("Erro ao criar/abrir fila de mensagens");
         exit(1);
@@ -93,52 +588,88 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
 
     // Criar/Abrir FIFO de controle
     mkfifo(FIFO_CONTROL, 0666);
-    int control_fd = open(FIFO_CONTROL, O_RDWR);
+    int control_fd = open(FIFO_CONTROL, O_RDWR | O_NONBLOCK);
     if (control_fd == -1) {
         perror("Erro ao abrir FIFO de controle");
         mq_close(mq);
         exit(1);
     }
 
-    // Criar threads
-    pthread_t reader_thread, processor_thread;
+    // Sem configuração dinâmica a interface continua recebendo mensagens;
+    // apenas os comandos de reconfiguração ficam indisponíveis
+    live_config = live_config_open();
+    metrics = metrics_register("control");
 
-    if (pthread_create(&reader_thread, NULL, message_reader_thread, &mq) != 0) {
-        perror("Erro ao criar thread leitora");
+    // No Linux o descritor da fila POSIX pode ser monitorado por epoll
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1 || epoll_add(epfd, (int) mq) == -1 ||
+        epoll_add(epfd, control_fd) == -1 || epoll_add(epfd, signal_fd) == -1) {
+        perror("Erro ao configurar epoll");
         exit(1);
     }
 
+    pthread_t processor_thread;
     if (pthread_create(&processor_thread, NULL, data_processor_thread, NULL) !=
         0) {
         perror("Erro ao criar thread processadora");
         exit(1);
     }
 
-    // Ler comandos do FIFO de controle
     log_message(COLOR_BLUE, "CONTROL", "Aguardando comandos de controle...");
+    notify_ready();
 
-    control_message_t cmd;
-    while (read(control_fd, &cmd, sizeof(control_message_t)) > 0) {
-        char msg[256];
-        snprintf(msg, sizeof(msg), "Comando recebido: %d (sensor=%d)",
-                 cmd.command, cmd.sensor_id);
-        log_message(COLOR_GREEN, "CONTROL", msg);
-
-        if (cmd.command == 3) { // Shutdown
+    uint64_t received = 0;
+    uint64_t invalid = 0;
+    int running = 1;
+    while (running) {
+        struct epoll_event events[4];
+        int n = epoll_wait(epfd, events, 4, -1);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Erro em epoll_wait");
             break;
         }
+
+        for (int i = 0; i < n && running; i++) {
+            int fd = events[i].data.fd;
+            if (fd == (int) mq) {
+                drain_message_queue(mq, &received, &invalid);
+            } else if (fd == control_fd) {
+                running = !drain_control_fifo(control_fd);
+            } else if (fd == signal_fd) {
+                struct signalfd_siginfo info;
+                if (read(signal_fd, &info, sizeof(info)) > 0) {
+                    log_event(LOG_INFO, COLOR_YELLOW, "CONTROL",
+                              "Sinal %u recebido", info.ssi_signo);
+                    running = 0;
+                }
+            }
+        }
+        metrics_set(metrics, METRIC_MQ_RECEIVED, received);
+        metrics_touch(metrics, monotonic_ns());
     }
 
-    // Cleanup
-    pthread_cancel(reader_thread);
-    pthread_cancel(processor_thread);
-    pthread_join(reader_thread, NULL);
+    // Entregar o que restou e encerrar o worker
+    exchange_publish(1);
+    pthread_mutex_lock(&exchange.lock);
+    exchange.stopping = 1;
+    pthread_cond_signal(&exchange.ready_cond);
+    pthread_mutex_unlock(&exchange.lock);
     pthread_join(processor_thread, NULL);
 
+    close(epfd);
+    close(signal_fd);
     close(control_fd);
     mq_close(mq);
+    live_config_close(live_config);
+    metrics_unregister(metrics);
 
-    log_message(COLOR_BLUE, "CONTROL", "Interface de controle encerrada");
+    log_event(LOG_INFO, COLOR_BLUE, "CONTROL",
+              "Interface de controle encerrada (%llu mensagens recebidas, "
+              "%llu inválidas)",
+              (unsigned long long) received, (unsigned long long) invalid);
 
     return 0;
 }
@@ -1,124 +1,1222 @@
 #include "common.h"
+#include "history.h"
+#include "latency.h"
+#include "live_config.h"
+#include "logger.h"
+#include "metrics.h"
+#include "net.h"
+#include "overload.h"
+#include "ring.h"
+#include "rt.h"
+#include "rules.h"
+#include "stats.h"
+#include "system_config.h"
+#include "telemetry.h"
+#include "transport.h"
+#include "tsdb.h"
 
-// Buffer compartilhado (produtor-consumidor)
-circular_buffer_t *shared_buffer = NULL;
+#include <poll.h>
+#include <sched.h>
+
+// Segmento compartilhado com os sensores: no modo SHM eles publicam
+// diretamente no ring do shard de cada sensor (produtor-consumidor entre
+// processos). Cada shard tem exatamente um consumidor, fixado em um core:
+// amostras de um sensor são processadas em ordem e os consumidores não
+// disputam as mesmas linhas de cache.
+sample_shm_t *sample_shm = NULL;
+uint32_t num_shards = 0;
 volatile int processor_running = 1;
 
-// Inicializar buffer circular
-void init_buffer(circular_buffer_t *buf)
+// Ingestão pela rede (net_ingest): sensores de outros nós, por UDP e TCP
+net_receiver_t *net_receiver = NULL;
+
+// Política de sobrecarga publicada no segmento (-o / SENSOR_OVERLOAD) e
+// atraso artificial por amostra para simular um consumidor lento (-d)
+overload_config_t overload_config;
+long consumer_delay_us = 0;
+
+// Ocupação do ring verificada a cada tantas amostras retiradas
+#define WATERMARK_CHECK_EVERY 16
+
+// Regras de alarme compiladas na carga (-R / SENSOR_RULES), compartilhadas
+// pelos consumidores, e fila por onde os alarmes saem com prioridade alta
+rule_table_t rule_table;
+mqd_t alarm_mq = (mqd_t) -1;
+
+// Alarmes que encontraram a fila cheia esperam aqui pela próxima tentativa
+#define ALARM_PENDING_MAX 64
+
+// Histórico (-P / SENSOR_TSDB): cada consumidor repassa as amostras
+// processadas por um ring próprio a uma única thread de persistência, que
+// as grava nos segmentos. O consumidor nunca espera pelo disco; com o ring
+// cheio a amostra fica fora do histórico e é contada.
+tsdb_config_t tsdb_config;
+sample_ring_t *persist_rings[SAMPLE_MAX_SHARDS];
+size_t persist_ring_size = 0;
+volatile int persist_running = 1;
+
+#define PERSIST_RING_CAPACITY 8192
+#define PERSIST_DRAIN_MAX 256 // Amostras retiradas de um ring por vez
+#define PERSIST_IDLE_MS 5
+
+// Estatísticas por sensor e histogramas de latência: uma tabela por
+// consumidor (único escritor)
+stats_shm_t *stats_shm = NULL;
+latency_shm_t *latency_shm = NULL;
+
+// Histórico recente consultado pela control_interface (-H sensores, 0 =
+// desligado): cada consumidor grava os sensores do seu shard
+history_shm_t *history_shm = NULL;
+long history_sensors = HISTORY_DEFAULT_SENSORS;
+
+// Limites de alarme (configuração dinâmica). Cada shard mantém uma view
+// por sensor_id, sem colisões: o estado do alarme não se perde quando outro
+// sensor aparece, e a verificação custa uma leitura atômica da versão da
+// entrada enquanto ela não muda. O calloc só ocupa as páginas dos sensores
+// que o shard de fato recebe.
+live_config_t *live_config = NULL;
+
+typedef struct {
+    int loaded; // 0 = view ainda não inicializada
+    int state;  // Último resultado de live_check_limits
+    live_sensor_view_t view;
+} limit_cache_entry_t;
+
+// Saída de alarmes de um consumidor
+typedef struct {
+    const char *component;
+    metrics_slot_t *metrics;
+    telemetry_msg_t pending[ALARM_PENDING_MAX];
+    uint32_t npending;
+    uint64_t raised;
+    uint64_t dropped; // Fila cheia e pendentes esgotados
+} alarm_output_t;
+
+// Estado das marcas alta/baixa do ring de um consumidor
+typedef struct {
+    int overloaded;
+    uint64_t since_ns;
+    uint64_t drops_at_high[OVERLOAD_DROP_COUNT];
+} watermark_t;
+
+// Estado de um shard, independente da thread que o atende: o pool pode
+// passar o shard de um consumidor a outro sem perder o estado das regras, o
+// cache de limites ou as marcas do ring. Um shard tem no máximo um dono por
+// vez (owner), então estatísticas e histórico continuam com um único
+// escritor por sensor.
+typedef struct {
+    uint32_t shard;
+    sample_ring_t *ring;
+    stats_table_t stats;
+    latency_table_t *latency;
+    limit_cache_entry_t *limits;
+    rule_engine_t engine;
+    alarm_output_t alarm_out;
+    watermark_t watermark;
+    uint64_t processed;
+    _Atomic int assigned; // Consumidor que deve atendê-lo (id, 0 = nenhum)
+    _Atomic int owner;    // Consumidor que o atende agora (0 = nenhum)
+} shard_state_t;
+
+typedef struct {
+    int id;  // 1..max
+    int cpu; // -1 = sem afinidade
+    pthread_t thread;
+    _Atomic int active;       // 0 = devolver os shards e terminar
+    _Atomic uint64_t busy_ns; // Tempo processando lotes (utilização)
+    uint64_t busy_seen;       // Última leitura do controlador
+} consumer_t;
+
+// Pool de consumidores (-S consumers=, adaptive=): os shards são divididos
+// entre os consumidores ativos (shard s → consumidor s % tamanho). No modo
+// adaptativo a thread principal observa a ocupação dos rings e a utilização
+// dos consumidores a cada intervalo e cresce ou encolhe o pool de um em um;
+// a redistribuição é feita pela troca de dono dos shards, sem parar a
+// ingestão. O pool vai de 1 ao número de shards (a unidade de paralelismo).
+typedef struct {
+    consumer_t consumers[SAMPLE_MAX_SHARDS];
+    uint32_t size; // Consumidores em execução
+    uint32_t min;
+    uint32_t max;
+    _Atomic uint32_t generation; // Muda a cada redistribuição
+    uint32_t calm;               // Intervalos seguidos com folga
+    uint64_t last_ns;
+    uint64_t resizes;
+} consumer_pool_t;
+
+static shard_state_t shard_states[SAMPLE_MAX_SHARDS];
+static consumer_pool_t pool;
+static system_config_t config;
+static long ncpus = 1;
+
+// Espera no ring de um shard quando o consumidor atende vários: curta, para
+// olhar os demais (com um shard só a espera é a de sempre, 100 ms)
+#define POOL_SHARED_WAIT_MS 2
+// Intervalos seguidos com folga antes de encolher (histerese)
+#define POOL_SHRINK_AFTER 4
+
+// Registros lidos do FIFO por chamada read() (staging de ~64 KiB)
+#define INGEST_BATCH_RECORDS (65536 / sizeof(sensor_data_t))
+
+// Distribui amostras recebidas (FIFO ou rede) por shard mantendo a ordem
+// de chegada de cada sensor (counting sort estável, via sharded) e publica
+// cada grupo com uma reserva, segundo a política de sobrecarga
+static void publish_samples(const sensor_data_t *incoming, uint32_t records,
+                            sensor_data_t *sharded, overload_state_t *overload,
+                            metrics_slot_t *metrics)
 {
-    buf->read_pos = 0;
-    buf->write_pos = 0;
-    buf->count = 0;
-    sem_init(&buf->empty_slots, 0, BUFFER_SIZE);
-    sem_init(&buf->full_slots, 0, 0);
-    pthread_mutex_init(&buf->mutex, NULL);
+    uint32_t start[SAMPLE_MAX_SHARDS + 1] = {0};
+    for (uint32_t i = 0; i < records; i++) {
+        start[sample_shard_of(incoming[i].sensor_id, num_shards) + 1]++;
+    }
+    for (uint32_t s = 0; s < num_shards; s++) {
+        start[s + 1] += start[s];
+    }
+    uint32_t next[SAMPLE_MAX_SHARDS];
+    memcpy(next, start, sizeof(next));
+    uint64_t now = monotonic_ns();
+    metrics_add(metrics, METRIC_SAMPLES_RECEIVED, records);
+    metrics_touch(metrics, now);
+    for (uint32_t i = 0; i < records; i++) {
+        uint32_t s = sample_shard_of(incoming[i].sensor_id, num_shards);
+        sensor_data_t *dst = &sharded[next[s]++];
+        *dst = incoming[i];
+        dst->t_ingest = now; // Ingestão = recebimento
+    }
+
+    for (uint32_t s = 0; s < num_shards; s++) {
+        uint32_t handled = start[s];
+        uint32_t published = 0;
+        int ring_full = 0;
+        while (handled < start[s + 1] && processor_running) {
+            uint32_t remaining = start[s + 1] - handled;
+            uint32_t n;
+            uint32_t done = sample_shm_offer(sample_shm, s, sharded + handled,
+                                             remaining, overload, 100, &n);
+            ring_full |= done < remaining || n < done;
+            handled += done;
+            published += n;
+        }
+        metrics_add(metrics, METRIC_RING_FULL, (uint64_t) ring_full);
+        metrics_add(metrics, METRIC_SAMPLES_SENT, published);
+        metrics_add(metrics, METRIC_SAMPLES_DROPPED, start[s + 1] - handled);
+    }
+    overload_report(overload, metrics);
 }
 
-// Produtor: lê dados do FIFO e coloca no buffer
+// Produtor: lê dados do FIFO (modo alternativo) em lotes e coloca no buffer.
+// Cada read() traz tantos bytes quanto houver no pipe; registros e quadros
+// parciais ficam no início do buffer de staging até serem completados. Os
+// quadros compactados rendem mais amostras por byte, então um staging cheio
+// pode precisar de vários lotes antes do próximo read().
 void *producer_thread(void *arg)
 {
     int fifo_fd = *(int *) arg;
     char component[] = "PRODUTOR";
 
-    log_message(COLOR_CYAN, component, "Thread produtora iniciada");
+    log_message(COLOR_CYAN, component, "Thread produtora iniciada (FIFO)");
+    metrics_slot_t *metrics = metrics_register("produtor");
+    rt_apply_thread(&config.rt, RT_ROLE_PRODUCER, -1, component);
+
+    // Com política diferente de BLOCK a thread nunca espera pelo ring: o
+    // pipe continua sendo drenado e os sensores não travam em write()
+    overload_state_t overload;
+    overload_state_init(&overload, (uint32_t) getpid());
+
+    static sensor_data_t staging[INGEST_BATCH_RECORDS];
+    static sensor_data_t incoming[INGEST_BATCH_RECORDS];
+    static sensor_data_t sharded[INGEST_BATCH_RECORDS];
+    char *staging_bytes = (char *) staging;
+    size_t fill = 0; // Bytes válidos em staging (inclui registro parcial)
+    int backlog = 0; // staging ainda tem amostras completas a separar
+
+    struct pollfd pfd = {.fd = fifo_fd, .events = POLLIN};
 
     while (processor_running) {
-        sensor_data_t data;
-        ssize_t bytes_read = read(fifo_fd, &data, sizeof(sensor_data_t));
-
-        if (bytes_read == sizeof(sensor_data_t)) {
-            // Aguardar slot vazio (semáforo)
-            sem_wait(&shared_buffer->empty_slots);
-
-            // Entrar na seção crítica (mutex)
-            pthread_mutex_lock(&shared_buffer->mutex);
-
-            // Escrever no buffer circular
-            shared_buffer->buffer[shared_buffer->write_pos] = data;
-            shared_buffer->write_pos =
-                (shared_buffer->write_pos + 1) % BUFFER_SIZE;
-            shared_buffer->count++;
-
-            // Sair da seção crítica
-            pthread_mutex_unlock(&shared_buffer->mutex);
-
-            // Sinalizar slot cheio
-            sem_post(&shared_buffer->full_slots);
-
-            char msg[128];
-            snprintf(msg, sizeof(msg), "Dados recebidos: Sensor-%d %s=%.2f",
-                     data.sensor_id, sensor_type_name(data.type), data.value);
-            log_message(COLOR_CYAN, component, msg);
-        } else if (bytes_read == 0) {
-            // FIFO fechado
-            break;
-        } else if (bytes_read == -1 && errno != EAGAIN) {
-            perror("Erro ao ler FIFO");
-            break;
+        if (!backlog) {
+            // poll com timeout para poder verificar processor_running
+            if (poll(&pfd, 1, 100) <= 0) {
+                if (overload.pending.count > 0) {
+                    uint32_t n; // Publicar amostras retidas (COALESCE)
+                    sample_shm_offer(sample_shm, 0, NULL, 0, &overload, 0,
+                                     &n);
+                    metrics_add(metrics, METRIC_SAMPLES_SENT, n);
+                }
+                continue;
+            }
+
+            ssize_t bytes_read =
+                read(fifo_fd, staging_bytes + fill, sizeof(staging) - fill);
+
+            if (bytes_read == 0) {
+                // FIFO fechado
+                break;
+            } else if (bytes_read == -1) {
+                if (errno == EAGAIN || errno == EINTR) {
+                    continue;
+                }
+                perror("Erro ao ler FIFO");
+                break;
+            }
+            fill += (size_t) bytes_read;
+        }
+
+        uint32_t records;
+        size_t consumed;
+        int parsed = sample_stream_parse(staging_bytes, fill, incoming,
+                                        INGEST_BATCH_RECORDS, &records,
+                                        &consumed);
+        if (parsed == -1) {
+            // Sem como ressincronizar dentro do fluxo: descarta o staging
+            log_event(LOG_ERROR, COLOR_RED, component,
+                      "Quadro inválido no FIFO, %zu bytes descartados", fill);
+            fill = 0;
+            backlog = 0;
+            continue;
         }
+        backlog = parsed;
+        if (records == 0) {
+            continue; // Só um pedaço de registro até agora
+        }
+
+        publish_samples(incoming, records, sharded, &overload, metrics);
+
+        // Mover o que sobrou (parcial ou ainda não separado) para o início
+        size_t partial = fill - consumed;
+        if (partial > 0) {
+            memmove(staging_bytes, staging_bytes + consumed, partial);
+        }
+        fill = partial;
+
+        log_event(LOG_INFO, COLOR_CYAN, component,
+                  "Lote recebido: %u amostras (%zu bytes)", records, consumed);
     }
 
+    overload_state_free(&overload);
+    metrics_unregister(metrics);
     log_message(COLOR_YELLOW, component, "Thread produtora encerrada");
     return NULL;
 }
 
-// Consumidor: processa dados do buffer
+// Recepção pela rede: mesma distribuição por shard do FIFO, com os quadros
+// de todos os emissores (UDP e conexões TCP) num só epoll. As lacunas de
+// sequência são quadros perdidos no caminho (métrica perdas_rede).
+void *net_thread(void *arg)
+{
+    net_receiver_t *rx = (net_receiver_t *) arg;
+    char component[] = "REDE";
+
+    log_message(COLOR_CYAN, component, "Thread de recepção iniciada (rede)");
+    metrics_slot_t *metrics = metrics_register("rede");
+    rt_apply_thread(&config.rt, RT_ROLE_PRODUCER, -1, component);
+
+    overload_state_t overload;
+    overload_state_init(&overload, (uint32_t) getpid());
+
+    static sensor_data_t incoming[NET_POLL_SAMPLES];
+    static sensor_data_t sharded[NET_POLL_SAMPLES];
+    uint64_t lost_seen = 0;
+    uint64_t lost_logged_ns = 0;
+
+    while (processor_running) {
+        int n = net_receiver_poll(rx, incoming, NET_POLL_SAMPLES, 100);
+        if (n == -1) {
+            perror("Erro ao receber da rede");
+            break;
+        }
+        if (n == 0) {
+            if (overload.pending.count > 0) {
+                uint32_t published; // Publicar amostras retidas (COALESCE)
+                sample_shm_offer(sample_shm, 0, NULL, 0, &overload, 0,
+                                 &published);
+                metrics_add(metrics, METRIC_SAMPLES_SENT, published);
+            }
+            continue;
+        }
+        publish_samples(incoming, (uint32_t) n, sharded, &overload, metrics);
+
+        net_stats_t stats;
+        net_receiver_stats(rx, &stats);
+        metrics_set(metrics, METRIC_NET_LOST, stats.lost);
+        uint64_t now = monotonic_ns();
+        if (stats.lost > lost_seen && now - lost_logged_ns >= 1000000000ull) {
+            // No máximo um aviso por segundo
+            log_event(LOG_WARN, COLOR_YELLOW, component,
+                      "%llu quadros perdidos na rede (total %llu)",
+                      (unsigned long long) (stats.lost - lost_seen),
+                      (unsigned long long) stats.lost);
+            lost_seen = stats.lost;
+            lost_logged_ns = now;
+        }
+    }
+
+    overload_state_free(&overload);
+    metrics_unregister(metrics);
+    log_message(COLOR_YELLOW, component, "Thread de recepção encerrada");
+    return NULL;
+}
+
+// Verifica os limites do sensor; loga apenas ao entrar/sair do alarme.
+// Retorna 1 se a amostra está fora dos limites.
+static int check_limits(limit_cache_entry_t *cache, const sensor_data_t *data,
+                        const char *component)
+{
+    if (data->sensor_id < 0 ||
+        (uint32_t) data->sensor_id >= LIVE_CONFIG_MAX_SENSORS) {
+        return 0; // Fora da tabela: sem limites configuráveis
+    }
+    limit_cache_entry_t *e = &cache[data->sensor_id];
+    if (!e->loaded) {
+        e->loaded = 1;
+        live_view_defaults(&e->view);
+    }
+    live_config_poll(live_config, data->sensor_id, &e->view);
+
+    int state = live_check_limits(&e->view, data->value);
+    if (state != e->state) {
+        if (state != 0) {
+            log_event(LOG_WARN, COLOR_RED, component,
+                      "ALARME: Sensor-%d %s=%.2f %s do limite (%.2f)",
+                      data->sensor_id, sensor_type_name(data->type),
+                      data->value, state < 0 ? "abaixo" : "acima",
+                      state < 0 ? e->view.low : e->view.high);
+        } else {
+            log_event(LOG_INFO, COLOR_GREEN, component,
+                      "Sensor-%d voltou aos limites (%.2f)", data->sensor_id,
+                      data->value);
+        }
+        e->state = state;
+    }
+    return state != 0;
+}
+
+// Marcas do ring: um evento ao cruzar a marca alta e outro ao voltar abaixo
+// da baixa, com a duração e os descartes do período. A histerese evita uma
+// enxurrada de eventos quando a ocupação oscila em torno de uma marca.
+static void check_watermarks(watermark_t *wm, uint32_t shard, uint32_t depth,
+                             metrics_slot_t *metrics, const char *component)
+{
+    const overload_config_t *cfg = &sample_shm->overload;
+    overload_shard_t *ov = &sample_shm->overload_shards[shard];
+
+    if (!wm->overloaded && depth >= cfg->high_mark) {
+        wm->overloaded = 1;
+        wm->since_ns = monotonic_ns();
+        for (int r = 0; r < OVERLOAD_DROP_COUNT; r++) {
+            wm->drops_at_high[r] =
+                sample_shm_drops(sample_shm, shard, (overload_drop_t) r);
+        }
+        atomic_store_explicit(&ov->overloaded, 1, memory_order_relaxed);
+        uint32_t events =
+            atomic_load_explicit(&ov->high_events, memory_order_relaxed);
+        atomic_store_explicit(&ov->high_events, events + 1,
+                              memory_order_relaxed);
+        metrics_add(metrics, METRIC_OVERLOAD_EVENTS, 1);
+
+        char policy[32];
+        overload_format(cfg, policy, sizeof(policy));
+        log_event(LOG_WARN, COLOR_YELLOW, component,
+                  "Sobrecarga: fila do shard %u em %u/%u (marca alta %u, "
+                  "política %s)",
+                  shard, depth, sample_shm->capacity, cfg->high_mark, policy);
+    } else if (wm->overloaded && depth <= cfg->low_mark) {
+        wm->overloaded = 0;
+        atomic_store_explicit(&ov->overloaded, 0, memory_order_relaxed);
+
+        uint64_t d[OVERLOAD_DROP_COUNT];
+        for (int r = 0; r < OVERLOAD_DROP_COUNT; r++) {
+            d[r] = sample_shm_drops(sample_shm, shard, (overload_drop_t) r) -
+                   wm->drops_at_high[r];
+        }
+        log_event(LOG_INFO, COLOR_GREEN, component,
+                  "Fila do shard %u normalizada após %.1f ms; descartes: "
+                  "novas=%llu antigas=%llu coalescidas=%llu amostragem=%llu",
+                  shard, (double) (monotonic_ns() - wm->since_ns) / 1e6,
+                  (unsigned long long) d[OVERLOAD_DROPPED_NEWEST],
+                  (unsigned long long) d[OVERLOAD_DROPPED_OLDEST],
+                  (unsigned long long) d[OVERLOAD_DROPPED_COALESCED],
+                  (unsigned long long) d[OVERLOAD_DROPPED_SAMPLED]);
+    }
+}
+
+// Reenvia alarmes que encontraram a fila cheia, na ordem em que ocorreram
+static void alarm_flush(alarm_output_t *out)
+{
+    uint32_t sent = 0;
+    while (sent < out->npending && alarm_mq != (mqd_t) -1 &&
+           mq_send(alarm_mq, (const char *) &out->pending[sent],
+                   sizeof(out->pending[sent]), MQ_PRIO_ALARM) == 0) {
+        sent++;
+    }
+    if (sent > 0) {
+        metrics_add(out->metrics, METRIC_MQ_SENT, sent);
+        memmove(&out->pending[0], &out->pending[sent],
+                (size_t) (out->npending - sent) * sizeof(out->pending[0]));
+        out->npending -= sent;
+    }
+}
+
+// Mudança de estado de uma regra: log e evento de prioridade alta na fila de
+// telemetria, à frente dos resumos dos sensores
+static void emit_alarm(const rule_event_t *event, void *ctx)
+{
+    alarm_output_t *out = (alarm_output_t *) ctx;
+    double detect_us = (double) (monotonic_ns() - event->t_created) / 1e3;
+    const char *name = rule_table.name[event->rule];
+
+    if (event->active) {
+        char rule[96];
+        rules_describe(&rule_table, event->rule, rule, sizeof(rule));
+        out->raised++;
+        metrics_add(out->metrics, METRIC_RULE_ALARMS, 1);
+        log_event(LOG_WARN, COLOR_RED, out->component,
+                  "ALARME %s: Sensor-%d %s=%.2f (%s), detectado em %.1f us",
+                  name, event->sensor_id, sensor_type_name(event->type),
+                  event->value, rule, detect_us);
+    } else {
+        log_event(LOG_INFO, COLOR_GREEN, out->component,
+                  "Alarme %s normalizado: Sensor-%d %s=%.2f", name,
+                  event->sensor_id, sensor_type_name(event->type),
+                  event->value);
+    }
+
+    alarm_flush(out);
+    if (out->npending == ALARM_PENDING_MAX) {
+        out->dropped++;
+        metrics_add(out->metrics, METRIC_MQ_DROPPED, 1);
+        return;
+    }
+    telemetry_event_init(&out->pending[out->npending++],
+                         event->active ? TELEMETRY_EVENT_ALARM_ON
+                                       : TELEMETRY_EVENT_ALARM_OFF,
+                         event->sensor_id, event->type, event->value, name);
+    alarm_flush(out);
+}
+
+// Processa um lote retirado do ring do shard (dono: a thread chamadora)
+static void consume_batch(shard_state_t *sh, sensor_data_t *batch,
+                          uint32_t count, uint64_t t_dequeue,
+                          metrics_slot_t *metrics, const char *component,
+                          uint64_t *alarms)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        const sensor_data_t *data = &batch[i];
+
+        // Atualizar estatísticas incrementais do sensor (sem locks)
+        stats_update(&sh->stats, data, t_dequeue);
+        if (history_shm != NULL) {
+            history_record(history_shm, data);
+        }
+
+        int alarm = check_limits(sh->limits, data, component);
+        *alarms += (uint64_t) alarm;
+
+        latency_record_sample(sh->latency, data, t_dequeue, monotonic_ns());
+
+        sh->processed++;
+        metrics_add(metrics, METRIC_ALARMS, (uint64_t) alarm);
+        if (sh->processed % WATERMARK_CHECK_EVERY == 0) {
+            uint32_t depth = ring_depth(sh->ring);
+            metrics_set(metrics, METRIC_QUEUE_DEPTH, depth);
+            check_watermarks(&sh->watermark, sh->shard, depth, metrics,
+                             component);
+        }
+        if (consumer_delay_us > 0) {
+            // Consumidor lento simulado (testes de sobrecarga)
+            struct timespec ts = {.tv_sec = consumer_delay_us / 1000000,
+                                  .tv_nsec =
+                                      (consumer_delay_us % 1000000) * 1000};
+            nanosleep(&ts, NULL);
+        }
+        if (sh->processed % 5 == 0 && log_enabled(LOG_INFO)) {
+            uint32_t id = (uint32_t) data->sensor_id;
+            if (id < sh->stats.capacity) {
+                log_event(LOG_INFO, COLOR_MAGENTA, component,
+                          "Processado: Sensor-%d %s=%.2f (média=%.2f, "
+                          "ewma=%.2f, n=%llu, shard %u: %llu)",
+                          data->sensor_id, sensor_type_name(data->type),
+                          data->value, sh->stats.mean[id],
+                          sh->stats.ewma[id],
+                          (unsigned long long) sh->stats.count[id], sh->shard,
+                          (unsigned long long) sh->processed);
+            }
+        }
+    }
+    metrics_add(metrics, METRIC_SAMPLES_RECEIVED, count);
+    metrics_touch(metrics, t_dequeue);
+
+    // Regras de alarme sobre o lote inteiro
+    rule_engine_eval(&sh->engine, batch, count, emit_alarm, &sh->alarm_out);
+
+    sample_ring_t *persist = persist_rings[sh->shard];
+    if (persist != NULL) {
+        uint32_t queued = ring_try_push_batch(persist, batch, count);
+        metrics_add(metrics, METRIC_PERSIST_DROPPED, count - queued);
+    }
+}
+
+// Acerta os shards do consumidor com a distribuição atual: devolve os que
+// passaram a outro e assume os seus assim que o dono anterior os soltar.
+// Retorna 1 se todos os shards atribuídos já foram assumidos.
+static int consumer_sync(consumer_t *c, const char *component,
+                         metrics_slot_t *metrics, uint32_t *owned,
+                         uint32_t *nowned)
+{
+    int active = atomic_load(&c->active);
+    int settled = 1;
+    uint32_t n = 0;
+    for (uint32_t s = 0; s < num_shards; s++) {
+        shard_state_t *sh = &shard_states[s];
+        int want = active && atomic_load_explicit(&sh->assigned,
+                                                  memory_order_acquire) ==
+                                 c->id;
+        int owner = atomic_load_explicit(&sh->owner, memory_order_acquire);
+        if (owner == c->id) {
+            if (want) {
+                owned[n++] = s;
+                continue;
+            }
+            // Alarmes pendentes saem antes de soltar o shard
+            alarm_flush(&sh->alarm_out);
+            atomic_store_explicit(&sh->owner, 0, memory_order_release);
+        } else if (want) {
+            int expected = 0;
+            if (atomic_compare_exchange_strong_explicit(
+                    &sh->owner, &expected, c->id, memory_order_acq_rel,
+                    memory_order_acquire)) {
+                sh->alarm_out.component = component;
+                sh->alarm_out.metrics = metrics;
+                owned[n++] = s;
+            } else {
+                settled = 0; // O dono anterior ainda não soltou
+            }
+        }
+    }
+    *nowned = n;
+    return settled;
+}
+
+// Consumidor: processa os rings dos shards que lhe cabem
 void *consumer_thread(void *arg)
 {
-    int thread_id = *(int *) arg;
+    consumer_t *c = (consumer_t *) arg;
     char component[32];
-    snprintf(component, sizeof(component), "CONSUMIDOR-%d", thread_id);
+    snprintf(component, sizeof(component), "CONSUMIDOR-%d", c->id);
 
-    log_message(COLOR_MAGENTA, component, "Thread consumidora iniciada");
+    if (c->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(c->cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            errno = rc;
+            perror("Erro ao fixar consumidor no core");
+        }
+    }
+
+    // Perfil de tempo real: a afinidade configurada substitui a fixação
+    rt_apply_thread(&config.rt, RT_ROLE_CONSUMER, c->id - 1, component);
+
+    log_event(LOG_INFO, COLOR_MAGENTA, component,
+              "Thread consumidora iniciada (core %d)", c->cpu);
+
+    char metrics_label[METRICS_NAME_LEN];
+    snprintf(metrics_label, sizeof(metrics_label), "consumidor-%d", c->id);
+    metrics_slot_t *metrics = metrics_register(metrics_label);
 
-    int processed = 0;
+    uint32_t owned[SAMPLE_MAX_SHARDS];
+    uint32_t nowned = 0;
+    uint32_t seen = 0;
+    int settled = 0;
+    uint32_t rr = 0;
+    uint64_t processed = 0, alarms = 0;
+    sensor_data_t batch[RULES_BATCH_MAX];
     while (processor_running) {
-        // Aguardar slot cheio (semáforo)
-        sem_wait(&shared_buffer->full_slots);
+        uint32_t generation =
+            atomic_load_explicit(&pool.generation, memory_order_acquire);
+        if (generation != seen || !settled) {
+            seen = generation;
+            settled = consumer_sync(c, component, metrics, owned, &nowned);
+            if (!atomic_load(&c->active)) {
+                break; // Pool encolheu: shards já devolvidos
+            }
+        }
+        if (nowned == 0) {
+            msleep(1);
+            continue;
+        }
 
-        // Entrar na seção crítica (mutex)
-        pthread_mutex_lock(&shared_buffer->mutex);
+        // Retirar do buffer lock-free, alternando entre os shards; só dorme
+        // (futex) se todos estiverem vazios. O timeout permite verificar
+        // processor_running e a distribuição periodicamente. Cada retirada
+        // leva o que já estiver no ring (até um lote) para avaliar as
+        // regras de uma vez.
+        shard_state_t *sh = NULL;
+        uint32_t count = 0;
+        for (uint32_t k = 0; k < nowned; k++) {
+            shard_state_t *next = &shard_states[owned[(rr + k) % nowned]];
+            alarm_flush(&next->alarm_out);
+            if (count == 0) {
+                count = ring_try_pop_batch(next->ring, batch, RULES_BATCH_MAX);
+                sh = next;
+            }
+        }
+        rr++;
+        if (count == 0) {
+            sh = &shard_states[owned[rr % nowned]];
+            count = ring_pop_batch(sh->ring, batch, RULES_BATCH_MAX,
+                                   nowned == 1 ? 100 : POOL_SHARED_WAIT_MS);
+            if (count == 0) {
+                metrics_set(metrics, METRIC_QUEUE_DEPTH, 0);
+                metrics_touch(metrics, monotonic_ns());
+                check_watermarks(&sh->watermark, sh->shard, 0, metrics,
+                                 component);
+                continue;
+            }
+        }
+        uint64_t t_dequeue = monotonic_ns();
 
-        // Ler do buffer circular
-        sensor_data_t data = shared_buffer->buffer[shared_buffer->read_pos];
-        shared_buffer->read_pos = (shared_buffer->read_pos + 1) % BUFFER_SIZE;
-        shared_buffer->count--;
+        consume_batch(sh, batch, count, t_dequeue, metrics, component,
+                      &alarms);
+        processed += count;
+        atomic_fetch_add_explicit(&c->busy_ns, monotonic_ns() - t_dequeue,
+                                  memory_order_relaxed);
+    }
+
+    // Encerramento: devolver os shards que ainda tem
+    for (uint32_t k = 0; k < nowned; k++) {
+        shard_state_t *sh = &shard_states[owned[k]];
+        if (atomic_load(&sh->owner) == c->id) {
+            alarm_flush(&sh->alarm_out);
+            atomic_store_explicit(&sh->owner, 0, memory_order_release);
+        }
+    }
+    metrics_unregister(metrics);
 
-        // Sair da seção crítica
-        pthread_mutex_unlock(&shared_buffer->mutex);
+    log_event(LOG_INFO, COLOR_YELLOW, component,
+              "Thread consumidora encerrada (processados=%llu, alarmes=%llu)",
+              (unsigned long long) processed, (unsigned long long) alarms);
+    return NULL;
+}
 
-        // Sinalizar slot vazio
-        sem_post(&shared_buffer->empty_slots);
+// Distribui os shards entre os n primeiros consumidores e acorda quem
+// dorme num ring, para que a troca de dono aconteça logo
+static void pool_assign(uint32_t n)
+{
+    for (uint32_t s = 0; s < num_shards; s++) {
+        atomic_store_explicit(&shard_states[s].assigned, (int) (s % n) + 1,
+                              memory_order_release);
+    }
+    atomic_fetch_add_explicit(&pool.generation, 1, memory_order_release);
+    for (uint32_t s = 0; s < num_shards; s++) {
+        ring_wake_all(shard_states[s].ring);
+    }
+}
 
-        // Processar dados (simular análise)
-        float processed_value = data.value * 1.1; // Exemplo de processamento
+static int pool_start(uint32_t index)
+{
+    consumer_t *c = &pool.consumers[index];
+    c->id = (int) index + 1;
+    // Só fixa em cores se houver um core para cada consumidor possível
+    c->cpu = (long) pool.max <= ncpus ? (int) index : -1;
+    atomic_store(&c->active, 1);
+    atomic_store(&c->busy_ns, 0);
+    c->busy_seen = 0;
+    if (pthread_create(&c->thread, NULL, consumer_thread, c) != 0) {
+        perror("Erro ao criar thread consumidora");
+        return -1;
+    }
+    return 0;
+}
 
-        processed++;
-        if (processed % 5 == 0) {
-            char msg[256];
-            snprintf(msg, sizeof(msg),
-                     "Processado: Sensor-%d %s=%.2f -> %.2f (total=%d)",
-                     data.sensor_id, sensor_type_name(data.type), data.value,
-                     processed_value, processed);
-            log_message(COLOR_MAGENTA, component, msg);
+// Muda o pool para n consumidores: cria os novos ou pede aos excedentes que
+// devolvam os shards e aguarda-os
+static void pool_resize(uint32_t n)
+{
+    uint32_t old = pool.size;
+    if (n > old) {
+        for (uint32_t i = old; i < n; i++) {
+            if (pool_start(i) == -1) {
+                n = i;
+                break;
+            }
+        }
+        pool_assign(n);
+    } else if (n < old) {
+        for (uint32_t i = n; i < old; i++) {
+            atomic_store(&pool.consumers[i].active, 0);
+        }
+        pool_assign(n);
+        for (uint32_t i = n; i < old; i++) {
+            pthread_join(pool.consumers[i].thread, NULL);
         }
+    }
+    pool.size = n;
+}
+
+// Observação periódica do modo adaptativo: cresce com rings enchendo ou
+// consumidores ocupados; encolhe após alguns intervalos seguidos com folga
+static void pool_adapt(uint64_t now)
+{
+    uint64_t elapsed = now - pool.last_ns;
+    pool.last_ns = now;
+    if (elapsed == 0) {
+        return;
+    }
+
+    uint64_t busy = 0;
+    for (uint32_t i = 0; i < pool.size; i++) {
+        consumer_t *c = &pool.consumers[i];
+        uint64_t total = atomic_load_explicit(&c->busy_ns,
+                                              memory_order_relaxed);
+        busy += total - c->busy_seen;
+        c->busy_seen = total;
+    }
+    double busy_pct = 100.0 * (double) busy / ((double) elapsed * pool.size);
+
+    double depth_pct = 0.0;
+    for (uint32_t s = 0; s < num_shards; s++) {
+        depth_pct += (double) ring_depth(shard_states[s].ring) /
+                     (double) sample_shm->capacity;
+    }
+    depth_pct = 100.0 * depth_pct / num_shards;
+
+    log_event(LOG_DEBUG, COLOR_BLUE, "POOL",
+              "%u consumidores: ocupação dos rings %.0f%%, utilização %.0f%%",
+              pool.size, depth_pct, busy_pct);
 
-        // Simular tempo de processamento
-        msleep(100); // 100ms
+    uint32_t target = pool.size;
+    const char *reason = NULL;
+    if (pool.size < pool.max &&
+        (depth_pct >= config.grow_depth_pct ||
+         busy_pct >= config.grow_busy_pct)) {
+        target = pool.size + 1;
+        reason = depth_pct >= config.grow_depth_pct ? "rings enchendo"
+                                                    : "consumidores ocupados";
+        pool.calm = 0;
+    } else if (pool.size > pool.min && depth_pct <= config.shrink_depth_pct &&
+               busy_pct <= config.shrink_busy_pct) {
+        if (++pool.calm >= POOL_SHRINK_AFTER) {
+            target = pool.size - 1;
+            reason = "folga";
+            pool.calm = 0;
+        }
+    } else {
+        pool.calm = 0;
     }
+    if (target == pool.size) {
+        return;
+    }
+
+    uint32_t old = pool.size;
+    pool_resize(target);
+    pool.resizes++;
+    // Utilização recomeça a contar do tamanho novo
+    pool.last_ns = monotonic_ns();
+    log_event(LOG_INFO, COLOR_BLUE, "POOL",
+              "Consumidores: %u → %u (%s: ocupação %.0f%%, utilização %.0f%%)",
+              old, pool.size, reason, depth_pct, busy_pct);
+}
+
+// Persistência: drena os rings dos consumidores em lotes para o escritor
+// do histórico, que grava blocos e sincroniza no ciclo configurado
+void *persist_thread(void *arg)
+{
+    tsdb_writer_t *writer = (tsdb_writer_t *) arg;
+    metrics_slot_t *metrics = metrics_register("PERSISTENCIA");
+    sensor_data_t batch[PERSIST_DRAIN_MAX];
+
+    for (;;) {
+        // Última volta depois que os consumidores terminaram
+        int last = !persist_running;
+        uint32_t drained = 0;
+        for (uint32_t s = 0; s < num_shards; s++) {
+            uint32_t n = ring_try_pop_batch(persist_rings[s], batch,
+                                            PERSIST_DRAIN_MAX);
+            tsdb_writer_append(writer, batch, n);
+            drained += n;
+        }
 
-    char msg[128];
-    snprintf(msg, sizeof(msg), "Thread consumidora encerrada (processados=%d)",
-             processed);
-    log_message(COLOR_YELLOW, component, msg);
+        uint64_t now = monotonic_ns();
+        metrics_add(metrics, METRIC_PERSISTED, drained);
+        metrics_touch(metrics, now);
+        tsdb_writer_tick(writer, now, 0);
+        if (last && drained == 0) {
+            break;
+        }
+        if (drained == 0) {
+            msleep(PERSIST_IDLE_MS);
+        }
+    }
 
+    metrics_unregister(metrics);
     return NULL;
 }
 
-int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
+void signal_handler(int sig)
+{
+    if (sig == SIGTERM || sig == SIGINT) {
+        processor_running = 0;
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s [-C arquivo] [-S chave=valor] [-s shards] "
+            "[-o política] [-d atraso_us]\n          [-R regras] "
+            "[-P histórico] [-H sensores]\n",
+            prog);
+    fprintf(stderr, "\n  -C  configuração do sistema (padrão: SENSOR_CONFIG "
+                    "ou %s)\n",
+            SYSTEM_CONFIG_DEFAULT_PATH);
+    fprintf(stderr, "  -S  sobrepõe uma chave da configuração, ex. "
+                    "ring_capacity=1024 ou\n      adaptive=on "
+                    "(repetível)\n");
+    fprintf(stderr, "  -s  shards, um por core (padrão: chave shards ou "
+                    "número de cores, máx. %d)\n",
+            SAMPLE_MAX_SHARDS);
+    fprintf(stderr, "  -o  política com o ring cheio: block, drop-newest, "
+                    "drop-oldest,\n      coalesce ou sample[:p] (padrão: "
+                    "SENSOR_OVERLOAD ou block)\n");
+    fprintf(stderr, "  -d  atraso por amostra no consumidor (simula "
+                    "processamento lento)\n");
+    fprintf(stderr, "  -P  histórico: off ou dir=,segment=,keep=,age=,"
+                    "rotate=,sync=,codec=\n      (padrão: SENSOR_TSDB ou "
+                    "%s)\n",
+            TSDB_DEFAULT_DIR);
+    fprintf(stderr, "  -H  sensores no histórico recente em memória, 0 "
+                    "desliga (padrão: %d)\n",
+            HISTORY_DEFAULT_SENSORS);
+    fprintf(stderr, "  -R  arquivo de regras de alarme (padrão: "
+                    "SENSOR_RULES ou %s)\n",
+            RULES_DEFAULT_PATH);
+    fprintf(stderr, "\nCom -S net_ingest=on recebe também sensores pela rede "
+                    "(-t udp|tcp) em\n%s (padrão: %s)\n",
+            NET_ADDR_ENV, NET_DEFAULT_ADDR);
+}
+
+// Carrega as regras de alarme. O arquivo padrão é opcional; um arquivo
+// pedido explicitamente (-R ou SENSOR_RULES) precisa existir.
+static void load_rules(const char *path)
+{
+    int explicit = path != NULL;
+    if (path == NULL) {
+        path = getenv("SENSOR_RULES");
+        explicit = path != NULL;
+    }
+    if (path == NULL) {
+        path = RULES_DEFAULT_PATH;
+    }
+
+    if (!explicit && access(path, R_OK) == -1) {
+        memset(&rule_table, 0, sizeof(rule_table));
+        log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC",
+                  "Sem regras de alarme (%s não encontrado)", path);
+        return;
+    }
+    if (rules_load(&rule_table, path) == -1) {
+        fprintf(stderr, "Erro ao carregar regras de %s\n", path);
+        exit(1);
+    }
+
+    log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC",
+              "%u regras de alarme carregadas de %s", rule_table.count, path);
+    for (uint32_t r = 0; r < rule_table.count; r++) {
+        char rule[96];
+        rules_describe(&rule_table, r, rule, sizeof(rule));
+        log_event(LOG_DEBUG, COLOR_BLUE, "DATA_PROC", "Regra %s: %s",
+                  rule_table.name[r], rule);
+    }
+}
+
+// Descartes por shard desde o início, para o resumo de encerramento
+static void log_overload_summary(void)
+{
+    char policy[32];
+    overload_format(&sample_shm->overload, policy, sizeof(policy));
+    for (uint32_t s = 0; s < num_shards; s++) {
+        uint64_t d[OVERLOAD_DROP_COUNT];
+        uint64_t total = 0;
+        for (int r = 0; r < OVERLOAD_DROP_COUNT; r++) {
+            d[r] = sample_shm_drops(sample_shm, s, (overload_drop_t) r);
+            total += d[r];
+        }
+        uint32_t events = atomic_load_explicit(
+            &sample_shm->overload_shards[s].high_events, memory_order_relaxed);
+        if (total == 0 && events == 0) {
+            continue;
+        }
+        log_event(LOG_INFO, COLOR_YELLOW, "DATA_PROC",
+                  "Shard %u (%s): %u sobrecargas; descartes: novas=%llu "
+                  "antigas=%llu coalescidas=%llu amostragem=%llu",
+                  s, policy, events,
+                  (unsigned long long) d[OVERLOAD_DROPPED_NEWEST],
+                  (unsigned long long) d[OVERLOAD_DROPPED_OLDEST],
+                  (unsigned long long) d[OVERLOAD_DROPPED_COALESCED],
+                  (unsigned long long) d[OVERLOAD_DROPPED_SAMPLED]);
+    }
+}
+
+static void log_tsdb_summary(tsdb_writer_t *tsdb)
+{
+    tsdb_writer_tick(tsdb, monotonic_ns(), 1);
+    tsdb_stats_t st;
+    tsdb_writer_stats(tsdb, &st);
+    log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC",
+              "Histórico: %llu amostras em %llu blocos, %llu segmentos "
+              "criados, %llu removidos; %llu sincronizações (média %.2f ms, "
+              "máx %.2f ms)",
+              (unsigned long long) st.samples, (unsigned long long) st.chunks,
+              (unsigned long long) st.segments,
+              (unsigned long long) st.removed, (unsigned long long) st.syncs,
+              st.syncs > 0 ? (double) st.sync_ns_total / (double) st.syncs / 1e6
+                           : 0.0,
+              (double) st.sync_ns_max / 1e6);
+    if (st.dropped_chunks > 0) {
+        log_event(LOG_WARN, COLOR_YELLOW, "DATA_PROC",
+                  "Histórico: %llu amostras em %llu blocos descartadas sem "
+                  "segmento aberto",
+                  (unsigned long long) st.dropped_samples,
+                  (unsigned long long) st.dropped_chunks);
+    }
+}
+
+static void log_net_summary(const net_receiver_t *rx)
+{
+    net_stats_t st;
+    net_receiver_stats(rx, &st);
+    log_event(st.lost > 0 || st.invalid > 0 ? LOG_WARN : LOG_INFO,
+              COLOR_BLUE, "DATA_PROC",
+              "Rede: %llu amostras em %llu quadros (%llu datagramas, %llu "
+              "conexões, %llu emissores); %llu quadros perdidos, %llu "
+              "atrasados, %llu inválidos",
+              (unsigned long long) st.samples, (unsigned long long) st.frames,
+              (unsigned long long) st.datagrams,
+              (unsigned long long) st.connections,
+              (unsigned long long) st.senders, (unsigned long long) st.lost,
+              (unsigned long long) st.late, (unsigned long long) st.invalid);
+}
+
+// Como o segmento foi assumido na partida
+static void log_takeover(const sample_shm_takeover_t *t)
 {
-    log_message(COLOR_BLUE, "DATA_PROC", "Iniciando processador de dados");
+    if (t->requested) {
+        log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC",
+                  "Instância anterior entregou os rings em %.1f ms",
+                  (double) t->wait_ns / 1e6);
+    }
+    if (t->crashed) {
+        log_event(LOG_WARN, COLOR_YELLOW, "DATA_PROC",
+                  "Instância anterior terminou sem entregar os rings");
+    }
+    if (t->adopted) {
+        log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC",
+                  "Rings retomados (geração %u): %llu amostras pendentes, "
+                  "%llu perdidas com a instância anterior",
+                  t->generation, (unsigned long long) t->pending,
+                  (unsigned long long) t->lost);
+    } else if (t->replaced) {
+        log_event(t->lost > 0 ? LOG_WARN : LOG_INFO, COLOR_YELLOW,
+                  "DATA_PROC",
+                  "Layout dos rings mudou: segmento recriado (geração %u), "
+                  "%llu amostras pendentes copiadas, %llu perdidas",
+                  t->generation, (unsigned long long) t->pending,
+                  (unsigned long long) t->lost);
+    }
+    if (t->lost_unknown) {
+        log_event(LOG_WARN, COLOR_YELLOW, "DATA_PROC",
+                  "Rings anteriores ilegíveis: pendentes descartados sem "
+                  "contagem");
+    }
+}
+
+// Limites do pool a partir da configuração: no modo estático o tamanho
+// inicial é fixo; no adaptativo começa pelo mínimo
+static void pool_configure(void)
+{
+    uint32_t max = config.consumers_max;
+    if (max == 0 || max > num_shards) {
+        max = num_shards;
+    }
+    uint32_t initial = config.consumers;
+    if (initial == 0) {
+        initial = config.adaptive ? config.consumers_min : num_shards;
+    }
+    if (initial > max) {
+        initial = max;
+    }
+    if (config.adaptive) {
+        pool.min = config.consumers_min < max ? config.consumers_min : max;
+        pool.max = max;
+        if (initial < pool.min) {
+            initial = pool.min;
+        }
+    } else {
+        pool.min = initial;
+        pool.max = initial;
+    }
+    pool.size = initial;
+}
+
+// Sobe o pool e os estados dos shards (antes de acordar os sensores)
+static void pool_init(void)
+{
+    for (uint32_t s = 0; s < num_shards; s++) {
+        shard_state_t *sh = &shard_states[s];
+        sh->shard = s;
+        sh->ring = sample_shm_ring(sample_shm, s);
+        stats_table_view(stats_shm, s, &sh->stats);
+        sh->latency = latency_table(latency_shm, s);
+        sh->limits = calloc(LIVE_CONFIG_MAX_SENSORS, sizeof(*sh->limits));
+        if (sh->limits == NULL) {
+            perror("Erro ao alocar cache de limites");
+            exit(1);
+        }
+        if (rule_engine_init(&sh->engine, &rule_table, STATS_MAX_SENSORS) ==
+            -1) {
+            perror("Erro ao alocar estado das regras");
+            exit(1);
+        }
+    }
+
+    uint32_t initial = pool.size;
+    pool.size = 0;
+    for (uint32_t i = 0; i < initial; i++) {
+        if (pool_start(i) == -1) {
+            exit(1);
+        }
+    }
+    pool.size = initial;
+    pool_assign(initial);
+    pool.last_ns = monotonic_ns();
+}
+
+static void pool_shutdown(void)
+{
+    for (uint32_t s = 0; s < num_shards; s++) {
+        ring_wake_all(shard_states[s].ring);
+    }
+    for (uint32_t i = 0; i < pool.size; i++) {
+        pthread_join(pool.consumers[i].thread, NULL);
+    }
+
+    uint64_t raised = 0, dropped = 0;
+    for (uint32_t s = 0; s < num_shards; s++) {
+        shard_state_t *sh = &shard_states[s];
+        alarm_flush(&sh->alarm_out);
+        raised += sh->alarm_out.raised;
+        dropped += sh->alarm_out.dropped;
+        free(sh->limits);
+        rule_engine_free(&sh->engine);
+    }
+    log_event(LOG_INFO, COLOR_YELLOW, "DATA_PROC",
+              "Consumidores: %u no fim (%u-%u, %llu ajustes); disparos de "
+              "regras=%llu, alarmes perdidos=%llu",
+              pool.size, pool.min, pool.max,
+              (unsigned long long) pool.resizes, (unsigned long long) raised,
+              (unsigned long long) dropped);
+}
+
+int main(int argc, char *argv[])
+{
+    ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpus < 1) {
+        ncpus = 1;
+    }
+    overload_config_default(&overload_config);
+    tsdb_config_default(&tsdb_config);
+    const char *rules_path = NULL;
+
+    // Configuração do arquivo primeiro; as opções abaixo a sobrepõem
+    system_config_default(&config);
+    if (system_config_load(&config, system_config_arg(argc, argv)) == -1) {
+        exit(1);
+    }
+    long shards = config.shards != 0 ? (long) config.shards : ncpus;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "C:S:s:o:d:R:P:H:h")) != -1) {
+        switch (opt) {
+        case 'C':
+            break; // Já carregado
+        case 'S':
+            if (system_config_set(&config, optarg) == -1) {
+                fprintf(stderr, "Configuração inválida: %s\n", optarg);
+                usage(argv[0]);
+                exit(1);
+            }
+            if (strncmp(optarg, "shards", 6) == 0 && config.shards != 0) {
+                shards = (long) config.shards;
+            }
+            break;
+        case 's':
+            shards = atol(optarg);
+            break;
+        case 'o':
+            if (overload_parse(optarg, &overload_config) == -1) {
+                usage(argv[0]);
+                exit(1);
+            }
+            break;
+        case 'd':
+            consumer_delay_us = atol(optarg);
+            break;
+        case 'R':
+            rules_path = optarg;
+            break;
+        case 'H':
+            history_sensors = atol(optarg);
+            break;
+        case 'P':
+            if (tsdb_config_parse(optarg, &tsdb_config) == -1) {
+                usage(argv[0]);
+                exit(1);
+            }
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (shards < 1 || shards > SAMPLE_MAX_SHARDS || consumer_delay_us < 0 ||
+        history_sensors < 0 || history_sensors > STATS_MAX_SENSORS) {
+        usage(argv[0]);
+        exit(1);
+    }
+    num_shards = (uint32_t) shards;
+    pool_configure();
+    // Valores efetivos, para o log da configuração
+    config.shards = num_shards;
+    config.consumers = pool.size;
+    config.consumers_min = pool.min;
+    config.consumers_max = pool.max;
+
+    // Encerramento ordenado (inclui o resumo de latência)
+    signal(SIGTERM, signal_handler);
+    signal(SIGINT, signal_handler);
+
+    char policy[32];
+    overload_format(&overload_config, policy, sizeof(policy));
+    log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC",
+              "Iniciando processador de dados (%u shards, %ld cores, "
+              "sobrecarga: %s)",
+              num_shards, ncpus, policy);
+    char sizing[192];
+    system_config_format(&config, sizing, sizeof(sizing));
+    log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC", "Configuração: %s", sizing);
+
+    load_rules(rules_path);
+
+    // Alarmes das regras saem pela fila de telemetria, com prioridade acima
+    // dos resumos. Não bloqueante: fila cheia deixa o alarme pendente no
+    // consumidor em vez de travar o processamento.
+    if (rule_table.count > 0) {
+        alarm_mq = telemetry_mq_open(O_WRONLY | O_NONBLOCK, config.mq_depth);
+        if (alarm_mq == (mqd_t) -1) {
+            perror("Erro ao abrir fila de mensagens (alarmes só no log)");
+        }
+    }
 
     // Criar/Abrir FIFO para leitura (se não existir)
     if (mkfifo(FIFO_SENSOR_DATA, 0666) == -1 && errno != EEXIST) {
@@ -126,45 +1224,115 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
         exit(1);
     }
 
-    // Abrir FIFO (bloqueante para garantir que há escritor)
-    int fifo_fd = open(FIFO_SENSOR_DATA, O_RDONLY);
-    if (fifo_fd == -1) {
-        perror("Erro ao abrir FIFO");
+    // Ponto de encontro: até os rings serem assumidos os sensores só
+    // guardam amostras (ring e fila local), sem política de sobrecarga
+    rendezvous_t *rendezvous = rendezvous_open();
+    rendezvous_set_reader(rendezvous, 0);
+
+    // Um ring por shard em memória compartilhada (modo SHM): retomado da
+    // instância anterior, com o que ela não consumiu, ou criado agora
+    uint32_t capacity = ring_round_capacity(config.ring_capacity);
+    sample_shm_takeover_t takeover;
+    sample_shm = sample_shm_acquire(capacity, num_shards, &overload_config,
+                                    config.rt.enabled && config.rt.hugepages,
+                                    &takeover);
+    if (sample_shm == NULL) {
+        perror(errno == EBUSY ? "Instância anterior não entregou os rings"
+                              : "Erro ao criar memória compartilhada");
         exit(1);
     }
+    log_takeover(&takeover);
 
-    // Criar memória compartilhada para o buffer
-    int shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0666);
-    if (shm_fd == -1) {
-        perror("Erro ao criar memória compartilhada");
-        close(fifo_fd);
+    // Estatísticas consultáveis pela control_interface
+    stats_shm = stats_shm_create(STATS_MAX_SENSORS, num_shards);
+    latency_shm = latency_shm_create(num_shards);
+    if (stats_shm == NULL || latency_shm == NULL) {
+        stats_shm_close(stats_shm);
+        sample_shm_destroy(sample_shm);
         exit(1);
     }
 
-    if (ftruncate(shm_fd, sizeof(circular_buffer_t)) == -1) {
-        perror("Erro ao definir tamanho da memória compartilhada");
-        close(shm_fd);
-        close(fifo_fd);
-        exit(1);
+    // Sem o histórico recente as consultas ficam indisponíveis, mas o
+    // processamento segue
+    if (history_sensors > 0) {
+        history_shm =
+            history_shm_create(STATS_MAX_SENSORS, (uint32_t) history_sensors);
+    }
+
+    // Sem configuração dinâmica não há verificação de limites
+    live_config = live_config_open();
+
+    // Histórico: sem diretório gravável o processamento segue sem ele
+    tsdb_writer_t *tsdb = NULL;
+    if (tsdb_config.enabled) {
+        tsdb = tsdb_writer_open(&tsdb_config, STATS_MAX_SENSORS);
+        uint32_t persist_capacity = ring_round_capacity(PERSIST_RING_CAPACITY);
+        persist_ring_size = ring_bytes(persist_capacity);
+        for (uint32_t i = 0; tsdb != NULL && i < num_shards; i++) {
+            persist_rings[i] = mmap(NULL, persist_ring_size,
+                                    PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (persist_rings[i] == MAP_FAILED) {
+                perror("Erro ao mapear ring de persistência");
+                exit(1);
+            }
+            ring_init(persist_rings[i], persist_capacity);
+        }
     }
+    char history[TSDB_PATH_LEN + 128];
+    tsdb_config_format(&tsdb_config, history, sizeof(history));
+    log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC", "Histórico: %s%s", history,
+              tsdb_config.enabled && tsdb == NULL ? " (falhou ao abrir)" : "");
 
-    shared_buffer = (circular_buffer_t *) mmap(NULL, sizeof(circular_buffer_t),
-                                               PROT_READ | PROT_WRITE,
-                                               MAP_SHARED, shm_fd, 0);
-    if (shared_buffer == MAP_FAILED) {
-        perror("Erro ao mapear memória compartilhada");
-        close(shm_fd);
-        close(fifo_fd);
+    // Abrir FIFO para o modo alternativo. O_RDWR evita bloquear aguardando
+    // escritor e evita EOF quando nenhum sensor usa o FIFO.
+    int fifo_fd = open(FIFO_SENSOR_DATA, O_RDWR);
+    if (fifo_fd == -1) {
+        perror("Erro ao abrir FIFO");
+        latency_shm_close(latency_shm);
+        stats_shm_close(stats_shm);
+        sample_shm_destroy(sample_shm);
         exit(1);
     }
 
-    // Inicializar buffer
-    init_buffer(shared_buffer);
+    // Sensores de outros nós: UDP e TCP no mesmo endereço
+    if (config.net_ingest) {
+        const char *addr = net_addr_default();
+        net_receiver = net_receiver_open(addr);
+        if (net_receiver == NULL) {
+            perror("Erro ao abrir a recepção pela rede");
+            close(fifo_fd);
+            latency_shm_close(latency_shm);
+            stats_shm_close(stats_shm);
+            sample_shm_destroy(sample_shm);
+            exit(1);
+        }
+        log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC",
+                  "Recebendo sensores pela rede em %s (udp e tcp)", addr);
+    }
+
+    // Perfil de tempo real: travar a memória e pré-carregar os segmentos
+    // agora, antes das threads, em vez de na primeira escrita de cada página
+    if (config.rt.enabled) {
+        rt_lock_memory(&config.rt, "DATA_PROC");
+        if (config.rt.lock_memory) {
+            rt_prefault(sample_shm, sample_shm->total_bytes, 1);
+            rt_prefault(stats_shm, stats_shm->total_bytes, 1);
+            rt_prefault(latency_shm, latency_shm->total_bytes, 1);
+            if (history_shm != NULL) {
+                rt_prefault(history_shm, history_shm->total_bytes, 1);
+            }
+        }
+        sample_shm_pages_t pages = (sample_shm_pages_t) sample_shm->pages;
+        log_event(LOG_INFO, COLOR_BLUE, "DATA_PROC",
+                  "Tempo real: ring de ingestão em %s",
+                  sample_shm_pages_name(pages));
+    }
 
     // Criar threads produtoras e consumidoras
     pthread_t producer;
-    pthread_t consumers[3];
-    int consumer_ids[3] = {1, 2, 3};
+    pthread_t receiver;
+    pthread_t persister;
 
     // Thread produtora
     if (pthread_create(&producer, NULL, producer_thread, &fifo_fd) != 0) {
@@ -172,32 +1340,100 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
         exit(1);
     }
 
-    // Threads consumidoras (modelo produtor-consumidor)
-    for (int i = 0; i < 3; i++) {
-        if (pthread_create(&consumers[i], NULL, consumer_thread,
-                           &consumer_ids[i]) != 0) {
-            perror("Erro ao criar thread consumidora");
-            exit(1);
-        }
+    // Thread de recepção pela rede
+    if (net_receiver != NULL &&
+        pthread_create(&receiver, NULL, net_thread, net_receiver) != 0) {
+        perror("Erro ao criar thread de recepção");
+        exit(1);
+    }
+
+    // Thread de persistência (fora do caminho dos consumidores)
+    if (tsdb != NULL &&
+        pthread_create(&persister, NULL, persist_thread, tsdb) != 0) {
+        perror("Erro ao criar thread de persistência");
+        exit(1);
     }
 
+    // Threads consumidoras (modelo produtor-consumidor), com os shards
+    // divididos entre elas
+    pool_init();
+
     log_message(COLOR_BLUE, "DATA_PROC", "Todas as threads criadas");
+    // Rings criados, FIFO aberto e consumidores ativos: acordar sensores
+    rendezvous_set_reader(rendezvous, 1);
+    notify_ready();
 
-    // Aguardar threads (em produção, aguardaria indefinidamente)
-    sleep(30);
+    // Executar por run_s segundos (0 = até SIGTERM/SIGINT), observando o
+    // pool a cada intervalo no modo adaptativo
+    uint32_t tick_ms = config.adaptive ? config.adapt_interval_ms : 100;
+    uint64_t deadline =
+        monotonic_ns() + (uint64_t) config.run_s * 1000000000ull;
+    while (processor_running &&
+           (config.run_s == 0 || monotonic_ns() < deadline)) {
+        msleep(tick_ms);
+        if (config.adaptive && processor_running) {
+            pool_adapt(monotonic_ns());
+        }
+    }
 
     processor_running = 0;
+    rendezvous_set_reader(rendezvous, 0);
+    rendezvous_close(rendezvous);
+    for (uint32_t i = 0; i < num_shards; i++) {
+        ring_wake_all(sample_shm_ring(sample_shm, i));
+    }
 
-    // Aguardar threads terminarem
-    pthread_join(producer, NULL);
-    for (int i = 0; i < 3; i++) {
-        pthread_join(consumers[i], NULL);
+    // A recepção pela rede sai antes: a porta fica livre para a próxima
+    // instância assim que ela assumir os rings
+    if (net_receiver != NULL) {
+        net_receiver_wake(net_receiver);
+        pthread_join(receiver, NULL);
+        log_net_summary(net_receiver);
+        net_receiver_close(net_receiver);
     }
 
+    // Consumidores parados: a persistência grava o resto e sela o
+    // histórico antes da entrega, para a próxima instância não abrir o
+    // diretório com o segmento desta ainda em uso
+    pool_shutdown();
+    if (tsdb != NULL) {
+        persist_running = 0;
+        pthread_join(persister, NULL);
+        log_tsdb_summary(tsdb);
+        tsdb_writer_close(tsdb);
+        for (uint32_t i = 0; i < num_shards; i++) {
+            munmap(persist_rings[i], persist_ring_size);
+        }
+    }
+
+    // Os rings, com o que restou neles, ficam para a próxima instância. A
+    // produtora (FIFO) ainda pode publicar até sair.
+    sample_shm_release(sample_shm);
+    pthread_join(producer, NULL);
+
+    latency_log_summary(latency_shm, "DATA_PROC");
+    log_overload_summary();
+
     // Cleanup
-    munmap(shared_buffer, sizeof(circular_buffer_t));
-    close(shm_fd);
+    if (history_shm != NULL) {
+        uint64_t overflow = atomic_load(&history_shm->overflow);
+        if (overflow > 0) {
+            log_event(LOG_WARN, COLOR_YELLOW, "DATA_PROC",
+                      "Histórico recente cheio (%u sensores): %llu amostras "
+                      "de outros sensores ficaram de fora",
+                      history_shm->nslots, (unsigned long long) overflow);
+        }
+    }
+
+    latency_shm_close(latency_shm);
+    stats_shm_close(stats_shm);
+    history_shm_close(history_shm);
+    live_config_close(live_config);
+    sample_shm_destroy(sample_shm);
     close(fifo_fd);
+    if (alarm_mq != (mqd_t) -1) {
+        mq_close(alarm_mq);
+    }
 
     log_message(COLOR_BLUE, "DATA_PROC", "Processador encerrado");
 
@@ -0,0 +1,300 @@
+#include "gorilla.h"
+
+void gorilla_writer_init(gorilla_writer_t *w, uint8_t *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->bits = 0;
+    w->overflow = 0;
+}
+
+void gorilla_reader_init(gorilla_reader_t *r, const uint8_t *buf, size_t len)
+{
+    r->buf = buf;
+    r->len = len;
+    r->bits = 0;
+    r->error = 0;
+}
+
+// Bits mais significativos primeiro, completando um byte por vez
+static void put_bits(gorilla_writer_t *w, uint64_t value, unsigned nbits)
+{
+    if (w->bits + nbits > w->cap * 8) {
+        w->overflow = 1;
+        return;
+    }
+    while (nbits > 0) {
+        unsigned used = (unsigned) (w->bits & 7);
+        unsigned room = 8 - used;
+        unsigned take = nbits < room ? nbits : room;
+        uint8_t chunk =
+            (uint8_t) ((value >> (nbits - take)) & ((1u << take) - 1));
+        uint8_t *byte = &w->buf[w->bits >> 3];
+        if (used == 0) {
+            *byte = 0;
+        }
+        *byte |= (uint8_t) (chunk << (room - take));
+        w->bits += take;
+        nbits -= take;
+    }
+}
+
+static uint64_t get_bits(gorilla_reader_t *r, unsigned nbits)
+{
+    if (r->bits + nbits > r->len * 8) {
+        r->error = 1;
+        return 0;
+    }
+    uint64_t value = 0;
+    while (nbits > 0) {
+        unsigned used = (unsigned) (r->bits & 7);
+        unsigned room = 8 - used;
+        unsigned take = nbits < room ? nbits : room;
+        uint8_t byte = r->buf[r->bits >> 3];
+        value = (value << take) |
+                ((uint64_t) (byte >> (room - take)) & ((1u << take) - 1));
+        r->bits += take;
+        nbits -= take;
+    }
+    return value;
+}
+
+// ---------------------------------------------------------------------------
+// Inteiros: delta-do-delta
+
+// Faixas [-(2^(b-1) - 1), 2^(b-1)] guardadas com deslocamento em b bits
+static const struct {
+    uint64_t control;
+    unsigned control_bits;
+    unsigned bits;
+} int_ranges[] = {
+    {0x2, 2, 8},
+    {0x6, 3, 20},
+    {0xe, 4, 32},
+};
+
+void gorilla_put_int(gorilla_writer_t *w, gorilla_int_t *state, int64_t v)
+{
+    if (state->n++ == 0) {
+        put_bits(w, (uint64_t) v, 64);
+        state->prev = v;
+        state->prev_delta = 0;
+        return;
+    }
+
+    // Aritmética sem sinal: diferenças que estouram int64 dão a volta
+    int64_t delta = (int64_t) ((uint64_t) v - (uint64_t) state->prev);
+    int64_t dod = (int64_t) ((uint64_t) delta - (uint64_t) state->prev_delta);
+    state->prev = v;
+    state->prev_delta = delta;
+
+    if (dod == 0) {
+        put_bits(w, 0, 1);
+        return;
+    }
+    for (size_t i = 0; i < sizeof(int_ranges) / sizeof(int_ranges[0]); i++) {
+        int64_t bias = ((int64_t) 1 << (int_ranges[i].bits - 1)) - 1;
+        if (dod >= -bias && dod <= bias + 1) {
+            put_bits(w, int_ranges[i].control, int_ranges[i].control_bits);
+            put_bits(w, (uint64_t) (dod + bias), int_ranges[i].bits);
+            return;
+        }
+    }
+    put_bits(w, 0xf, 4);
+    put_bits(w, (uint64_t) dod, 64);
+}
+
+int64_t gorilla_get_int(gorilla_reader_t *r, gorilla_int_t *state)
+{
+    if (state->n++ == 0) {
+        state->prev = (int64_t) get_bits(r, 64);
+        state->prev_delta = 0;
+        return state->prev;
+    }
+
+    int64_t dod = 0;
+    if (get_bits(r, 1) != 0) {
+        size_t i = 0;
+        size_t nranges = sizeof(int_ranges) / sizeof(int_ranges[0]);
+        while (i < nranges && get_bits(r, 1) != 0) {
+            i++;
+        }
+        if (i < nranges) {
+            int64_t bias = ((int64_t) 1 << (int_ranges[i].bits - 1)) - 1;
+            dod = (int64_t) get_bits(r, int_ranges[i].bits) - bias;
+        } else {
+            dod = (int64_t) get_bits(r, 64);
+        }
+    }
+
+    state->prev_delta =
+        (int64_t) ((uint64_t) state->prev_delta + (uint64_t) dod);
+    state->prev = (int64_t) ((uint64_t) state->prev +
+                             (uint64_t) state->prev_delta);
+    return state->prev;
+}
+
+// ---------------------------------------------------------------------------
+// Floats: XOR com o anterior
+
+void gorilla_put_float(gorilla_writer_t *w, gorilla_float_t *state, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    if (state->n++ == 0) {
+        put_bits(w, bits, 32);
+        state->prev = bits;
+        return;
+    }
+
+    uint32_t x = bits ^ state->prev;
+    state->prev = bits;
+    if (x == 0) {
+        put_bits(w, 0, 1);
+        return;
+    }
+
+    unsigned leading = (unsigned) __builtin_clz(x);
+    unsigned trailing = (unsigned) __builtin_ctz(x);
+    if (state->meaningful != 0 && leading >= state->leading &&
+        trailing >= 32u - state->leading - state->meaningful) {
+        // Cabe na janela anterior: só os bits dela
+        unsigned shift = 32u - state->leading - state->meaningful;
+        put_bits(w, 0x2, 2);
+        put_bits(w, x >> shift, state->meaningful);
+        return;
+    }
+
+    unsigned meaningful = 32u - leading - trailing;
+    put_bits(w, 0x3, 2);
+    put_bits(w, leading, 5);
+    put_bits(w, meaningful - 1, 5);
+    put_bits(w, x >> trailing, meaningful);
+    state->leading = (uint8_t) leading;
+    state->meaningful = (uint8_t) meaningful;
+}
+
+float gorilla_get_float(gorilla_reader_t *r, gorilla_float_t *state)
+{
+    float v;
+    if (state->n++ == 0) {
+        state->prev = (uint32_t) get_bits(r, 32);
+        memcpy(&v, &state->prev, sizeof(v));
+        return v;
+    }
+
+    if (get_bits(r, 1) != 0) {
+        if (get_bits(r, 1) != 0) {
+            state->leading = (uint8_t) get_bits(r, 5);
+            state->meaningful = (uint8_t) (get_bits(r, 5) + 1);
+            if (state->leading + state->meaningful > 32) {
+                r->error = 1;
+                state->meaningful = (uint8_t) (32 - state->leading);
+            }
+        } else if (state->meaningful == 0) {
+            r->error = 1; // Janela reaproveitada antes de existir
+        }
+        unsigned shift = 32u - state->leading - state->meaningful;
+        uint32_t x = (uint32_t) get_bits(r, state->meaningful) << shift;
+        state->prev ^= x;
+    }
+    memcpy(&v, &state->prev, sizeof(v));
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// Formatos
+
+size_t gorilla_encode_series(const int64_t *ts, const float *values,
+                             uint32_t n, uint8_t *out, size_t cap)
+{
+    gorilla_writer_t w;
+    gorilla_writer_init(&w, out, cap);
+    gorilla_int_t time_state = {0};
+    gorilla_float_t value_state = {0};
+    for (uint32_t i = 0; i < n && !w.overflow; i++) {
+        gorilla_put_int(&w, &time_state, ts[i]);
+        gorilla_put_float(&w, &value_state, values[i]);
+    }
+    return w.overflow ? 0 : gorilla_writer_bytes(&w);
+}
+
+int gorilla_decode_series(const uint8_t *in, size_t len, uint32_t n,
+                          int64_t *ts, float *values)
+{
+    gorilla_reader_t r;
+    gorilla_reader_init(&r, in, len);
+    gorilla_int_t time_state = {0};
+    gorilla_float_t value_state = {0};
+    for (uint32_t i = 0; i < n && !r.error; i++) {
+        ts[i] = gorilla_get_int(&r, &time_state);
+        values[i] = gorilla_get_float(&r, &value_state);
+    }
+    return r.error ? -1 : 0;
+}
+
+// Um estado de valor por tipo: leituras de tipos diferentes intercaladas
+// no lote não se misturam no XOR
+typedef struct {
+    gorilla_int_t id;
+    gorilla_int_t timestamp;
+    gorilla_int_t created;
+    gorilla_float_t value[4];
+} sample_state_t;
+
+size_t gorilla_encode_samples_prefix(const sensor_data_t *items, uint32_t n,
+                                     uint8_t *out, size_t cap,
+                                     uint32_t *count)
+{
+    gorilla_writer_t w;
+    gorilla_writer_init(&w, out, cap);
+    sample_state_t s;
+    memset(&s, 0, sizeof(s));
+    uint32_t done = 0;
+    size_t bits = 0; // Fim da última amostra completa
+    for (uint32_t i = 0; i < n && !w.overflow; i++) {
+        const sensor_data_t *d = &items[i];
+        unsigned type = (unsigned) d->type & 3;
+        gorilla_put_int(&w, &s.id, d->sensor_id);
+        put_bits(&w, type, 2);
+        put_bits(&w, d->active != 0, 1);
+        gorilla_put_int(&w, &s.timestamp, (int64_t) d->timestamp);
+        gorilla_put_int(&w, &s.created, (int64_t) d->t_created);
+        gorilla_put_float(&w, &s.value[type], d->value);
+        if (!w.overflow) {
+            done = i + 1;
+            bits = w.bits;
+        }
+    }
+    *count = done;
+    return (bits + 7) / 8;
+}
+
+size_t gorilla_encode_samples(const sensor_data_t *items, uint32_t n,
+                              uint8_t *out, size_t cap)
+{
+    uint32_t count;
+    size_t bytes = gorilla_encode_samples_prefix(items, n, out, cap, &count);
+    return count == n ? bytes : 0;
+}
+
+int gorilla_decode_samples(const uint8_t *in, size_t len, uint32_t n,
+                           sensor_data_t *out)
+{
+    gorilla_reader_t r;
+    gorilla_reader_init(&r, in, len);
+    sample_state_t s;
+    memset(&s, 0, sizeof(s));
+    for (uint32_t i = 0; i < n && !r.error; i++) {
+        sensor_data_t *d = &out[i];
+        memset(d, 0, sizeof(*d));
+        d->sensor_id = (int) gorilla_get_int(&r, &s.id);
+        unsigned type = (unsigned) get_bits(&r, 2);
+        d->type = (sensor_type_t) type;
+        d->active = (int) get_bits(&r, 1);
+        d->timestamp = (time_t) gorilla_get_int(&r, &s.timestamp);
+        d->t_created = (uint64_t) gorilla_get_int(&r, &s.created);
+        d->value = gorilla_get_float(&r, &s.value[type]);
+    }
+    return r.error ? -1 : 0;
+}
@@ -0,0 +1,285 @@
+#include "common.h"
+#include "history.h"
+
+#include <stddef.h>
+
+#define HISTORY_SHM_MAGIC 0x54534948u // "HIST"
+#define HISTORY_RAW_MASK (HISTORY_RAW_POINTS - 1)
+#define SLOT_NONE UINT32_MAX // Sensor sem entrada (segmento cheio)
+
+_Static_assert((HISTORY_RAW_POINTS & HISTORY_RAW_MASK) == 0,
+               "HISTORY_RAW_POINTS precisa ser potência de 2");
+
+// Níveis de agregação, do mais fino ao mais grosso
+static const struct {
+    uint32_t seconds;
+    uint32_t nbuckets;
+    size_t offset;
+} levels[HISTORY_LEVELS] = {
+    {1, HISTORY_SEC_BUCKETS, offsetof(history_slot_t, sec)},
+    {60, HISTORY_MIN_BUCKETS, offsetof(history_slot_t, min)},
+    {3600, HISTORY_HOUR_BUCKETS, offsetof(history_slot_t, hour)},
+};
+
+static history_slot_t *slot_at(const history_shm_t *shm, uint32_t index)
+{
+    return (history_slot_t *) ((char *) shm + shm->slots_offset +
+                               (size_t) index * sizeof(history_slot_t));
+}
+
+static const history_bucket_t *level_buckets(const history_slot_t *slot,
+                                             int level)
+{
+    return (const history_bucket_t *) ((const char *) slot +
+                                       levels[level].offset);
+}
+
+history_shm_t *history_shm_create(uint32_t capacity, uint32_t nslots)
+{
+    if (nslots == 0) {
+        nslots = HISTORY_DEFAULT_SENSORS;
+    }
+    size_t slots_offset = shm_align(sizeof(history_shm_t) +
+                                    (size_t) capacity * sizeof(uint32_t));
+    size_t total = slots_offset + (size_t) nslots * sizeof(history_slot_t);
+
+    // Segmento zerado (mapa vazio); as páginas de uma entrada só são
+    // ocupadas quando o sensor grava nela
+    history_shm_t *shm =
+        shm_table_create(HISTORY_SHM_NAME, total, "do histórico recente");
+    if (shm == NULL) {
+        return NULL;
+    }
+
+    struct timespec wall, mono;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    shm->clock_offset =
+        ((int64_t) wall.tv_sec - mono.tv_sec) * 1000000000LL +
+        (wall.tv_nsec - mono.tv_nsec);
+    shm->capacity = capacity;
+    shm->nslots = nslots;
+    shm->total_bytes = total;
+    shm->slots_offset = slots_offset;
+    shm_table_publish(shm, HISTORY_SHM_MAGIC);
+
+    return shm;
+}
+
+history_shm_t *history_shm_open(void)
+{
+    return shm_table_open(HISTORY_SHM_NAME, sizeof(history_shm_t),
+                          HISTORY_SHM_MAGIC,
+                          offsetof(history_shm_t, total_bytes));
+}
+
+void history_shm_close(history_shm_t *shm)
+{
+    if (shm != NULL) {
+        munmap(shm, shm->total_bytes);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Escrita
+
+// Entrada do sensor, reservada na primeira amostra. Só o escritor do
+// sensor reserva, então não há disputa pela mesma posição do mapa.
+static history_slot_t *writer_slot(history_shm_t *shm, uint32_t id)
+{
+    uint32_t s = atomic_load_explicit(&shm->slot_of[id], memory_order_relaxed);
+    if (s == SLOT_NONE) {
+        return NULL;
+    }
+    if (s != 0) {
+        return slot_at(shm, s - 1);
+    }
+
+    uint32_t index = atomic_fetch_add(&shm->used, 1);
+    if (index >= shm->nslots) {
+        atomic_store_explicit(&shm->slot_of[id], SLOT_NONE,
+                              memory_order_relaxed);
+        return NULL;
+    }
+    history_slot_t *slot = slot_at(shm, index);
+    slot->sensor_id = (int32_t) id;
+    atomic_store_explicit(&shm->slot_of[id], index + 1, memory_order_release);
+    return slot;
+}
+
+void history_record(history_shm_t *shm, const sensor_data_t *data)
+{
+    if (data->sensor_id < 0 || (uint32_t) data->sensor_id >= shm->capacity) {
+        return;
+    }
+    history_slot_t *slot = writer_slot(shm, (uint32_t) data->sensor_id);
+    if (slot == NULL) {
+        atomic_fetch_add_explicit(&shm->overflow, 1, memory_order_relaxed);
+        return;
+    }
+
+    // Sem carimbo monotônico (FIFO antigo): resolução de segundos
+    int64_t t = data->t_created != 0
+                    ? (int64_t) data->t_created + shm->clock_offset
+                    : (int64_t) data->timestamp * 1000000000LL;
+    // A busca binária precisa de tempos crescentes no ring: uma leitura
+    // fora de ordem (reenvio, relógio do sensor) fica com o tempo anterior
+    uint64_t head = slot->head;
+    if (head > 0 && t < slot->ts[(head - 1) & HISTORY_RAW_MASK]) {
+        t = slot->ts[(head - 1) & HISTORY_RAW_MASK];
+    }
+
+    uint32_t seq = seqlock_write_begin(&slot->seq);
+
+    float v = data->value;
+    slot->ts[head & HISTORY_RAW_MASK] = t;
+    slot->values[head & HISTORY_RAW_MASK] = v;
+    slot->head = head + 1;
+    slot->type = (uint32_t) data->type;
+
+    uint32_t epoch = (uint32_t) (t / 1000000000LL);
+    stats_bucket_add(&slot->sec[epoch % HISTORY_SEC_BUCKETS], epoch, v);
+    stats_bucket_add(&slot->min[epoch / 60 % HISTORY_MIN_BUCKETS], epoch / 60,
+                     v);
+    stats_bucket_add(&slot->hour[epoch / 3600 % HISTORY_HOUR_BUCKETS],
+                     epoch / 3600, v);
+
+    seqlock_write_end(&slot->seq, seq);
+}
+
+// ---------------------------------------------------------------------------
+// Consulta
+
+// Leituras em [from, to]: busca binária pela primeira e cópia até passar
+// de to. Chamada dentro da seção de leitura do seqlock.
+static void query_raw(const history_slot_t *slot, int64_t from_ns,
+                      int64_t to_ns, history_row_t *rows, uint32_t max_rows,
+                      history_result_t *result)
+{
+    uint64_t head = slot->head;
+    uint64_t lo = head > HISTORY_RAW_POINTS ? head - HISTORY_RAW_POINTS : 0;
+    uint64_t hi = head;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (slot->ts[mid & HISTORY_RAW_MASK] < from_ns) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    uint32_t n = 0;
+    uint64_t i = lo;
+    for (; i < head && n < max_rows; i++) {
+        int64_t t = slot->ts[i & HISTORY_RAW_MASK];
+        if (t > to_ns) {
+            break;
+        }
+        float v = slot->values[i & HISTORY_RAW_MASK];
+        rows[n++] = (history_row_t){
+            .t_ns = t, .count = 1, .min = v, .max = v, .avg = v};
+    }
+    result->rows = n;
+    result->truncated =
+        i < head && n == max_rows && slot->ts[i & HISTORY_RAW_MASK] <= to_ns;
+}
+
+// Baldes de step segundos em [from, to] a partir de um nível. Cada linha
+// junta step / resolução baldes do nível, acessados diretamente pelo epoch.
+static void query_level(const history_slot_t *slot, int level, int64_t from_s,
+                        int64_t to_s, uint32_t step, history_row_t *rows,
+                        uint32_t max_rows, history_result_t *result)
+{
+    const history_bucket_t *buckets = level_buckets(slot, level);
+    uint32_t res = levels[level].seconds;
+    uint32_t nbuckets = levels[level].nbuckets;
+
+    uint32_t n = 0;
+    int64_t t = from_s - from_s % step;
+    for (; t <= to_s && n < max_rows; t += step) {
+        history_row_t row = {.t_ns = t * 1000000000LL};
+        double sum = 0.0;
+        for (int64_t e = t / res; e < (t + step) / res; e++) {
+            const history_bucket_t *b = &buckets[e % nbuckets];
+            if (b->count == 0 || b->epoch != (uint32_t) e) {
+                continue;
+            }
+            if (row.count == 0 || b->min < row.min) {
+                row.min = b->min;
+            }
+            if (row.count == 0 || b->max > row.max) {
+                row.max = b->max;
+            }
+            row.count += b->count;
+            sum += b->sum;
+        }
+        if (row.count > 0) {
+            row.avg = (float) (sum / row.count);
+            rows[n++] = row;
+        }
+    }
+    result->rows = n;
+    result->truncated = t <= to_s;
+}
+
+int history_query(const history_shm_t *shm, int sensor_id, int64_t from_ns,
+                  int64_t to_ns, uint32_t step_s, history_row_t *rows,
+                  uint32_t max_rows, history_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    if (sensor_id < 0 || (uint32_t) sensor_id >= shm->capacity) {
+        return -1;
+    }
+    uint32_t s = atomic_load_explicit(&shm->slot_of[sensor_id],
+                                      memory_order_acquire);
+    if (s == 0 || s == SLOT_NONE) {
+        return -1;
+    }
+    const history_slot_t *slot = slot_at(shm, s - 1);
+
+    // Nível mais grosso que ainda cabe no passo; sobe se ele não alcança o
+    // início do intervalo (o passo acompanha a resolução do nível)
+    int level = 0;
+    int64_t from_s = from_ns / 1000000000LL;
+    int64_t to_s = to_ns / 1000000000LL;
+    if (step_s > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        while (level + 1 < HISTORY_LEVELS &&
+               levels[level + 1].seconds <= step_s) {
+            level++;
+        }
+        while (level + 1 < HISTORY_LEVELS &&
+               from_s < (int64_t) now.tv_sec - (int64_t) levels[level].seconds *
+                                                   levels[level].nbuckets) {
+            level++;
+        }
+        uint32_t res = levels[level].seconds;
+        step_s = (step_s + res - 1) / res * res;
+
+        // Nada fora da retenção do nível: limita o laço de baldes
+        int64_t oldest = (int64_t) now.tv_sec -
+                         (int64_t) res * levels[level].nbuckets;
+        if (from_s < oldest) {
+            from_s = oldest;
+        }
+        if (to_s > (int64_t) now.tv_sec) {
+            to_s = (int64_t) now.tv_sec;
+        }
+    }
+
+    int attempts = 0;
+    uint32_t s1;
+    do {
+        s1 = seqlock_read_begin(&slot->seq, &attempts);
+        result->type = (sensor_type_t) slot->type;
+        result->step_s = step_s;
+        if (step_s == 0) {
+            query_raw(slot, from_ns, to_ns, rows, max_rows, result);
+        } else {
+            query_level(slot, level, from_s, to_s, step_s, rows, max_rows,
+                        result);
+        }
+    } while (!seqlock_read_end(&slot->seq, s1, &attempts));
+    return 0;
+}
@@ -0,0 +1,222 @@
+#include "common.h"
+#include "latency.h"
+#include "logger.h"
+
+#include <stddef.h>
+
+#define LATENCY_SHM_MAGIC 0x4c41544eu // "NTAL"
+
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    "criação→ingestão", "ingestão→retirada", "retirada→fim", "total"};
+
+latency_shm_t *latency_shm_create(uint32_t ntables)
+{
+    size_t table_offset = shm_align(sizeof(latency_shm_t));
+    size_t total = table_offset + (size_t) ntables * sizeof(latency_table_t);
+
+    // Segmento zerado: todos os histogramas começam vazios
+    latency_shm_t *shm =
+        shm_table_create(LATENCY_SHM_NAME, total, "de latência");
+    if (shm == NULL) {
+        return NULL;
+    }
+
+    shm->ntables = ntables;
+    shm->total_bytes = total;
+    shm->table_offset = table_offset;
+    shm_table_publish(shm, LATENCY_SHM_MAGIC);
+
+    return shm;
+}
+
+latency_shm_t *latency_shm_open(void)
+{
+    return shm_table_open(LATENCY_SHM_NAME, sizeof(latency_shm_t),
+                          LATENCY_SHM_MAGIC,
+                          offsetof(latency_shm_t, total_bytes));
+}
+
+void latency_shm_close(latency_shm_t *shm)
+{
+    if (shm != NULL) {
+        munmap(shm, shm->total_bytes);
+    }
+}
+
+const char *latency_stage_name(latency_stage_t stage)
+{
+    return stage < LATENCY_STAGE_COUNT ? stage_names[stage] : "?";
+}
+
+// Índice log-linear: valores < 32 ns são exatos; acima, o expoente escolhe o
+// bloco e os 5 bits seguintes ao bit mais significativo o sub-balde
+static inline uint32_t bucket_index(uint64_t ns)
+{
+    if (ns < LATENCY_SUB_COUNT) {
+        return (uint32_t) ns;
+    }
+    uint32_t exp = 63u - (uint32_t) __builtin_clzll(ns);
+    if (exp > LATENCY_MAX_EXP) {
+        return LATENCY_BUCKETS - 1;
+    }
+    uint32_t sub = (uint32_t) (ns >> (exp - LATENCY_SUB_BITS)) &
+                   (LATENCY_SUB_COUNT - 1);
+    return (exp - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT + sub;
+}
+
+// Maior valor representado pelo balde (como no HDR Histogram)
+static uint64_t bucket_upper(uint32_t index)
+{
+    if (index < LATENCY_SUB_COUNT) {
+        return index;
+    }
+    uint32_t block = index / LATENCY_SUB_COUNT;
+    uint32_t sub = index % LATENCY_SUB_COUNT;
+    uint32_t shift = block - 1;
+    return (((uint64_t) (LATENCY_SUB_COUNT + sub) + 1) << shift) - 1;
+}
+
+// Único escritor: load + store relaxados evitam instruções com lock
+static inline void counter_add(_Atomic uint64_t *counter, uint64_t value)
+{
+    atomic_store_explicit(
+        counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+        memory_order_relaxed);
+}
+
+void latency_hist_record(latency_hist_t *h, uint64_t ns)
+{
+    counter_add(&h->buckets[bucket_index(ns)], 1);
+    counter_add(&h->count, 1);
+    counter_add(&h->sum, ns);
+    if (ns > atomic_load_explicit(&h->max, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max, ns, memory_order_relaxed);
+    }
+}
+
+static inline uint64_t elapsed(uint64_t from, uint64_t to)
+{
+    return to > from ? to - from : 0;
+}
+
+void latency_record_sample(latency_table_t *table, const sensor_data_t *data,
+                           uint64_t t_dequeue, uint64_t t_done)
+{
+    uint32_t type = (uint32_t) data->type;
+    if (type >= SENSOR_TYPE_COUNT) {
+        return;
+    }
+
+    if (data->t_created != 0 && data->t_ingest != 0) {
+        latency_hist_record(&table->hist[LATENCY_CREATE_INGEST][type],
+                    elapsed(data->t_created, data->t_ingest));
+    }
+    if (data->t_ingest != 0) {
+        latency_hist_record(&table->hist[LATENCY_INGEST_DEQUEUE][type],
+                    elapsed(data->t_ingest, t_dequeue));
+    }
+    latency_hist_record(&table->hist[LATENCY_DEQUEUE_DONE][type],
+                elapsed(t_dequeue, t_done));
+    if (data->t_created != 0) {
+        latency_hist_record(&table->hist[LATENCY_TOTAL][type],
+                    elapsed(data->t_created, t_done));
+    }
+}
+
+void latency_hist_add(latency_snapshot_t *out, const latency_hist_t *h)
+{
+    uint64_t count = atomic_load_explicit(&h->count, memory_order_relaxed);
+    if (count == 0) {
+        return;
+    }
+    out->count += count;
+    out->sum += atomic_load_explicit(&h->sum, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    if (max > out->max) {
+        out->max = max;
+    }
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        out->buckets[i] +=
+            atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+    }
+}
+
+void latency_collect(latency_shm_t *shm, latency_stage_t stage, int type,
+                     latency_snapshot_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    for (uint32_t t = 0; t < shm->ntables; t++) {
+        latency_table_t *table = latency_table(shm, t);
+        for (int k = 0; k < SENSOR_TYPE_COUNT; k++) {
+            if (type < 0 || type == k) {
+                latency_hist_add(out, &table->hist[stage][k]);
+            }
+        }
+    }
+}
+
+uint64_t latency_percentile(const latency_snapshot_t *snap, double q)
+{
+    // Total pelos baldes: a leitura concorrente pode ver count e baldes
+    // ligeiramente defasados
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        total += snap->buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t) (q * (double) total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += snap->buckets[i];
+        if (seen >= rank) {
+            uint64_t value = bucket_upper(i);
+            return value < snap->max ? value : snap->max;
+        }
+    }
+    return snap->max;
+}
+
+void latency_format(const latency_snapshot_t *snap, char *buf, size_t len)
+{
+    if (snap->count == 0) {
+        snprintf(buf, len, "sem amostras");
+        return;
+    }
+    snprintf(buf, len,
+             "n=%llu p50=%.1f p99=%.1f p99.9=%.1f máx=%.1f média=%.1f us",
+             (unsigned long long) snap->count,
+             (double) latency_percentile(snap, 0.50) / 1e3,
+             (double) latency_percentile(snap, 0.99) / 1e3,
+             (double) latency_percentile(snap, 0.999) / 1e3,
+             (double) snap->max / 1e3,
+             (double) snap->sum / (double) snap->count / 1e3);
+}
+
+void latency_log_summary(latency_shm_t *shm, const char *component)
+{
+    // ~9 KiB: fora da pilha para threads com pilha reduzida
+    static latency_snapshot_t snap;
+    char line[160];
+
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        latency_collect(shm, (latency_stage_t) stage, -1, &snap);
+        latency_format(&snap, line, sizeof(line));
+        log_event(LOG_INFO, COLOR_CYAN, component, "Latência %s: %s",
+                  latency_stage_name((latency_stage_t) stage), line);
+    }
+    for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        latency_collect(shm, LATENCY_TOTAL, type, &snap);
+        if (snap.count == 0) {
+            continue;
+        }
+        latency_format(&snap, line, sizeof(line));
+        log_event(LOG_INFO, COLOR_CYAN, component, "Latência total %s: %s",
+                  sensor_type_name((sensor_type_t) type), line);
+    }
+}
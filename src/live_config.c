@@ -0,0 +1,141 @@
+#include "common.h"
+#include "live_config.h"
+
+#define LIVE_CONFIG_MAGIC 0x4c434647u // "GFCL"
+
+live_config_t *live_config_open(void)
+{
+    int fd = shm_open(CONFIG_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) {
+        perror("Erro ao abrir configuração compartilhada");
+        return NULL;
+    }
+
+    size_t total = sizeof(live_config_t) +
+                   LIVE_CONFIG_MAX_SENSORS * sizeof(live_sensor_cfg_t);
+
+    // Quem chegar primeiro dimensiona; ftruncate para o mesmo tamanho não
+    // altera o conteúdo, então a corrida entre processos é inofensiva
+    struct stat st;
+    if (fstat(fd, &st) == -1 ||
+        (st.st_size < (off_t) total && ftruncate(fd, total) == -1)) {
+        perror("Erro ao dimensionar configuração compartilhada");
+        close(fd);
+        return NULL;
+    }
+
+    live_config_t *cfg = (live_config_t *) mmap(
+        NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (cfg == MAP_FAILED) {
+        perror("Erro ao mapear configuração compartilhada");
+        return NULL;
+    }
+
+    if (cfg->magic != LIVE_CONFIG_MAGIC) {
+        cfg->capacity = LIVE_CONFIG_MAX_SENSORS;
+        cfg->total_bytes = total;
+        cfg->magic = LIVE_CONFIG_MAGIC;
+    }
+    return cfg;
+}
+
+void live_config_close(live_config_t *cfg)
+{
+    if (cfg != NULL) {
+        munmap(cfg, cfg->total_bytes);
+    }
+}
+
+void live_view_defaults(live_sensor_view_t *view)
+{
+    memset(view, 0, sizeof(*view));
+    view->enabled = 1;
+    view->gain = 1.0f;
+}
+
+int live_config_poll(live_config_t *cfg, int sensor_id,
+                     live_sensor_view_t *view)
+{
+    if (cfg == NULL || sensor_id < 0 ||
+        (uint32_t) sensor_id >= LIVE_CONFIG_MAX_SENSORS) {
+        return 0;
+    }
+
+    // Caminho comum: uma única leitura atômica e nada mudou
+    live_sensor_cfg_t *e = &cfg->sensors[sensor_id];
+    uint32_t s1 = atomic_load_explicit(&e->seq, memory_order_acquire);
+    if (s1 == view->seq || (s1 & 1)) {
+        return 0; // Sem mudança ou escritor no meio da atualização
+    }
+
+    live_sensor_view_t next;
+    next.enabled = (int) e->enabled;
+    next.rate_hz = e->rate_hz;
+    next.gain = e->gain;
+    next.offset = e->offset;
+    next.low = e->low;
+    next.high = e->high;
+    next.flags = e->flags;
+
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t s2 = atomic_load_explicit(&e->seq, memory_order_relaxed);
+    if (s1 != s2) {
+        return 0; // Atualizada durante a cópia: tentar na próxima iteração
+    }
+
+    next.seq = s1;
+    *view = next;
+    return 1;
+}
+
+static void edit_entry(live_sensor_cfg_t *e, live_config_edit_fn edit,
+                       void *ctx)
+{
+    // Único escritor: a leitura da própria entrada não precisa do seqlock
+    uint32_t seq = atomic_load_explicit(&e->seq, memory_order_relaxed);
+    live_sensor_view_t view;
+    live_view_defaults(&view);
+    if (seq != 0) {
+        view.enabled = (int) e->enabled;
+        view.rate_hz = e->rate_hz;
+        view.gain = e->gain;
+        view.offset = e->offset;
+        view.low = e->low;
+        view.high = e->high;
+        view.flags = e->flags;
+    }
+
+    edit(&view, ctx);
+
+    // Seqlock: seq ímpar enquanto a entrada está sendo escrita
+    seqlock_write_begin(&e->seq);
+
+    e->enabled = view.enabled ? 1u : 0u;
+    e->rate_hz = view.rate_hz;
+    e->gain = view.gain;
+    e->offset = view.offset;
+    e->low = view.low;
+    e->high = view.high;
+    e->flags = view.flags;
+
+    seqlock_write_end(&e->seq, seq);
+}
+
+int live_config_edit(live_config_t *cfg, int sensor_id,
+                     live_config_edit_fn edit, void *ctx)
+{
+    if (sensor_id >= LIVE_CONFIG_MAX_SENSORS) {
+        return -1;
+    }
+
+    if (sensor_id > 0) {
+        edit_entry(&cfg->sensors[sensor_id], edit, ctx);
+        return 0;
+    }
+
+    for (uint32_t id = 1; id < LIVE_CONFIG_MAX_SENSORS; id++) {
+        edit_entry(&cfg->sensors[id], edit, ctx);
+    }
+    return 0;
+}
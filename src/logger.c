@@ -0,0 +1,656 @@
+#include "common.h"
+#include "logger.h"
+
+#include <ctype.h>
+#include <stddef.h>
+
+// Intervalo de varredura da thread escritora quando não há registros
+#define LOG_IDLE_MS 10
+// Tamanho do lote formatado antes de cada write()
+#define LOG_OUT_BYTES 65536
+#define LOG_RING_MASK (LOG_RING_RECORDS - 1)
+
+// Ring SPSC por thread: a thread dona escreve em head, a escritora lê em tail
+typedef struct {
+    _Alignas(64) _Atomic uint32_t head;
+    _Alignas(64) _Atomic uint32_t tail;
+    _Atomic int in_use;
+    _Atomic int owner_exited;
+    // Balde de tokens (acessado só pela thread dona)
+    uint64_t last_refill_ns;
+    double tokens;
+    log_record_t records[LOG_RING_RECORDS];
+} log_ring_t;
+
+typedef enum {
+    LEN_NONE = 0,
+    LEN_HH,
+    LEN_H,
+    LEN_L,
+    LEN_LL,
+    LEN_Z,
+    LEN_J,
+    LEN_T,
+    LEN_BIG_L
+} log_length_t;
+
+// Especificador de conversão printf já decomposto
+typedef struct {
+    const char *body; // flags, largura e precisão (após '%')
+    size_t body_len;
+    log_length_t length;
+    char conv;
+} log_spec_t;
+
+static log_ring_t log_pool[LOG_MAX_THREADS];
+static _Thread_local log_ring_t *tl_ring = NULL;
+
+static _Atomic int log_min_level = LOG_INFO;
+static double log_rate_per_sec = 1000.0;
+
+static _Atomic uint64_t dropped_full = 0;
+static _Atomic uint64_t dropped_rate = 0;
+static _Atomic uint64_t dropped_noslot = 0;
+
+static pthread_mutex_t log_init_mutex = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic int log_started = 0;
+static _Atomic int writer_running = 0;
+static pthread_t writer_tid;
+static pthread_key_t ring_key;
+
+// Buffer de saída (usado só pela thread escritora)
+static char out_buf[LOG_OUT_BYTES];
+static size_t out_len = 0;
+
+static const char *parse_spec(const char *p, log_spec_t *spec)
+{
+    spec->body = p;
+    while (*p != '\0' && strchr("-+ #0", *p) != NULL) {
+        p++;
+    }
+    while (isdigit((unsigned char) *p)) {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (isdigit((unsigned char) *p)) {
+            p++;
+        }
+    }
+    spec->body_len = (size_t) (p - spec->body);
+
+    spec->length = LEN_NONE;
+    if (p[0] == 'h' && p[1] == 'h') {
+        spec->length = LEN_HH;
+        p += 2;
+    } else if (p[0] == 'l' && p[1] == 'l') {
+        spec->length = LEN_LL;
+        p += 2;
+    } else if (*p == 'h') {
+        spec->length = LEN_H;
+        p++;
+    } else if (*p == 'l') {
+        spec->length = LEN_L;
+        p++;
+    } else if (*p == 'z') {
+        spec->length = LEN_Z;
+        p++;
+    } else if (*p == 'j') {
+        spec->length = LEN_J;
+        p++;
+    } else if (*p == 't') {
+        spec->length = LEN_T;
+        p++;
+    } else if (*p == 'L') {
+        spec->length = LEN_BIG_L;
+        p++;
+    }
+
+    spec->conv = *p;
+    return *p != '\0' ? p + 1 : p;
+}
+
+// Captura os argumentos variádicos conforme o formato (sem formatar)
+static void capture_args(log_record_t *rec, const char *fmt, va_list ap)
+{
+    const char *p = fmt;
+    rec->nargs = 0;
+    rec->str_used = 0;
+
+    while ((p = strchr(p, '%')) != NULL && rec->nargs < LOG_MAX_ARGS) {
+        log_spec_t spec;
+        p = parse_spec(p + 1, &spec);
+        log_arg_t *arg = &rec->args[rec->nargs];
+
+        switch (spec.conv) {
+        case 'd':
+        case 'i':
+            switch (spec.length) {
+            case LEN_LL:
+                arg->i = va_arg(ap, long long);
+                break;
+            case LEN_L:
+                arg->i = va_arg(ap, long);
+                break;
+            case LEN_Z:
+                arg->i = va_arg(ap, ssize_t);
+                break;
+            case LEN_J:
+                arg->i = va_arg(ap, intmax_t);
+                break;
+            case LEN_T:
+                arg->i = va_arg(ap, ptrdiff_t);
+                break;
+            default:
+                arg->i = va_arg(ap, int);
+            }
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            switch (spec.length) {
+            case LEN_LL:
+                arg->u = va_arg(ap, unsigned long long);
+                break;
+            case LEN_L:
+                arg->u = va_arg(ap, unsigned long);
+                break;
+            case LEN_Z:
+                arg->u = va_arg(ap, size_t);
+                break;
+            case LEN_J:
+                arg->u = va_arg(ap, uintmax_t);
+                break;
+            case LEN_T:
+                arg->u = (unsigned long long) va_arg(ap, ptrdiff_t);
+                break;
+            default:
+                arg->u = va_arg(ap, unsigned int);
+            }
+            break;
+        case 'c':
+            arg->i = va_arg(ap, int);
+            break;
+        case 'p':
+            arg->u = (uintptr_t) va_arg(ap, void *);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (spec.length == LEN_BIG_L) {
+                arg->d = (double) va_arg(ap, long double);
+            } else {
+                arg->d = va_arg(ap, double);
+            }
+            break;
+        case 's': {
+            const char *str = va_arg(ap, const char *);
+            if (str == NULL) {
+                str = "(null)";
+            }
+            size_t room = LOG_STR_BYTES - rec->str_used;
+            if (room <= 1) {
+                // Sem espaço: string vazia
+                rec->strbuf[LOG_STR_BYTES - 1] = '\0';
+                arg->str_offset = LOG_STR_BYTES - 1;
+                break;
+            }
+            size_t len = strnlen(str, room - 1);
+            arg->str_offset = rec->str_used;
+            memcpy(rec->strbuf + rec->str_used, str, len);
+            rec->strbuf[rec->str_used + len] = '\0';
+            rec->str_used += (uint16_t) (len + 1);
+            break;
+        }
+        default:
+            // '%%' ou conversão não suportada: não consome argumento
+            continue;
+        }
+        rec->nargs++;
+    }
+}
+
+// Formata o registro (executado apenas pela thread escritora)
+static size_t render_message(const log_record_t *rec, char *dst, size_t cap)
+{
+    size_t len = 0;
+    const char *p = rec->fmt;
+    int argi = 0;
+
+    while (*p != '\0' && len + 1 < cap) {
+        if (*p != '%') {
+            dst[len++] = *p++;
+            continue;
+        }
+
+        const char *spec_start = p;
+        log_spec_t spec;
+        p = parse_spec(p + 1, &spec);
+
+        char one[32];
+        int n = 0;
+        if (spec.conv == '%') {
+            dst[len++] = '%';
+            continue;
+        }
+        if (spec.body_len > 16 || argi >= rec->nargs) {
+            // Especificador desconhecido ou sem argumento: copiar literal
+            size_t raw = (size_t) (p - spec_start);
+            if (raw > cap - len - 1) {
+                raw = cap - len - 1;
+            }
+            memcpy(dst + len, spec_start, raw);
+            len += raw;
+            continue;
+        }
+
+        const log_arg_t *arg = &rec->args[argi];
+        int used_arg = 1;
+        switch (spec.conv) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            snprintf(one, sizeof(one), "%%%.*sll%c", (int) spec.body_len,
+                     spec.body, spec.conv);
+            if (spec.conv == 'd' || spec.conv == 'i') {
+                n = snprintf(dst + len, cap - len, one, arg->i);
+            } else {
+                n = snprintf(dst + len, cap - len, one, arg->u);
+            }
+            break;
+        case 'c':
+            snprintf(one, sizeof(one), "%%%.*sc", (int) spec.body_len,
+                     spec.body);
+            n = snprintf(dst + len, cap - len, one, (int) arg->i);
+            break;
+        case 'p':
+            snprintf(one, sizeof(one), "%%%.*sp", (int) spec.body_len,
+                     spec.body);
+            n = snprintf(dst + len, cap - len, one,
+                         (void *) (uintptr_t) arg->u);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            snprintf(one, sizeof(one), "%%%.*s%c", (int) spec.body_len,
+                     spec.body, spec.conv);
+            n = snprintf(dst + len, cap - len, one, arg->d);
+            break;
+        case 's':
+            snprintf(one, sizeof(one), "%%%.*ss", (int) spec.body_len,
+                     spec.body);
+            n = snprintf(dst + len, cap - len, one,
+                         rec->strbuf + arg->str_offset);
+            break;
+        default:
+            used_arg = 0;
+            break;
+        }
+
+        argi += used_arg;
+        if (n > 0) {
+            len += (size_t) n < cap - len ? (size_t) n : cap - len - 1;
+        }
+    }
+
+    dst[len] = '\0';
+    return len;
+}
+
+static void out_flush(void)
+{
+    size_t off = 0;
+    while (off < out_len) {
+        ssize_t n = write(STDOUT_FILENO, out_buf + off, out_len - off);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        off += (size_t) n;
+    }
+    out_len = 0;
+}
+
+static void out_append_record(const log_record_t *rec)
+{
+    // Cache do texto de data: só muda uma vez por segundo
+    static time_t cached_sec = 0;
+    static char time_str[32];
+
+    time_t sec = (time_t) (rec->timestamp_ns / 1000000000ull);
+    if (sec != cached_sec) {
+        struct tm tm;
+        localtime_r(&sec, &tm);
+        strftime(time_str, sizeof(time_str), "%a %b %e %H:%M:%S %Y", &tm);
+        cached_sec = sec;
+    }
+
+    char message[512];
+    render_message(rec, message, sizeof(message));
+
+    if (out_len + sizeof(message) + 128 > sizeof(out_buf)) {
+        out_flush();
+    }
+    int n = snprintf(out_buf + out_len, sizeof(out_buf) - out_len,
+                     "%s[%s] %s%s %s%s\n", rec->color, time_str, COLOR_CYAN,
+                     rec->component, COLOR_RESET, message);
+    if (n > 0) {
+        out_len += (size_t) n < sizeof(out_buf) - out_len
+                       ? (size_t) n
+                       : sizeof(out_buf) - out_len - 1;
+    }
+}
+
+// Drena todos os rings; retorna quantos registros foram escritos
+static size_t drain_all(void)
+{
+    size_t total = 0;
+
+    for (int i = 0; i < LOG_MAX_THREADS; i++) {
+        log_ring_t *ring = &log_pool[i];
+        if (!atomic_load_explicit(&ring->in_use, memory_order_acquire)) {
+            continue;
+        }
+
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail != head) {
+            out_append_record(&ring->records[tail & LOG_RING_MASK]);
+            tail++;
+            total++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        // Thread dona terminou e o ring esvaziou: devolver ao pool
+        if (atomic_load_explicit(&ring->owner_exited, memory_order_acquire) &&
+            atomic_load_explicit(&ring->head, memory_order_acquire) == tail) {
+            atomic_store_explicit(&ring->in_use, 0, memory_order_release);
+        }
+    }
+
+    out_flush();
+    return total;
+}
+
+static void report_drops(void)
+{
+    static uint64_t last_full = 0, last_rate = 0, last_noslot = 0;
+
+    uint64_t full = atomic_load(&dropped_full);
+    uint64_t rate = atomic_load(&dropped_rate);
+    uint64_t noslot = atomic_load(&dropped_noslot);
+    if (full == last_full && rate == last_rate && noslot == last_noslot) {
+        return;
+    }
+
+    char line[256];
+    int n = snprintf(line, sizeof(line),
+                     "%s[LOG] %sregistros descartados: ring cheio=%llu, "
+                     "limite de taxa=%llu, sem ring=%llu%s\n",
+                     COLOR_YELLOW, COLOR_RESET,
+                     (unsigned long long) (full - last_full),
+                     (unsigned long long) (rate - last_rate),
+                     (unsigned long long) (noslot - last_noslot),
+                     COLOR_RESET);
+    if (n > 0 && write(STDOUT_FILENO, line, (size_t) n) < 0) {
+        // Nada a fazer: stdout indisponível
+    }
+
+    last_full = full;
+    last_rate = rate;
+    last_noslot = noslot;
+}
+
+static void *log_writer_thread(void *arg __attribute__((unused)))
+{
+    uint64_t last_report = monotonic_ns();
+
+    while (atomic_load_explicit(&writer_running, memory_order_acquire)) {
+        size_t written = drain_all();
+
+        uint64_t now = monotonic_ns();
+        if (now - last_report >= 1000000000ull) {
+            report_drops();
+            last_report = now;
+        }
+
+        if (written == 0) {
+            msleep(LOG_IDLE_MS);
+        }
+    }
+
+    // Escrita final de tudo o que ainda estiver pendente
+    drain_all();
+    report_drops();
+    return NULL;
+}
+
+static void ring_owner_exit(void *ptr)
+{
+    log_ring_t *ring = (log_ring_t *) ptr;
+    atomic_store_explicit(&ring->owner_exited, 1, memory_order_release);
+}
+
+static void log_shutdown(void)
+{
+    if (atomic_exchange(&writer_running, 0)) {
+        pthread_join(writer_tid, NULL);
+    }
+}
+
+// Após fork o filho não tem a thread escritora: descartar registros herdados
+// (o pai os escreverá) e reiniciar o subsistema na primeira chamada
+static void log_atfork_child(void)
+{
+    for (int i = 0; i < LOG_MAX_THREADS; i++) {
+        uint32_t head = atomic_load(&log_pool[i].head);
+        atomic_store(&log_pool[i].tail, head);
+    }
+    atomic_store(&writer_running, 0);
+    atomic_store(&log_started, 0);
+    pthread_mutex_init(&log_init_mutex, NULL);
+}
+
+static log_level_t parse_level(const char *name)
+{
+    if (strcmp(name, "debug") == 0) {
+        return LOG_DEBUG;
+    } else if (strcmp(name, "warn") == 0) {
+        return LOG_WARN;
+    } else if (strcmp(name, "error") == 0) {
+        return LOG_ERROR;
+    }
+    return LOG_INFO;
+}
+
+static void log_start(void)
+{
+    pthread_mutex_lock(&log_init_mutex);
+
+    if (!atomic_load(&log_started)) {
+        static int once = 0;
+        if (!once) {
+            const char *level = getenv("SENSOR_LOG_LEVEL");
+            if (level != NULL) {
+                atomic_store(&log_min_level, parse_level(level));
+            }
+            const char *rate = getenv("SENSOR_LOG_RATE");
+            if (rate != NULL) {
+                log_rate_per_sec = atof(rate);
+            }
+            pthread_key_create(&ring_key, ring_owner_exit);
+            pthread_atfork(NULL, NULL, log_atfork_child);
+            atexit(log_shutdown);
+            once = 1;
+        }
+
+        // A thread escritora herda uma máscara com todos os sinais
+        // bloqueados: sinais do processo vão para as threads da aplicação
+        // (ex.: signalfd/handlers), nunca para ela
+        sigset_t all, previous;
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &previous);
+        atomic_store(&writer_running, 1);
+        if (pthread_create(&writer_tid, NULL, log_writer_thread, NULL) != 0) {
+            atomic_store(&writer_running, 0);
+        }
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        atomic_store_explicit(&log_started, 1, memory_order_release);
+    }
+
+    pthread_mutex_unlock(&log_init_mutex);
+}
+
+// Obtém o ring da thread atual (só aloca um slot do pool na primeira vez)
+static log_ring_t *thread_ring(uint64_t now_ns)
+{
+    if (tl_ring != NULL) {
+        return tl_ring;
+    }
+
+    for (int i = 0; i < LOG_MAX_THREADS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&log_pool[i].in_use, &expected,
+                                           1)) {
+            log_ring_t *ring = &log_pool[i];
+            atomic_store(&ring->owner_exited, 0);
+            ring->tokens = log_rate_per_sec;
+            ring->last_refill_ns = now_ns;
+            pthread_setspecific(ring_key, ring);
+            tl_ring = ring;
+            return ring;
+        }
+    }
+    return NULL;
+}
+
+// Balde de tokens por thread: no máximo log_rate_per_sec registros/s
+static int rate_allow(log_ring_t *ring, uint64_t now_ns)
+{
+    if (log_rate_per_sec <= 0) {
+        return 1;
+    }
+
+    double elapsed = (double) (now_ns - ring->last_refill_ns) / 1e9;
+    ring->last_refill_ns = now_ns;
+    ring->tokens += elapsed * log_rate_per_sec;
+    if (ring->tokens > log_rate_per_sec) {
+        ring->tokens = log_rate_per_sec;
+    }
+    if (ring->tokens < 1.0) {
+        return 0;
+    }
+    ring->tokens -= 1.0;
+    return 1;
+}
+
+void log_eventv(log_level_t level, const char *color, const char *component,
+                const char *fmt, va_list ap)
+{
+    if ((int) level < atomic_load_explicit(&log_min_level,
+                                           memory_order_relaxed)) {
+        return;
+    }
+    if (!atomic_load_explicit(&log_started, memory_order_acquire)) {
+        log_start();
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t now = (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+
+    log_ring_t *ring = thread_ring(now);
+    if (ring == NULL) {
+        atomic_fetch_add_explicit(&dropped_noslot, 1, memory_order_relaxed);
+        return;
+    }
+    if (!rate_allow(ring, now)) {
+        atomic_fetch_add_explicit(&dropped_rate, 1, memory_order_relaxed);
+        return;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= LOG_RING_RECORDS) {
+        // Nunca bloqueia: conta e descarta
+        atomic_fetch_add_explicit(&dropped_full, 1, memory_order_relaxed);
+        return;
+    }
+
+    log_record_t *rec = &ring->records[head & LOG_RING_MASK];
+    rec->timestamp_ns = now;
+    rec->color = color;
+    rec->fmt = fmt;
+    rec->level = (uint8_t) level;
+    strncpy(rec->component, component, LOG_COMPONENT_BYTES - 1);
+    rec->component[LOG_COMPONENT_BYTES - 1] = '\0';
+    capture_args(rec, fmt, ap);
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void log_event(log_level_t level, const char *color, const char *component,
+               const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    log_eventv(level, color, component, fmt, ap);
+    va_end(ap);
+}
+
+void log_set_level(log_level_t level)
+{
+    atomic_store(&log_min_level, (int) level);
+}
+
+int log_enabled(log_level_t level)
+{
+    return (int) level >= atomic_load_explicit(&log_min_level,
+                                               memory_order_relaxed);
+}
+
+void log_flush(void)
+{
+    if (!atomic_load(&writer_running)) {
+        return;
+    }
+
+    // Aguarda a escritora esvaziar todos os rings (limite de ~1 s)
+    for (int attempt = 0; attempt < 100; attempt++) {
+        int pending = 0;
+        for (int i = 0; i < LOG_MAX_THREADS; i++) {
+            if (atomic_load(&log_pool[i].in_use) &&
+                atomic_load(&log_pool[i].head) !=
+                    atomic_load(&log_pool[i].tail)) {
+                pending = 1;
+                break;
+            }
+        }
+        if (!pending) {
+            return;
+        }
+        msleep(LOG_IDLE_MS);
+    }
+}
+
+uint64_t log_dropped_total(void)
+{
+    return atomic_load(&dropped_full) + atomic_load(&dropped_rate) +
+           atomic_load(&dropped_noslot);
+}
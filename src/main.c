@@ -1,48 +1,348 @@
 #include "common.h"
+#include "logger.h"
+#include "metrics.h"
+#include "system_config.h"
+#include "telemetry.h"
 
-// PIDs dos processos principais
-pid_t sensor_mgr_pid = -1;
-pid_t data_proc_pid = -1;
-pid_t control_pid = -1;
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
 
-// Handler para sinais de término
-void signal_handler(int sig __attribute__((unused)))
+// Supervisor: um único loop epoll espera pelo término dos componentes
+// (pidfd), pelo handshake de prontidão (pipe) e pelos sinais (signalfd).
+// Os componentes sobem em ordem, cada um assim que o anterior sinaliza que
+// está pronto, sem esperas fixas. Um componente que falha é reiniciado de
+// imediato e, se voltar a falhar, com espera exponencial; o tempo entre a
+// falha e a nova prontidão é registrado.
+
+#define BACKOFF_MIN_MS 100
+#define BACKOFF_MAX_MS 5000
+#define STABLE_RUN_NS 10000000000ull  // 10 s estável zera o backoff
+#define READY_TIMEOUT_NS 5000000000ull // Sem handshake: seguir mesmo assim
+#define SHUTDOWN_GRACE_NS 5000000000ull // Depois disso, SIGKILL
+
+typedef enum {
+    COMP_STOPPED = 0, // Ainda não iniciado
+    COMP_STARTING,    // Aguardando handshake de prontidão
+    COMP_RUNNING,
+    COMP_BACKOFF, // Falhou; aguardando restart_at_ns
+    COMP_DONE,    // Terminou normalmente ou durante o encerramento
+} comp_state_t;
+
+typedef struct {
+    const char *name;
+    const char *path;
+    pid_t pid;
+    int pidfd;    // -1 sem pidfd (kernel antigo): término via SIGCHLD
+    int ready_fd; // Ponta de leitura do handshake (-1 fora de STARTING)
+    comp_state_t state;
+    uint32_t restarts;
+    uint32_t backoff_ms; // Atraso do próximo reinício (0 = imediato)
+    uint64_t spawn_ns;
+    uint64_t ready_ns;
+    uint64_t crash_ns; // Falha ainda não recuperada (0 = nenhuma)
+    uint64_t restart_at_ns;
+} component_t;
+
+// Ordem de início = ordem de dependência
+static component_t components[] = {
+    {.name = "data_processor", .path = "./bin/data_processor"},
+    {.name = "sensor_manager", .path = "./bin/sensor_manager"},
+    {.name = "control_interface", .path = "./bin/control_interface"},
+};
+#define NUM_COMPONENTS ((int) (sizeof(components) / sizeof(components[0])))
+
+// Identificação dos eventos no epoll: tipo nos 32 bits altos, índice do
+// componente nos baixos
+#define EV_SIGNAL 1ull
+#define EV_PIDFD 2ull
+#define EV_READY 3ull
+#define EV_TAG(kind, index) (((kind) << 32) | (uint64_t) (index))
+
+static int epfd = -1;
+static metrics_slot_t *metrics = NULL;
+
+static int epoll_watch(int fd, uint64_t tag)
 {
-    log_message(COLOR_YELLOW, "MAIN",
-                "Recebido sinal de término, encerrando sistema...");
-
-    // Enviar SIGTERM para processos filhos
-    if (sensor_mgr_pid > 0)
-        kill(sensor_mgr_pid, SIGTERM);
-    if (data_proc_pid > 0)
-        kill(data_proc_pid, SIGTERM);
-    if (control_pid > 0)
-        kill(control_pid, SIGTERM);
-
-    // Aguardar processos terminarem
-    if (sensor_mgr_pid > 0)
-        waitpid(sensor_mgr_pid, NULL, 0);
-    if (data_proc_pid > 0)
-        waitpid(data_proc_pid, NULL, 0);
-    if (control_pid > 0)
-        waitpid(control_pid, NULL, 0);
-
-    // Cleanup de recursos
-    cleanup_resources();
+    struct epoll_event ev = {.events = EPOLLIN, .data.u64 = tag};
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void close_watch(int *fd)
+{
+    if (*fd >= 0) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, *fd, NULL);
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+static int spawn_component(component_t *c)
+{
+    int ready[2];
+    if (pipe2(ready, O_CLOEXEC) == -1) {
+        perror("Erro ao criar pipe de prontidão");
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("Erro ao criar processo");
+        close(ready[0]);
+        close(ready[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        // A máscara de sinais sobrevive ao exec: restaurar a padrão
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, NULL);
+
+        char fd_str[16];
+        snprintf(fd_str, sizeof(fd_str), "%d", ready[1]);
+        fcntl(ready[1], F_SETFD, 0); // Herdado apenas pelo componente
+        setenv(READY_FD_ENV, fd_str, 1);
+
+        char *args[] = {(char *) c->path, NULL};
+        execv(args[0], args);
+        perror("Erro ao executar componente");
+        _exit(127);
+    }
+
+    close(ready[1]);
+    c->pid = pid;
+    c->spawn_ns = monotonic_ns();
+    c->state = COMP_STARTING;
+    c->ready_fd = ready[0];
+    epoll_watch(c->ready_fd, EV_TAG(EV_READY, c - components));
+
+    c->pidfd = (int) syscall(SYS_pidfd_open, pid, 0);
+    if (c->pidfd >= 0) {
+        epoll_watch(c->pidfd, EV_TAG(EV_PIDFD, c - components));
+    }
+
+    metrics_add(metrics, METRIC_CHILDREN_STARTED, 1);
+    log_event(LOG_INFO, COLOR_BLUE, "MAIN", "%s iniciado (PID=%d)", c->name,
+              (int) pid);
+    return 0;
+}
 
-    exit(0);
+// Início ordenado: o próximo componente só sobe quando nenhum está
+// aguardando prontidão
+static void start_next(void)
+{
+    for (int i = 0; i < NUM_COMPONENTS; i++) {
+        if (components[i].state == COMP_STARTING) {
+            return;
+        }
+    }
+    for (int i = 0; i < NUM_COMPONENTS; i++) {
+        if (components[i].state == COMP_STOPPED) {
+            if (spawn_component(&components[i]) == -1) {
+                components[i].state = COMP_DONE;
+                continue;
+            }
+            return;
+        }
+    }
 }
 
-int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
+static void mark_ready(component_t *c, uint64_t now, int handshake)
 {
-    // Registrar handler de sinais
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    close_watch(&c->ready_fd);
+    c->state = COMP_RUNNING;
+    c->ready_ns = now;
+
+    double ms = (double) (now - c->spawn_ns) / 1e6;
+    if (c->crash_ns != 0) {
+        log_event(LOG_INFO, COLOR_GREEN, "MAIN",
+                  "%s recuperado em %.1f ms após a falha (reinício #%u)",
+                  c->name, (double) (now - c->crash_ns) / 1e6, c->restarts);
+        c->crash_ns = 0;
+    } else if (handshake) {
+        log_event(LOG_INFO, COLOR_GREEN, "MAIN", "%s pronto em %.1f ms",
+                  c->name, ms);
+    } else {
+        log_event(LOG_WARN, COLOR_YELLOW, "MAIN",
+                  "%s sem sinal de prontidão após %.0f ms; prosseguindo",
+                  c->name, ms);
+    }
+}
+
+static void handle_ready(component_t *c, uint64_t now)
+{
+    char byte;
+    ssize_t n = read(c->ready_fd, &byte, 1);
+    if (n == 1) {
+        mark_ready(c, now, 1);
+    } else if (n == 0) {
+        // Fechou sem sinalizar: o término chega pelo pidfd/SIGCHLD
+        close_watch(&c->ready_fd);
+    }
+}
+
+// Coleta o componente se ele terminou; decide entre fim e reinício
+static void reap_component(component_t *c, uint64_t now, int shutting_down)
+{
+    if (c->state != COMP_STARTING && c->state != COMP_RUNNING) {
+        return;
+    }
+
+    int status;
+    if (waitpid(c->pid, &status, WNOHANG) != c->pid) {
+        return;
+    }
+    close_watch(&c->pidfd);
+    close_watch(&c->ready_fd);
+    metrics_add(metrics, METRIC_CHILD_EXITS, 1);
+
+    int clean_exit = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (shutting_down || clean_exit) {
+        log_event(LOG_INFO, COLOR_YELLOW, "MAIN", "%s terminou", c->name);
+        c->state = COMP_DONE;
+        return;
+    }
+
+    if (WIFSIGNALED(status)) {
+        log_event(LOG_WARN, COLOR_RED, "MAIN", "%s falhou (sinal %d)",
+                  c->name, WTERMSIG(status));
+    } else {
+        log_event(LOG_WARN, COLOR_RED, "MAIN", "%s falhou (status=%d)",
+                  c->name, WEXITSTATUS(status));
+    }
+
+    // Primeiro reinício imediato; falhas seguidas dobram a espera
+    if (c->state == COMP_RUNNING && now - c->ready_ns >= STABLE_RUN_NS) {
+        c->backoff_ms = 0;
+    }
+    if (c->crash_ns == 0) {
+        c->crash_ns = now;
+    }
+    c->restart_at_ns = now + (uint64_t) c->backoff_ms * 1000000ull;
+    c->backoff_ms = c->backoff_ms == 0 ? BACKOFF_MIN_MS
+                                       : c->backoff_ms * 2 > BACKOFF_MAX_MS
+                                             ? BACKOFF_MAX_MS
+                                             : c->backoff_ms * 2;
+    c->state = COMP_BACKOFF;
+}
+
+// Reinícios vencidos e handshakes expirados
+static void handle_timers(uint64_t now)
+{
+    for (int i = 0; i < NUM_COMPONENTS; i++) {
+        component_t *c = &components[i];
+        if (c->state == COMP_BACKOFF && now >= c->restart_at_ns) {
+            c->restarts++;
+            metrics_add(metrics, METRIC_RESTARTS, 1);
+            if (spawn_component(c) == -1) {
+                c->restart_at_ns = now + (uint64_t) BACKOFF_MAX_MS * 1000000ull;
+            }
+        } else if (c->state == COMP_STARTING &&
+                   now - c->spawn_ns >= READY_TIMEOUT_NS) {
+            mark_ready(c, now, 0);
+        }
+    }
+}
+
+// Milissegundos até o próximo prazo (-1 = nenhum)
+static int next_timeout_ms(uint64_t now, uint64_t deadline)
+{
+    uint64_t next = deadline;
+    for (int i = 0; i < NUM_COMPONENTS; i++) {
+        const component_t *c = &components[i];
+        uint64_t t = 0;
+        if (c->state == COMP_BACKOFF) {
+            t = c->restart_at_ns;
+        } else if (c->state == COMP_STARTING) {
+            t = c->spawn_ns + READY_TIMEOUT_NS;
+        }
+        if (t != 0 && (next == 0 || t < next)) {
+            next = t;
+        }
+    }
+    if (next == 0) {
+        return -1;
+    }
+    return next <= now ? 0 : (int) ((next - now + 999999) / 1000000);
+}
+
+static int all_done(void)
+{
+    for (int i = 0; i < NUM_COMPONENTS; i++) {
+        if (components[i].state != COMP_DONE) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void signal_components(int sig)
+{
+    // Ordem inversa: quem produz para para antes de quem consome
+    for (int i = NUM_COMPONENTS - 1; i >= 0; i--) {
+        component_t *c = &components[i];
+        if (c->state == COMP_STARTING || c->state == COMP_RUNNING) {
+            kill(c->pid, sig);
+        } else if (c->state != COMP_DONE) {
+            c->state = COMP_DONE; // Não iniciar/reiniciar mais
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t t_start = monotonic_ns();
+
+    // Configuração do sistema (-C arquivo): validada aqui e repassada aos
+    // componentes por SENSOR_CONFIG
+    int opt;
+    while ((opt = getopt(argc, argv, "C:")) != -1) {
+        if (opt != 'C') {
+            fprintf(stderr, "Uso: %s [-C arquivo]\n", argv[0]);
+            exit(1);
+        }
+        setenv(SYSTEM_CONFIG_ENV, optarg, 1);
+    }
+    system_config_t config;
+    system_config_default(&config);
+    if (system_config_load(&config, NULL) == -1) {
+        exit(1);
+    }
+
+    // Sinais viram eventos do loop (signalfd); SIGCHLD cobre kernels sem
+    // pidfd_open
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &signals, NULL);
+    int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd == -1) {
+        perror("Erro ao criar signalfd");
+        exit(1);
+    }
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1 || epoll_watch(signal_fd, EV_TAG(EV_SIGNAL, 0)) == -1) {
+        perror("Erro ao configurar epoll");
+        exit(1);
+    }
 
     log_message(COLOR_BLUE, "MAIN",
                 "=== Sistema de Monitoramento de Sensores ===");
     log_message(COLOR_BLUE, "MAIN", "Iniciando componentes do sistema...");
 
+    metrics = metrics_register("supervisor");
+
+    // Perfil de tempo real: os componentes aplicam cada um o seu papel (a
+    // política do supervisor não passa aos filhos)
+    if (config.rt.enabled) {
+        rt_lock_memory(&config.rt, "MAIN");
+        rt_apply_thread(&config.rt, RT_ROLE_SUPERVISOR, -1, "MAIN");
+    }
+
     // Criar diretórios necessários
     mkdir("fifos", 0755);
 
@@ -50,92 +350,119 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
     mkfifo(FIFO_SENSOR_DATA, 0666);
     mkfifo(FIFO_CONTROL, 0666);
 
-    // Criar fila de mensagens POSIX
-    struct mq_attr attr = {
-        .mq_flags = 0, .mq_maxmsg = 10, .mq_msgsize = MAX_MESSAGE_SIZE};
-    mqd_t mq = mq_open(MQ_NAME, O_CREAT | O_RDWR, 0666, &attr);
+    // Criar fila de telemetria
+    mqd_t mq = telemetry_mq_open(O_RDWR, config.mq_depth);
     if (mq == (mqd_t) -1) {
         perror("Erro ao criar fila de mensagens");
     } else {
         mq_close(mq);
     }
 
-    // Criar processo de processamento de dados
-    data_proc_pid = fork();
-    if (data_proc_pid == 0) {
-        // Processo filho - executar data_processor
-        char *args[] = {"./bin/data_processor", NULL};
-        execv(args[0], args);
-        perror("Erro ao executar data_processor");
-        exit(1);
-    } else if (data_proc_pid == -1) {
-        perror("Erro ao criar processo data_processor");
-        exit(1);
-    }
-
-    sleep(1); // Aguardar data_processor inicializar
-
-    // Criar processo gerenciador de sensores
-    sensor_mgr_pid = fork();
-    if (sensor_mgr_pid == 0) {
-        // Processo filho - executar sensor_manager
-        char *args[] = {"./bin/sensor_manager", NULL};
-        execv(args[0], args);
-        perror("Erro ao executar sensor_manager");
-        exit(1);
-    } else if (sensor_mgr_pid == -1) {
-        perror("Erro ao criar processo sensor_manager");
-        kill(data_proc_pid, SIGTERM);
-        exit(1);
+    for (int i = 0; i < NUM_COMPONENTS; i++) {
+        components[i].pidfd = -1;
+        components[i].ready_fd = -1;
     }
+    start_next();
 
-    sleep(1);
+    int started = 0;
+    int shutting_down = 0;
+    uint64_t shutdown_deadline = 0;
+    // run_s vale para o sistema inteiro: no prazo, encerra como com SIGTERM
+    // (a interface de controle não tem prazo próprio)
+    uint64_t run_deadline =
+        config.run_s != 0
+            ? t_start + (uint64_t) config.run_s * 1000000000ull
+            : 0;
 
-    // Criar processo de interface de controle
-    control_pid = fork();
-    if (control_pid == 0) {
-        // Processo filho - executar control_interface
-        char *args[] = {"./bin/control_interface", NULL};
-        execv(args[0], args);
-        perror("Erro ao executar control_interface");
-        exit(1);
-    } else if (control_pid == -1) {
-        perror("Erro ao criar processo control_interface");
-        kill(sensor_mgr_pid, SIGTERM);
-        kill(data_proc_pid, SIGTERM);
-        exit(1);
-    }
+    while (!all_done()) {
+        uint64_t now = monotonic_ns();
+        struct epoll_event events[8];
+        int n = epoll_wait(
+            epfd, events, 8,
+            next_timeout_ms(now, shutting_down ? shutdown_deadline
+                                               : run_deadline));
+        if (n == -1 && errno != EINTR) {
+            perror("Erro em epoll_wait");
+            break;
+        }
 
-    log_message(COLOR_GREEN, "MAIN", "Todos os processos criados com sucesso");
-    log_message(COLOR_GREEN, "MAIN",
-                "Sistema em execução. Pressione Ctrl+C para encerrar.");
+        now = monotonic_ns();
+        int reap = 0;
+        for (int i = 0; i < n; i++) {
+            uint64_t kind = events[i].data.u64 >> 32;
+            component_t *c = &components[events[i].data.u64 & 0xffffffffu];
 
-    // Processo supervisor aguarda indefinidamente
-    // Monitora processos filhos e aguarda sinais
-    while (1) {
-        sleep(1);
+            if (kind == EV_READY) {
+                handle_ready(c, now);
+            } else if (kind == EV_PIDFD) {
+                reap = 1;
+            } else {
+                struct signalfd_siginfo info;
+                while (read(signal_fd, &info, sizeof(info)) > 0) {
+                    if (info.ssi_signo == SIGCHLD) {
+                        reap = 1;
+                    } else if (!shutting_down) {
+                        log_message(COLOR_YELLOW, "MAIN",
+                                    "Recebido sinal de término, encerrando "
+                                    "sistema...");
+                        shutting_down = 1;
+                        shutdown_deadline = now + SHUTDOWN_GRACE_NS;
+                        signal_components(SIGTERM);
+                    }
+                }
+            }
+        }
 
-        // Verificar se processos ainda estão rodando
-        if (waitpid(sensor_mgr_pid, NULL, WNOHANG) > 0) {
-            log_message(COLOR_YELLOW, "MAIN", "sensor_manager terminou");
-            sensor_mgr_pid = -1;
+        if (reap) {
+            for (int i = 0; i < NUM_COMPONENTS; i++) {
+                reap_component(&components[i], now, shutting_down);
+            }
         }
-        if (waitpid(data_proc_pid, NULL, WNOHANG) > 0) {
-            log_message(COLOR_YELLOW, "MAIN", "data_processor terminou");
-            data_proc_pid = -1;
+
+        if (!shutting_down && run_deadline != 0 && now >= run_deadline) {
+            log_event(LOG_INFO, COLOR_YELLOW, "MAIN",
+                      "Tempo de execução (run_s = %u s) esgotado, encerrando "
+                      "sistema...",
+                      config.run_s);
+            shutting_down = 1;
+            shutdown_deadline = now + SHUTDOWN_GRACE_NS;
+            signal_components(SIGTERM);
         }
-        if (waitpid(control_pid, NULL, WNOHANG) > 0) {
-            log_message(COLOR_YELLOW, "MAIN", "control_interface terminou");
-            control_pid = -1;
+
+        if (shutting_down) {
+            if (now >= shutdown_deadline) {
+                log_message(COLOR_RED, "MAIN",
+                            "Componentes não encerraram; enviando SIGKILL");
+                signal_components(SIGKILL);
+                shutdown_deadline = now + SHUTDOWN_GRACE_NS;
+            }
+            continue;
         }
 
-        // Se todos os processos terminaram, sair
-        if (sensor_mgr_pid == -1 && data_proc_pid == -1 && control_pid == -1) {
-            log_message(COLOR_BLUE, "MAIN", "Todos os processos terminaram");
-            break;
+        handle_timers(now);
+        start_next();
+        metrics_touch(metrics, now);
+
+        if (!started) {
+            int ready = 0;
+            for (int i = 0; i < NUM_COMPONENTS; i++) {
+                ready += components[i].state == COMP_RUNNING;
+            }
+            if (ready == NUM_COMPONENTS) {
+                started = 1;
+                log_event(LOG_INFO, COLOR_GREEN, "MAIN",
+                          "Sistema pronto em %.1f ms. Pressione Ctrl+C para "
+                          "encerrar.",
+                          (double) (monotonic_ns() - t_start) / 1e6);
+            }
         }
     }
 
+    log_message(COLOR_BLUE, "MAIN", "Todos os processos terminaram");
+
+    close(epfd);
+    close(signal_fd);
+    metrics_unregister(metrics);
     cleanup_resources();
     log_message(COLOR_BLUE, "MAIN", "Sistema encerrado");
 
@@ -0,0 +1,159 @@
+#include "metrics.h"
+
+#define METRICS_SHM_MAGIC 0x4d545243u // "CRTM"
+
+// Segmento mapeado pelo processo (compartilhado entre suas threads)
+static metrics_shm_t *process_shm = NULL;
+static pthread_mutex_t process_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static metrics_shm_t *map_segment(void)
+{
+    int fd = shm_open(METRICS_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) {
+        perror("Erro ao abrir métricas compartilhadas");
+        return NULL;
+    }
+
+    // Tamanho fixo: ftruncate para o mesmo tamanho não altera o conteúdo
+    struct stat st;
+    if (fstat(fd, &st) == -1 ||
+        (st.st_size < (off_t) sizeof(metrics_shm_t) &&
+         ftruncate(fd, sizeof(metrics_shm_t)) == -1)) {
+        perror("Erro ao dimensionar métricas compartilhadas");
+        close(fd);
+        return NULL;
+    }
+
+    metrics_shm_t *shm = (metrics_shm_t *) mmap(
+        NULL, sizeof(metrics_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED) {
+        perror("Erro ao mapear métricas compartilhadas");
+        return NULL;
+    }
+
+    if (shm->magic != METRICS_SHM_MAGIC) {
+        shm->nslots = METRICS_MAX_SLOTS;
+        shm->total_bytes = sizeof(metrics_shm_t);
+        shm->magic = METRICS_SHM_MAGIC;
+    }
+    return shm;
+}
+
+// Tenta tomar o slot: livre, ou de um processo que não existe mais
+static int claim_slot(metrics_slot_t *slot, int32_t self)
+{
+    int32_t owner = atomic_load_explicit(&slot->owner, memory_order_relaxed);
+    if (owner != 0 && (kill(owner, 0) == 0 || errno != ESRCH)) {
+        return 0;
+    }
+    return atomic_compare_exchange_strong(&slot->owner, &owner, self);
+}
+
+metrics_slot_t *metrics_register(const char *name)
+{
+    pthread_mutex_lock(&process_lock);
+    if (process_shm == NULL) {
+        process_shm = map_segment();
+    }
+    metrics_shm_t *shm = process_shm;
+    pthread_mutex_unlock(&process_lock);
+    if (shm == NULL) {
+        return NULL;
+    }
+
+    int32_t self = (int32_t) getpid();
+    for (uint32_t i = 0; i < METRICS_MAX_SLOTS; i++) {
+        metrics_slot_t *slot = &shm->slots[i];
+        if (!claim_slot(slot, self)) {
+            continue;
+        }
+
+        atomic_store_explicit(&slot->ready, 0, memory_order_relaxed);
+        snprintf(slot->name, sizeof(slot->name), "%s", name);
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            atomic_store_explicit(&slot->values[m], 0, memory_order_relaxed);
+        }
+        slot->started_ns = monotonic_ns();
+        atomic_store_explicit(&slot->last_seen_ns, slot->started_ns,
+                              memory_order_relaxed);
+        atomic_store_explicit(&slot->ready, 1, memory_order_release);
+        return slot;
+    }
+
+    fprintf(stderr, "Aviso: sem slot de métricas livre para %s\n", name);
+    return NULL;
+}
+
+void metrics_unregister(metrics_slot_t *slot)
+{
+    if (slot != NULL) {
+        atomic_store_explicit(&slot->ready, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->owner, 0, memory_order_release);
+    }
+}
+
+const metrics_shm_t *metrics_shm_open_readonly(void)
+{
+    int fd = shm_open(METRICS_SHM_NAME, O_RDONLY, 0);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t) sizeof(metrics_shm_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    metrics_shm_t *shm = (metrics_shm_t *) mmap(
+        NULL, sizeof(metrics_shm_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (shm->magic != METRICS_SHM_MAGIC) {
+        munmap(shm, sizeof(metrics_shm_t));
+        return NULL;
+    }
+    return shm;
+}
+
+void metrics_shm_close(const metrics_shm_t *shm)
+{
+    if (shm != NULL) {
+        munmap((void *) shm, sizeof(metrics_shm_t));
+    }
+}
+
+const char *metrics_name(metric_id_t id)
+{
+    static const char *const names[METRIC_COUNT] = {
+        [METRIC_SAMPLES_SENT] = "enviadas",
+        [METRIC_SAMPLES_RECEIVED] = "recebidas",
+        [METRIC_SAMPLES_DROPPED] = "descartadas",
+        [METRIC_RING_FULL] = "ring_cheio",
+        [METRIC_MQ_SENT] = "mq_env",
+        [METRIC_MQ_DROPPED] = "mq_eagain",
+        [METRIC_MQ_RECEIVED] = "mq_rec",
+        [METRIC_QUEUE_DEPTH] = "fila",
+        [METRIC_ALARMS] = "alarmes",
+        [METRIC_COMMANDS] = "comandos",
+        [METRIC_CHILDREN_STARTED] = "filhos",
+        [METRIC_CHILD_EXITS] = "saidas",
+        [METRIC_RESTARTS] = "reinicios",
+        [METRIC_STARTUP_US] = "partida_us",
+        [METRIC_DROPPED_NEWEST] = "desc_novas",
+        [METRIC_DROPPED_OLDEST] = "desc_antigas",
+        [METRIC_DROPPED_COALESCED] = "coalescidas",
+        [METRIC_DROPPED_SAMPLED] = "desc_amostr",
+        [METRIC_OVERLOAD_EVENTS] = "sobrecarga",
+        [METRIC_RULE_ALARMS] = "disparos",
+        [METRIC_PERSISTED] = "persistidas",
+        [METRIC_PERSIST_DROPPED] = "desc_persist",
+        [METRIC_BACKLOG] = "fila_local",
+        [METRIC_NET_LOST] = "perdas_rede",
+    };
+    return (unsigned) id < METRIC_COUNT ? names[id] : "?";
+}
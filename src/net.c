@@ -0,0 +1,662 @@
+#include "net.h"
+#include "gorilla.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+// Maior quadro possível (pior caso da compactação)
+#define NET_FRAME_MAX_BYTES                                                    \
+    (sizeof(net_frame_t) +                                                     \
+     GORILLA_MAX_BYTES(NET_FRAME_MAX_SAMPLES, GORILLA_SAMPLE_MAX_BITS))
+// Buffer de uma conexão TCP (recepção) e de um envio em fluxo
+#define NET_STREAM_BUFFER (64 * 1024)
+// Emissores acompanhados (sequência); potência de 2
+#define NET_MAX_PEERS 4096
+#define NET_PEER_PROBE 16
+// Prazo de uma tentativa de conexão TCP
+#define NET_CONNECT_ATTEMPT_MS 100
+#define NET_MAX_EVENTS 64
+
+// Marcas dos descritores no epoll; conexões a partir de TAG_CONN
+#define TAG_UDP 0
+#define TAG_LISTEN 1
+#define TAG_WAKE 2
+#define TAG_CONN 3
+
+int net_addr_parse(const char *spec, struct sockaddr_in *addr)
+{
+    char host[256];
+    snprintf(host, sizeof(host), "%s", spec);
+    char *colon = strrchr(host, ':');
+    if (colon == NULL) {
+        return -1;
+    }
+    *colon = '\0';
+    char *end;
+    unsigned long port = strtoul(colon + 1, &end, 10);
+    if (end == colon + 1 || *end != '\0' || port == 0 || port > 65535) {
+        return -1;
+    }
+
+    struct addrinfo hints = {.ai_family = AF_INET};
+    struct addrinfo *res;
+    if (getaddrinfo(host[0] != '\0' ? host : "0.0.0.0", NULL, &hints,
+                    &res) != 0) {
+        return -1;
+    }
+    memcpy(addr, res->ai_addr, sizeof(*addr));
+    freeaddrinfo(res);
+    addr->sin_port = htons((uint16_t) port);
+    return 0;
+}
+
+const char *net_addr_default(void)
+{
+    const char *env = getenv(NET_ADDR_ENV);
+    return env != NULL && env[0] != '\0' ? env : NET_DEFAULT_ADDR;
+}
+
+// ---------------------------------------------------------------------------
+// Emissor
+
+// Identificador do emissor: processos de nós diferentes não combinam nada
+// entre si, então mistura relógio, pid e endereço de pilha
+static uint32_t sender_id(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t x = (uint64_t) ts.tv_nsec ^ ((uint64_t) ts.tv_sec << 30) ^
+                 ((uint64_t) getpid() << 17) ^ (uint64_t) (uintptr_t) &ts;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return (uint32_t) x;
+}
+
+// Uma tentativa de conexão, com prazo curto para não travar o envio
+static int sender_connect(net_sender_t *sender)
+{
+    int fd = socket(AF_INET,
+                    (sender->stream ? SOCK_STREAM : SOCK_DGRAM) | SOCK_CLOEXEC,
+                    0);
+    if (fd == -1) {
+        return -1;
+    }
+    if (!sender->stream) {
+        // UDP: connect só fixa o destino (e traz de volta ECONNREFUSED)
+        if (connect(fd, (struct sockaddr *) &sender->addr,
+                    sizeof(sender->addr)) == -1) {
+            close(fd);
+            return -1;
+        }
+        sender->fd = fd;
+        return 0;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    if (connect(fd, (struct sockaddr *) &sender->addr,
+                sizeof(sender->addr)) == -1) {
+        int err = errno;
+        if (err == EINPROGRESS) {
+            struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+            socklen_t len = sizeof(err);
+            if (poll(&pfd, 1, NET_CONNECT_ATTEMPT_MS) != 1) {
+                err = ETIMEDOUT;
+            } else if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) ==
+                       -1) {
+                err = errno;
+            }
+        }
+        if (err != 0) {
+            close(fd);
+            errno = err;
+            return -1;
+        }
+    }
+    fcntl(fd, F_SETFL, flags);
+    sender->fd = fd;
+    return 0;
+}
+
+int net_sender_open(net_sender_t *sender, const char *addr, int stream,
+                    long timeout_ms)
+{
+    memset(sender, 0, sizeof(*sender));
+    sender->fd = -1;
+    sender->stream = stream;
+    sender->sender = sender_id();
+    if (net_addr_parse(addr, &sender->addr) == -1) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint64_t deadline = monotonic_ns() + (uint64_t) timeout_ms * 1000000ull;
+    while (sender_connect(sender) == -1) {
+        if (monotonic_ns() >= deadline) {
+            return -1;
+        }
+        if (errno == ECONNREFUSED) {
+            msleep(NET_CONNECT_ATTEMPT_MS / 2); // Ainda sem escuta
+        }
+    }
+    return 0;
+}
+
+void net_sender_close(net_sender_t *sender)
+{
+    if (sender->fd != -1) {
+        close(sender->fd);
+        sender->fd = -1;
+    }
+}
+
+// Cabeçalho + o maior prefixo de items que cabe em cap; retorna os bytes do
+// quadro e em *count as amostras
+static size_t encode_frame(net_sender_t *sender, const sensor_data_t *items,
+                           uint32_t n, uint8_t *buf, size_t cap,
+                           uint32_t *count)
+{
+    uint32_t k = n < NET_FRAME_MAX_SAMPLES ? n : NET_FRAME_MAX_SAMPLES;
+    size_t payload = gorilla_encode_samples_prefix(
+        items, k, buf + sizeof(net_frame_t), cap - sizeof(net_frame_t),
+        count);
+    net_frame_t frame = {
+        .magic = htonl(NET_FRAME_MAGIC),
+        .sender = htonl(sender->sender),
+        .seq = htonl(sender->seq++),
+        .count = htons((uint16_t) *count),
+        .bytes = htons((uint16_t) payload),
+    };
+    memcpy(buf, &frame, sizeof(frame));
+    return sizeof(frame) + payload;
+}
+
+// Até NET_SEND_BATCH datagramas por sendmmsg. Um datagrama recusado (sem
+// receptor, ECONNREFUSED) ou sem buffer no kernel se perde; o quadro já
+// numerado aparece como lacuna no receptor.
+static uint32_t send_datagrams(net_sender_t *sender, const sensor_data_t *items,
+                               uint32_t n)
+{
+    uint8_t bufs[NET_SEND_BATCH][NET_DATAGRAM_BYTES];
+    struct iovec iov[NET_SEND_BATCH];
+    struct mmsghdr msgs[NET_SEND_BATCH];
+    uint32_t counts[NET_SEND_BATCH];
+    uint32_t done = 0;
+    uint32_t sent = 0;
+
+    while (done < n) {
+        uint32_t batch = 0;
+        while (batch < NET_SEND_BATCH && done < n) {
+            size_t len = encode_frame(sender, items + done, n - done,
+                                      bufs[batch], NET_DATAGRAM_BYTES,
+                                      &counts[batch]);
+            iov[batch] = (struct iovec){.iov_base = bufs[batch],
+                                        .iov_len = len};
+            msgs[batch] = (struct mmsghdr){
+                .msg_hdr = {.msg_iov = &iov[batch], .msg_iovlen = 1}};
+            done += counts[batch];
+            batch++;
+        }
+
+        // sendmmsg para no primeiro erro: pula o datagrama e continua
+        uint32_t k = 0;
+        while (k < batch) {
+            int r = sendmmsg(sender->fd, msgs + k, batch - k, 0);
+            if (r == -1) {
+                if (errno != EINTR) {
+                    k++;
+                }
+                continue;
+            }
+            for (uint32_t i = k; i < k + (uint32_t) r; i++) {
+                sent += counts[i];
+            }
+            k += (uint32_t) r;
+        }
+    }
+    return sent;
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = send(fd, buf, len, MSG_NOSIGNAL);
+        if (w == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += w;
+        len -= (size_t) w;
+    }
+    return 0;
+}
+
+// Quadros acumulados em blocos de até NET_STREAM_BUFFER por send(). Com a
+// conexão perdida o resto do lote se perde e a reconexão fica para depois.
+static uint32_t send_stream(net_sender_t *sender, const sensor_data_t *items,
+                            uint32_t n)
+{
+    uint8_t buf[NET_STREAM_BUFFER];
+    uint32_t done = 0;
+    while (done < n) {
+        size_t fill = 0;
+        uint32_t chunk = 0;
+        while (done + chunk < n && sizeof(buf) - fill >= NET_FRAME_MAX_BYTES) {
+            uint32_t count;
+            fill += encode_frame(sender, items + done + chunk,
+                                 n - done - chunk, buf + fill,
+                                 NET_FRAME_MAX_BYTES, &count);
+            chunk += count;
+        }
+        if (write_all(sender->fd, buf, fill) == -1) {
+            net_sender_close(sender);
+            sender->reconnect_ns =
+                monotonic_ns() + NET_RECONNECT_MS * 1000000ull;
+            break;
+        }
+        done += chunk;
+    }
+    return done;
+}
+
+uint32_t net_sender_send(net_sender_t *sender, const sensor_data_t *items,
+                         uint32_t n)
+{
+    if (sender->fd == -1) {
+        uint64_t now = monotonic_ns();
+        if (now < sender->reconnect_ns) {
+            return 0;
+        }
+        sender->reconnect_ns = now + NET_RECONNECT_MS * 1000000ull;
+        if (sender_connect(sender) == -1) {
+            return 0;
+        }
+    }
+    return sender->stream ? send_stream(sender, items, n)
+                          : send_datagrams(sender, items, n);
+}
+
+// ---------------------------------------------------------------------------
+// Receptor
+
+typedef struct {
+    int fd; // -1 = livre
+    int backlog; // Quadros completos no buffer esperando espaço em out
+    size_t fill;
+    uint8_t *buf; // NET_STREAM_BUFFER, alocado na primeira conexão do slot
+} net_conn_t;
+
+// Próxima sequência esperada de um emissor
+typedef struct {
+    uint32_t sender;
+    uint32_t next;
+    int used;
+} net_peer_t;
+
+struct net_receiver {
+    int epoll_fd;
+    int udp_fd;
+    int listen_fd;
+    int wake_fd; // eventfd de net_receiver_wake
+    uint32_t backlogged; // Conexões com backlog
+    net_stats_t stats;
+    net_conn_t conns[NET_MAX_CONNECTIONS];
+    net_peer_t peers[NET_MAX_PEERS];
+    struct iovec iov[NET_RECV_BATCH];
+    struct mmsghdr msgs[NET_RECV_BATCH];
+    uint8_t datagrams[NET_RECV_BATCH][NET_DATAGRAM_BYTES];
+};
+
+// Lacuna na sequência = quadros perdidos; sequência que volta = atrasado ou
+// repetido. O primeiro quadro de um emissor só fixa a referência (o
+// receptor pode ter partido no meio do fluxo).
+static void track_sequence(net_receiver_t *rx, uint32_t sender, uint32_t seq)
+{
+    uint32_t home = (sender * 2654435761u) & (NET_MAX_PEERS - 1);
+    net_peer_t *peer = NULL;
+    for (uint32_t p = 0; p < NET_PEER_PROBE; p++) {
+        net_peer_t *e = &rx->peers[(home + p) & (NET_MAX_PEERS - 1)];
+        if (!e->used || e->sender == sender) {
+            peer = e;
+            break;
+        }
+    }
+    if (peer == NULL) {
+        peer = &rx->peers[home]; // Vizinhança cheia: substitui
+        peer->used = 0;
+    }
+    if (!peer->used) {
+        *peer = (net_peer_t){.sender = sender, .next = seq + 1, .used = 1};
+        rx->stats.senders++;
+        return;
+    }
+    int32_t ahead = (int32_t) (seq - peer->next);
+    if (ahead >= 0) {
+        rx->stats.lost += (uint64_t) ahead;
+        peer->next = seq + 1;
+    } else {
+        rx->stats.late++;
+    }
+}
+
+// Cabeçalho em ordem do host; tamanho do quadro, 0 se ainda incompleto ou
+// -1 se inválido
+static long frame_parse(const uint8_t *buf, size_t len, net_frame_t *frame)
+{
+    if (len < sizeof(*frame)) {
+        return 0;
+    }
+    memcpy(frame, buf, sizeof(*frame));
+    frame->magic = ntohl(frame->magic);
+    frame->sender = ntohl(frame->sender);
+    frame->seq = ntohl(frame->seq);
+    frame->count = ntohs(frame->count);
+    frame->bytes = ntohs(frame->bytes);
+    if (frame->magic != NET_FRAME_MAGIC || frame->count == 0 ||
+        frame->count > NET_FRAME_MAX_SAMPLES ||
+        frame->bytes >
+            GORILLA_MAX_BYTES(frame->count, GORILLA_SAMPLE_MAX_BITS)) {
+        return -1;
+    }
+    size_t total = sizeof(*frame) + frame->bytes;
+    return len < total ? 0 : (long) total;
+}
+
+static uint32_t frame_decode(net_receiver_t *rx, const net_frame_t *frame,
+                             const uint8_t *payload, sensor_data_t *out)
+{
+    if (gorilla_decode_samples(payload, frame->bytes, frame->count, out) ==
+        -1) {
+        rx->stats.invalid++;
+        return 0;
+    }
+    track_sequence(rx, frame->sender, frame->seq);
+    rx->stats.frames++;
+    rx->stats.samples += frame->count;
+    return frame->count;
+}
+
+// recvmmsg até esvaziar o socket ou faltar espaço em out
+static uint32_t receive_datagrams(net_receiver_t *rx, sensor_data_t *out,
+                                  uint32_t room)
+{
+    uint32_t n = 0;
+    while (room - n >= NET_FRAME_MAX_SAMPLES) {
+        uint32_t batch = (room - n) / NET_FRAME_MAX_SAMPLES;
+        batch = batch < NET_RECV_BATCH ? batch : NET_RECV_BATCH;
+        int got = recvmmsg(rx->udp_fd, rx->msgs, batch, MSG_DONTWAIT, NULL);
+        if (got <= 0) {
+            break; // EAGAIN: vazio
+        }
+        rx->stats.datagrams += (uint64_t) got;
+        for (int i = 0; i < got; i++) {
+            size_t len = rx->msgs[i].msg_len;
+            rx->stats.bytes += len;
+            net_frame_t frame;
+            if ((rx->msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ||
+                frame_parse(rx->datagrams[i], len, &frame) != (long) len) {
+                rx->stats.invalid++;
+                continue;
+            }
+            n += frame_decode(rx, &frame,
+                              rx->datagrams[i] + sizeof(net_frame_t),
+                              out + n);
+        }
+        if ((uint32_t) got < batch) {
+            break;
+        }
+    }
+    return n;
+}
+
+static void close_connection(net_receiver_t *rx, net_conn_t *conn)
+{
+    epoll_ctl(rx->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    conn->fd = -1;
+    conn->fill = 0;
+    if (conn->backlog) {
+        conn->backlog = 0;
+        rx->backlogged--;
+    }
+}
+
+static void accept_connections(net_receiver_t *rx)
+{
+    for (;;) {
+        int fd = accept4(rx->listen_fd, NULL, NULL,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            return; // EAGAIN: sem mais pendentes
+        }
+        uint32_t slot = 0;
+        while (slot < NET_MAX_CONNECTIONS && rx->conns[slot].fd != -1) {
+            slot++;
+        }
+        net_conn_t *conn = &rx->conns[slot];
+        if (slot == NET_MAX_CONNECTIONS ||
+            (conn->buf == NULL &&
+             (conn->buf = malloc(NET_STREAM_BUFFER)) == NULL)) {
+            close(fd); // Recusada: o emissor reconecta mais tarde
+            continue;
+        }
+        struct epoll_event ev = {.events = EPOLLIN,
+                                 .data.u32 = TAG_CONN + slot};
+        if (epoll_ctl(rx->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->fill = 0;
+        rx->stats.connections++;
+    }
+}
+
+// Decodifica os quadros completos do buffer da conexão enquanto houver
+// espaço em out; o que não couber fica para a próxima chamada (backlog)
+static uint32_t drain_connection(net_receiver_t *rx, net_conn_t *conn,
+                                 sensor_data_t *out, uint32_t room)
+{
+    uint32_t n = 0;
+    size_t pos = 0;
+    int backlog = 0;
+    for (;;) {
+        net_frame_t frame;
+        long total = frame_parse(conn->buf + pos, conn->fill - pos, &frame);
+        if (total == -1) {
+            // Sem como ressincronizar o fluxo: encerra a conexão
+            rx->stats.invalid++;
+            close_connection(rx, conn);
+            return n;
+        }
+        if (total == 0) {
+            break;
+        }
+        if (frame.count > room - n) {
+            backlog = 1;
+            break;
+        }
+        n += frame_decode(rx, &frame, conn->buf + pos + sizeof(frame),
+                          out + n);
+        pos += (size_t) total;
+    }
+    if (pos > 0) {
+        memmove(conn->buf, conn->buf + pos, conn->fill - pos);
+        conn->fill -= pos;
+    }
+    if (backlog != conn->backlog) {
+        conn->backlog = backlog;
+        rx->backlogged += backlog ? 1u : (uint32_t) -1;
+    }
+    return n;
+}
+
+static uint32_t service_connection(net_receiver_t *rx, net_conn_t *conn,
+                                   sensor_data_t *out, uint32_t room)
+{
+    uint32_t n = drain_connection(rx, conn, out, room);
+    if (conn->fd == -1 || conn->backlog) {
+        return n;
+    }
+    ssize_t r = recv(conn->fd, conn->buf + conn->fill,
+                     NET_STREAM_BUFFER - conn->fill, 0);
+    if (r == 0 || (r == -1 && errno != EAGAIN && errno != EINTR)) {
+        close_connection(rx, conn); // Emissor saiu (quadro parcial perdido)
+        return n;
+    }
+    if (r > 0) {
+        conn->fill += (size_t) r;
+        rx->stats.bytes += (uint64_t) r;
+        n += drain_connection(rx, conn, out + n, room - n);
+    }
+    return n;
+}
+
+net_receiver_t *net_receiver_open(const char *addr)
+{
+    struct sockaddr_in sin;
+    if (net_addr_parse(addr, &sin) == -1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    net_receiver_t *rx = calloc(1, sizeof(*rx));
+    if (rx == NULL) {
+        return NULL;
+    }
+    rx->udp_fd = rx->listen_fd = rx->wake_fd = -1;
+    for (uint32_t i = 0; i < NET_MAX_CONNECTIONS; i++) {
+        rx->conns[i].fd = -1;
+    }
+    for (uint32_t i = 0; i < NET_RECV_BATCH; i++) {
+        rx->iov[i] = (struct iovec){.iov_base = rx->datagrams[i],
+                                    .iov_len = NET_DATAGRAM_BYTES};
+        rx->msgs[i].msg_hdr.msg_iov = &rx->iov[i];
+        rx->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    rx->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    rx->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    rx->udp_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    rx->listen_fd =
+        socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (rx->epoll_fd == -1 || rx->wake_fd == -1 || rx->udp_fd == -1 ||
+        rx->listen_fd == -1) {
+        goto fail;
+    }
+
+    // Rajadas de datagramas esperam no kernel enquanto os rings estão
+    // cheios; acima de rmem_max só com privilégio (FORCE)
+    int rcvbuf = NET_RCVBUF_BYTES;
+    if (setsockopt(rx->udp_fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf,
+                   sizeof(rcvbuf)) == -1) {
+        setsockopt(rx->udp_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf,
+                   sizeof(rcvbuf));
+    }
+    int one = 1;
+    setsockopt(rx->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(rx->udp_fd, (struct sockaddr *) &sin, sizeof(sin)) == -1 ||
+        bind(rx->listen_fd, (struct sockaddr *) &sin, sizeof(sin)) == -1 ||
+        listen(rx->listen_fd, SOMAXCONN) == -1) {
+        goto fail;
+    }
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = TAG_UDP};
+    if (epoll_ctl(rx->epoll_fd, EPOLL_CTL_ADD, rx->udp_fd, &ev) == -1) {
+        goto fail;
+    }
+    ev.data.u32 = TAG_LISTEN;
+    if (epoll_ctl(rx->epoll_fd, EPOLL_CTL_ADD, rx->listen_fd, &ev) == -1) {
+        goto fail;
+    }
+    ev.data.u32 = TAG_WAKE;
+    if (epoll_ctl(rx->epoll_fd, EPOLL_CTL_ADD, rx->wake_fd, &ev) == -1) {
+        goto fail;
+    }
+    return rx;
+
+fail:;
+    int err = errno;
+    net_receiver_close(rx);
+    errno = err;
+    return NULL;
+}
+
+int net_receiver_poll(net_receiver_t *rx, sensor_data_t *out, uint32_t max,
+                      int timeout_ms)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; rx->backlogged > 0 && i < NET_MAX_CONNECTIONS; i++) {
+        if (rx->conns[i].backlog) {
+            n += drain_connection(rx, &rx->conns[i], out + n, max - n);
+        }
+    }
+
+    struct epoll_event events[NET_MAX_EVENTS];
+    int ready = epoll_wait(rx->epoll_fd, events, NET_MAX_EVENTS,
+                           n > 0 || rx->backlogged > 0 ? 0 : timeout_ms);
+    if (ready == -1) {
+        return errno == EINTR ? (int) n : -1;
+    }
+    // Nível: o que não for lido agora é sinalizado de novo
+    for (int i = 0; i < ready && max - n >= NET_FRAME_MAX_SAMPLES; i++) {
+        uint32_t tag = events[i].data.u32;
+        if (tag == TAG_UDP) {
+            n += receive_datagrams(rx, out + n, max - n);
+        } else if (tag == TAG_LISTEN) {
+            accept_connections(rx);
+        } else if (tag == TAG_WAKE) {
+            eventfd_t count; // Só zera o contador: quem acordou decide
+            eventfd_read(rx->wake_fd, &count);
+        } else {
+            n += service_connection(rx, &rx->conns[tag - TAG_CONN], out + n,
+                                    max - n);
+        }
+    }
+    return (int) n;
+}
+
+void net_receiver_wake(net_receiver_t *rx)
+{
+    eventfd_write(rx->wake_fd, 1);
+}
+
+void net_receiver_stats(const net_receiver_t *rx, net_stats_t *stats)
+{
+    *stats = rx->stats;
+}
+
+void net_receiver_close(net_receiver_t *rx)
+{
+    if (rx == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < NET_MAX_CONNECTIONS; i++) {
+        if (rx->conns[i].fd != -1) {
+            close(rx->conns[i].fd);
+        }
+        free(rx->conns[i].buf);
+    }
+    if (rx->udp_fd != -1) {
+        close(rx->udp_fd);
+    }
+    if (rx->listen_fd != -1) {
+        close(rx->listen_fd);
+    }
+    if (rx->wake_fd != -1) {
+        close(rx->wake_fd);
+    }
+    if (rx->epoll_fd != -1) {
+        close(rx->epoll_fd);
+    }
+    free(rx);
+}
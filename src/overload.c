@@ -0,0 +1,228 @@
+#include "overload.h"
+
+#include <math.h>
+
+#define COALESCE_MIN_CAPACITY 8
+
+static const char *const policy_names[OVERLOAD_POLICY_COUNT] = {
+    [OVERLOAD_BLOCK] = "block",
+    [OVERLOAD_DROP_NEWEST] = "drop-newest",
+    [OVERLOAD_DROP_OLDEST] = "drop-oldest",
+    [OVERLOAD_COALESCE] = "coalesce",
+    [OVERLOAD_SAMPLE] = "sample",
+};
+
+int overload_parse(const char *spec, overload_config_t *config)
+{
+    const char *colon = strchr(spec, ':');
+    size_t name_len = colon != NULL ? (size_t) (colon - spec) : strlen(spec);
+
+    for (int p = 0; p < OVERLOAD_POLICY_COUNT; p++) {
+        if (strlen(policy_names[p]) != name_len ||
+            strncmp(spec, policy_names[p], name_len) != 0) {
+            continue;
+        }
+
+        double prob = 0.1;
+        if (colon != NULL) {
+            char *end;
+            prob = strtod(colon + 1, &end);
+            if (p != OVERLOAD_SAMPLE || *end != '\0' || !(prob > 0.0) ||
+                prob > 1.0) {
+                return -1;
+            }
+        }
+        config->policy = (uint32_t) p;
+        config->sample_prob = (uint32_t) lround(prob * 65536.0);
+        return 0;
+    }
+    return -1;
+}
+
+void overload_config_default(overload_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->policy = OVERLOAD_BLOCK;
+    config->sample_prob = 65536 / 10;
+
+    const char *env = getenv("SENSOR_OVERLOAD");
+    if (env != NULL && overload_parse(env, config) == -1) {
+        fprintf(stderr, "SENSOR_OVERLOAD inválido: %s (usando block)\n", env);
+        config->policy = OVERLOAD_BLOCK;
+    }
+}
+
+void overload_set_marks(overload_config_t *config, uint32_t capacity)
+{
+    config->high_mark = capacity * OVERLOAD_HIGH_PCT / 100;
+    config->low_mark = capacity * OVERLOAD_LOW_PCT / 100;
+    if (config->high_mark == 0) {
+        config->high_mark = 1;
+    }
+}
+
+const char *overload_policy_name(overload_policy_t policy)
+{
+    return (unsigned) policy < OVERLOAD_POLICY_COUNT ? policy_names[policy]
+                                                     : "?";
+}
+
+const char *overload_drop_name(overload_drop_t reason)
+{
+    static const char *const names[OVERLOAD_DROP_COUNT] = {
+        [OVERLOAD_DROPPED_NEWEST] = "novas",
+        [OVERLOAD_DROPPED_OLDEST] = "antigas",
+        [OVERLOAD_DROPPED_COALESCED] = "coalescidas",
+        [OVERLOAD_DROPPED_SAMPLED] = "amostragem",
+    };
+    return (unsigned) reason < OVERLOAD_DROP_COUNT ? names[reason] : "?";
+}
+
+void overload_format(const overload_config_t *config, char *buf, size_t len)
+{
+    if (config->policy == OVERLOAD_SAMPLE) {
+        snprintf(buf, len, "sample:%.3g",
+                 (double) config->sample_prob / 65536.0);
+    } else {
+        snprintf(buf, len, "%s",
+                 overload_policy_name((overload_policy_t) config->policy));
+    }
+}
+
+static uint32_t coalesce_hash(int sensor_id, uint32_t mask)
+{
+    return ((uint32_t) sensor_id * 2654435761u) & mask;
+}
+
+// Realoca com a capacidade dada e reinsere as amostras retidas (descarta
+// as marcas de remoção)
+static int coalesce_resize(coalesce_table_t *table, uint32_t capacity)
+{
+    sensor_data_t *items = malloc((size_t) capacity * sizeof(*items));
+    uint8_t *state = calloc(capacity, 1);
+    if (items == NULL || state == NULL) {
+        free(items);
+        free(state);
+        return -1;
+    }
+
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        if (table->state[i] != 1) {
+            continue;
+        }
+        uint32_t h = coalesce_hash(table->items[i].sensor_id, mask);
+        while (state[h] != 0) {
+            h = (h + 1) & mask;
+        }
+        items[h] = table->items[i];
+        state[h] = 1;
+    }
+
+    free(table->items);
+    free(table->state);
+    table->items = items;
+    table->state = state;
+    table->capacity = capacity;
+    table->tombstones = 0;
+    return 0;
+}
+
+int coalesce_replace(coalesce_table_t *table, const sensor_data_t *data)
+{
+    if (table->count == 0) {
+        return 0;
+    }
+    uint32_t mask = table->capacity - 1;
+    for (uint32_t h = coalesce_hash(data->sensor_id, mask);
+         table->state[h] != 0; h = (h + 1) & mask) {
+        if (table->state[h] == 1 &&
+            table->items[h].sensor_id == data->sensor_id) {
+            table->items[h] = *data;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int coalesce_put(coalesce_table_t *table, const sensor_data_t *data)
+{
+    // Manter ocupados + removidos abaixo de 1/2 para sondagens curtas
+    if ((table->count + table->tombstones + 1) * 2 > table->capacity) {
+        uint32_t capacity = table->capacity < COALESCE_MIN_CAPACITY
+                                ? COALESCE_MIN_CAPACITY
+                                : table->capacity;
+        while ((table->count + 1) * 2 > capacity) {
+            capacity <<= 1;
+        }
+        if (coalesce_resize(table, capacity) == -1) {
+            return -1;
+        }
+    }
+
+    uint32_t mask = table->capacity - 1;
+    uint32_t h = coalesce_hash(data->sensor_id, mask);
+    int64_t reuse = -1;
+    while (table->state[h] != 0) {
+        if (table->state[h] == 1 &&
+            table->items[h].sensor_id == data->sensor_id) {
+            table->items[h] = *data;
+            return 1;
+        }
+        if (table->state[h] == 2 && reuse < 0) {
+            reuse = h;
+        }
+        h = (h + 1) & mask;
+    }
+
+    if (reuse >= 0) {
+        h = (uint32_t) reuse;
+        table->tombstones--;
+    }
+    table->items[h] = *data;
+    table->state[h] = 1;
+    table->count++;
+    return 0;
+}
+
+uint32_t coalesce_drain(coalesce_table_t *table, coalesce_publish_fn publish,
+                        void *ctx)
+{
+    uint32_t published = 0;
+    for (uint32_t i = 0; i < table->capacity && table->count > 0; i++) {
+        if (table->state[i] != 1) {
+            continue;
+        }
+        if (!publish(&table->items[i], ctx)) {
+            break;
+        }
+        table->state[i] = 2;
+        table->count--;
+        table->tombstones++;
+        published++;
+    }
+
+    if (table->count == 0 && table->tombstones > 0) {
+        memset(table->state, 0, table->capacity);
+        table->tombstones = 0;
+    }
+    return published;
+}
+
+void coalesce_free(coalesce_table_t *table)
+{
+    free(table->items);
+    free(table->state);
+    memset(table, 0, sizeof(*table));
+}
+
+void overload_state_init(overload_state_t *state, uint32_t seed)
+{
+    memset(state, 0, sizeof(*state));
+    state->rng = seed != 0 ? seed : 0x9e3779b9u;
+}
+
+void overload_state_free(overload_state_t *state)
+{
+    coalesce_free(&state->pending);
+}
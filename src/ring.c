@@ -0,0 +1,396 @@
+#include "common.h"
+#include "ring.h"
+
+#include <limits.h>
+
+// Tentativas de espera ativa antes de recorrer ao futex
+#define RING_SPIN_LIMIT 128
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+uint32_t ring_round_capacity(uint32_t n)
+{
+    uint32_t capacity = 2;
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+size_t ring_bytes(uint32_t capacity)
+{
+    return sizeof(sample_ring_t) + (size_t) capacity * sizeof(ring_slot_t);
+}
+
+void ring_init(sample_ring_t *ring, uint32_t capacity)
+{
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->not_empty, 0);
+    atomic_init(&ring->not_full, 0);
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_init(&ring->slots[i].seq, i);
+    }
+}
+
+// Acorda quem dorme no futex. Só paga a syscall quem desligar
+// RING_SLEEPERS; como o bit vale para todos os que dormem, acorda todos.
+// Eventos seguintes, antes de alguém voltar a dormir, não fazem syscall.
+static void ring_signal(_Atomic uint32_t *word)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    uint32_t value = atomic_load_explicit(word, memory_order_relaxed);
+    while (value & RING_SLEEPERS) {
+        if (atomic_compare_exchange_weak_explicit(
+                word, &value, (value + RING_EVENT) & ~RING_SLEEPERS,
+                memory_order_release, memory_order_relaxed)) {
+            futex_wake(word, INT_MAX);
+            return;
+        }
+    }
+}
+
+uint32_t ring_try_push_batch(sample_ring_t *ring, const sensor_data_t *items,
+                             uint32_t n)
+{
+    if (n > ring->capacity) {
+        n = ring->capacity;
+    }
+
+    uint64_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    for (;;) {
+        // Contar quantos slots consecutivos a partir de pos estão livres
+        uint32_t avail = 0;
+        while (avail < n) {
+            ring_slot_t *slot = &ring->slots[(pos + avail) & ring->mask];
+            uint64_t seq =
+                atomic_load_explicit(&slot->seq, memory_order_acquire);
+            if (seq != pos + avail) {
+                break;
+            }
+            avail++;
+        }
+
+        if (avail == 0) {
+            ring_slot_t *slot = &ring->slots[pos & ring->mask];
+            uint64_t seq =
+                atomic_load_explicit(&slot->seq, memory_order_acquire) &
+                ~RING_SEQ_WRITING;
+            if ((int64_t) seq - (int64_t) pos < 0) {
+                return 0; // Cheio
+            }
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+            continue;
+        }
+
+        // Reservar o lote inteiro de uma vez
+        if (atomic_compare_exchange_weak_explicit(&ring->head, &pos,
+                                                  pos + avail,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            // Confirmar a posse de cada slot antes de escrever. Depois da
+            // primeira reserva tomada por ring_recover, os slots seguintes
+            // ainda nossos saem vazios para as amostras não trocarem de
+            // ordem; as que faltaram são repetidas pelo chamador.
+            uint32_t written = 0;
+            int lost = 0;
+            for (uint32_t i = 0; i < avail; i++) {
+                ring_slot_t *slot = &ring->slots[(pos + i) & ring->mask];
+                uint64_t expected = pos + i;
+                if (!atomic_compare_exchange_strong_explicit(
+                        &slot->seq, &expected, (pos + i) | RING_SEQ_WRITING,
+                        memory_order_acquire, memory_order_relaxed)) {
+                    lost = 1;
+                    continue;
+                }
+                if (lost) {
+                    slot->data =
+                        (sensor_data_t){.sensor_id = RING_SLOT_ABANDONED};
+                } else {
+                    slot->data = items[written++];
+                }
+                atomic_store_explicit(&slot->seq, pos + i + 1,
+                                      memory_order_release);
+            }
+            ring_signal(&ring->not_empty);
+            if (written > 0) {
+                return written;
+            }
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+}
+
+uint32_t ring_try_pop_batch(sample_ring_t *ring, sensor_data_t *out,
+                            uint32_t max)
+{
+    if (max > ring->capacity) {
+        max = ring->capacity;
+    }
+
+    uint64_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    for (;;) {
+        // Contar quantos slots consecutivos a partir de pos estão publicados
+        uint32_t avail = 0;
+        while (avail < max) {
+            ring_slot_t *slot = &ring->slots[(pos + avail) & ring->mask];
+            uint64_t seq =
+                atomic_load_explicit(&slot->seq, memory_order_acquire);
+            if (seq != pos + avail + 1) {
+                break;
+            }
+            avail++;
+        }
+
+        if (avail == 0) {
+            ring_slot_t *slot = &ring->slots[pos & ring->mask];
+            uint64_t seq =
+                atomic_load_explicit(&slot->seq, memory_order_acquire) &
+                ~RING_SEQ_WRITING;
+            if ((int64_t) seq - (int64_t) (pos + 1) < 0) {
+                return 0; // Vazio (ou o próximo ainda não foi publicado)
+            }
+            pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            continue;
+        }
+
+        // Retirar o lote inteiro com um único avanço de tail
+        if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos,
+                                                  pos + avail,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            uint32_t n = 0;
+            for (uint32_t i = 0; i < avail; i++) {
+                ring_slot_t *slot = &ring->slots[(pos + i) & ring->mask];
+                out[n] = slot->data;
+                // Libera o slot para a próxima volta do produtor
+                atomic_store_explicit(&slot->seq, pos + i + ring->mask + 1,
+                                      memory_order_release);
+                // Reserva de um produtor morto (ring_recover): pular
+                n += out[n].sensor_id != RING_SLOT_ABANDONED;
+            }
+            ring_signal(&ring->not_full);
+            if (n > 0) {
+                return n;
+            }
+            pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        }
+    }
+}
+
+int ring_try_push(sample_ring_t *ring, const sensor_data_t *data)
+{
+    return (int) ring_try_push_batch(ring, data, 1);
+}
+
+int ring_try_pop(sample_ring_t *ring, sensor_data_t *out)
+{
+    return (int) ring_try_pop_batch(ring, out, 1);
+}
+
+// Espera ativa só compensa com outra CPU para o lado oposto avançar; com
+// uma só, girar apenas adia a troca de contexto
+static int spin_limit(void)
+{
+    static _Atomic int limit = -1;
+    int value = atomic_load_explicit(&limit, memory_order_relaxed);
+    if (value < 0) {
+        value = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? RING_SPIN_LIMIT : 0;
+        atomic_store_explicit(&limit, value, memory_order_relaxed);
+    }
+    return value;
+}
+
+static inline uint32_t ring_op(sample_ring_t *ring, int is_push,
+                               const sensor_data_t *in, sensor_data_t *out,
+                               uint32_t n)
+{
+    return is_push ? ring_try_push_batch(ring, in, n)
+                   : ring_try_pop_batch(ring, out, n);
+}
+
+// Espera genérica: tenta a operação, gira um pouco (com mais de uma CPU) e
+// só então dorme no futex. Retorna quantos itens moveu (até n), 0 se o
+// tempo esgotou.
+static uint32_t ring_wait_op(sample_ring_t *ring, _Atomic uint32_t *word,
+                             int is_push, const sensor_data_t *in,
+                             sensor_data_t *out, uint32_t n, long timeout_ms)
+{
+    uint32_t done = ring_op(ring, is_push, in, out, n);
+    if (done > 0) {
+        return done;
+    }
+
+    uint64_t deadline = 0;
+    if (timeout_ms >= 0) {
+        deadline = monotonic_ns() + (uint64_t) timeout_ms * 1000000ull;
+    }
+
+    int spins = spin_limit();
+    for (;;) {
+        for (int spin = 0; spin < spins; spin++) {
+            cpu_relax();
+            if ((done = ring_op(ring, is_push, in, out, n)) > 0) {
+                return done;
+            }
+        }
+
+        // Anunciar a espera; o bit fica ligado até o próximo evento
+        uint32_t event =
+            atomic_fetch_or_explicit(word, RING_SLEEPERS,
+                                     memory_order_seq_cst) |
+            RING_SLEEPERS;
+        atomic_thread_fence(memory_order_seq_cst);
+
+        // Revalidar após anunciar a espera para não perder o evento
+        if ((done = ring_op(ring, is_push, in, out, n)) > 0) {
+            return done;
+        }
+        long wait_ms = -1;
+        if (timeout_ms >= 0) {
+            uint64_t now = monotonic_ns();
+            wait_ms = now >= deadline
+                          ? 0
+                          : (long) ((deadline - now + 999999) / 1000000);
+        }
+        if (wait_ms != 0) {
+            futex_wait(word, event, wait_ms);
+        }
+
+        if (timeout_ms >= 0 && monotonic_ns() >= deadline) {
+            // Última tentativa antes de desistir
+            return ring_op(ring, is_push, in, out, n);
+        }
+    }
+}
+
+int ring_push(sample_ring_t *ring, const sensor_data_t *data, long timeout_ms)
+{
+    return ring_wait_op(ring, &ring->not_full, 1, data, NULL, 1,
+                        timeout_ms) > 0
+               ? 0
+               : -1;
+}
+
+int ring_pop(sample_ring_t *ring, sensor_data_t *out, long timeout_ms)
+{
+    return ring_wait_op(ring, &ring->not_empty, 0, NULL, out, 1,
+                        timeout_ms) > 0
+               ? 0
+               : -1;
+}
+
+uint32_t ring_push_batch(sample_ring_t *ring, const sensor_data_t *items,
+                         uint32_t n, long timeout_ms)
+{
+    uint32_t done = 0;
+    while (done < n) {
+        // Cheio: aguarda espaço e publica o quanto couber de uma vez
+        uint32_t pushed =
+            ring_wait_op(ring, &ring->not_full, 1, items + done, NULL,
+                         n - done, timeout_ms);
+        if (pushed == 0) {
+            break;
+        }
+        done += pushed;
+    }
+    return done;
+}
+
+uint32_t ring_pop_batch(sample_ring_t *ring, sensor_data_t *out, uint32_t max,
+                        long timeout_ms)
+{
+    return ring_wait_op(ring, &ring->not_empty, 0, NULL, out, max,
+                        timeout_ms);
+}
+
+uint32_t ring_depth(sample_ring_t *ring)
+{
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    return head > tail ? (uint32_t) (head - tail) : 0;
+}
+
+void ring_wake_all(sample_ring_t *ring)
+{
+    atomic_fetch_add(&ring->not_empty, RING_EVENT);
+    atomic_fetch_add(&ring->not_full, RING_EVENT);
+    futex_wake(&ring->not_empty, INT_MAX);
+    futex_wake(&ring->not_full, INT_MAX);
+}
+
+// Slots em [tail, head) reservados e ainda não publicados (seq == pos)
+static uint32_t count_unpublished(sample_ring_t *ring, uint64_t tail,
+                                  uint64_t head)
+{
+    uint32_t n = 0;
+    for (uint64_t pos = tail; pos < head; pos++) {
+        ring_slot_t *slot = &ring->slots[pos & ring->mask];
+        n += atomic_load_explicit(&slot->seq, memory_order_acquire) == pos;
+    }
+    return n;
+}
+
+int ring_recover(sample_ring_t *ring, uint32_t capacity, long grace_ms)
+{
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (ring->capacity != capacity || ring->mask != capacity - 1 ||
+        head < tail || head - tail > capacity) {
+        return -1;
+    }
+
+    // Posições já passadas por tail na última volta: liberadas têm
+    // seq = pos + capacidade (ou + 1, já reescritas); pos + 1 é um slot
+    // retirado e nunca liberado
+    int freed = 0;
+    uint64_t first = tail > capacity ? tail - capacity : 0;
+    for (uint64_t pos = first; pos < tail; pos++) {
+        ring_slot_t *slot = &ring->slots[pos & ring->mask];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) ==
+            pos + 1) {
+            atomic_store_explicit(&slot->seq, pos + capacity,
+                                  memory_order_release);
+            freed++;
+        }
+    }
+
+    // Reservas de produtores que morreram entre avançar head e confirmar a
+    // posse: o slot fica em seq == pos e o consumidor pararia nele. A
+    // reserva é tomada com o mesmo CAS de confirmação do produtor, então um
+    // produtor vivo e atrasado perde a disputa e não escreve no slot
+    if (grace_ms >= 0 && count_unpublished(ring, tail, head) > 0) {
+        // Só até o head visto antes da espera: reservas mais novas são de
+        // produtores em andamento
+        msleep(grace_ms);
+        for (uint64_t pos = tail; pos < head; pos++) {
+            ring_slot_t *slot = &ring->slots[pos & ring->mask];
+            uint64_t expected = pos;
+            if (atomic_compare_exchange_strong_explicit(
+                    &slot->seq, &expected, pos | RING_SEQ_WRITING,
+                    memory_order_acquire, memory_order_relaxed)) {
+                // Sem consumidores: ninguém lê o slot antes da marca
+                slot->data = (sensor_data_t){.sensor_id = RING_SLOT_ABANDONED};
+                atomic_store_explicit(&slot->seq, pos + 1,
+                                      memory_order_release);
+                freed++;
+            }
+        }
+    }
+    if (freed > 0) {
+        ring_signal(&ring->not_full);
+    }
+    return freed;
+}
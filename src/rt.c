@@ -0,0 +1,291 @@
+#include "rt.h"
+#include "logger.h"
+
+#include <malloc.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+static const char *const role_names[RT_ROLE_COUNT] = {
+    [RT_ROLE_SUPERVISOR] = "supervisor",
+    [RT_ROLE_SENSOR] = "sensor",
+    [RT_ROLE_PRODUCER] = "produtora",
+    [RT_ROLE_CONSUMER] = "consumidora",
+};
+
+static const struct {
+    const char *name;
+    int policy;
+} policies[] = {
+    {"other", SCHED_OTHER},
+    {"fifo", SCHED_FIFO},
+    {"rr", SCHED_RR},
+};
+
+// Avisos de queda para o padrão: uma vez por processo
+static atomic_int sched_warned = 0;
+static atomic_int affinity_warned = 0;
+
+void rt_profile_default(rt_profile_t *profile)
+{
+    memset(profile, 0, sizeof(*profile));
+    profile->lock_memory = 1;
+    static const int priority[RT_ROLE_COUNT] = {
+        [RT_ROLE_SUPERVISOR] = 10,
+        [RT_ROLE_SENSOR] = 40,
+        [RT_ROLE_PRODUCER] = 50,
+        [RT_ROLE_CONSUMER] = 45,
+    };
+    for (int r = 0; r < RT_ROLE_COUNT; r++) {
+        profile->roles[r].policy = SCHED_FIFO;
+        profile->roles[r].priority = priority[r];
+    }
+}
+
+const char *rt_role_name(rt_role_t role)
+{
+    return (unsigned) role < RT_ROLE_COUNT ? role_names[role] : "?";
+}
+
+// "0-3,6" → máscara; -1 se inválido ou fora de 0..63
+static int parse_cpus(const char *list, uint64_t *mask)
+{
+    *mask = 0;
+    const char *p = list;
+    while (*p != '\0') {
+        char *end;
+        unsigned long first = strtoul(p, &end, 10);
+        if (end == p) {
+            return -1;
+        }
+        unsigned long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtoul(p + 1, &end, 10);
+            if (end == p + 1) {
+                return -1;
+            }
+            p = end;
+        }
+        if (last < first || last >= 64) {
+            return -1;
+        }
+        for (unsigned long c = first; c <= last; c++) {
+            *mask |= 1ull << c;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+    return *mask != 0 ? 0 : -1;
+}
+
+int rt_thread_parse(const char *spec, rt_thread_config_t *out)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    rt_thread_config_t config = {.policy = -1};
+    char *at = strchr(buf, '@');
+    if (at != NULL) {
+        *at = '\0';
+        if (parse_cpus(at + 1, &config.cpus) == -1) {
+            return -1;
+        }
+    }
+    char *colon = strchr(buf, ':');
+    if (colon != NULL) {
+        *colon = '\0';
+        char *end;
+        long prio = strtol(colon + 1, &end, 10);
+        if (end == colon + 1 || *end != '\0' || prio < 1 ||
+            prio > RT_PRIORITY_MAX) {
+            return -1;
+        }
+        config.priority = (int) prio;
+    }
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (strcmp(buf, policies[i].name) == 0) {
+            config.policy = policies[i].policy;
+        }
+    }
+    if (config.policy == -1) {
+        return -1;
+    }
+    if (config.policy == SCHED_OTHER) {
+        config.priority = 0;
+    } else if (config.priority == 0) {
+        return -1; // FIFO/RR exigem prioridade
+    }
+    *out = config;
+    return 0;
+}
+
+void rt_thread_format(const rt_thread_config_t *config, char *buf, size_t len)
+{
+    const char *name = "?";
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (policies[i].policy == config->policy) {
+            name = policies[i].name;
+        }
+    }
+    int n = config->policy == SCHED_OTHER
+                ? snprintf(buf, len, "%s", name)
+                : snprintf(buf, len, "%s:%d", name, config->priority);
+    if (config->cpus == 0 || n < 0 || (size_t) n >= len) {
+        return;
+    }
+
+    // Faixas de CPUs de volta ao formato de entrada
+    char sep = '@';
+    for (int c = 0; c < 64; c++) {
+        if (!(config->cpus & (1ull << c))) {
+            continue;
+        }
+        int last = c;
+        while (last + 1 < 64 && (config->cpus & (1ull << (last + 1)))) {
+            last++;
+        }
+        int w = last > c ? snprintf(buf + n, len - (size_t) n, "%c%d-%d", sep,
+                                    c, last)
+                         : snprintf(buf + n, len - (size_t) n, "%c%d", sep, c);
+        if (w < 0 || (size_t) (n + w) >= len) {
+            return;
+        }
+        n += w;
+        sep = ',';
+        c = last;
+    }
+}
+
+// index-ésima CPU da máscara, em rodízio
+static int mask_nth(uint64_t mask, int index)
+{
+    int count = __builtin_popcountll(mask);
+    int n = index % count;
+    for (int c = 0; c < 64; c++) {
+        if ((mask & (1ull << c)) && n-- == 0) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+int rt_apply_thread(const rt_profile_t *profile, rt_role_t role, int index,
+                    const char *component)
+{
+    if (!profile->enabled) {
+        return 0;
+    }
+    const rt_thread_config_t *config = &profile->roles[role];
+    int rc = 0;
+
+    if (config->cpus != 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (index >= 0) {
+            CPU_SET(mask_nth(config->cpus, index), &set);
+        } else {
+            for (int c = 0; c < 64; c++) {
+                if (config->cpus & (1ull << c)) {
+                    CPU_SET(c, &set);
+                }
+            }
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            rc = -1;
+            if (atomic_exchange(&affinity_warned, 1) == 0) {
+                log_event(LOG_WARN, COLOR_YELLOW, component,
+                          "Tempo real: afinidade recusada (%s); seguindo "
+                          "sem fixar CPU",
+                          strerror(err));
+            }
+        }
+    }
+
+    // sched_setscheduler(0) vale para a thread chamadora; RESET_ON_FORK
+    // impede que processos filhos herdem a política
+    struct sched_param param = {.sched_priority = config->priority};
+    if (sched_setscheduler(0, config->policy | SCHED_RESET_ON_FORK, &param) ==
+        -1) {
+        rc = -1;
+        if (atomic_exchange(&sched_warned, 1) == 0) {
+            log_event(LOG_WARN, COLOR_YELLOW, component,
+                      "Tempo real: política %s recusada (%s); seguindo no "
+                      "escalonamento padrão",
+                      rt_role_name(role), strerror(errno));
+        }
+    }
+
+    if (profile->lock_memory) {
+        rt_prefault_stack();
+    }
+
+    char desc[64];
+    rt_thread_format(config, desc, sizeof(desc));
+    log_event(LOG_DEBUG, COLOR_BLUE, component, "Tempo real: %s %s%s",
+              rt_role_name(role), desc, rc == 0 ? "" : " (parcial)");
+    return rc;
+}
+
+int rt_lock_memory(const rt_profile_t *profile, const char *component)
+{
+    if (!profile->enabled || !profile->lock_memory) {
+        return 0;
+    }
+
+    // Memória liberada continua no processo (travada), sem mmap por
+    // alocação: free/malloc não voltam a causar falhas de página
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    // MCL_FUTURE só com limite para isso: sem ele, mapeamentos futuros
+    // falhariam ao passar de RLIMIT_MEMLOCK
+    struct rlimit limit;
+    int unlimited = geteuid() == 0 ||
+                    (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 &&
+                     limit.rlim_cur == RLIM_INFINITY);
+    int flags = unlimited ? MCL_CURRENT | MCL_FUTURE : MCL_CURRENT;
+    if (mlockall(flags) == -1) {
+        log_event(LOG_WARN, COLOR_YELLOW, component,
+                  "Tempo real: mlockall recusado (%s); memória pode sofrer "
+                  "falhas de página e swap",
+                  strerror(errno));
+        return -1;
+    }
+    log_event(LOG_INFO, COLOR_BLUE, component, "Tempo real: memória travada%s",
+              unlimited ? "" : " (só os mapeamentos atuais)");
+    return 0;
+}
+
+void rt_prefault(void *addr, size_t len, int writable)
+{
+    if (addr == NULL || len == 0) {
+        return;
+    }
+#if defined(MADV_POPULATE_WRITE) && defined(MADV_POPULATE_READ)
+    if (madvise(addr, len, writable ? MADV_POPULATE_WRITE
+                                    : MADV_POPULATE_READ) == 0) {
+        return;
+    }
+#endif
+    // Kernel sem MADV_POPULATE_*: uma leitura por página mapeia a página
+    // (sem alterar o conteúdo, que pode estar em uso por outro processo)
+    (void) writable;
+    long page = sysconf(_SC_PAGESIZE);
+    volatile const char *p = addr;
+    for (size_t off = 0; off < len; off += (size_t) page) {
+        (void) p[off];
+    }
+}
+
+__attribute__((noinline)) void rt_prefault_stack(void)
+{
+    volatile char stack[RT_STACK_PREFAULT];
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t off = 0; off < sizeof(stack); off += (size_t) page) {
+        stack[off] = 0;
+    }
+}
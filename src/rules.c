@@ -0,0 +1,433 @@
+#include "rules.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <strings.h>
+
+static const char *const kind_names[RULE_KIND_COUNT] = {
+    [RULE_ABOVE] = "above",
+    [RULE_BELOW] = "below",
+    [RULE_RATE] = "rate",
+    [RULE_STUCK] = "stuck",
+};
+
+const char *rule_kind_name(rule_kind_t kind)
+{
+    return (unsigned) kind < RULE_KIND_COUNT ? kind_names[kind] : "?";
+}
+
+static int parse_float(const char *text, float *out)
+{
+    if (text == NULL) {
+        return -1;
+    }
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || *end != '\0' || !isfinite(value)) {
+        return -1;
+    }
+    *out = (float) value;
+    return 0;
+}
+
+static int parse_scope(const char *text, int8_t *type, int32_t *id)
+{
+    *type = -1;
+    *id = 0;
+    if (strcmp(text, "*") == 0) {
+        return 0;
+    }
+    if (strncmp(text, "id=", 3) == 0) {
+        char *end;
+        long value = strtol(text + 3, &end, 10);
+        if (end == text + 3 || *end != '\0' || value <= 0 ||
+            value > INT32_MAX) {
+            return -1;
+        }
+        *id = (int32_t) value;
+        return 0;
+    }
+    for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+        if (strcasecmp(text, sensor_type_name((sensor_type_t) t)) == 0) {
+            *type = (int8_t) t;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int rules_add(rule_table_t *table, const char *line)
+{
+    if (table->count == RULES_MAX) {
+        return -1;
+    }
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", line);
+    char *save = NULL;
+    char *scope = strtok_r(buf, " \t", &save);
+    char *kind = strtok_r(NULL, " \t", &save);
+    char *param = strtok_r(NULL, " \t", &save);
+    if (scope == NULL || kind == NULL) {
+        return -1;
+    }
+
+    uint32_t r = table->count;
+    int found = -1;
+    for (int k = 0; k < RULE_KIND_COUNT; k++) {
+        if (strcmp(kind, kind_names[k]) == 0) {
+            found = k;
+        }
+    }
+    float threshold;
+    if (found < 0 || parse_scope(scope, &table->scope_type[r],
+                                 &table->scope_id[r]) == -1 ||
+        parse_float(param, &threshold) == -1) {
+        return -1;
+    }
+
+    float hyst = 0.0f;
+    float eps = 0.0f;
+    int n = 1;
+    int m = 1;
+    snprintf(table->name[r], RULES_NAME_LEN, "%s:%s", scope, kind);
+
+    char *opt;
+    while ((opt = strtok_r(NULL, " \t", &save)) != NULL) {
+        if (strcmp(opt, "hyst") == 0) {
+            if (parse_float(strtok_r(NULL, " \t", &save), &hyst) == -1 ||
+                hyst < 0.0f) {
+                return -1;
+            }
+        } else if (strcmp(opt, "eps") == 0) {
+            if (parse_float(strtok_r(NULL, " \t", &save), &eps) == -1 ||
+                eps < 0.0f) {
+                return -1;
+            }
+        } else if (strcmp(opt, "nofm") == 0) {
+            char *ns = strtok_r(NULL, " \t", &save);
+            char *ms = strtok_r(NULL, " \t", &save);
+            n = ns != NULL ? atoi(ns) : 0;
+            m = ms != NULL ? atoi(ms) : 0;
+            if (n < 1 || m < n || m > 32) {
+                return -1;
+            }
+        } else if (strncmp(opt, "name=", 5) == 0 && opt[5] != '\0') {
+            snprintf(table->name[r], RULES_NAME_LEN, "%s", opt + 5);
+        } else {
+            return -1;
+        }
+    }
+
+    table->kind[r] = (uint8_t) found;
+    table->threshold[r] = threshold;
+    table->n[r] = (uint8_t) n;
+    table->m[r] = (uint8_t) m;
+    switch ((rule_kind_t) found) {
+    case RULE_ABOVE:
+        table->release[r] = threshold - hyst;
+        break;
+    case RULE_BELOW:
+        table->release[r] = threshold + hyst;
+        break;
+    case RULE_STUCK:
+        table->release[r] = eps;
+        break;
+    default:
+        table->release[r] = 0.0f;
+        break;
+    }
+
+    // Compilar: regra de sensor específico ou programa de cada tipo
+    if (table->scope_id[r] != 0) {
+        table->id_rules[table->id_count++] = (uint8_t) r;
+    } else {
+        for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+            if (table->scope_type[r] < 0 || table->scope_type[r] == t) {
+                table->type_rules[t][table->type_count[t]++] = (uint8_t) r;
+            }
+        }
+    }
+    table->count++;
+    return 0;
+}
+
+int rules_load(rule_table_t *table, const char *path)
+{
+    memset(table, 0, sizeof(*table));
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    char line[256];
+    int lineno = 0;
+    int rc = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+        char *p = line;
+        while (isspace((unsigned char) *p)) {
+            p++;
+        }
+        size_t len = strlen(p);
+        while (len > 0 && isspace((unsigned char) p[len - 1])) {
+            p[--len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+        if (rules_add(table, p) == -1) {
+            fprintf(stderr, "%s:%d: regra inválida: %s\n", path, lineno, p);
+            rc = -1;
+            break;
+        }
+    }
+    fclose(f);
+    return rc;
+}
+
+void rules_describe(const rule_table_t *table, uint32_t rule, char *buf,
+                    size_t len)
+{
+    char scope[32];
+    if (table->scope_id[rule] != 0) {
+        snprintf(scope, sizeof(scope), "id=%d", table->scope_id[rule]);
+    } else if (table->scope_type[rule] >= 0) {
+        snprintf(scope, sizeof(scope), "%s",
+                 sensor_type_name((sensor_type_t) table->scope_type[rule]));
+    } else {
+        snprintf(scope, sizeof(scope), "*");
+    }
+
+    int n = snprintf(buf, len, "%s %s %g", scope,
+                     rule_kind_name((rule_kind_t) table->kind[rule]),
+                     (double) table->threshold[rule]);
+    if (n > 0 && (size_t) n < len && table->kind[rule] <= RULE_BELOW &&
+        table->release[rule] != table->threshold[rule]) {
+        n += snprintf(buf + n, len - (size_t) n, " hyst %g",
+                      (double) fabsf(table->threshold[rule] -
+                                     table->release[rule]));
+    }
+    if (n > 0 && (size_t) n < len && table->m[rule] > 1) {
+        snprintf(buf + n, len - (size_t) n, " nofm %u %u", table->n[rule],
+                 table->m[rule]);
+    }
+}
+
+int rule_engine_init(rule_engine_t *engine, const rule_table_t *table,
+                     uint32_t max_sensors)
+{
+    memset(engine, 0, sizeof(*engine));
+    engine->table = table;
+    engine->max_sensors = max_sensors;
+    if (table->count == 0) {
+        return 0;
+    }
+    // calloc grande vem do mmap: páginas zeradas sob demanda
+    engine->states = calloc((size_t) max_sensors * table->count,
+                            sizeof(rule_state_t));
+    return engine->states == NULL ? -1 : 0;
+}
+
+void rule_engine_free(rule_engine_t *engine)
+{
+    free(engine->states);
+    engine->states = NULL;
+}
+
+// Comparações de um lote contra um limite: laços sem desvios sobre arrays
+// contíguos, que o compilador vetoriza
+static void compare_above(const float *restrict values, uint32_t n,
+                          float limit, float release, uint8_t *restrict hit,
+                          uint8_t *restrict clear)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        hit[i] = values[i] > limit;
+        clear[i] = values[i] <= release;
+    }
+}
+
+static void compare_below(const float *restrict values, uint32_t n,
+                          float limit, float release, uint8_t *restrict hit,
+                          uint8_t *restrict clear)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        hit[i] = values[i] < limit;
+        clear[i] = values[i] >= release;
+    }
+}
+
+// Condição das regras com estado próprio (rate, stuck); 1 se vale
+static int stateful_condition(const rule_table_t *t, uint32_t r,
+                              rule_state_t *s, const sensor_data_t *d)
+{
+    int cond = 0;
+    if (t->kind[r] == RULE_RATE) {
+        if (s->seen && d->t_created > s->last_ns) {
+            double dt = (double) (d->t_created - s->last_ns) / 1e9;
+            cond = fabs((double) (d->value - s->last_value)) / dt >
+                   (double) t->threshold[r];
+        }
+        s->last_value = d->value;
+        s->last_ns = d->t_created;
+    } else {
+        // stuck: last_value é a referência desde stuck_since
+        if (!s->seen || fabsf(d->value - s->last_value) > t->release[r]) {
+            s->last_value = d->value;
+            s->stuck_since = (int64_t) d->timestamp;
+        } else {
+            cond = (double) ((int64_t) d->timestamp - s->stuck_since) >=
+                   (double) t->threshold[r];
+        }
+    }
+    s->seen = 1;
+    return cond;
+}
+
+// Janela N-de-M e transições; emite o evento ao disparar/voltar
+static void update_state(rule_engine_t *engine, uint32_t r,
+                         const sensor_data_t *d, int cond, int clear_ok,
+                         rule_state_t *s, rule_emit_fn emit, void *ctx)
+{
+    const rule_table_t *t = engine->table;
+    uint32_t m = t->m[r];
+    uint32_t mask = m >= 32 ? 0xffffffffu : (1u << m) - 1;
+    s->window = ((s->window << 1) | (uint32_t) (cond != 0)) & mask;
+    uint32_t hits = (uint32_t) __builtin_popcount(s->window);
+
+    int changed = 0;
+    if (!s->active && hits >= t->n[r]) {
+        s->active = 1;
+        changed = 1;
+    } else if (s->active && clear_ok && hits < t->n[r]) {
+        s->active = 0;
+        changed = 1;
+    }
+
+    if (changed) {
+        rule_event_t event = {.rule = r,
+                              .active = s->active,
+                              .sensor_id = d->sensor_id,
+                              .type = d->type,
+                              .value = d->value,
+                              .t_created = d->t_created};
+        emit(&event, ctx);
+    }
+}
+
+static rule_state_t *state_of(rule_engine_t *engine, int sensor_id,
+                              uint32_t rule)
+{
+    if (sensor_id < 0 || (uint32_t) sensor_id >= engine->max_sensors) {
+        return NULL;
+    }
+    return &engine->states[(size_t) sensor_id * engine->table->count + rule];
+}
+
+void rule_engine_eval(rule_engine_t *engine, const sensor_data_t *batch,
+                      uint32_t n, rule_emit_fn emit, void *ctx)
+{
+    const rule_table_t *t = engine->table;
+    if (t->count == 0 || n == 0) {
+        return;
+    }
+    if (n > RULES_BATCH_MAX) {
+        n = RULES_BATCH_MAX;
+    }
+
+    // Agrupar por tipo mantendo a ordem de chegada (counting sort estável):
+    // values fica contíguo por tipo e order aponta para a amostra no lote
+    uint32_t start[SENSOR_TYPE_COUNT + 1] = {0};
+    for (uint32_t i = 0; i < n; i++) {
+        if ((unsigned) batch[i].type < SENSOR_TYPE_COUNT) {
+            start[batch[i].type + 1]++;
+        }
+    }
+    for (int ty = 0; ty < SENSOR_TYPE_COUNT; ty++) {
+        start[ty + 1] += start[ty];
+    }
+    uint32_t next[SENSOR_TYPE_COUNT];
+    memcpy(next, start, sizeof(next));
+    float values[RULES_BATCH_MAX];
+    uint8_t order[RULES_BATCH_MAX];
+    for (uint32_t i = 0; i < n; i++) {
+        if ((unsigned) batch[i].type < SENSOR_TYPE_COUNT) {
+            uint32_t pos = next[batch[i].type]++;
+            values[pos] = batch[i].value;
+            order[pos] = (uint8_t) i;
+        }
+    }
+
+    uint8_t hit[RULES_BATCH_MAX];
+    uint8_t clear[RULES_BATCH_MAX];
+    for (int ty = 0; ty < SENSOR_TYPE_COUNT; ty++) {
+        uint32_t first = start[ty];
+        uint32_t len = start[ty + 1] - first;
+        if (len == 0) {
+            continue;
+        }
+        for (uint32_t k = 0; k < t->type_count[ty]; k++) {
+            uint32_t r = t->type_rules[ty][k];
+            if (t->kind[r] == RULE_ABOVE) {
+                compare_above(values + first, len, t->threshold[r],
+                              t->release[r], hit, clear);
+            } else if (t->kind[r] == RULE_BELOW) {
+                compare_below(values + first, len, t->threshold[r],
+                              t->release[r], hit, clear);
+            }
+
+            for (uint32_t j = 0; j < len; j++) {
+                const sensor_data_t *d = &batch[order[first + j]];
+                rule_state_t *s = state_of(engine, d->sensor_id, r);
+                if (s == NULL) {
+                    continue;
+                }
+                if (t->kind[r] <= RULE_BELOW) {
+                    update_state(engine, r, d, hit[j], clear[j], s, emit, ctx);
+                } else {
+                    int cond = stateful_condition(t, r, s, d);
+                    update_state(engine, r, d, cond, !cond, s, emit, ctx);
+                }
+            }
+            engine->evaluations += len;
+        }
+    }
+
+    // Regras de sensores específicos: escalar, na ordem do lote
+    for (uint32_t k = 0; k < t->id_count; k++) {
+        uint32_t r = t->id_rules[k];
+        for (uint32_t i = 0; i < n; i++) {
+            const sensor_data_t *d = &batch[i];
+            if (d->sensor_id != t->scope_id[r]) {
+                continue;
+            }
+            rule_state_t *s = state_of(engine, d->sensor_id, r);
+            if (s == NULL) {
+                continue;
+            }
+            int cond;
+            int clear_ok;
+            switch ((rule_kind_t) t->kind[r]) {
+            case RULE_ABOVE:
+                cond = d->value > t->threshold[r];
+                clear_ok = d->value <= t->release[r];
+                break;
+            case RULE_BELOW:
+                cond = d->value < t->threshold[r];
+                clear_ok = d->value >= t->release[r];
+                break;
+            default:
+                cond = stateful_condition(t, r, s, d);
+                clear_ok = !cond;
+                break;
+            }
+            update_state(engine, r, d, cond, clear_ok, s, emit, ctx);
+            engine->evaluations++;
+        }
+    }
+}
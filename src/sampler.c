@@ -0,0 +1,103 @@
+#include "common.h"
+#include "sampler.h"
+
+#include <math.h>
+
+static int rate_to_period(double rate_hz, uint64_t *period_ns)
+{
+    if (!(rate_hz > 0.0) || rate_hz > SAMPLER_MAX_RATE_HZ) {
+        return -1;
+    }
+    *period_ns = (uint64_t) (1e9 / rate_hz + 0.5);
+    return 0;
+}
+
+int sampler_init(sampler_t *sampler, double rate_hz)
+{
+    memset(sampler, 0, sizeof(*sampler));
+    if (rate_to_period(rate_hz, &sampler->period_ns) == -1) {
+        return -1;
+    }
+    sampler->next_deadline = monotonic_ns() + sampler->period_ns;
+    sampler_reset_stats(sampler);
+    return 0;
+}
+
+int sampler_set_rate(sampler_t *sampler, double rate_hz)
+{
+    uint64_t period_ns;
+    if (rate_to_period(rate_hz, &period_ns) == -1) {
+        return -1;
+    }
+    // Reancorar o próximo deadline no novo período
+    sampler->next_deadline = sampler->next_deadline - sampler->period_ns +
+                             period_ns;
+    sampler->period_ns = period_ns;
+    return 0;
+}
+
+int sampler_wait(sampler_t *sampler)
+{
+    uint64_t deadline = sampler->next_deadline;
+    struct timespec ts = {.tv_sec = (time_t) (deadline / 1000000000ull),
+                          .tv_nsec = (long) (deadline % 1000000000ull)};
+
+    int rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    if (rc == EINTR) {
+        return -1;
+    }
+
+    uint64_t now = monotonic_ns();
+    uint64_t lateness = now > deadline ? now - deadline : 0;
+
+    // Welford para média/variância do jitter
+    sampler->wakeups++;
+    double delta = (double) lateness - sampler->jitter_mean;
+    sampler->jitter_mean += delta / (double) sampler->wakeups;
+    sampler->jitter_m2 += delta * ((double) lateness - sampler->jitter_mean);
+    if (lateness < sampler->jitter_min) {
+        sampler->jitter_min = lateness;
+    }
+    if (lateness > sampler->jitter_max) {
+        sampler->jitter_max = lateness;
+    }
+
+    // Deadlines seguintes que já venceram são perdidos (não recuperados)
+    int missed = 0;
+    if (lateness >= sampler->period_ns) {
+        uint64_t skipped = lateness / sampler->period_ns;
+        sampler->missed += skipped;
+        deadline += skipped * sampler->period_ns;
+        missed = skipped > INT32_MAX ? INT32_MAX : (int) skipped;
+    }
+
+    sampler->next_deadline = deadline + sampler->period_ns;
+    return missed;
+}
+
+void sampler_reset_stats(sampler_t *sampler)
+{
+    sampler->wakeups = 0;
+    sampler->missed = 0;
+    sampler->jitter_min = UINT64_MAX;
+    sampler->jitter_max = 0;
+    sampler->jitter_mean = 0.0;
+    sampler->jitter_m2 = 0.0;
+}
+
+void sampler_format_stats(const sampler_t *sampler, char *buf, size_t len)
+{
+    double stddev = 0.0;
+    if (sampler->wakeups > 1) {
+        stddev = sqrt(sampler->jitter_m2 / (double) (sampler->wakeups - 1));
+    }
+    uint64_t jmin = sampler->wakeups > 0 ? sampler->jitter_min : 0;
+
+    snprintf(buf, len,
+             "%.1f Hz, jitter min/médio/máx = %.1f/%.1f/%.1f us "
+             "(desvio %.1f us), %llu deadlines perdidos em %llu",
+             1e9 / (double) sampler->period_ns, (double) jmin / 1e3,
+             sampler->jitter_mean / 1e3, (double) sampler->jitter_max / 1e3,
+             stddev / 1e3, (unsigned long long) sampler->missed,
+             (unsigned long long) (sampler->wakeups + sampler->missed));
+}
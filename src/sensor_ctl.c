@@ -0,0 +1,225 @@
+#include "common.h"
+
+#include <math.h>
+#include <poll.h>
+
+// Ferramenta de linha de comando: envia um comando à control_interface pelo
+// FIFO de controle. O resultado aparece no log da control_interface, exceto
+// o de history, que volta por um FIFO de resposta criado para a consulta e
+// é impresso na saída padrão (CSV).
+
+#define REPLY_TIMEOUT_MS 2000
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s <stop|start|status|shutdown|latency> [sensor_id]\n"
+            "     %s rate <sensor_id> <hz>\n"
+            "     %s calibrate <sensor_id> <ganho> <offset>\n"
+            "     %s thresholds <sensor_id> <mín|-> <máx|->\n"
+            "     %s history <sensor_id> <desde> [passo_s] [até]\n",
+            prog, prog, prog, prog, prog);
+    fprintf(stderr, "\n  status sem sensor_id lista todos os sensores com "
+                    "dados\n");
+    fprintf(stderr, "  latency mostra p50/p99/p99.9/máx por etapa do "
+                    "pipeline\n");
+    fprintf(stderr, "  stop/start/rate/calibrate/thresholds valem na próxima "
+                    "leitura; sensor_id 0 = todos\n");
+    fprintf(stderr, "  rate 0 volta à taxa de linha de comando do sensor; "
+                    "'-' remove o limite\n");
+    fprintf(stderr, "  history: leituras (passo 0) ou baldes de passo_s "
+                    "segundos com n/mín/máx/média;\n    desde/até em "
+                    "segundos Unix ou relativos a agora com '-' (ex.: "
+                    "history 3 -300)\n");
+}
+
+// Quantidade de argumentos numéricos após sensor_id, por comando
+// (history tem argumentos opcionais e é tratado à parte)
+static const int command_args[] = {0, 0, 0, 0, 0, 1, 2, 2, 0};
+
+#define CMD_HISTORY 8
+
+// "-" (limite ausente) vira NAN; retorna -1 se não for número
+static int parse_arg(const char *text, float *out)
+{
+    if (strcmp(text, "-") == 0) {
+        *out = NAN;
+        return 0;
+    }
+    char *end;
+    *out = strtof(text, &end);
+    return end == text || *end != '\0' ? -1 : 0;
+}
+
+static int parse_command(const char *name)
+{
+    static const char *const names[] = {"stop",      "start",   "status",
+                                        "shutdown",  "latency", "rate",
+                                        "calibrate", "thresholds",
+                                        "history"};
+    for (int i = 0; i < (int) (sizeof(names) / sizeof(names[0])); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Segundos Unix ou, com sinal negativo, segundos antes de agora
+static int parse_time(const char *text, int64_t *out)
+{
+    char *end;
+    double seconds = strtod(text, &end);
+    if (end == text || *end != '\0') {
+        return -1;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (seconds < 0) {
+        seconds += (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+    }
+    *out = (int64_t) (seconds * 1e9);
+    return 0;
+}
+
+// history <sensor_id> <desde> [passo_s] [até]
+static int parse_history(int argc, char *argv[], control_message_t *cmd)
+{
+    if (argc < 4 || argc > 6) {
+        return -1;
+    }
+    cmd->sensor_id = atoi(argv[2]);
+    if (parse_time(argv[3], &cmd->from_ns) == -1) {
+        return -1;
+    }
+    cmd->to_ns = INT64_MAX;
+    if (argc >= 5 && (parse_arg(argv[4], &cmd->args[0]) == -1 ||
+                      !(cmd->args[0] >= 0.0f))) {
+        return -1;
+    }
+    if (argc == 6 && parse_time(argv[5], &cmd->to_ns) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+// Envia a consulta com um FIFO de resposta próprio e copia a resposta para
+// a saída padrão até a control_interface fechar a ponta de escrita
+static int run_history(int control_fd, control_message_t *cmd)
+{
+    snprintf(cmd->message, sizeof(cmd->message), "/tmp/sensor_ctl_%d",
+             (int) getpid());
+    unlink(cmd->message);
+    if (mkfifo(cmd->message, 0600) == -1) {
+        perror("Erro ao criar FIFO de resposta");
+        return -1;
+    }
+    // Aberto antes do envio: a control_interface só escreve se houver leitor
+    int fd = open(cmd->message, O_RDONLY | O_NONBLOCK);
+    if (fd == -1) {
+        perror("Erro ao abrir FIFO de resposta");
+        unlink(cmd->message);
+        return -1;
+    }
+
+    int rc = -1;
+    if (write(control_fd, cmd, sizeof(*cmd)) != (ssize_t) sizeof(*cmd)) {
+        perror("Erro ao enviar comando");
+        goto out;
+    }
+
+    char buf[4096];
+    for (;;) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        int ready = poll(&pfd, 1, REPLY_TIMEOUT_MS);
+        if (ready == 0) {
+            fprintf(stderr, "Sem resposta da control_interface\n");
+            goto out;
+        }
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Erro em poll");
+            goto out;
+        }
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n == 0) {
+            break; // Resposta completa
+        }
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            perror("Erro ao ler resposta");
+            goto out;
+        }
+        fwrite(buf, 1, (size_t) n, stdout);
+    }
+    rc = 0;
+
+out:
+    close(fd);
+    unlink(cmd->message);
+    return rc;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    control_message_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.command = parse_command(argv[1]);
+    if (cmd.command == -1) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    if (cmd.command == CMD_HISTORY) {
+        if (parse_history(argc, argv, &cmd) == -1) {
+            usage(argv[0]);
+            exit(1);
+        }
+    } else {
+        // Comandos com parâmetros exigem sensor_id e todos os argumentos
+        int nargs = command_args[cmd.command];
+        if ((nargs == 0 && argc > 3) || (nargs > 0 && argc != 3 + nargs)) {
+            usage(argv[0]);
+            exit(1);
+        }
+        cmd.sensor_id = argc >= 3 ? atoi(argv[2]) : 0;
+        for (int i = 0; i < nargs; i++) {
+            if (parse_arg(argv[3 + i], &cmd.args[i]) == -1) {
+                fprintf(stderr, "Argumento inválido: %s\n", argv[3 + i]);
+                exit(1);
+            }
+        }
+        snprintf(cmd.message, sizeof(cmd.message), "%s", argv[1]);
+    }
+
+    // Não bloquear se a control_interface não estiver rodando
+    int fd = open(FIFO_CONTROL, O_WRONLY | O_NONBLOCK);
+    if (fd == -1) {
+        perror("Erro ao abrir FIFO de controle (control_interface ativa?)");
+        exit(1);
+    }
+
+    if (cmd.command == CMD_HISTORY) {
+        int rc = run_history(fd, &cmd);
+        close(fd);
+        return rc == -1 ? 1 : 0;
+    }
+
+    if (write(fd, &cmd, sizeof(cmd)) != (ssize_t) sizeof(cmd)) {
+        perror("Erro ao enviar comando");
+        close(fd);
+        exit(1);
+    }
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,466 @@
+#include "common.h"
+#include "live_config.h"
+#include "logger.h"
+#include "metrics.h"
+#include "system_config.h"
+#include "transport.h"
+
+#include <sched.h>
+
+// Processo hospedeiro de sensores: um único processo simula milhares de
+// sensores. O estado de cada sensor fica em arrays compactos (estrutura de
+// arrays) e o disparo das leituras é feito por uma roda de temporização
+// (timer wheel) com tick de 1 ms, então o custo por tick é proporcional
+// apenas aos sensores que vencem naquele tick.
+//
+// A configuração dinâmica de cada sensor (live_config.h) é consultada quando
+// ele dispara: uma leitura atômica no caso comum, e a cópia local só é
+// atualizada quando a versão da entrada muda.
+
+#define WHEEL_SLOTS 1024
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define TICK_NS 1000000ull // 1 ms
+#define HOST_BATCH 512     // Amostras por envio ao data_processor (por shard)
+#define MAX_CATCHUP_TICKS WHEEL_SLOTS
+#define REPORT_INTERVAL_NS 10000000000ull // 10 s
+
+typedef struct {
+    uint32_t count;
+    int first_id;
+
+    // Estado por sensor (índice = sensor_id - first_id)
+    uint8_t *type;
+    float *base;
+    uint32_t *rng;
+    uint32_t *period_ticks;
+    uint32_t *rounds; // Voltas completas da roda antes de disparar
+    int32_t *next;    // Lista encadeada intrusiva do slot
+
+    // Configuração dinâmica aplicada (cópia local da entrada compartilhada)
+    live_config_t *live;
+    uint32_t *live_seq;
+    uint8_t *enabled;
+    float *gain;
+    float *offset;
+    uint32_t default_period;
+
+    int32_t slot_head[WHEEL_SLOTS];
+    uint64_t now_tick;
+} sensor_fleet_t;
+
+// Lotes pendentes, um por shard do data_processor, para que cada envio seja
+// uma única reserva no ring de destino
+typedef struct {
+    uint32_t nshards;
+    uint32_t *fill;
+    sensor_data_t *items; // nshards * HOST_BATCH
+} host_batches_t;
+
+volatile sig_atomic_t running = 1;
+
+// Contadores ao vivo do hospedeiro (sensor_top)
+static metrics_slot_t *metrics = NULL;
+
+void signal_handler(int sig)
+{
+    if (sig == SIGTERM || sig == SIGINT) {
+        running = 0;
+    }
+}
+
+// Memória residente do processo em bytes
+static size_t resident_bytes(void)
+{
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f == NULL) {
+        return 0;
+    }
+    unsigned long size = 0, resident = 0;
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(f);
+    return (size_t) resident * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+static void wheel_schedule(sensor_fleet_t *fleet, uint32_t i, uint32_t delay)
+{
+    if (delay == 0) {
+        delay = 1;
+    }
+    uint32_t slot = (uint32_t) ((fleet->now_tick + delay) & WHEEL_MASK);
+    fleet->rounds[i] = (delay - 1) / WHEEL_SLOTS;
+    fleet->next[i] = fleet->slot_head[slot];
+    fleet->slot_head[slot] = (int32_t) i;
+}
+
+static uint32_t rate_to_ticks(double rate_hz)
+{
+    uint32_t period = (uint32_t) (1000.0 / rate_hz + 0.5);
+    return period == 0 ? 1 : period;
+}
+
+static int fleet_init(sensor_fleet_t *fleet, uint32_t count, int first_id,
+                      double rate_hz)
+{
+    memset(fleet, 0, sizeof(*fleet));
+    fleet->count = count;
+    fleet->first_id = first_id;
+
+    fleet->type = calloc(count, sizeof(*fleet->type));
+    fleet->base = calloc(count, sizeof(*fleet->base));
+    fleet->rng = calloc(count, sizeof(*fleet->rng));
+    fleet->period_ticks = calloc(count, sizeof(*fleet->period_ticks));
+    fleet->rounds = calloc(count, sizeof(*fleet->rounds));
+    fleet->next = calloc(count, sizeof(*fleet->next));
+    fleet->live_seq = calloc(count, sizeof(*fleet->live_seq));
+    fleet->enabled = calloc(count, sizeof(*fleet->enabled));
+    fleet->gain = calloc(count, sizeof(*fleet->gain));
+    fleet->offset = calloc(count, sizeof(*fleet->offset));
+    if (!fleet->type || !fleet->base || !fleet->rng || !fleet->period_ticks ||
+        !fleet->rounds || !fleet->next || !fleet->live_seq ||
+        !fleet->enabled || !fleet->gain || !fleet->offset) {
+        return -1;
+    }
+
+    for (int s = 0; s < WHEEL_SLOTS; s++) {
+        fleet->slot_head[s] = -1;
+    }
+
+    uint32_t period = rate_to_ticks(rate_hz);
+    fleet->default_period = period;
+
+    for (uint32_t i = 0; i < count; i++) {
+        int id = first_id + (int) i;
+        fleet->type[i] = (uint8_t) (id % SENSOR_TYPE_COUNT);
+        fleet->base[i] = sensor_base_value((sensor_type_t) fleet->type[i]);
+        fleet->rng[i] = (uint32_t) id * 2654435761u + 1;
+        fleet->period_ticks[i] = period;
+        fleet->enabled[i] = 1;
+        fleet->gain[i] = 1.0f;
+        // Espalhar a primeira leitura ao longo do período
+        wheel_schedule(fleet, i, 1 + i % period);
+    }
+
+    return 0;
+}
+
+static void fleet_free(sensor_fleet_t *fleet)
+{
+    free(fleet->type);
+    free(fleet->base);
+    free(fleet->rng);
+    free(fleet->period_ticks);
+    free(fleet->rounds);
+    free(fleet->next);
+    free(fleet->live_seq);
+    free(fleet->enabled);
+    free(fleet->gain);
+    free(fleet->offset);
+    live_config_close(fleet->live);
+}
+
+// Aplica a configuração dinâmica do sensor i se a entrada mudou
+static void fleet_refresh_config(sensor_fleet_t *fleet, int32_t i, int id)
+{
+    live_sensor_view_t view;
+    view.seq = fleet->live_seq[i];
+    if (!live_config_poll(fleet->live, id, &view)) {
+        return;
+    }
+    fleet->live_seq[i] = view.seq;
+    fleet->enabled[i] = view.enabled ? 1 : 0;
+    fleet->gain[i] = view.gain;
+    fleet->offset[i] = view.offset;
+    fleet->period_ticks[i] = view.rate_hz > 0.0f
+                                 ? rate_to_ticks(view.rate_hz)
+                                 : fleet->default_period;
+}
+
+// Envia o lote acumulado; retorna -1 em erro de transporte
+static int flush_batch(sample_writer_t *writer, sensor_data_t *batch,
+                       uint32_t *fill)
+{
+    uint32_t sent = 0;
+    uint32_t published = 0;
+    int ring_full = 0;
+    while (sent < *fill && running) {
+        uint32_t n;
+        int rc =
+            sample_writer_send_batch(writer, batch + sent, *fill - sent, &n);
+        if (rc == -1) {
+            perror("Erro ao enviar lote");
+            return -1;
+        }
+        ring_full |= (uint32_t) rc < *fill - sent || n < (uint32_t) rc;
+        sent += (uint32_t) rc;
+        published += n;
+    }
+    // Tratadas e não publicadas: descartes/retenções da política de
+    // sobrecarga, contados por motivo
+    metrics_add(metrics, METRIC_RING_FULL, (uint64_t) ring_full);
+    metrics_add(metrics, METRIC_SAMPLES_SENT, published);
+    metrics_add(metrics, METRIC_SAMPLES_DROPPED, *fill - sent);
+    overload_report(&writer->overload, metrics);
+    metrics_set(metrics, METRIC_BACKLOG, sample_writer_backlog(writer));
+    *fill = 0;
+    return 0;
+}
+
+static int flush_all(sample_writer_t *writer, host_batches_t *batches)
+{
+    for (uint32_t s = 0; s < batches->nshards; s++) {
+        if (batches->fill[s] > 0 &&
+            flush_batch(writer, batches->items + (size_t) s * HOST_BATCH,
+                        &batches->fill[s]) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Avança a roda um tick, gerando as leituras dos sensores que venceram
+static int wheel_advance(sensor_fleet_t *fleet, sample_writer_t *writer,
+                         host_batches_t *batches, time_t wall,
+                         uint64_t now_ns, uint64_t *samples)
+{
+    uint64_t tick = ++fleet->now_tick;
+    uint32_t slot = (uint32_t) (tick & WHEEL_MASK);
+    int32_t i = fleet->slot_head[slot];
+    fleet->slot_head[slot] = -1;
+
+    while (i != -1) {
+        int32_t next = fleet->next[i];
+
+        if (fleet->rounds[i] > 0) {
+            // Ainda faltam voltas: recolocar no mesmo slot
+            fleet->rounds[i]--;
+            fleet->next[i] = fleet->slot_head[slot];
+            fleet->slot_head[slot] = i;
+        } else {
+            int id = fleet->first_id + i;
+            fleet_refresh_config(fleet, i, id);
+            wheel_schedule(fleet, (uint32_t) i, fleet->period_ticks[i]);
+            if (!fleet->enabled[i]) {
+                i = next; // Pausado: continua agendado, sem amostras
+                continue;
+            }
+
+            uint32_t shard = sample_writer_shard(writer, id);
+            sensor_data_t *batch = batches->items + (size_t) shard * HOST_BATCH;
+            uint32_t *fill = &batches->fill[shard];
+
+            sensor_data_t *data = &batch[(*fill)++];
+            data->type = (sensor_type_t) fleet->type[i];
+            data->sensor_id = id;
+            data->value = sensor_simulate(fleet->base[i], &fleet->rng[i]) *
+                              fleet->gain[i] +
+                          fleet->offset[i];
+            data->timestamp = wall;
+            data->active = 1;
+            data->t_created = now_ns;
+            (*samples)++;
+
+            if (*fill == HOST_BATCH && flush_batch(writer, batch, fill) == -1) {
+                return -1;
+            }
+        }
+
+        i = next;
+    }
+
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s [-t shm|fifo|fifo-gorilla|udp|tcp] [-n sensores] "
+            "[-f primeiro_id] [-r taxa_hz] [-c cpu]\n",
+            prog);
+    fprintf(stderr, "\n  -n  quantidade de sensores simulados (padrão: 1000)\n");
+    fprintf(stderr, "  -f  ID do primeiro sensor (padrão: 1)\n");
+    fprintf(stderr,
+            "  -r  leituras por segundo de cada sensor, até %g (padrão: 1)\n",
+            SENSOR_HOST_MAX_RATE_HZ);
+    fprintf(stderr, "  -c  fixar o processo neste core\n");
+    fprintf(stderr, "\nTipos são atribuídos por sensor_id %% %d.\n",
+            SENSOR_TYPE_COUNT);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t t_start = monotonic_ns();
+
+    transport_mode_t transport = transport_mode_default();
+    uint32_t count = 1000;
+    int first_id = 1;
+    double rate_hz = 1.0;
+    int cpu = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:n:f:r:c:h")) != -1) {
+        switch (opt) {
+        case 't':
+            if (transport_mode_parse(optarg, &transport) == -1) {
+                usage(argv[0]);
+                exit(1);
+            }
+            break;
+        case 'n':
+            count = (uint32_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'f':
+            first_id = atoi(optarg);
+            break;
+        case 'r':
+            rate_hz = atof(optarg);
+            break;
+        case 'c':
+            cpu = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+
+    if (count == 0 || rate_hz <= 0.0 || rate_hz > SENSOR_HOST_MAX_RATE_HZ) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    signal(SIGTERM, signal_handler);
+    signal(SIGINT, signal_handler);
+
+    char component[64];
+    snprintf(component, sizeof(component), "HOST-%d", first_id);
+    char metrics_label[METRICS_NAME_LEN];
+    snprintf(metrics_label, sizeof(metrics_label), "host-%d", first_id);
+    metrics = metrics_register(metrics_label);
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+            perror("Erro ao fixar CPU");
+        }
+    }
+
+    size_t rss_before = resident_bytes();
+
+    sensor_fleet_t fleet;
+    if (fleet_init(&fleet, count, first_id, rate_hz) == -1) {
+        fprintf(stderr, "Erro: memória insuficiente para %u sensores\n",
+                count);
+        exit(1);
+    }
+
+    // Sem configuração dinâmica os sensores seguem os parâmetros de -r
+    fleet.live = live_config_open();
+
+    sample_writer_t writer;
+    if (sample_writer_open(&writer, transport, component) == -1) {
+        fleet_free(&fleet);
+        exit(1);
+    }
+
+    host_batches_t batches;
+    batches.nshards = writer.nshards;
+    batches.fill = calloc(batches.nshards, sizeof(*batches.fill));
+    batches.items = malloc((size_t) batches.nshards * HOST_BATCH *
+                           sizeof(*batches.items));
+    if (batches.fill == NULL || batches.items == NULL) {
+        fprintf(stderr, "Erro: memória insuficiente para lotes\n");
+        sample_writer_close(&writer);
+        fleet_free(&fleet);
+        exit(1);
+    }
+
+    // Tempo real: a afinidade do perfil, se houver, substitui a de -c
+    system_config_t config;
+    system_config_default(&config);
+    if (system_config_load(&config, NULL) == -1) {
+        exit(1);
+    }
+    sample_writer_set_backlog(&writer, config.sensor_backlog);
+    if (config.rt.enabled) {
+        rt_lock_memory(&config.rt, component);
+        if (config.rt.lock_memory) {
+            rt_prefault(writer.shm, writer.shm_bytes, 1);
+        }
+        rt_apply_thread(&config.rt, RT_ROLE_SENSOR, -1, component);
+    }
+
+    sample_writer_announce(&writer, count);
+
+    size_t rss_after = resident_bytes();
+    // O kernel pode devolver páginas no meio da partida: sem crescimento,
+    // o custo por sensor é 0 (a diferença sem sinal daria a volta)
+    size_t rss_growth = rss_after > rss_before ? rss_after - rss_before : 0;
+    double startup_ms = (double) (monotonic_ns() - t_start) / 1e6;
+    log_event(LOG_INFO, COLOR_GREEN, component,
+              "%u sensores (IDs %d-%d, %.1f Hz, via %s, %u shards) prontos "
+              "em %.2f ms; RSS %.1f KiB (%.1f bytes/sensor)",
+              count, first_id, first_id + (int) count - 1, rate_hz,
+              transport_mode_name(transport), batches.nshards, startup_ms,
+              (double) rss_after / 1024.0,
+              (double) rss_growth / (double) count);
+
+    uint64_t samples = 0;
+    uint64_t last_samples = 0;
+    uint64_t base_ns = monotonic_ns();
+    uint64_t last_report = base_ns;
+
+    while (running) {
+        // Dormir até o próximo tick (deadline absoluto, sem deriva)
+        uint64_t next_ns = base_ns + (fleet.now_tick + 1) * TICK_NS;
+        struct timespec deadline = {.tv_sec = (time_t) (next_ns / 1000000000ull),
+                                    .tv_nsec = (long) (next_ns % 1000000000ull)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+
+        // Processar todos os ticks vencidos (recupera atrasos)
+        uint64_t now = monotonic_ns();
+        uint64_t due_tick = (now - base_ns) / TICK_NS;
+        if (due_tick > fleet.now_tick + MAX_CATCHUP_TICKS) {
+            // Atraso grande: descartar ticks em vez de gerar rajada
+            base_ns += (due_tick - fleet.now_tick - MAX_CATCHUP_TICKS) * TICK_NS;
+            due_tick = fleet.now_tick + MAX_CATCHUP_TICKS;
+        }
+
+        time_t wall = time(NULL);
+        int error = 0;
+        while (fleet.now_tick < due_tick && !error) {
+            error = wheel_advance(&fleet, &writer, &batches, wall, now,
+                                  &samples) == -1;
+        }
+        if (error || flush_all(&writer, &batches) == -1) {
+            break;
+        }
+        metrics_touch(metrics, now);
+
+        if (now - last_report >= REPORT_INTERVAL_NS) {
+            double elapsed = (double) (now - last_report) / 1e9;
+            log_event(LOG_INFO, COLOR_GREEN, component,
+                      "%.0f amostras/s (%llu no total), RSS %.1f KiB",
+                      (double) (samples - last_samples) / elapsed,
+                      (unsigned long long) samples,
+                      (double) resident_bytes() / 1024.0);
+            last_samples = samples;
+            last_report = now;
+        }
+    }
+
+    log_event(LOG_INFO, COLOR_YELLOW, component,
+              "Encerrando (%llu amostras enviadas)",
+              (unsigned long long) samples);
+
+    free(batches.fill);
+    free(batches.items);
+    sample_writer_close(&writer);
+    fleet_free(&fleet);
+    metrics_unregister(metrics);
+
+    return 0;
+}
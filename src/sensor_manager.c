@@ -1,73 +1,249 @@
 #include "common.h"
+#include "logger.h"
+#include "metrics.h"
+#include "system_config.h"
+#include "telemetry.h"
+#include "transport.h"
 
-#define MAX_CHILDREN MAX_SENSORS
-pid_t child_pids[MAX_CHILDREN];
+#include <poll.h>
+#include <spawn.h>
+#include <sys/signalfd.h>
+
+extern char **environ;
+
+// Prazo para a frota inteira se conectar ao data_processor
+#define FLEET_START_TIMEOUT_MS 30000
+
+// PIDs dos filhos (sensores ou hospedeiros); capacidade definida no início
+pid_t *child_pids = NULL;
+int max_children = 0;
 int num_children = 0;
 
-// Handler para sinais de filhos terminados
-void sigchld_handler(int sig __attribute__((unused)))
+// Contadores ao vivo (sensor_top), escritos só pelo fluxo principal
+metrics_slot_t *metrics = NULL;
+
+static void track_child(pid_t pid)
+{
+    if (num_children < max_children) {
+        child_pids[num_children++] = pid;
+    }
+    metrics_add(metrics, METRIC_CHILDREN_STARTED, 1);
+}
+
+int manager_running = 1;
+
+// SIGTERM/SIGINT/SIGCHLD chegam pelo signalfd e são tratados no fluxo
+// principal: o log e os contadores não são seguros num handler
+static int signal_fd = -1;
+
+// Coletar todos os processos filhos terminados (wait sem bloquear)
+static void reap_children(void)
 {
     int status;
     pid_t pid;
 
-    // Coletar todos os processos filhos terminados (wait sem bloquear)
     while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
         for (int i = 0; i < num_children; i++) {
             if (child_pids[i] == pid) {
-                char msg[128];
-                snprintf(msg, sizeof(msg),
-                         "Processo filho %d terminou (status=%d)", pid,
-                         WEXITSTATUS(status));
-                log_message(COLOR_YELLOW, "SENSOR_MGR", msg);
+                log_event(LOG_INFO, COLOR_YELLOW, "SENSOR_MGR",
+                          "Processo filho %d terminou (status=%d)", (int) pid,
+                          WEXITSTATUS(status));
                 child_pids[i] = -1;
+                metrics_add(metrics, METRIC_CHILD_EXITS, 1);
                 break;
             }
         }
     }
 }
 
-// Criar processo de sensor usando fork e exec
-pid_t create_sensor_process(int sensor_id, sensor_type_t sensor_type)
+// Drena o signalfd; SIGTERM/SIGINT (supervisor): encerrar os filhos antes
+// de sair
+static void handle_signals(void)
 {
-    pid_t pid = fork();
+    struct signalfd_siginfo info;
+    int reap = 0;
+    while (read(signal_fd, &info, sizeof(info)) > 0) {
+        if (info.ssi_signo == SIGCHLD) {
+            reap = 1;
+        } else {
+            manager_running = 0;
+        }
+    }
+    if (reap) {
+        reap_children();
+    }
+}
 
-    if (pid == -1) {
-        perror("Erro no fork");
-        return -1;
+// Taxa de amostragem repassada aos sensores (-r ou sensor_rate_hz)
+const char *sensor_rate = NULL;
+
+// Cria o filho com posix_spawn (sem copiar a tabela de páginas do
+// gerenciador, como em fork): a frota inteira é criada em sequência rápida,
+// sem esperas entre filhos
+static pid_t spawn_child(char *const args[])
+{
+    // Os sinais bloqueados para o signalfd não passam aos filhos
+    static posix_spawnattr_t attr;
+    static int attr_ready = 0;
+    if (!attr_ready) {
+        sigset_t none;
+        sigemptyset(&none);
+        posix_spawnattr_init(&attr);
+        posix_spawnattr_setsigmask(&attr, &none);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+        attr_ready = 1;
     }
 
-    if (pid == 0) {
-        // Processo filho - executar sensor_process
-        char id_str[16], type_str[16];
-        snprintf(id_str, sizeof(id_str), "%d", sensor_id);
-        snprintf(type_str, sizeof(type_str), "%d", (int) sensor_type);
+    pid_t pid;
+    int rc = posix_spawn(&pid, args[0], NULL, &attr, args, environ);
+    if (rc != 0) {
+        errno = rc;
+        perror("Erro no posix_spawn");
+        return -1;
+    }
+    track_child(pid);
+    return pid;
+}
 
-        char *args[] = {"./bin/sensor_process", id_str, type_str, NULL};
+// Criar processo de sensor
+pid_t create_sensor_process(int sensor_id, sensor_type_t sensor_type)
+{
+    char id_str[16], type_str[16];
+    snprintf(id_str, sizeof(id_str), "%d", sensor_id);
+    snprintf(type_str, sizeof(type_str), "%d", (int) sensor_type);
 
-        // Usar exec para substituir imagem do processo
-        if (execv(args[0], args) == -1) {
-            perror("Erro no execv");
-            exit(1);
-        }
-    } else {
-        // Processo pai
-        char msg[128];
-        snprintf(msg, sizeof(msg),
-                 "Criado processo sensor %d (PID=%d, tipo=%s)", sensor_id, pid,
-                 sensor_type_name(sensor_type));
-        log_message(COLOR_BLUE, "SENSOR_MGR", msg);
-
-        if (num_children < MAX_CHILDREN) {
-            child_pids[num_children++] = pid;
-        }
+    char *args[] = {"./bin/sensor_process", "-r", (char *) sensor_rate,
+                    id_str, type_str, NULL};
+    pid_t pid = spawn_child(args);
+    if (pid > 0) {
+        log_event(LOG_DEBUG, COLOR_BLUE, "SENSOR_MGR",
+                  "Criado processo sensor %d (PID=%d, tipo=%s)", sensor_id,
+                  (int) pid, sensor_type_name(sensor_type));
     }
+    return pid;
+}
+
+// Criar processo hospedeiro que simula 'count' sensores a partir de first_id
+pid_t create_sensor_host(int first_id, int count, const char *rate, int cpu)
+{
+    char first_str[16], count_str[16], cpu_str[16];
+    snprintf(first_str, sizeof(first_str), "%d", first_id);
+    snprintf(count_str, sizeof(count_str), "%d", count);
+    snprintf(cpu_str, sizeof(cpu_str), "%d", cpu);
 
+    char *args[] = {"./bin/sensor_host", "-f", first_str, "-n", count_str,
+                    "-r", (char *) rate, "-c", cpu_str, NULL};
+    pid_t pid = spawn_child(args);
+    if (pid > 0) {
+        log_event(LOG_INFO, COLOR_BLUE, "SENSOR_MGR",
+                  "Criado hospedeiro (PID=%d) para sensores %d-%d na CPU %d",
+                  (int) pid, first_id, first_id + count - 1, cpu);
+    }
     return pid;
 }
 
-int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s [-C arquivo] [-S chave=valor] [-r taxa_hz] "
+            "[-n sensores] [-H [-p processos]]\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
 {
+    // Modo padrão: um processo por sensor (isolamento). Com -H, sensores são
+    // distribuídos entre processos hospedeiros (um por core por padrão).
+    // As opções sobrepõem a configuração do sistema (-C/-S).
+    system_config_t config;
+    system_config_default(&config);
+    if (system_config_load(&config, system_config_arg(argc, argv)) == -1) {
+        exit(1);
+    }
+    int host_mode = -1;
+    int fleet_size = -1; // -n; padrão: 4 processos ou 1000 hospedados
+    int host_procs = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "C:S:Hn:p:r:")) != -1) {
+        switch (opt) {
+        case 'C':
+            break; // Já carregado
+        case 'S':
+            if (system_config_set(&config, optarg) == -1) {
+                fprintf(stderr, "Configuração inválida: %s\n", optarg);
+                usage(argv[0]);
+                exit(1);
+            }
+            break;
+        case 'H':
+            host_mode = 1;
+            break;
+        case 'n':
+            fleet_size = atoi(optarg);
+            break;
+        case 'p':
+            host_procs = atoi(optarg);
+            break;
+        case 'r':
+            sensor_rate = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (host_mode < 0) {
+        host_mode = config.host_mode;
+    }
+    if (fleet_size < 0 && config.sensors != 0) {
+        fleet_size = (int) config.sensors;
+    }
+    if (host_procs < 0) {
+        host_procs = config.host_procs != 0
+                         ? (int) config.host_procs
+                         : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    static char rate_str[32];
+    if (sensor_rate == NULL) {
+        snprintf(rate_str, sizeof(rate_str), "%g", config.sensor_rate_hz);
+        sensor_rate = rate_str;
+    }
+    if (host_mode && atof(sensor_rate) > SENSOR_HOST_MAX_RATE_HZ) {
+        // O hospedeiro recusaria a taxa e a frota não subiria
+        fprintf(stderr,
+                "Taxa %s Hz acima do limite de %g Hz dos hospedeiros\n",
+                sensor_rate, SENSOR_HOST_MAX_RATE_HZ);
+        exit(1);
+    }
+    if (fleet_size < 0) {
+        fleet_size = host_mode ? 1000 : 4;
+    }
+    if (fleet_size < 1) {
+        fleet_size = 1;
+    }
+    if (host_procs < 1) {
+        host_procs = 1;
+    }
+    if (host_procs > fleet_size) {
+        host_procs = fleet_size;
+    }
+
+    max_children = host_mode ? host_procs : fleet_size;
+    child_pids = calloc((size_t) max_children, sizeof(pid_t));
+    if (child_pids == NULL) {
+        perror("Erro ao alocar lista de processos");
+        exit(1);
+    }
+
     log_message(COLOR_BLUE, "SENSOR_MGR", "Iniciando gerenciador de sensores");
+    metrics = metrics_register("sensor_manager");
+    notify_ready_detach(); // Sensores não herdam o pipe do supervisor
+
+    rendezvous_t *rendezvous = rendezvous_open();
+    if (rendezvous == NULL) {
+        exit(1);
+    }
 
     // Criar diretórios necessários
     mkdir("fifos", 0755);
@@ -82,10 +258,8 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
         exit(1);
     }
 
-    // Criar fila de mensagens POSIX (se não existir)
-    struct mq_attr attr = {
-        .mq_flags = 0, .mq_maxmsg = 10, .mq_msgsize = MAX_MESSAGE_SIZE};
-    mqd_t mq = mq_open(MQ_NAME, O_CREAT | O_RDWR, 0666, &attr);
+    // Criar fila de telemetria (se não existir)
+    mqd_t mq = telemetry_mq_open(O_RDWR, config.mq_depth);
     if (mq == (mqd_t) -1) {
         perror("Erro ao criar fila de mensagens");
         exit(1);
@@ -93,26 +267,96 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
         mq_close(mq);
     }
 
-    // Configurar handler para SIGCHLD (filhos terminados)
-    signal(SIGCHLD, sigchld_handler);
+    // Filhos terminados e pedidos de término viram eventos (signalfd)
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &signals, NULL);
+    signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd == -1) {
+        perror("Erro ao criar signalfd");
+        exit(1);
+    }
 
-    // Criar processos de sensores usando fork/exec
-    create_sensor_process(1, SENSOR_TEMPERATURE);
-    msleep(100); // Pequeno delay entre criações
+    // Partida da frota: criar todos os filhos de uma vez; cada sensor se
+    // conecta assim que o data_processor sinaliza no ponto de encontro e
+    // se conta em sensors_started
+    uint64_t t_spawn = monotonic_ns();
+    uint32_t started_base = rendezvous_sensors(rendezvous);
+    int expected = 0;
 
-    create_sensor_process(2, SENSOR_TEMPERATURE);
-    msleep(100); // Pequeno delay entre criações
+    if (host_mode) {
+        // Dividir a frota entre os hospedeiros, um por core
+        int ncpu = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        int first_id = 1;
+        for (int p = 0; p < host_procs; p++) {
+            int count = fleet_size / host_procs +
+                        (p < fleet_size % host_procs ? 1 : 0);
+            if (create_sensor_host(first_id, count, sensor_rate, p % ncpu) >
+                0) {
+                expected += count;
+            }
+            first_id += count;
+        }
+    } else {
+        // Tipos na ordem histórica: 2 de temperatura, umidade, pressão
+        static const sensor_type_t types[] = {
+            SENSOR_TEMPERATURE, SENSOR_TEMPERATURE, SENSOR_HUMIDITY,
+            SENSOR_PRESSURE};
+        for (int id = 1; id <= fleet_size; id++) {
+            if (create_sensor_process(id, types[(id - 1) % 4]) > 0) {
+                expected++;
+            }
+        }
+    }
 
-    create_sensor_process(3, SENSOR_HUMIDITY);
-    msleep(100); // Pequeno delay entre criações
+    double spawn_ms = (double) (monotonic_ns() - t_spawn) / 1e6;
+    log_event(LOG_INFO, COLOR_BLUE, "SENSOR_MGR",
+              "%d processos criados em %.1f ms; aguardando %d sensores",
+              num_children, spawn_ms, expected);
 
-    create_sensor_process(4, SENSOR_PRESSURE);
+    uint64_t wait_deadline =
+        t_spawn + (uint64_t) FLEET_START_TIMEOUT_MS * 1000000ull;
+    int connected = -1;
+    while (manager_running && monotonic_ns() < wait_deadline &&
+           (connected = rendezvous_wait_sensors(
+                rendezvous, started_base + (uint32_t) expected, 100)) == -1) {
+        // Timeout curto: reavaliar sinais e o prazo total
+        handle_signals();
+    }
 
-    log_message(COLOR_BLUE, "SENSOR_MGR", "Todos os sensores criados");
+    uint64_t startup_ns = monotonic_ns() - t_spawn;
+    metrics_set(metrics, METRIC_STARTUP_US, startup_ns / 1000);
+    if (connected == 0) {
+        log_event(LOG_INFO, COLOR_GREEN, "SENSOR_MGR",
+                  "Frota de %d sensores conectada em %.1f ms", expected,
+                  (double) startup_ns / 1e6);
+    } else {
+        log_event(LOG_WARN, COLOR_YELLOW, "SENSOR_MGR",
+                  "Apenas %u de %d sensores conectados após %.1f ms",
+                  rendezvous_sensors(rendezvous) - started_base, expected,
+                  (double) startup_ns / 1e6);
+    }
+    notify_ready();
 
-    // Aguardar um tempo antes de encerrar (em produção, aguardaria
-    // indefinidamente)
-    sleep(30);
+    // Executar por run_s segundos (0 = indefinidamente), atendendo aos
+    // sinais até SIGTERM/SIGINT
+    uint64_t deadline =
+        monotonic_ns() + (uint64_t) config.run_s * 1000000000ull;
+    struct pollfd pfd = {.fd = signal_fd, .events = POLLIN};
+    while (manager_running) {
+        handle_signals();
+        uint64_t now = monotonic_ns();
+        if (!manager_running || (config.run_s != 0 && now >= deadline)) {
+            break;
+        }
+        int timeout = config.run_s == 0
+                          ? -1
+                          : (int) ((deadline - now + 999999) / 1000000);
+        poll(&pfd, 1, timeout);
+    }
 
     // Enviar SIGTERM para todos os filhos
     log_message(COLOR_YELLOW, "SENSOR_MGR", "Encerrando processos filhos...");
@@ -129,6 +373,10 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
         }
     }
 
+    free(child_pids);
+    close(signal_fd);
+    rendezvous_close(rendezvous);
+    metrics_unregister(metrics);
     log_message(COLOR_BLUE, "SENSOR_MGR", "Gerenciador encerrado");
 
     return 0;
@@ -1,4 +1,11 @@
 #include "common.h"
+#include "live_config.h"
+#include "logger.h"
+#include "metrics.h"
+#include "sampler.h"
+#include "system_config.h"
+#include "telemetry.h"
+#include "transport.h"
 
 // Variável global para sinal de término
 volatile sig_atomic_t running = 1;
@@ -13,12 +20,52 @@ void signal_handler(int sig)
 
 int main(int argc, char *argv[])
 {
-    if (argc < 3) {
-        fprintf(stderr, "Uso: %s <sensor_id> <sensor_type>\n", argv[0]);
+    transport_mode_t transport = transport_mode_default();
+    double rate_hz = 1.0;
+    uint32_t summary_ms = telemetry_interval_default();
+    int opt;
+    while ((opt = getopt(argc, argv, "t:r:i:")) != -1) {
+        if (opt == 't' && transport_mode_parse(optarg, &transport) == 0) {
+            continue;
+        }
+        if (opt == 'r') {
+            rate_hz = atof(optarg);
+            if (rate_hz > 0.0 && rate_hz <= SAMPLER_MAX_RATE_HZ) {
+                continue;
+            }
+        }
+        if (opt == 'i') {
+            char *end;
+            unsigned long ms = strtoul(optarg, &end, 10);
+            if (end != optarg && *end == '\0' && ms <= 3600000ul) {
+                summary_ms = (uint32_t) ms;
+                continue;
+            }
+        }
+        argc = 0; // Opção inválida: mostrar uso
+        break;
+    }
+
+    if (argc - optind < 2) {
+        fprintf(stderr,
+                "Uso: %s [-t shm|fifo|fifo-gorilla|udp|tcp] [-r taxa_hz] "
+                "[-i resumo_ms] <sensor_id> <sensor_type>\n",
+                argv[0]);
         fprintf(stderr, "\nTipos de sensor válidos:\n");
         fprintf(stderr, "  0 = TEMPERATURA\n");
         fprintf(stderr, "  1 = UMIDADE\n");
         fprintf(stderr, "  2 = PRESSAO\n");
+        fprintf(stderr, "\nTransporte (-t ou SENSOR_TRANSPORT):\n");
+        fprintf(stderr, "  shm  = ring em memória compartilhada (padrão)\n");
+        fprintf(stderr, "  fifo = pipe nomeado %s\n", FIFO_SENSOR_DATA);
+        fprintf(stderr, "  udp, tcp = rede, para %s (%s)\n",
+                net_addr_default(), NET_ADDR_ENV);
+        fprintf(stderr, "\nTaxa de amostragem (-r): 1 Hz (padrão) até %.0f Hz\n",
+                SAMPLER_MAX_RATE_HZ);
+        fprintf(stderr,
+                "\nResumo na fila %s (-i ou SENSOR_SUMMARY_MS): %d ms "
+                "(padrão), 0 desliga\n",
+                MQ_NAME, TELEMETRY_INTERVAL_MS);
         fprintf(stderr, "\nExemplo: %s 1 0  (sensor ID 1, tipo TEMPERATURA)\n",
                 argv[0]);
         fprintf(stderr, "\nNota: Este programa normalmente é executado pelo "
@@ -28,8 +75,8 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
-    int sensor_id = atoi(argv[1]);
-    sensor_type_t sensor_type = (sensor_type_t) atoi(argv[2]);
+    int sensor_id = atoi(argv[optind]);
+    sensor_type_t sensor_type = (sensor_type_t) atoi(argv[optind + 1]);
 
     // Configurar handler de sinais
     signal(SIGTERM, signal_handler);
@@ -39,112 +86,181 @@ int main(int argc, char *argv[])
     snprintf(component, sizeof(component), "SENSOR-%d", sensor_id);
     log_message(COLOR_GREEN, component, "Processo iniciado");
 
-    // Aguardar FIFO ser criado e ter um leitor
-    int fifo_fd = -1;
-    int retries = 20; // Aumentar tentativas
-    while (retries-- > 0 &&
-           (fifo_fd = open(FIFO_SENSOR_DATA, O_WRONLY | O_NONBLOCK)) == -1) {
-        if (errno == ENOENT) {
-            // FIFO não existe ainda, aguardar
-            msleep(500);
-        } else if (errno == ENXIO) {
-            // FIFO existe mas não há leitor, aguardar
-            msleep(500);
-        } else {
-            // Outro erro, tentar novamente
-            msleep(500);
-        }
+    // Conectar ao data_processor (ring compartilhado ou FIFO)
+    sample_writer_t writer;
+    if (sample_writer_open(&writer, transport, component) == -1) {
+        exit(1);
     }
 
-    // Se ainda não conseguiu abrir, tentar modo bloqueante uma última vez
-    if (fifo_fd == -1) {
-        log_message(COLOR_YELLOW, component,
-                    "Aguardando leitor do FIFO (data_processor)...");
-        fifo_fd = open(FIFO_SENSOR_DATA, O_WRONLY);
-        if (fifo_fd == -1) {
-            if (errno == ENXIO) {
-                fprintf(stderr,
-                        "Erro: FIFO existe mas não há leitor. Execute "
-                        "'data_processor' primeiro ou use 'sensor_system' para "
-                        "iniciar todo o sistema.\n");
-            } else {
-                perror("Erro ao abrir FIFO");
-            }
-            exit(1);
-        }
-    } else {
-        // Se abriu em modo non-blocking, mudar para bloqueante
-        int flags = fcntl(fifo_fd, F_GETFL);
-        fcntl(fifo_fd, F_SETFL, flags & ~O_NONBLOCK);
+    char conn_msg[96];
+    snprintf(conn_msg, sizeof(conn_msg), "Conectado via %s",
+             transport_mode_name(transport));
+    log_message(COLOR_GREEN, component, conn_msg);
+
+    // Perfil de tempo real da configuração do sistema (SENSOR_CONFIG)
+    system_config_t config;
+    system_config_default(&config);
+    if (system_config_load(&config, NULL) == -1) {
+        sample_writer_close(&writer);
+        exit(1);
     }
+    sample_writer_set_backlog(&writer, config.sensor_backlog);
 
-    // Abrir fila de mensagens POSIX
-    mqd_t mq = mq_open(MQ_NAME, O_WRONLY);
+    // Abrir fila de telemetria (não bloqueante: fila cheia não pode atrasar a
+    // amostragem). Leva só resumos periódicos e eventos, não as amostras.
+    mqd_t mq = telemetry_mq_open(O_WRONLY | O_NONBLOCK, 0);
     if (mq == (mqd_t) -1) {
         perror("Erro ao abrir fila de mensagens");
-        close(fifo_fd);
+        sample_writer_close(&writer);
         exit(1);
     }
 
+    // Contadores ao vivo (sensor_top)
+    char metrics_label[METRICS_NAME_LEN];
+    snprintf(metrics_label, sizeof(metrics_label), "sensor-%d", sensor_id);
+    metrics_slot_t *metrics = metrics_register(metrics_label);
+
+    // Configuração dinâmica (control_interface): sem ela o sensor segue com
+    // os parâmetros da linha de comando
+    live_config_t *live_config = live_config_open();
+    live_sensor_view_t live;
+    live_view_defaults(&live);
+    double current_rate = rate_hz;
+
+    telemetry_window_t window;
+    telemetry_window_init(&window, sensor_id, sensor_type, summary_ms,
+                          monotonic_ns());
+    telemetry_send_event(mq, TELEMETRY_EVENT_SENSOR_START, sensor_id,
+                         sensor_type, (float) rate_hz, NULL, MQ_PRIO_EVENT);
+
+    // Conectado: contar no ponto de encontro (tempo de partida da frota)
+    sample_writer_announce(&writer, 1);
+
     // Simular coleta de dados do sensor
-    float base_value = 0.0;
-    switch (sensor_type) {
-    case SENSOR_TEMPERATURE:
-        base_value = 25.0; // 25°C
-        break;
-    case SENSOR_HUMIDITY:
-        base_value = 60.0; // 60%
-        break;
-    case SENSOR_PRESSURE:
-        base_value = 1013.25; // hPa
-        break;
-    default:
-        base_value = 0.0;
+    float base_value = sensor_base_value(sensor_type);
+    uint32_t rng_state = (uint32_t) getpid() * 2654435761u + 1;
+
+    // Tempo real: travar a memória com tudo já mapeado e pré-carregar o
+    // ring antes da primeira leitura
+    if (config.rt.enabled) {
+        rt_lock_memory(&config.rt, component);
+        if (config.rt.lock_memory) {
+            rt_prefault(writer.shm, writer.shm_bytes, 1);
+        }
+        rt_apply_thread(&config.rt, RT_ROLE_SENSOR, -1, component);
     }
 
+    // Amostragem por deadlines absolutos (sem deriva)
+    sampler_t sampler;
+    sampler_init(&sampler, rate_hz);
+    char stats[192];
+
+    // Logar cerca de uma leitura por segundo, no mínimo a cada 10
+    int log_every = rate_hz > 10.0 ? (int) rate_hz : 10;
+
     int count = 0;
     while (running) {
+        // Uma leitura atômica por iteração no caso comum (nada mudou)
+        if (live_config_poll(live_config, sensor_id, &live)) {
+            double new_rate = live.rate_hz > 0.0f ? live.rate_hz : rate_hz;
+            if (new_rate != current_rate &&
+                sampler_set_rate(&sampler, new_rate) == 0) {
+                current_rate = new_rate;
+                log_event(LOG_INFO, COLOR_GREEN, component,
+                          "Taxa de amostragem: %.2f Hz", new_rate);
+            }
+            log_event(LOG_INFO, COLOR_GREEN, component,
+                      "Configuração: %s (ganho=%.3f, offset=%.3f)",
+                      live.enabled ? "ativo" : "pausado", live.gain,
+                      live.offset);
+            telemetry_send_event(mq, TELEMETRY_EVENT_SENSOR_CONFIG, sensor_id,
+                                 sensor_type, (float) current_rate, NULL,
+                                 MQ_PRIO_EVENT);
+        }
+        if (!live.enabled) {
+            sampler_wait(&sampler); // Pausado: manter o agendamento
+            continue;
+        }
+
         // Simular variação de leitura
-        float variation = ((float) rand() / RAND_MAX) * 5.0 - 2.5;
-        float value = base_value + variation;
+        float value = live_calibrate(&live, sensor_simulate(base_value,
+                                                            &rng_state));
 
         sensor_data_t data = {.type = sensor_type,
                               .sensor_id = sensor_id,
                               .value = value,
                               .timestamp = time(NULL),
-                              .active = 1};
+                              .active = 1,
+                              .t_created = monotonic_ns()};
 
-        // Enviar via FIFO (pipe nomeado)
-        if (write(fifo_fd, &data, sizeof(sensor_data_t)) == -1) {
-            perror("Erro ao escrever no FIFO");
+        // Enviar via ring compartilhado (ou FIFO no modo alternativo)
+        int rc;
+        int ring_full = 0;
+        while ((rc = sample_writer_send(&writer, &data)) == -1 &&
+               errno == EAGAIN && running) {
+            // Ring cheio: aguardar consumidores
+            ring_full = 1;
+        }
+        metrics_add(metrics, METRIC_RING_FULL, (uint64_t) ring_full);
+        if (rc == -1 && errno != EAGAIN) {
+            perror("Erro ao enviar amostra");
             break;
         }
+        // rc == 0: tratada pela política de sobrecarga (contada abaixo);
+        // rc > 1: publicou também amostras retidas antes
+        metrics_add(metrics, METRIC_SAMPLES_SENT, rc > 0 ? (uint64_t) rc : 0);
+        metrics_add(metrics, METRIC_SAMPLES_DROPPED, (uint64_t) (rc == -1));
+        overload_report(&writer.overload, metrics);
+        metrics_set(metrics, METRIC_BACKLOG, sample_writer_backlog(&writer));
+        metrics_touch(metrics, data.t_created);
 
-        // Enviar via fila de mensagens POSIX (alternativa)
-        char msg[MAX_MESSAGE_SIZE];
-        snprintf(msg, sizeof(msg), "SENSOR-%d:%.2f", sensor_id, value);
-        if (mq_send(mq, msg, strlen(msg) + 1, 0) == -1) {
-            if (errno != EAGAIN) {
-                perror("Erro ao enviar mensagem");
+        // Resumo da janela na fila de telemetria quando o intervalo vence
+        if (telemetry_window_add(&window, value, data.t_created)) {
+            if (telemetry_window_flush(&window, mq, data.t_created) == 0) {
+                metrics_add(metrics, METRIC_MQ_SENT, 1);
+            } else {
+                if (errno != EAGAIN) {
+                    perror("Erro ao enviar resumo");
+                }
+                metrics_add(metrics, METRIC_MQ_DROPPED, 1);
             }
         }
 
         count++;
-        if (count % 10 == 0) {
-            char log_msg[128];
-            snprintf(log_msg, sizeof(log_msg), "%s: %.2f (leitura #%d)",
-                     sensor_type_name(sensor_type), value, count);
-            log_message(COLOR_GREEN, component, log_msg);
+        if (count % log_every == 0) {
+            log_event(LOG_INFO, COLOR_GREEN, component,
+                      "%s: %.2f (leitura #%d)", sensor_type_name(sensor_type),
+                      value, count);
+        }
+        if (count % (log_every * 10) == 0) {
+            sampler_format_stats(&sampler, stats, sizeof(stats));
+            log_event(LOG_INFO, COLOR_GREEN, component, "Amostragem: %s",
+                      stats);
         }
 
-        // Simular intervalo de leitura (1 segundo)
-        sleep(1);
+        // Aguardar o próximo deadline absoluto
+        sampler_wait(&sampler);
+    }
+
+    // Último resumo (janela parcial) e aviso de parada
+    if (window.interval_ns != 0 &&
+        telemetry_window_flush(&window, mq, monotonic_ns()) == 0) {
+        metrics_add(metrics, METRIC_MQ_SENT, 1);
     }
+    telemetry_send_event(mq, TELEMETRY_EVENT_SENSOR_STOP, sensor_id,
+                         sensor_type, 0.0f, NULL, MQ_PRIO_EVENT);
 
-    log_message(COLOR_YELLOW, component, "Encerrando processo...");
+    sampler_format_stats(&sampler, stats, sizeof(stats));
+    log_event(LOG_INFO, COLOR_YELLOW, component,
+              "Encerrando processo... (amostragem: %s; resumos: %llu "
+              "enviados, %llu adiados)",
+              stats, (unsigned long long) window.sent,
+              (unsigned long long) window.deferred);
 
-    close(fifo_fd);
+    sample_writer_close(&writer);
     mq_close(mq);
+    live_config_close(live_config);
+    metrics_unregister(metrics);
 
     return 0;
 }
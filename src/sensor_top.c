@@ -0,0 +1,270 @@
+#include "common.h"
+#include "latency.h"
+#include "metrics.h"
+#include "transport.h"
+
+// Monitor ao vivo: lê as métricas publicadas pelos componentes em memória
+// compartilhada e os histogramas de latência do data_processor. Apenas lê
+// os segmentos, então pode atualizar em alta frequência sem afetar o
+// caminho dos dados nem depender da control_interface.
+
+// Métricas mostradas em colunas próprias (as demais vão em "outros")
+static const metric_id_t columns[] = {
+    METRIC_SAMPLES_SENT,   METRIC_SAMPLES_RECEIVED, METRIC_SAMPLES_DROPPED,
+    METRIC_RING_FULL,      METRIC_MQ_DROPPED,       METRIC_QUEUE_DEPTH,
+    METRIC_ALARMS,
+};
+#define NCOLUMNS ((int) (sizeof(columns) / sizeof(columns[0])))
+
+// Cópia de um slot em um instante
+typedef struct {
+    int active;
+    int32_t pid;
+    char name[METRICS_NAME_LEN];
+    uint64_t started_ns;
+    uint64_t last_seen_ns;
+    uint64_t values[METRIC_COUNT];
+} slot_snapshot_t;
+
+static slot_snapshot_t current[METRICS_MAX_SLOTS];
+static slot_snapshot_t previous[METRICS_MAX_SLOTS];
+
+volatile sig_atomic_t running = 1;
+
+void signal_handler(int sig)
+{
+    if (sig == SIGTERM || sig == SIGINT) {
+        running = 0;
+    }
+}
+
+static void take_snapshot(const metrics_shm_t *shm)
+{
+    for (uint32_t i = 0; i < METRICS_MAX_SLOTS; i++) {
+        const metrics_slot_t *slot = &shm->slots[i];
+        slot_snapshot_t *snap = &current[i];
+        snap->active =
+            atomic_load_explicit(&slot->ready, memory_order_acquire) != 0;
+        if (!snap->active) {
+            continue;
+        }
+        snap->pid = atomic_load_explicit(&slot->owner, memory_order_relaxed);
+        memcpy(snap->name, slot->name, sizeof(snap->name));
+        snap->name[sizeof(snap->name) - 1] = '\0';
+        snap->started_ns = slot->started_ns;
+        snap->last_seen_ns =
+            atomic_load_explicit(&slot->last_seen_ns, memory_order_relaxed);
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            snap->values[m] =
+                atomic_load_explicit(&slot->values[m], memory_order_relaxed);
+        }
+    }
+}
+
+// Coluna: taxa por segundo para amostras, valor atual para os demais
+static void format_column(const slot_snapshot_t *now,
+                          const slot_snapshot_t *before, metric_id_t id,
+                          double interval_s, char *buf, size_t len)
+{
+    uint64_t value = now->values[id];
+    if (id != METRIC_SAMPLES_SENT && id != METRIC_SAMPLES_RECEIVED) {
+        snprintf(buf, len, "%llu", (unsigned long long) value);
+    } else if (before == NULL) {
+        snprintf(buf, len, "-/s"); // Primeira leitura do slot
+    } else {
+        uint64_t delta = value - before->values[id];
+        snprintf(buf, len, "%.0f/s", (double) delta / interval_s);
+    }
+}
+
+static void print_metrics(double interval_s, uint64_t now_ns)
+{
+    printf("%-16s %7s %-6s %6s", "componente", "pid", "estado", "idade");
+    for (int c = 0; c < NCOLUMNS; c++) {
+        printf(" %11s", metrics_name(columns[c]));
+    }
+    printf("  outros\n");
+
+    int shown = 0;
+    for (uint32_t i = 0; i < METRICS_MAX_SLOTS; i++) {
+        const slot_snapshot_t *snap = &current[i];
+        if (!snap->active) {
+            continue;
+        }
+        // Taxas só fazem sentido se o slot não foi reaproveitado
+        const slot_snapshot_t *before =
+            previous[i].active && previous[i].started_ns == snap->started_ns
+                ? &previous[i]
+                : NULL;
+
+        int alive = kill(snap->pid, 0) == 0 || errno != ESRCH;
+        double age_s = now_ns > snap->last_seen_ns
+                           ? (double) (now_ns - snap->last_seen_ns) / 1e9
+                           : 0.0;
+        printf("%-16s %7d %-6s %5.1fs", snap->name, (int) snap->pid,
+               alive ? "ativo" : "morto", age_s);
+
+        for (int c = 0; c < NCOLUMNS; c++) {
+            char cell[32];
+            format_column(snap, before, columns[c], interval_s, cell,
+                          sizeof(cell));
+            printf(" %11s", cell);
+        }
+
+        printf(" ");
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            int in_columns = 0;
+            for (int c = 0; c < NCOLUMNS; c++) {
+                in_columns |= columns[c] == (metric_id_t) m;
+            }
+            if (!in_columns && snap->values[m] != 0) {
+                printf(" %s=%llu", metrics_name((metric_id_t) m),
+                       (unsigned long long) snap->values[m]);
+            }
+        }
+        printf("\n");
+        shown++;
+    }
+
+    if (shown == 0) {
+        printf("(nenhum componente registrado)\n");
+    }
+}
+
+static void print_ingest(void)
+{
+    // Reabrir a cada atualização: o data_processor recria o segmento
+    sample_shm_t *shm = (sample_shm_t *) sample_shm_open_readonly();
+    if (shm == NULL) {
+        printf("\nIngestão: data_processor não encontrado\n");
+        return;
+    }
+
+    char policy[32];
+    overload_format(&shm->overload, policy, sizeof(policy));
+    printf("\nIngestão (sobrecarga: %s, marcas %u/%u de %u):\n", policy,
+           shm->overload.high_mark, shm->overload.low_mark, shm->capacity);
+    printf("  %-5s %6s %-10s %7s", "shard", "fila", "estado", "eventos");
+    for (int r = 0; r < OVERLOAD_DROP_COUNT; r++) {
+        printf(" %11s", overload_drop_name((overload_drop_t) r));
+    }
+    printf("\n");
+
+    for (uint32_t s = 0; s < shm->nshards; s++) {
+        const overload_shard_t *ov = &shm->overload_shards[s];
+        printf("  %-5u %6u %-10s %7u", s, ring_depth(sample_shm_ring(shm, s)),
+               atomic_load_explicit(&ov->overloaded, memory_order_relaxed)
+                   ? "sobrecarga"
+                   : "normal",
+               atomic_load_explicit(&ov->high_events, memory_order_relaxed));
+        for (int r = 0; r < OVERLOAD_DROP_COUNT; r++) {
+            printf(" %11llu", (unsigned long long) sample_shm_drops(
+                                  shm, s, (overload_drop_t) r));
+        }
+        printf("\n");
+    }
+    sample_shm_close(shm);
+}
+
+static void print_latency(void)
+{
+    // Reabrir a cada atualização: o data_processor recria o segmento
+    latency_shm_t *shm = latency_shm_open();
+    if (shm == NULL) {
+        printf("\nLatência: data_processor não encontrado\n");
+        return;
+    }
+
+    printf("\nLatência (todos os tipos):\n");
+    static latency_snapshot_t snap;
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        memset(&snap, 0, sizeof(snap));
+        latency_collect(shm, (latency_stage_t) stage, -1, &snap);
+        char line[192];
+        latency_format(&snap, line, sizeof(line));
+        printf("  %-18s %s\n", latency_stage_name((latency_stage_t) stage),
+               line);
+    }
+    latency_shm_close(shm);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Uso: %s [-i intervalo_ms] [-n atualizações] [-b]\n",
+            prog);
+    fprintf(stderr, "\n  -i  intervalo entre atualizações (padrão: 1000 ms, "
+                    "mín. 10)\n");
+    fprintf(stderr, "  -n  encerra após n atualizações (padrão: contínuo)\n");
+    fprintf(stderr, "  -b  modo texto: não limpa a tela (para logs/pipes)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    long interval_ms = 1000;
+    long iterations = 0;
+    int batch_mode = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:bh")) != -1) {
+        switch (opt) {
+        case 'i':
+            interval_ms = atol(optarg);
+            break;
+        case 'n':
+            iterations = atol(optarg);
+            break;
+        case 'b':
+            batch_mode = 1;
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (interval_ms < 10 || iterations < 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    signal(SIGTERM, signal_handler);
+    signal(SIGINT, signal_handler);
+
+    const metrics_shm_t *shm = NULL;
+    uint64_t last_ns = monotonic_ns();
+
+    for (long n = 0; running && (iterations == 0 || n < iterations); n++) {
+        if (n > 0) {
+            msleep((int) interval_ms);
+        }
+
+        if (shm == NULL) {
+            shm = metrics_shm_open_readonly();
+        }
+
+        uint64_t now_ns = monotonic_ns();
+        double interval_s = (double) (now_ns - last_ns) / 1e9;
+        last_ns = now_ns;
+
+        if (!batch_mode) {
+            printf("\033[H\033[2J"); // Cursor no topo e limpar tela
+        }
+        time_t wall = time(NULL);
+        printf("sensor_top - %s", ctime(&wall));
+
+        if (shm == NULL) {
+            printf("Métricas indisponíveis (%s ainda não criado)\n",
+                   METRICS_SHM_NAME);
+        } else {
+            take_snapshot(shm);
+            print_metrics(interval_s, now_ns);
+            memcpy(previous, current, sizeof(previous));
+        }
+        print_ingest();
+        print_latency();
+        printf("\n");
+        fflush(stdout);
+    }
+
+    metrics_shm_close(shm);
+    return 0;
+}
@@ -0,0 +1,285 @@
+#include "common.h"
+#include "stats.h"
+
+#include <stddef.h>
+
+#define STATS_SHM_MAGIC 0x53544154u // "TATS"
+
+// Deslocamentos de cada array dentro de uma tabela
+typedef struct {
+    size_t seq;
+    size_t type;
+    size_t count;
+    size_t min;
+    size_t max;
+    size_t mean;
+    size_t m2;
+    size_t ewma;
+    size_t last_value;
+    size_t last_ns;
+    size_t sec;
+    size_t tensec;
+    size_t total;
+} stats_layout_t;
+
+static void stats_layout(uint32_t capacity, stats_layout_t *l)
+{
+    size_t off = 0;
+    size_t n = capacity;
+
+    l->seq = off;
+    off = shm_align(off + n * sizeof(uint32_t));
+    l->type = off;
+    off = shm_align(off + n * sizeof(uint8_t));
+    l->count = off;
+    off = shm_align(off + n * sizeof(uint64_t));
+    l->min = off;
+    off = shm_align(off + n * sizeof(float));
+    l->max = off;
+    off = shm_align(off + n * sizeof(float));
+    l->mean = off;
+    off = shm_align(off + n * sizeof(double));
+    l->m2 = off;
+    off = shm_align(off + n * sizeof(double));
+    l->ewma = off;
+    off = shm_align(off + n * sizeof(float));
+    l->last_value = off;
+    off = shm_align(off + n * sizeof(float));
+    l->last_ns = off;
+    off = shm_align(off + n * sizeof(uint64_t));
+    l->sec = off;
+    off = shm_align(off + n * STATS_SEC_BUCKETS * sizeof(stats_bucket_t));
+    l->tensec = off;
+    off = shm_align(off + n * STATS_TENSEC_BUCKETS * sizeof(stats_bucket_t));
+    l->total = off;
+}
+
+stats_shm_t *stats_shm_create(uint32_t capacity, uint32_t ntables)
+{
+    stats_layout_t layout;
+    stats_layout(capacity, &layout);
+    size_t table_offset = shm_align(sizeof(stats_shm_t));
+    size_t total = table_offset + (size_t) ntables * layout.total;
+
+    // Segmento zerado: count == 0 significa "sem dados"
+    stats_shm_t *shm =
+        shm_table_create(STATS_SHM_NAME, total, "de estatísticas");
+    if (shm == NULL) {
+        return NULL;
+    }
+
+    shm->capacity = capacity;
+    shm->ntables = ntables;
+    shm->total_bytes = total;
+    shm->table_offset = table_offset;
+    shm->table_bytes = layout.total;
+    shm_table_publish(shm, STATS_SHM_MAGIC);
+
+    return shm;
+}
+
+stats_shm_t *stats_shm_open(void)
+{
+    return shm_table_open(STATS_SHM_NAME, sizeof(stats_shm_t),
+                          STATS_SHM_MAGIC,
+                          offsetof(stats_shm_t, total_bytes));
+}
+
+void stats_shm_close(stats_shm_t *shm)
+{
+    if (shm != NULL) {
+        munmap(shm, shm->total_bytes);
+    }
+}
+
+void stats_table_view(stats_shm_t *shm, uint32_t index, stats_table_t *table)
+{
+    stats_layout_t l;
+    stats_layout(shm->capacity, &l);
+    char *base =
+        (char *) shm + shm->table_offset + (size_t) index * shm->table_bytes;
+
+    table->capacity = shm->capacity;
+    table->seq = (_Atomic uint32_t *) (base + l.seq);
+    table->type = (uint8_t *) (base + l.type);
+    table->count = (uint64_t *) (base + l.count);
+    table->min = (float *) (base + l.min);
+    table->max = (float *) (base + l.max);
+    table->mean = (double *) (base + l.mean);
+    table->m2 = (double *) (base + l.m2);
+    table->ewma = (float *) (base + l.ewma);
+    table->last_value = (float *) (base + l.last_value);
+    table->last_ns = (uint64_t *) (base + l.last_ns);
+    table->sec = (stats_bucket_t *) (base + l.sec);
+    table->tensec = (stats_bucket_t *) (base + l.tensec);
+}
+
+void stats_update(stats_table_t *table, const sensor_data_t *data,
+                  uint64_t now_ns)
+{
+    uint32_t id = (uint32_t) data->sensor_id;
+    if (id >= table->capacity) {
+        return;
+    }
+
+    uint32_t seq = seqlock_write_begin(&table->seq[id]);
+
+    float v = data->value;
+    uint64_t n = ++table->count[id];
+    if (n == 1) {
+        table->min[id] = v;
+        table->max[id] = v;
+        table->mean[id] = v;
+        table->m2[id] = 0.0;
+        table->ewma[id] = v;
+    } else {
+        if (v < table->min[id]) {
+            table->min[id] = v;
+        }
+        if (v > table->max[id]) {
+            table->max[id] = v;
+        }
+        // Welford
+        double delta = v - table->mean[id];
+        table->mean[id] += delta / (double) n;
+        table->m2[id] += delta * (v - table->mean[id]);
+        table->ewma[id] += STATS_EWMA_ALPHA * (v - table->ewma[id]);
+    }
+    table->type[id] = (uint8_t) data->type;
+    table->last_value[id] = v;
+    table->last_ns[id] = now_ns;
+
+    uint32_t epoch = (uint32_t) (now_ns / 1000000000ull);
+    stats_bucket_add(&table->sec[(size_t) id * STATS_SEC_BUCKETS +
+                           epoch % STATS_SEC_BUCKETS],
+               epoch, v);
+    uint32_t epoch10 = epoch / 10;
+    stats_bucket_add(&table->tensec[(size_t) id * STATS_TENSEC_BUCKETS +
+                              epoch10 % STATS_TENSEC_BUCKETS],
+               epoch10, v);
+
+    seqlock_write_end(&table->seq[id], seq);
+}
+
+// Cópia bruta de um sensor de uma tabela (consistente via seqlock)
+typedef struct {
+    stats_snapshot_t snap;
+    stats_bucket_t sec[STATS_SEC_BUCKETS];
+    stats_bucket_t tensec[STATS_TENSEC_BUCKETS];
+} stats_raw_t;
+
+static void read_table(stats_table_t *t, uint32_t id, stats_raw_t *raw)
+{
+    int attempts = 0;
+    uint32_t s1;
+    do {
+        s1 = seqlock_read_begin(&t->seq[id], &attempts);
+        raw->snap.type = (sensor_type_t) t->type[id];
+        raw->snap.count = t->count[id];
+        raw->snap.min = t->min[id];
+        raw->snap.max = t->max[id];
+        raw->snap.mean = t->mean[id];
+        raw->snap.m2 = t->m2[id];
+        raw->snap.ewma = t->ewma[id];
+        raw->snap.last_value = t->last_value[id];
+        raw->snap.last_ns = t->last_ns[id];
+        memcpy(raw->sec, &t->sec[(size_t) id * STATS_SEC_BUCKETS],
+               sizeof(raw->sec));
+        memcpy(raw->tensec, &t->tensec[(size_t) id * STATS_TENSEC_BUCKETS],
+               sizeof(raw->tensec));
+    } while (!seqlock_read_end(&t->seq[id], s1, &attempts));
+}
+
+// Acumula baldes cujo epoch está em (now - span, now]
+static void window_add(stats_window_t *win, double *sum,
+                       const stats_bucket_t *buckets, int nbuckets,
+                       uint32_t now_epoch, uint32_t span)
+{
+    for (int b = 0; b < nbuckets; b++) {
+        const stats_bucket_t *bucket = &buckets[b];
+        if (bucket->count == 0 || bucket->epoch > now_epoch ||
+            now_epoch - bucket->epoch >= span) {
+            continue;
+        }
+        if (win->count == 0 || bucket->min < win->min) {
+            win->min = bucket->min;
+        }
+        if (win->count == 0 || bucket->max > win->max) {
+            win->max = bucket->max;
+        }
+        win->count += bucket->count;
+        *sum += bucket->sum;
+    }
+}
+
+int stats_query(stats_shm_t *shm, int sensor_id, uint64_t now_ns,
+                stats_snapshot_t *out)
+{
+    if (sensor_id < 0 || (uint32_t) sensor_id >= shm->capacity) {
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+    uint32_t epoch = (uint32_t) (now_ns / 1000000000ull);
+    double sum_1s = 0.0, sum_10s = 0.0, sum_60s = 0.0;
+
+    for (uint32_t i = 0; i < shm->ntables; i++) {
+        stats_table_t table;
+        stats_table_view(shm, i, &table);
+
+        stats_raw_t raw;
+        read_table(&table, (uint32_t) sensor_id, &raw);
+        if (raw.snap.count == 0) {
+            continue;
+        }
+
+        if (out->count == 0) {
+            stats_window_t w1 = out->win_1s, w10 = out->win_10s,
+                           w60 = out->win_60s;
+            *out = raw.snap;
+            out->win_1s = w1;
+            out->win_10s = w10;
+            out->win_60s = w60;
+        } else {
+            // Combinação de Welford entre tabelas (Chan et al.)
+            double n1 = (double) out->count, n2 = (double) raw.snap.count;
+            double n = n1 + n2;
+            double delta = raw.snap.mean - out->mean;
+            out->mean += delta * n2 / n;
+            out->m2 += raw.snap.m2 + delta * delta * n1 * n2 / n;
+            out->count += raw.snap.count;
+            if (raw.snap.min < out->min) {
+                out->min = raw.snap.min;
+            }
+            if (raw.snap.max > out->max) {
+                out->max = raw.snap.max;
+            }
+            if (raw.snap.last_ns > out->last_ns) {
+                out->last_ns = raw.snap.last_ns;
+                out->last_value = raw.snap.last_value;
+                out->ewma = raw.snap.ewma;
+                out->type = raw.snap.type;
+            }
+        }
+
+        window_add(&out->win_1s, &sum_1s, raw.sec, STATS_SEC_BUCKETS, epoch,
+                   1);
+        window_add(&out->win_10s, &sum_10s, raw.sec, STATS_SEC_BUCKETS, epoch,
+                   10);
+        window_add(&out->win_60s, &sum_60s, raw.tensec, STATS_TENSEC_BUCKETS,
+                   epoch / 10, STATS_TENSEC_BUCKETS);
+    }
+
+    if (out->count == 0) {
+        return -1;
+    }
+
+    out->variance = out->count > 1 ? out->m2 / (double) (out->count - 1) : 0.0;
+    out->win_1s.avg = out->win_1s.count ? (float) (sum_1s / out->win_1s.count)
+                                        : 0.0f;
+    out->win_10s.avg =
+        out->win_10s.count ? (float) (sum_10s / out->win_10s.count) : 0.0f;
+    out->win_60s.avg =
+        out->win_60s.count ? (float) (sum_60s / out->win_60s.count) : 0.0f;
+    return 0;
+}
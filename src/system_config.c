@@ -0,0 +1,226 @@
+#include "system_config.h"
+#include "transport.h"
+
+#include <ctype.h>
+#include <stddef.h>
+
+// Chaves do arquivo: campo, tipo e faixa válida
+typedef enum { KEY_U32, KEY_BOOL, KEY_RATE, KEY_RT_THREAD } key_kind_t;
+
+typedef struct {
+    const char *name;
+    size_t offset;
+    key_kind_t kind;
+    uint32_t min;
+    uint32_t max;
+} config_key_t;
+
+#define KEY(field, kind, min, max)                                             \
+    {#field, offsetof(system_config_t, field), kind, min, max}
+#define KEY_AS(name, field, kind)                                              \
+    {name, offsetof(system_config_t, field), kind, 0, 0}
+
+static const config_key_t keys[] = {
+    KEY(ring_capacity, KEY_U32, 2, 1u << 24),
+    KEY(shards, KEY_U32, 0, SAMPLE_MAX_SHARDS),
+    KEY(consumers, KEY_U32, 0, SAMPLE_MAX_SHARDS),
+    KEY(adaptive, KEY_BOOL, 0, 1),
+    KEY(consumers_min, KEY_U32, 1, SAMPLE_MAX_SHARDS),
+    KEY(consumers_max, KEY_U32, 0, SAMPLE_MAX_SHARDS),
+    KEY(adapt_interval_ms, KEY_U32, 10, 60000),
+    KEY(grow_depth_pct, KEY_U32, 1, 100),
+    KEY(shrink_depth_pct, KEY_U32, 0, 100),
+    KEY(grow_busy_pct, KEY_U32, 1, 100),
+    KEY(shrink_busy_pct, KEY_U32, 0, 100),
+    KEY(net_ingest, KEY_BOOL, 0, 1),
+    KEY(sensors, KEY_U32, 0, 1000000),
+    KEY(host_mode, KEY_BOOL, 0, 1),
+    KEY(host_procs, KEY_U32, 0, 4096),
+    KEY(sensor_rate_hz, KEY_RATE, 0, 0),
+    KEY(sensor_backlog, KEY_U32, 0, 1u << 24),
+    KEY(mq_depth, KEY_U32, 0, 65536),
+    KEY(run_s, KEY_U32, 0, 86400 * 365),
+    KEY_AS("rt", rt.enabled, KEY_BOOL),
+    KEY_AS("rt_mlock", rt.lock_memory, KEY_BOOL),
+    KEY_AS("rt_hugepages", rt.hugepages, KEY_BOOL),
+    KEY_AS("rt_supervisor", rt.roles[RT_ROLE_SUPERVISOR], KEY_RT_THREAD),
+    KEY_AS("rt_sensor", rt.roles[RT_ROLE_SENSOR], KEY_RT_THREAD),
+    KEY_AS("rt_producer", rt.roles[RT_ROLE_PRODUCER], KEY_RT_THREAD),
+    KEY_AS("rt_consumer", rt.roles[RT_ROLE_CONSUMER], KEY_RT_THREAD),
+};
+
+void system_config_default(system_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->ring_capacity = 128;
+    config->consumers_min = 1;
+    config->adapt_interval_ms = 500;
+    config->grow_depth_pct = 50;
+    config->shrink_depth_pct = 10;
+    config->grow_busy_pct = 80;
+    config->shrink_busy_pct = 30;
+    config->sensor_rate_hz = 1.0;
+    config->sensor_backlog = 4096;
+    config->run_s = 30;
+    rt_profile_default(&config->rt);
+}
+
+static int parse_bool(const char *value, int *out)
+{
+    if (strcmp(value, "on") == 0 || strcmp(value, "1") == 0 ||
+        strcmp(value, "sim") == 0) {
+        *out = 1;
+    } else if (strcmp(value, "off") == 0 || strcmp(value, "0") == 0 ||
+               strcmp(value, "nao") == 0) {
+        *out = 0;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int system_config_set(system_config_t *config, const char *assignment)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", assignment);
+    char *eq = strchr(buf, '=');
+    if (eq == NULL) {
+        return -1;
+    }
+    // "chave = valor": espaços em volta do '=' são opcionais
+    char *key_end = eq;
+    while (key_end > buf && isspace((unsigned char) key_end[-1])) {
+        key_end--;
+    }
+    *key_end = '\0';
+    char *value = eq + 1;
+    while (isspace((unsigned char) *value)) {
+        value++;
+    }
+
+    for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+        if (strcmp(buf, keys[k].name) != 0) {
+            continue;
+        }
+        char *field = (char *) config + keys[k].offset;
+        char *end;
+        switch (keys[k].kind) {
+        case KEY_BOOL:
+            return parse_bool(value, (int *) field);
+        case KEY_RT_THREAD:
+            return rt_thread_parse(value, (rt_thread_config_t *) field);
+        case KEY_RATE: {
+            double hz = strtod(value, &end);
+            if (end == value || *end != '\0' || hz <= 0.0 || hz > 100000.0) {
+                return -1;
+            }
+            *(double *) field = hz;
+            return 0;
+        }
+        case KEY_U32: {
+            unsigned long n = strtoul(value, &end, 10);
+            if (end == value || *end != '\0' || *value == '-' ||
+                n < keys[k].min || n > keys[k].max) {
+                return -1;
+            }
+            *(uint32_t *) field = (uint32_t) n;
+            return 0;
+        }
+        }
+    }
+    return -1;
+}
+
+int system_config_load(system_config_t *config, const char *path)
+{
+    int explicit = path != NULL;
+    if (path == NULL) {
+        path = getenv(SYSTEM_CONFIG_ENV);
+        explicit = path != NULL;
+    }
+    if (path == NULL) {
+        path = SYSTEM_CONFIG_DEFAULT_PATH;
+    }
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        if (!explicit && errno == ENOENT) {
+            return 0;
+        }
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    int lineno = 0;
+    int rc = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+        char *p = line;
+        while (isspace((unsigned char) *p)) {
+            p++;
+        }
+        size_t len = strlen(p);
+        while (len > 0 && isspace((unsigned char) p[len - 1])) {
+            p[--len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+        if (system_config_set(config, p) == -1) {
+            fprintf(stderr, "%s:%d: configuração inválida: %s\n", path,
+                    lineno, p);
+            rc = -1;
+            break;
+        }
+    }
+    fclose(f);
+    if (rc == 0 && config->host_mode &&
+        config->sensor_rate_hz > SENSOR_HOST_MAX_RATE_HZ) {
+        fprintf(stderr,
+                "%s: sensor_rate_hz = %g acima do limite de %g Hz dos "
+                "hospedeiros (host_mode)\n",
+                path, config->sensor_rate_hz, SENSOR_HOST_MAX_RATE_HZ);
+        rc = -1;
+    }
+    return rc;
+}
+
+const char *system_config_arg(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            break;
+        }
+        if (strncmp(argv[i], "-C", 2) == 0) {
+            if (argv[i][2] != '\0') {
+                return argv[i] + 2;
+            }
+            return i + 1 < argc ? argv[i + 1] : NULL;
+        }
+    }
+    return NULL;
+}
+
+void system_config_format(const system_config_t *config, char *buf,
+                          size_t len)
+{
+    char consumers[64];
+    if (config->adaptive) {
+        snprintf(consumers, sizeof(consumers), "adaptativo %u-%u",
+                 config->consumers_min, config->consumers_max);
+    } else {
+        snprintf(consumers, sizeof(consumers), "%u", config->consumers);
+    }
+    snprintf(buf, len,
+             "ring de %u amostras, %u shards, consumidores %s, fila de "
+             "telemetria %u, execução %u s%s%s",
+             config->ring_capacity, config->shards, consumers,
+             config->mq_depth, config->run_s,
+             config->net_ingest ? ", ingestão pela rede" : "",
+             config->rt.enabled ? ", tempo real" : "");
+}
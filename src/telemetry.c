@@ -0,0 +1,176 @@
+#include "telemetry.h"
+
+uint32_t telemetry_interval_default(void)
+{
+    const char *env = getenv("SENSOR_SUMMARY_MS");
+    if (env == NULL) {
+        return TELEMETRY_INTERVAL_MS;
+    }
+    char *end;
+    unsigned long ms = strtoul(env, &end, 10);
+    if (end == env || *end != '\0' || ms > 3600000ul) {
+        fprintf(stderr, "SENSOR_SUMMARY_MS inválido: %s (usando %d)\n", env,
+                TELEMETRY_INTERVAL_MS);
+        return TELEMETRY_INTERVAL_MS;
+    }
+    return (uint32_t) ms;
+}
+
+static int64_t wall_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+mqd_t telemetry_mq_open(int flags, uint32_t depth)
+{
+    long maxmsg = depth != 0 ? (long) depth : TELEMETRY_MQ_DEPTH;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        // Profundidade acima de msg_max exige privilégio: cair para o padrão
+        struct mq_attr attr = {.mq_flags = 0,
+                               .mq_maxmsg = maxmsg,
+                               .mq_msgsize = sizeof(telemetry_msg_t)};
+        mqd_t mq = mq_open(MQ_NAME, O_CREAT | flags, 0666, &attr);
+        if (mq == (mqd_t) -1 && errno == EINVAL) {
+            attr.mq_maxmsg = TELEMETRY_MQ_DEPTH_MIN;
+            mq = mq_open(MQ_NAME, O_CREAT | flags, 0666, &attr);
+        }
+        if (mq == (mqd_t) -1) {
+            return mq;
+        }
+
+        // Fila já existente: os atributos pedidos são ignorados
+        struct mq_attr current;
+        if (mq_getattr(mq, &current) == 0 &&
+            current.mq_msgsize == (long) sizeof(telemetry_msg_t)) {
+            return mq;
+        }
+        mq_close(mq);
+        mq_unlink(MQ_NAME); // Fila de uma versão anterior (texto)
+    }
+    errno = EINVAL;
+    return (mqd_t) -1;
+}
+
+void telemetry_window_init(telemetry_window_t *w, int sensor_id,
+                           sensor_type_t type, uint32_t interval_ms,
+                           uint64_t now_ns)
+{
+    memset(w, 0, sizeof(*w));
+    w->sensor_id = sensor_id;
+    w->type = type;
+    w->interval_ns = (uint64_t) interval_ms * 1000000ull;
+    w->start_ns = now_ns;
+    w->due_ns = now_ns + w->interval_ns;
+}
+
+int telemetry_window_flush(telemetry_window_t *w, mqd_t mq, uint64_t now_ns)
+{
+    if (w->count == 0) {
+        w->start_ns = now_ns;
+        w->due_ns = now_ns + w->interval_ns;
+        return 0;
+    }
+
+    // Janela em tempo monotônico, convertida para o relógio de parede
+    int64_t end = wall_ns();
+    telemetry_msg_t msg = {
+        .magic = TELEMETRY_MAGIC,
+        .kind = TELEMETRY_SUMMARY,
+        .sensor_id = w->sensor_id,
+        .type = (uint32_t) w->type,
+        .t_start_ns = end - (int64_t) (now_ns - w->start_ns),
+        .t_end_ns = end,
+        .count = w->count,
+        .min = w->min,
+        .max = w->max,
+        .value = (float) (w->sum / w->count),
+    };
+    if (mq_send(mq, (const char *) &msg, sizeof(msg), MQ_PRIO_SUMMARY) == -1) {
+        w->deferred++;
+        w->due_ns = now_ns + w->interval_ns;
+        return -1;
+    }
+
+    w->sent++;
+    w->count = 0;
+    w->sum = 0.0;
+    w->start_ns = now_ns;
+    w->due_ns = now_ns + w->interval_ns;
+    return 0;
+}
+
+void telemetry_event_init(telemetry_msg_t *msg, telemetry_event_t event,
+                          int sensor_id, sensor_type_t type, float value,
+                          const char *name)
+{
+    memset(msg, 0, sizeof(*msg));
+    msg->magic = TELEMETRY_MAGIC;
+    msg->kind = TELEMETRY_EVENT;
+    msg->event = (uint16_t) event;
+    msg->sensor_id = sensor_id;
+    msg->type = (uint32_t) type;
+    msg->t_start_ns = wall_ns();
+    msg->t_end_ns = msg->t_start_ns;
+    msg->count = 1;
+    msg->min = value;
+    msg->max = value;
+    msg->value = value;
+    if (name != NULL) {
+        snprintf(msg->name, sizeof(msg->name), "%s", name);
+    }
+}
+
+int telemetry_send_event(mqd_t mq, telemetry_event_t event, int sensor_id,
+                         sensor_type_t type, float value, const char *name,
+                         unsigned priority)
+{
+    telemetry_msg_t msg;
+    telemetry_event_init(&msg, event, sensor_id, type, value, name);
+    return mq_send(mq, (const char *) &msg, sizeof(msg), priority);
+}
+
+int telemetry_msg_valid(const telemetry_msg_t *msg, ssize_t bytes)
+{
+    return bytes == (ssize_t) sizeof(*msg) && msg->magic == TELEMETRY_MAGIC &&
+           (msg->kind == TELEMETRY_SUMMARY || msg->kind == TELEMETRY_EVENT);
+}
+
+void telemetry_format(const telemetry_msg_t *msg, char *buf, size_t len)
+{
+    const char *type = sensor_type_name((sensor_type_t) msg->type);
+    if (msg->kind == TELEMETRY_SUMMARY) {
+        snprintf(buf, len,
+                 "Sensor-%d %s: n=%u mín=%.2f máx=%.2f média=%.2f (%.1f s)",
+                 msg->sensor_id, type, msg->count, msg->min, msg->max,
+                 msg->value, (double) (msg->t_end_ns - msg->t_start_ns) / 1e9);
+        return;
+    }
+
+    switch ((telemetry_event_t) msg->event) {
+    case TELEMETRY_EVENT_ALARM_ON:
+        snprintf(buf, len, "ALARME %s: Sensor-%d %s=%.2f", msg->name,
+                 msg->sensor_id, type, msg->value);
+        break;
+    case TELEMETRY_EVENT_ALARM_OFF:
+        snprintf(buf, len, "Alarme %s normalizado: Sensor-%d %s=%.2f",
+                 msg->name, msg->sensor_id, type, msg->value);
+        break;
+    case TELEMETRY_EVENT_SENSOR_START:
+        snprintf(buf, len, "Sensor-%d %s iniciado (%.2f Hz)", msg->sensor_id,
+                 type, msg->value);
+        break;
+    case TELEMETRY_EVENT_SENSOR_STOP:
+        snprintf(buf, len, "Sensor-%d %s encerrado", msg->sensor_id, type);
+        break;
+    case TELEMETRY_EVENT_SENSOR_CONFIG:
+        snprintf(buf, len, "Sensor-%d %s reconfigurado (%.2f Hz)",
+                 msg->sensor_id, type, msg->value);
+        break;
+    default:
+        snprintf(buf, len, "Evento %u do Sensor-%d", msg->event,
+                 msg->sensor_id);
+        break;
+    }
+}
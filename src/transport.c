@@ -0,0 +1,1113 @@
+#include "common.h"
+#include "gorilla.h"
+#include "transport.h"
+
+#include <limits.h>
+#include <linux/magic.h>
+#include <sys/vfs.h>
+
+// Prazo para o data_processor aparecer
+#define CONNECT_TIMEOUT_MS 10000
+// Reverificação enquanto o sinal de prontidão for de uma execução anterior
+#define CONNECT_RECHECK_MS 50
+// Troca de segmento: tempo para escritores que já conferiram o estado do
+// antigo terminarem de publicar nele antes da cópia
+#define SAMPLE_SHM_RETIRE_GRACE_MS 10
+
+// Amostras por quadro compactado, pelo pior caso, para caber em PIPE_BUF
+#define FRAME_MAX_SAMPLES                                                     \
+    ((PIPE_BUF - sizeof(sample_frame_t) - 8) * 8 / GORILLA_SAMPLE_MAX_BITS)
+
+static const char *const mode_names[] = {
+    [TRANSPORT_SHM] = "shm",
+    [TRANSPORT_FIFO] = "fifo",
+    [TRANSPORT_FIFO_GORILLA] = "fifo-gorilla",
+    [TRANSPORT_UDP] = "udp",
+    [TRANSPORT_TCP] = "tcp",
+};
+
+int transport_mode_parse(const char *name, transport_mode_t *mode)
+{
+    for (size_t m = 0; m < sizeof(mode_names) / sizeof(mode_names[0]); m++) {
+        if (strcmp(name, mode_names[m]) == 0) {
+            *mode = (transport_mode_t) m;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+transport_mode_t transport_mode_default(void)
+{
+    transport_mode_t mode = TRANSPORT_SHM;
+    const char *env = getenv("SENSOR_TRANSPORT");
+    if (env != NULL && transport_mode_parse(env, &mode) == -1) {
+        fprintf(stderr, "SENSOR_TRANSPORT inválido: %s (usando shm)\n", env);
+        mode = TRANSPORT_SHM;
+    }
+    return mode;
+}
+
+const char *transport_mode_name(transport_mode_t mode)
+{
+    return (size_t) mode < sizeof(mode_names) / sizeof(mode_names[0])
+               ? mode_names[mode]
+               : "?";
+}
+
+static size_t sample_shm_ring_offset(void)
+{
+    size_t align = CACHE_LINE_SIZE;
+    return (sizeof(sample_shm_t) + align - 1) & ~(align - 1);
+}
+
+const char *sample_shm_pages_name(sample_shm_pages_t pages)
+{
+    switch (pages) {
+    case SAMPLE_SHM_PAGES_THP:
+        return "huge pages transparentes (pedidas)";
+    case SAMPLE_SHM_PAGES_HUGETLB:
+        return "huge pages (hugetlbfs)";
+    default:
+        return "páginas normais";
+    }
+}
+
+// Segmento no hugetlbfs, com o tamanho arredondado para a huge page.
+// NULL se não houver hugetlbfs montado ou páginas reservadas.
+static sample_shm_t *hugetlb_map(size_t *total)
+{
+    int fd = open(SAMPLE_SHM_HUGETLB_PATH, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd == -1) {
+        return NULL;
+    }
+    struct statfs fs; // f_bsize: tamanho da huge page
+    void *addr = MAP_FAILED;
+    if (fstatfs(fd, &fs) == 0 && fs.f_type == HUGETLBFS_MAGIC) {
+        size_t page = (size_t) fs.f_bsize;
+        size_t size = (*total + page - 1) / page * page;
+        if (ftruncate(fd, (off_t) size) == 0) {
+            addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                        0);
+            *total = size;
+        }
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        unlink(SAMPLE_SHM_HUGETLB_PATH);
+        return NULL;
+    }
+    return (sample_shm_t *) addr;
+}
+
+// Registra este processo como dono do segmento
+static void set_owner(sample_shm_t *shm)
+{
+    atomic_store_explicit(&shm->owner_start, process_start_time(getpid()),
+                          memory_order_relaxed);
+    atomic_store_explicit(&shm->owner, (int32_t) getpid(),
+                          memory_order_release);
+}
+
+// O dono registrado ainda é o processo que assumiu o segmento? Conferir o
+// instante de início evita tomar por vivo quem herdou o pid após uma queda
+static int owner_alive(const sample_shm_t *shm, int32_t owner,
+                       uint64_t *start)
+{
+    *start = atomic_load_explicit(&shm->owner_start, memory_order_relaxed);
+    return owner > 0 && *start != 0 &&
+           process_start_time((pid_t) owner) == *start;
+}
+
+// Cria o segmento; publish = 0 deixa ready em 0 (amostras ainda a copiar)
+static sample_shm_t *shm_create(uint32_t capacity, uint32_t nshards,
+                                const overload_config_t *overload,
+                                int hugepages, int publish)
+{
+    // Remover segmento antigo para que sensores não usem um ring obsoleto
+    shm_unlink(SHM_NAME);
+    unlink(SAMPLE_SHM_HUGETLB_PATH);
+
+    // Cada ring começa em sua própria linha de cache
+    size_t stride = (ring_bytes(capacity) + CACHE_LINE_SIZE - 1) &
+                    ~((size_t) CACHE_LINE_SIZE - 1);
+    size_t total = sample_shm_ring_offset() + stride * nshards;
+
+    sample_shm_t *shm = hugepages ? hugetlb_map(&total) : NULL;
+    sample_shm_pages_t pages = SAMPLE_SHM_PAGES_HUGETLB;
+    if (shm == NULL) {
+        int shm_fd = shm_open(SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0666);
+        if (shm_fd == -1) {
+            perror("Erro ao criar memória compartilhada");
+            return NULL;
+        }
+        if (ftruncate(shm_fd, total) == -1) {
+            perror("Erro ao definir tamanho da memória compartilhada");
+            close(shm_fd);
+            return NULL;
+        }
+
+        shm = (sample_shm_t *) mmap(NULL, total, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED, shm_fd, 0);
+        close(shm_fd);
+        if (shm == MAP_FAILED) {
+            perror("Erro ao mapear memória compartilhada");
+            return NULL;
+        }
+        // Sem hugetlbfs: huge pages transparentes, se o kernel as der ao
+        // shmem (transparent_hugepage/shmem_enabled)
+        pages = hugepages && madvise(shm, total, MADV_HUGEPAGE) == 0
+                    ? SAMPLE_SHM_PAGES_THP
+                    : SAMPLE_SHM_PAGES_NORMAL;
+    }
+
+    shm->magic = SAMPLE_SHM_MAGIC;
+    shm->version = SAMPLE_SHM_VERSION;
+    set_owner(shm);
+    atomic_store_explicit(&shm->state, SAMPLE_SHM_ACTIVE,
+                          memory_order_relaxed);
+    shm->generation = 1;
+    shm->total_bytes = total;
+    shm->pages = pages;
+    shm->ring_offset = sample_shm_ring_offset();
+    shm->ring_stride = stride;
+    shm->nshards = nshards;
+    shm->capacity = capacity;
+    shm->overload = *overload;
+    overload_set_marks(&shm->overload, capacity);
+    for (uint32_t i = 0; i < nshards; i++) {
+        ring_init(sample_shm_ring(shm, i), capacity);
+    }
+
+    // Publicar: sensores só usam o ring depois de ver ready == 1
+    if (publish) {
+        atomic_store_explicit(&shm->ready, 1, memory_order_release);
+        futex_wake(&shm->ready, INT32_MAX);
+    }
+    return shm;
+}
+
+sample_shm_t *sample_shm_create(uint32_t capacity, uint32_t nshards,
+                                const overload_config_t *overload,
+                                int hugepages)
+{
+    return shm_create(capacity, nshards, overload, hugepages, 1);
+}
+
+void sample_shm_destroy(sample_shm_t *shm)
+{
+    if (shm != NULL) {
+        munmap(shm, shm->total_bytes);
+    }
+}
+
+// Mapeia o segmento criado pelo data_processor; retorna NULL se ainda não
+// existir ou não estiver pronto
+static sample_shm_t *sample_shm_attach(size_t *bytes, int writable)
+{
+    int shm_fd = shm_open(SHM_NAME, writable ? O_RDWR : O_RDONLY, 0);
+    if (shm_fd == -1) {
+        shm_fd = open(SAMPLE_SHM_HUGETLB_PATH, writable ? O_RDWR : O_RDONLY);
+    }
+    if (shm_fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(shm_fd, &st) == -1 || st.st_size < (off_t) sizeof(sample_shm_t)) {
+        close(shm_fd);
+        return NULL;
+    }
+
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    sample_shm_t *shm =
+        (sample_shm_t *) mmap(NULL, st.st_size, prot, MAP_SHARED, shm_fd, 0);
+    close(shm_fd);
+    if (shm == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (shm->magic != SAMPLE_SHM_MAGIC ||
+        atomic_load_explicit(&shm->ready, memory_order_acquire) != 1 ||
+        shm->version != SAMPLE_SHM_VERSION ||
+        shm->total_bytes > (uint64_t) st.st_size || shm->nshards == 0 ||
+        shm->nshards > SAMPLE_MAX_SHARDS) {
+        munmap(shm, st.st_size);
+        return NULL;
+    }
+
+    *bytes = st.st_size;
+    return shm;
+}
+
+// Aguarda a instância dona do segmento entregá-lo, pedindo a saída dela
+// uma vez. -1 se ela continuar ativa após o prazo.
+static int wait_handoff(sample_shm_t *shm, sample_shm_takeover_t *info)
+{
+    uint64_t start = monotonic_ns();
+    uint64_t deadline =
+        start + (uint64_t) SAMPLE_SHM_HANDOFF_TIMEOUT_MS * 1000000ull;
+    while (atomic_load_explicit(&shm->state, memory_order_acquire) ==
+           SAMPLE_SHM_ACTIVE) {
+        int32_t owner =
+            atomic_load_explicit(&shm->owner, memory_order_acquire);
+        uint64_t start;
+        if (owner == (int32_t) getpid() || !owner_alive(shm, owner, &start)) {
+            info->crashed = 1; // Morreu sem entregar
+            break;
+        }
+        if (!info->requested) {
+            process_signal((pid_t) owner, start, SIGTERM);
+            info->requested = 1;
+        }
+        uint64_t now = monotonic_ns();
+        if (now >= deadline) {
+            errno = EBUSY;
+            return -1;
+        }
+        // Acordado pela entrega; o prazo curto reavalia se o dono morreu
+        futex_wait(&shm->state, SAMPLE_SHM_ACTIVE, 20);
+    }
+    info->wait_ns = monotonic_ns() - start;
+    return 0;
+}
+
+// Copia as amostras pendentes de um segmento incompatível para o novo,
+// redistribuídas pelos shards deste
+static void migrate(sample_shm_t *from, sample_shm_t *to,
+                    sample_shm_takeover_t *info)
+{
+    sensor_data_t data;
+    for (uint32_t s = 0; s < from->nshards; s++) {
+        sample_ring_t *ring = sample_shm_ring(from, s);
+        while (ring_try_pop(ring, &data)) {
+            uint32_t shard = sample_shard_of(data.sensor_id, to->nshards);
+            if (ring_try_push(sample_shm_ring(to, shard), &data)) {
+                info->pending++;
+            } else {
+                info->lost++;
+            }
+        }
+    }
+}
+
+sample_shm_t *sample_shm_acquire(uint32_t capacity, uint32_t nshards,
+                                 const overload_config_t *overload,
+                                 int hugepages, sample_shm_takeover_t *info)
+{
+    memset(info, 0, sizeof(*info));
+    size_t bytes;
+    sample_shm_t *old = sample_shm_attach(&bytes, 1);
+    if (old == NULL) {
+        info->generation = 1;
+        return shm_create(capacity, nshards, overload, hugepages, 1);
+    }
+    if (wait_handoff(old, info) == -1) {
+        munmap(old, bytes);
+        return NULL;
+    }
+
+    // Rings coerentes e, após uma queda, sem slots presos pelo consumidor
+    // que morreu nem reservas de produtores mortos. Numa entrega em ordem
+    // as reservas pendentes são de produtores vivos e ficam com eles.
+    int retired = atomic_load(&old->state) == SAMPLE_SHM_RETIRED;
+    int addressable = old->ring_offset == sample_shm_ring_offset() &&
+                      old->ring_offset + old->ring_stride * old->nshards <=
+                          old->total_bytes &&
+                      old->ring_stride >= ring_bytes(old->capacity);
+    int consistent = !retired && addressable;
+    for (uint32_t s = 0; consistent && s < old->nshards; s++) {
+        int freed = ring_recover(sample_shm_ring(old, s), old->capacity,
+                                 info->crashed ? SAMPLE_SHM_RETIRE_GRACE_MS
+                                               : -1);
+        consistent = freed >= 0;
+        info->lost += freed > 0 ? (uint64_t) freed : 0;
+    }
+    if (!consistent && !retired) {
+        // Os pendentes do antigo não serão copiados: contá-los como
+        // perdidos onde head/tail ainda fazem sentido
+        for (uint32_t s = 0; addressable && s < old->nshards; s++) {
+            sample_ring_t *ring = sample_shm_ring(old, s);
+            uint64_t tail = atomic_load(&ring->tail);
+            uint64_t head = atomic_load(&ring->head);
+            if (head < tail || head - tail > old->capacity) {
+                info->lost_unknown = 1;
+            } else {
+                info->lost += head - tail;
+            }
+        }
+        info->lost_unknown |= !addressable;
+    }
+
+    if (consistent && old->capacity == capacity && old->nshards == nshards) {
+        old->overload = *overload;
+        overload_set_marks(&old->overload, capacity);
+        old->generation++;
+        for (uint32_t s = 0; s < nshards; s++) {
+            info->pending += ring_depth(sample_shm_ring(old, s));
+        }
+        info->adopted = 1;
+        info->generation = old->generation;
+        set_owner(old);
+        atomic_store_explicit(&old->state, SAMPLE_SHM_ACTIVE,
+                              memory_order_release);
+        return old;
+    }
+
+    // Outro layout: segmento novo, ainda sem ready; os escritores do antigo
+    // veem RETIRED e passam à fila local até o novo ser publicado
+    uint32_t generation = old->generation + 1;
+    sample_shm_t *shm =
+        shm_create(capacity, nshards, overload, hugepages, 0);
+    if (shm == NULL) {
+        munmap(old, bytes);
+        return NULL;
+    }
+    atomic_store_explicit(&old->state, SAMPLE_SHM_RETIRED,
+                          memory_order_release);
+    futex_wake(&old->state, INT32_MAX);
+    if (consistent) {
+        // Quem já conferiu o estado antes da troca termina de publicar
+        msleep(SAMPLE_SHM_RETIRE_GRACE_MS);
+        migrate(old, shm, info);
+    }
+    munmap(old, bytes);
+
+    info->replaced = 1;
+    info->generation = generation;
+    shm->generation = generation;
+    atomic_store_explicit(&shm->ready, 1, memory_order_release);
+    futex_wake(&shm->ready, INT32_MAX);
+    return shm;
+}
+
+void sample_shm_release(sample_shm_t *shm)
+{
+    if (shm != NULL) {
+        atomic_store_explicit(&shm->owner, 0, memory_order_relaxed);
+        atomic_store_explicit(&shm->owner_start, 0, memory_order_relaxed);
+        atomic_store_explicit(&shm->state, SAMPLE_SHM_HANDOFF,
+                              memory_order_release);
+        futex_wake(&shm->state, INT32_MAX);
+    }
+}
+
+const sample_shm_t *sample_shm_open_readonly(void)
+{
+    size_t bytes;
+    return sample_shm_attach(&bytes, 0);
+}
+
+void sample_shm_close(const sample_shm_t *shm)
+{
+    if (shm != NULL) {
+        munmap((void *) shm, shm->total_bytes);
+    }
+}
+
+static void count_drop(sample_shm_t *shm, uint32_t shard,
+                       overload_state_t *state, overload_drop_t reason,
+                       uint64_t n)
+{
+    if (n > 0) {
+        state->drops[reason] += n;
+        atomic_fetch_add_explicit(&shm->overload_shards[shard].drops[reason],
+                                  n, memory_order_relaxed);
+    }
+}
+
+// Publicação de uma amostra retida (COALESCE) no ring do seu shard
+typedef struct {
+    sample_shm_t *shm;
+    uint32_t published;
+} pending_ctx_t;
+
+static int publish_pending(const sensor_data_t *data, void *arg)
+{
+    pending_ctx_t *ctx = (pending_ctx_t *) arg;
+    uint32_t shard = sample_shard_of(data->sensor_id, ctx->shm->nshards);
+    if (!ring_try_push(sample_shm_ring(ctx->shm, shard), data)) {
+        return 0;
+    }
+    ctx->published++;
+    return 1;
+}
+
+// DROP_OLDEST: abre espaço retirando a amostra mais antiga. Limita as
+// tentativas para não disputar indefinidamente com outros produtores.
+static int push_evicting(sample_shm_t *shm, uint32_t shard,
+                         const sensor_data_t *data, overload_state_t *state)
+{
+    sample_ring_t *ring = sample_shm_ring(shm, shard);
+    for (int attempt = 0; attempt < 4; attempt++) {
+        if (ring_try_push(ring, data)) {
+            return 1;
+        }
+        sensor_data_t victim;
+        if (ring_try_pop(ring, &victim)) {
+            count_drop(shm, shard, state, OVERLOAD_DROPPED_OLDEST, 1);
+        }
+    }
+    count_drop(shm, shard, state, OVERLOAD_DROPPED_NEWEST, 1);
+    return 0;
+}
+
+uint32_t sample_shm_offer(sample_shm_t *shm, uint32_t shard,
+                          const sensor_data_t *items, uint32_t n,
+                          overload_state_t *state, long timeout_ms,
+                          uint32_t *published)
+{
+    sample_ring_t *ring = sample_shm_ring(shm, shard);
+    const overload_config_t *cfg = &shm->overload;
+    *published = 0;
+
+    if (state->pending.count > 0) {
+        pending_ctx_t ctx = {.shm = shm, .published = 0};
+        coalesce_drain(&state->pending, publish_pending, &ctx);
+        *published += ctx.published;
+    }
+
+    switch ((overload_policy_t) cfg->policy) {
+    case OVERLOAD_DROP_NEWEST:
+    case OVERLOAD_DROP_OLDEST: {
+        uint32_t pushed = ring_try_push_batch(ring, items, n);
+        *published += pushed;
+        for (uint32_t i = pushed; i < n; i++) {
+            if (cfg->policy == OVERLOAD_DROP_OLDEST) {
+                *published += (uint32_t) push_evicting(shm, shard, &items[i],
+                                                       state);
+            } else {
+                count_drop(shm, shard, state, OVERLOAD_DROPPED_NEWEST, 1);
+            }
+        }
+        return n;
+    }
+
+    case OVERLOAD_COALESCE:
+        for (uint32_t i = 0; i < n; i++) {
+            // Uma amostra retida do mesmo sensor é mais antiga: a nova a
+            // substitui em vez de passar à frente dela no ring
+            int rc = state->pending.count > 0
+                         ? coalesce_replace(&state->pending, &items[i])
+                         : 0;
+            if (rc == 0 && ring_try_push(ring, &items[i])) {
+                (*published)++;
+                continue;
+            }
+            if (rc == 0) {
+                rc = coalesce_put(&state->pending, &items[i]);
+            }
+            if (rc != 0) {
+                // Substituída (1) ou sem memória para retê-la (-1)
+                count_drop(shm, shard, state,
+                           rc > 0 ? OVERLOAD_DROPPED_COALESCED
+                                  : OVERLOAD_DROPPED_NEWEST,
+                           1);
+            }
+        }
+        return n;
+
+    case OVERLOAD_SAMPLE:
+        if (ring_depth(ring) < cfg->high_mark) {
+            uint32_t pushed = ring_try_push_batch(ring, items, n);
+            *published += pushed;
+            count_drop(shm, shard, state, OVERLOAD_DROPPED_NEWEST, n - pushed);
+            return n;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (!overload_sample_accept(state, cfg->sample_prob)) {
+                count_drop(shm, shard, state, OVERLOAD_DROPPED_SAMPLED, 1);
+            } else if (ring_try_push(ring, &items[i])) {
+                (*published)++;
+            } else {
+                count_drop(shm, shard, state, OVERLOAD_DROPPED_NEWEST, 1);
+            }
+        }
+        return n;
+
+    case OVERLOAD_BLOCK:
+    default: {
+        uint32_t pushed = ring_push_batch(ring, items, n, timeout_ms);
+        *published += pushed;
+        return pushed;
+    }
+    }
+}
+
+#define RENDEZVOUS_MAGIC 0x5652444eu // "NDRV"
+
+rendezvous_t *rendezvous_open(void)
+{
+    int fd = shm_open(RENDEZVOUS_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) {
+        perror("Erro ao abrir ponto de encontro");
+        return NULL;
+    }
+
+    // Tamanho fixo e zerado pelo kernel: a corrida entre criadores é inócua
+    struct stat st;
+    if (fstat(fd, &st) == -1 ||
+        (st.st_size < (off_t) sizeof(rendezvous_t) &&
+         ftruncate(fd, sizeof(rendezvous_t)) == -1)) {
+        perror("Erro ao dimensionar ponto de encontro");
+        close(fd);
+        return NULL;
+    }
+
+    rendezvous_t *rv = (rendezvous_t *) mmap(
+        NULL, sizeof(rendezvous_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (rv == MAP_FAILED) {
+        perror("Erro ao mapear ponto de encontro");
+        return NULL;
+    }
+    rv->magic = RENDEZVOUS_MAGIC;
+    return rv;
+}
+
+void rendezvous_close(rendezvous_t *rv)
+{
+    if (rv != NULL) {
+        munmap(rv, sizeof(rendezvous_t));
+    }
+}
+
+void rendezvous_set_reader(rendezvous_t *rv, int ready)
+{
+    if (rv != NULL) {
+        atomic_store_explicit(&rv->reader_ready, ready ? 1u : 0u,
+                              memory_order_release);
+        if (ready) {
+            futex_wake(&rv->reader_ready, INT32_MAX);
+        }
+    }
+}
+
+uint32_t rendezvous_sensors(rendezvous_t *rv)
+{
+    return atomic_load_explicit(&rv->sensors_started, memory_order_acquire);
+}
+
+int rendezvous_wait_sensors(rendezvous_t *rv, uint32_t target,
+                            long timeout_ms)
+{
+    uint64_t deadline = monotonic_ns() + (uint64_t) timeout_ms * 1000000ull;
+    for (;;) {
+        uint32_t seen = rendezvous_sensors(rv);
+        if ((int32_t) (seen - target) >= 0) {
+            return 0;
+        }
+        uint64_t now = monotonic_ns();
+        if (now >= deadline) {
+            return -1;
+        }
+        futex_wait(&rv->sensors_started, seen,
+                   (long) ((deadline - now) / 1000000ull) + 1);
+    }
+}
+
+// Dorme até o data_processor aceitar amostras ou até o prazo (-1)
+static int wait_reader(rendezvous_t *rv, uint64_t deadline)
+{
+    while (atomic_load_explicit(&rv->reader_ready, memory_order_acquire) ==
+           0) {
+        uint64_t now = monotonic_ns();
+        if (now >= deadline) {
+            return -1;
+        }
+        futex_wait(&rv->reader_ready, 0,
+                   (long) ((deadline - now) / 1000000ull) + 1);
+    }
+    return 0;
+}
+
+// Tenta conectar (FIFO ou ring); 0 se conectou
+static int try_connect(sample_writer_t *writer)
+{
+    if (writer->mode != TRANSPORT_SHM) {
+        // O leitor já existe: a abertura não bloqueia
+        int fd = open(FIFO_SENSOR_DATA, O_WRONLY | O_NONBLOCK);
+        if (fd == -1) {
+            return -1; // ENOENT/ENXIO: leitor ainda não pronto
+        }
+        int flags = fcntl(fd, F_GETFL);
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+        writer->fifo_fd = fd;
+        return 0;
+    }
+
+    writer->shm = sample_shm_attach(&writer->shm_bytes, 1);
+    if (writer->shm == NULL) {
+        return -1;
+    }
+    writer->nshards = writer->shm->nshards;
+    return 0;
+}
+
+int sample_writer_open(sample_writer_t *writer, transport_mode_t mode,
+                       const char *component)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->mode = mode;
+    writer->fifo_fd = -1;
+    writer->nshards = 1;
+    writer->backlog_capacity = SAMPLE_WRITER_BACKLOG;
+    overload_state_init(&writer->overload, (uint32_t) getpid());
+
+    writer->net.fd = -1;
+    writer->rendezvous = rendezvous_open();
+    if (writer->rendezvous == NULL) {
+        return -1;
+    }
+
+    // Rede: o data_processor pode estar em outro nó, sem ponto de encontro
+    // em comum (o local ainda conta os sensores iniciados)
+    if (mode == TRANSPORT_UDP || mode == TRANSPORT_TCP) {
+        const char *addr = net_addr_default();
+        if (net_sender_open(&writer->net, addr, mode == TRANSPORT_TCP,
+                            CONNECT_TIMEOUT_MS) == -1) {
+            fprintf(stderr, "Erro: data_processor não encontrado em %s "
+                            "(%s): %s\n",
+                    addr, transport_mode_name(mode), strerror(errno));
+            sample_writer_close(writer);
+            return -1;
+        }
+        return 0;
+    }
+
+    uint64_t deadline =
+        monotonic_ns() + (uint64_t) CONNECT_TIMEOUT_MS * 1000000ull;
+    int waited = 0;
+    while (try_connect(writer) == -1) {
+        if (!waited) {
+            log_message(COLOR_YELLOW, component,
+                        "Aguardando data_processor...");
+            waited = 1;
+        }
+        // Se a marca ainda é de um data_processor anterior, o novo a zera e
+        // remarca; a espera curta cobre essa janela
+        rendezvous_t *rv = writer->rendezvous;
+        if (wait_reader(rv, deadline) == 0) {
+            futex_wait(&rv->reader_ready, 1, CONNECT_RECHECK_MS);
+        }
+        if (monotonic_ns() >= deadline) {
+            fprintf(stderr,
+                    "Erro: data_processor não encontrado (%s). Execute "
+                    "'data_processor' primeiro ou use 'sensor_system' para "
+                    "iniciar todo o sistema.\n",
+                    transport_mode_name(mode));
+            sample_writer_close(writer);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void sample_writer_set_backlog(sample_writer_t *writer, uint32_t capacity)
+{
+    if (writer->backlog == NULL) {
+        writer->backlog_capacity = capacity;
+    }
+}
+
+// O data_processor aceita amostras? Um dono que morreu sem entregar
+// deixa a marca no ponto de encontro: ausente até outro assumir os rings.
+static int reader_present(const sample_writer_t *writer)
+{
+    if (atomic_load_explicit(&writer->rendezvous->reader_ready,
+                             memory_order_acquire) == 0) {
+        return 0;
+    }
+    if (writer->dead_owner == 0 || writer->shm == NULL) {
+        return 1;
+    }
+    // Outro dono, ainda que com o mesmo pid, assumiu os rings
+    return atomic_load_explicit(&writer->shm->owner, memory_order_acquire) !=
+               writer->dead_owner ||
+           atomic_load_explicit(&writer->shm->owner_start,
+                                memory_order_relaxed) !=
+               writer->dead_owner_start;
+}
+
+// Ring cheio com o leitor presente: o consumidor pode ter morrido
+static void check_owner(sample_writer_t *writer)
+{
+    int32_t owner =
+        atomic_load_explicit(&writer->shm->owner, memory_order_acquire);
+    uint64_t start;
+    if (owner > 0 && !owner_alive(writer->shm, owner, &start)) {
+        writer->dead_owner = owner;
+        writer->dead_owner_start = start;
+    }
+}
+
+// Segmento substituído por um data_processor com outro layout: mapear o
+// novo (NULL até ele ser publicado, com as amostras do antigo já copiadas)
+static void writer_refresh(sample_writer_t *writer)
+{
+    if (writer->shm != NULL &&
+        atomic_load_explicit(&writer->shm->state, memory_order_acquire) !=
+            SAMPLE_SHM_RETIRED) {
+        return;
+    }
+    if (writer->shm != NULL) {
+        munmap(writer->shm, writer->shm_bytes);
+    }
+    writer->shm = sample_shm_attach(&writer->shm_bytes, 1);
+}
+
+// Publica em ordem no segmento atual. Com o data_processor presente segue a
+// política de sobrecarga (BLOCK espera até timeout_ms); ausente, o ring é
+// só um buffer: entra o que couber, sem descartar nem esperar. Retorna
+// quantas amostras do início foram tratadas.
+static uint32_t writer_offer(sample_writer_t *writer, sensor_data_t *items,
+                             uint32_t n, long timeout_ms, uint32_t *published)
+{
+    sample_shm_t *shm = writer->shm;
+    int present = reader_present(writer);
+    uint64_t now = monotonic_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        items[i].t_ingest = now;
+    }
+
+    *published = 0;
+    uint32_t sent = 0;
+    while (sent < n) {
+        // Sequência de amostras do mesmo shard: uma única reserva
+        uint32_t shard = sample_shard_of(items[sent].sensor_id, shm->nshards);
+        uint32_t run = 1;
+        while (sent + run < n &&
+               sample_shard_of(items[sent + run].sensor_id, shm->nshards) ==
+                   shard) {
+            run++;
+        }
+        uint32_t handled, run_published;
+        sample_ring_t *ring = sample_shm_ring(shm, shard);
+        if (present && ring_depth(ring) >= shm->capacity) {
+            // Antes de esperar por espaço: o consumidor ainda existe?
+            check_owner(writer);
+            present = reader_present(writer);
+        }
+        if (present) {
+            handled = sample_shm_offer(shm, shard, items + sent, run,
+                                       &writer->overload, timeout_ms,
+                                       &run_published);
+        } else {
+            handled = ring_try_push_batch(ring, items + sent, run);
+            run_published = handled;
+        }
+        *published += run_published;
+        sent += handled;
+        if (handled < run) {
+            break; // Ring cheio (BLOCK após o timeout, ou sem leitor)
+        }
+    }
+    return sent;
+}
+
+// Descarte de amostras que não couberam em lugar nenhum
+static void writer_drop(sample_writer_t *writer, const sensor_data_t *items,
+                        uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (writer->shm != NULL) {
+            count_drop(writer->shm,
+                       sample_shard_of(items[i].sensor_id,
+                                       writer->shm->nshards),
+                       &writer->overload, OVERLOAD_DROPPED_NEWEST, 1);
+        } else {
+            writer->overload.drops[OVERLOAD_DROPPED_NEWEST]++;
+        }
+    }
+}
+
+// Guarda no fim da fila local; retorna quantas couberam
+static uint32_t backlog_push(sample_writer_t *writer,
+                             const sensor_data_t *items, uint32_t n)
+{
+    uint32_t capacity = writer->backlog_capacity;
+    if (writer->backlog == NULL && capacity > 0) {
+        writer->backlog = malloc((size_t) capacity * sizeof(sensor_data_t));
+        if (writer->backlog == NULL) {
+            writer->backlog_capacity = 0;
+            return 0;
+        }
+    }
+    uint32_t room = writer->backlog_capacity - writer->backlog_count;
+    uint32_t kept = n < room ? n : room;
+    for (uint32_t i = 0; i < kept; i++) {
+        uint32_t slot = (writer->backlog_head + writer->backlog_count + i) %
+                        capacity;
+        writer->backlog[slot] = items[i];
+    }
+    writer->backlog_count += kept;
+    return kept;
+}
+
+// Publica a fila local, na ordem, até o primeiro ring cheio
+static void backlog_drain(sample_writer_t *writer, long timeout_ms,
+                          uint32_t *published)
+{
+    while (writer->backlog_count > 0) {
+        uint32_t head = writer->backlog_head;
+        uint32_t chunk = writer->backlog_capacity - head;
+        if (chunk > writer->backlog_count) {
+            chunk = writer->backlog_count;
+        }
+        uint32_t chunk_published;
+        uint32_t handled = writer_offer(writer, writer->backlog + head,
+                                        chunk, timeout_ms, &chunk_published);
+        *published += chunk_published;
+        writer->backlog_head = (head + handled) % writer->backlog_capacity;
+        writer->backlog_count -= handled;
+        if (handled < chunk) {
+            return;
+        }
+    }
+}
+
+// Envio no modo SHM: primeiro a fila local, depois o lote. Sem
+// data_processor, ou atrás de uma fila local ainda não vazia, o lote vai
+// para a fila (as mais novas se perdem com ela cheia). Retorna quantas
+// amostras do início do lote foram tratadas.
+static uint32_t writer_send_shm(sample_writer_t *writer, sensor_data_t *items,
+                                uint32_t n, uint32_t *published)
+{
+    *published = 0;
+    writer_refresh(writer);
+
+    uint32_t handled = 0;
+    if (writer->shm != NULL) {
+        if (writer->backlog_count > 0) {
+            // Fila cheia com o leitor de volta: BLOCK espera por espaço
+            int full = writer->backlog_count == writer->backlog_capacity;
+            backlog_drain(writer, full ? 100 : 0, published);
+        }
+        if (writer->backlog_count == 0) {
+            uint32_t run_published;
+            handled = writer_offer(writer, items, n, 100, &run_published);
+            *published += run_published;
+        }
+    }
+
+    int present = reader_present(writer);
+    if (handled < n && (writer->shm == NULL || !present ||
+                        writer->backlog_count > 0)) {
+        handled += backlog_push(writer, items + handled, n - handled);
+        if (!present) {
+            writer_drop(writer, items + handled, n - handled);
+            handled = n;
+        }
+    }
+    return handled;
+}
+
+// Rede: o que o kernel não aceitou (sem receptor, buffer cheio ou conexão
+// perdida) se perde e conta como descarte
+static uint32_t writer_send_net(sample_writer_t *writer,
+                                const sensor_data_t *items, uint32_t n,
+                                uint32_t *published)
+{
+    uint32_t sent = net_sender_send(&writer->net, items, n);
+    writer->overload.drops[OVERLOAD_DROPPED_NEWEST] += n - sent;
+    *published = sent;
+    return n;
+}
+
+// Compacta e escreve um quadro (até FRAME_MAX_SAMPLES amostras)
+static int write_frame(int fd, const sensor_data_t *items, uint32_t n)
+{
+    union {
+        sample_frame_t header;
+        uint8_t bytes[PIPE_BUF];
+    } frame;
+    size_t payload = gorilla_encode_samples(
+        items, n, frame.bytes + sizeof(sample_frame_t),
+        sizeof(frame) - sizeof(sample_frame_t));
+    frame.header.magic = SAMPLE_FRAME_MAGIC;
+    frame.header.count = (uint16_t) n;
+    frame.header.bytes = (uint16_t) payload;
+
+    ssize_t written;
+    do {
+        written = write(fd, frame.bytes, sizeof(sample_frame_t) + payload);
+    } while (written == -1 && errno == EINTR);
+    return written == -1 ? -1 : 0;
+}
+
+// Registros sensor_data_t ou quadros compactados, distinguidos pelo
+// primeiro campo (o magic do quadro não é um sensor_type_t válido)
+int sample_stream_parse(const char *buf, size_t fill, sensor_data_t *out,
+                        uint32_t max, uint32_t *count, size_t *consumed)
+{
+    size_t pos = 0;
+    uint32_t n = 0;
+    int more = 0;
+    while (fill - pos >= sizeof(uint32_t)) {
+        uint32_t magic;
+        memcpy(&magic, buf + pos, sizeof(magic));
+        if (magic != SAMPLE_FRAME_MAGIC) {
+            if (fill - pos < sizeof(sensor_data_t)) {
+                break;
+            }
+            if (n == max) {
+                more = 1;
+                break;
+            }
+            memcpy(&out[n++], buf + pos, sizeof(sensor_data_t));
+            pos += sizeof(sensor_data_t);
+            continue;
+        }
+
+        sample_frame_t frame;
+        if (fill - pos < sizeof(frame)) {
+            break;
+        }
+        memcpy(&frame, buf + pos, sizeof(frame));
+        if (frame.count == 0 || frame.count > max ||
+            sizeof(frame) + frame.bytes > PIPE_BUF) {
+            return -1;
+        }
+        if (fill - pos < sizeof(frame) + frame.bytes) {
+            break;
+        }
+        if (frame.count > max - n) {
+            more = 1;
+            break;
+        }
+        if (gorilla_decode_samples((const uint8_t *) buf + pos + sizeof(frame),
+                                   frame.bytes, frame.count, out + n) == -1) {
+            return -1;
+        }
+        n += frame.count;
+        pos += sizeof(frame) + frame.bytes;
+    }
+    *count = n;
+    *consumed = pos;
+    return more;
+}
+
+int sample_writer_send(sample_writer_t *writer, sensor_data_t *data)
+{
+    if (writer->mode == TRANSPORT_UDP || writer->mode == TRANSPORT_TCP) {
+        uint32_t published;
+        writer_send_net(writer, data, 1, &published);
+        return (int) published;
+    }
+    if (writer->mode == TRANSPORT_FIFO_GORILLA) {
+        return write_frame(writer->fifo_fd, data, 1) == -1 ? -1 : 1;
+    }
+    if (writer->mode == TRANSPORT_FIFO) {
+        return write(writer->fifo_fd, data, sizeof(*data)) == -1 ? -1 : 1;
+    }
+
+    // Escreve direto no ring do data_processor; com o ring cheio segue a
+    // política de sobrecarga. Em BLOCK o timeout devolve o controle ao
+    // chamador para checar o encerramento.
+    uint32_t published;
+    if (writer_send_shm(writer, data, 1, &published) == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return (int) published;
+}
+
+int sample_writer_send_batch(sample_writer_t *writer, sensor_data_t *items,
+                             uint32_t n, uint32_t *published)
+{
+    *published = 0;
+    if (writer->mode == TRANSPORT_SHM) {
+        return (int) writer_send_shm(writer, items, n, published);
+    }
+    if (writer->mode == TRANSPORT_UDP || writer->mode == TRANSPORT_TCP) {
+        return (int) writer_send_net(writer, items, n, published);
+    }
+
+    if (writer->mode == TRANSPORT_FIFO_GORILLA) {
+        uint32_t sent = 0;
+        while (sent < n) {
+            uint32_t count = n - sent < FRAME_MAX_SAMPLES
+                                 ? n - sent
+                                 : (uint32_t) FRAME_MAX_SAMPLES;
+            if (write_frame(writer->fifo_fd, items + sent, count) == -1) {
+                return sent > 0 ? (int) sent : -1;
+            }
+            sent += count;
+        }
+        *published = sent;
+        return (int) sent;
+    }
+
+    const uint32_t chunk = PIPE_BUF / sizeof(sensor_data_t);
+    uint32_t sent = 0;
+    while (sent < n) {
+        uint32_t count = n - sent < chunk ? n - sent : chunk;
+        ssize_t written =
+            write(writer->fifo_fd, items + sent, count * sizeof(sensor_data_t));
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return sent > 0 ? (int) sent : -1;
+        }
+        sent += (uint32_t) ((size_t) written / sizeof(sensor_data_t));
+    }
+    *published = sent;
+    return (int) sent;
+}
+
+void sample_writer_close(sample_writer_t *writer)
+{
+    if (writer->fifo_fd != -1) {
+        close(writer->fifo_fd);
+        writer->fifo_fd = -1;
+    }
+    net_sender_close(&writer->net);
+    if (writer->mode == TRANSPORT_SHM) {
+        writer_refresh(writer);
+    }
+    if (writer->shm != NULL && writer->backlog_count > 0) {
+        // Fila local: o que ainda couber nos rings (com o leitor presente,
+        // esperando por espaço como BLOCK); o resto se perde
+        uint32_t published;
+        backlog_drain(writer, reader_present(writer) ? 100 : 0, &published);
+    }
+    while (writer->backlog_count > 0) {
+        writer_drop(writer, &writer->backlog[writer->backlog_head], 1);
+        writer->backlog_head =
+            (writer->backlog_head + 1) % writer->backlog_capacity;
+        writer->backlog_count--;
+    }
+    if (writer->shm != NULL) {
+        // Última chance para as amostras retidas; as que não couberem se
+        // perdem e contam como descartes
+        pending_ctx_t ctx = {.shm = writer->shm, .published = 0};
+        coalesce_table_t *pending = &writer->overload.pending;
+        coalesce_drain(pending, publish_pending, &ctx);
+        for (uint32_t i = 0; i < pending->capacity; i++) {
+            if (pending->state[i] == 1) {
+                count_drop(writer->shm,
+                           sample_shard_of(pending->items[i].sensor_id,
+                                           writer->shm->nshards),
+                           &writer->overload, OVERLOAD_DROPPED_NEWEST, 1);
+            }
+        }
+        munmap(writer->shm, writer->shm_bytes);
+        writer->shm = NULL;
+    }
+    rendezvous_close(writer->rendezvous);
+    writer->rendezvous = NULL;
+    overload_state_free(&writer->overload);
+    free(writer->backlog);
+    writer->backlog = NULL;
+    writer->backlog_count = 0;
+}
+
+void sample_writer_announce(sample_writer_t *writer, uint32_t nsensors)
+{
+    if (writer->rendezvous != NULL) {
+        atomic_fetch_add_explicit(&writer->rendezvous->sensors_started,
+                                  nsensors, memory_order_release);
+        futex_wake(&writer->rendezvous->sensors_started, INT32_MAX);
+    }
+}
@@ -0,0 +1,826 @@
+#include "tsdb.h"
+#include "gorilla.h"
+#include "logger.h"
+
+#include <dirent.h>
+#include <sys/file.h>
+
+#define TSDB_MIN_SEGMENT (64u * 1024u)
+// Trava do diretório: um único escritor por vez
+#define TSDB_LOCK_FILE "LOCK"
+// Espera por um escritor anterior que ainda fecha o histórico
+#define TSDB_LOCK_TIMEOUT_MS 5000
+
+// Amostras ainda não gravadas de um sensor (um bloco em construção)
+typedef struct {
+    int64_t ts[TSDB_CHUNK_MAX];
+    float values[TSDB_CHUNK_MAX];
+    uint32_t count;
+    uint8_t type;
+    uint8_t listed; // Já está em dirty
+} tsdb_pending_t;
+
+struct tsdb_writer {
+    tsdb_config_t config;
+    uint32_t max_sensors;
+    tsdb_pending_t **pending; // [sensor_id], alocado no primeiro uso
+    uint32_t *dirty;          // Sensores com amostras pendentes
+    uint32_t ndirty;
+    int64_t clock_offset;     // Relógio de parede - monotônico (ns)
+
+    int lock_fd; // TSDB_LOCK_FILE, com flock exclusivo
+
+    // Segmento atual
+    int fd;
+    char *map;
+    tsdb_header_t *header;
+    uint64_t seq;
+    uint64_t opened_ns;
+    char path[TSDB_PATH_LEN + 32];
+
+    uint64_t last_sync_ns;
+    tsdb_stats_t stats;
+
+    // Bloco comprimido antes de ir para o segmento
+    uint8_t scratch[GORILLA_MAX_BYTES(TSDB_CHUNK_MAX,
+                                      GORILLA_SERIES_MAX_BITS)];
+};
+
+static int64_t realtime_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Configuração
+
+static int parse_size(const char *text, uint64_t *out)
+{
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text) {
+        return -1;
+    }
+    switch (*end) {
+    case 'K':
+    case 'k':
+        value <<= 10;
+        end++;
+        break;
+    case 'M':
+    case 'm':
+        value <<= 20;
+        end++;
+        break;
+    case 'G':
+    case 'g':
+        value <<= 30;
+        end++;
+        break;
+    default:
+        break;
+    }
+    if (*end != '\0') {
+        return -1;
+    }
+    *out = value;
+    return 0;
+}
+
+static int parse_seconds(const char *text, uint32_t *out)
+{
+    char *end;
+    unsigned long value = strtoul(text, &end, 10);
+    if (end == text) {
+        return -1;
+    }
+    switch (*end) {
+    case 'm':
+        value *= 60;
+        end++;
+        break;
+    case 'h':
+        value *= 3600;
+        end++;
+        break;
+    case 'd':
+        value *= 86400;
+        end++;
+        break;
+    case 's':
+        end++;
+        break;
+    default:
+        break;
+    }
+    if (*end != '\0' || value > UINT32_MAX) {
+        return -1;
+    }
+    *out = (uint32_t) value;
+    return 0;
+}
+
+int tsdb_config_parse(const char *spec, tsdb_config_t *config)
+{
+    if (strcmp(spec, "off") == 0) {
+        config->enabled = 0;
+        return 0;
+    }
+
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", spec);
+    char *save = NULL;
+    for (char *item = strtok_r(buf, ",", &save); item != NULL;
+         item = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(item, '=');
+        if (value == NULL || value[1] == '\0') {
+            return -1;
+        }
+        *value++ = '\0';
+
+        int rc = 0;
+        uint32_t ms = 0;
+        if (strcmp(item, "dir") == 0) {
+            rc = strlen(value) < sizeof(config->dir) ? 0 : -1;
+            snprintf(config->dir, sizeof(config->dir), "%s", value);
+        } else if (strcmp(item, "segment") == 0) {
+            rc = parse_size(value, &config->segment_bytes);
+        } else if (strcmp(item, "keep") == 0) {
+            rc = parse_size(value, &config->max_bytes);
+        } else if (strcmp(item, "age") == 0) {
+            rc = parse_seconds(value, &config->max_age_s);
+        } else if (strcmp(item, "rotate") == 0) {
+            rc = parse_seconds(value, &config->rotate_s);
+        } else if (strcmp(item, "codec") == 0) {
+            if (strcmp(value, "raw") == 0) {
+                config->codec = TSDB_ENC_RAW;
+            } else if (strcmp(value, "gorilla") == 0) {
+                config->codec = TSDB_ENC_GORILLA;
+            } else {
+                rc = -1;
+            }
+        } else if (strcmp(item, "sync") == 0) {
+            char *end;
+            ms = (uint32_t) strtoul(value, &end, 10);
+            rc = *end == '\0' ? 0 : -1;
+            config->sync_ms = ms;
+        } else {
+            rc = -1;
+        }
+        if (rc == -1) {
+            return -1;
+        }
+    }
+
+    if (config->segment_bytes < TSDB_MIN_SEGMENT) {
+        return -1;
+    }
+    config->enabled = 1;
+    return 0;
+}
+
+void tsdb_config_default(tsdb_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    snprintf(config->dir, sizeof(config->dir), "%s", TSDB_DEFAULT_DIR);
+    config->segment_bytes = 8u << 20;
+    config->max_bytes = 256u << 20;
+    config->max_age_s = 7 * 86400;
+    config->rotate_s = 3600;
+    config->sync_ms = 1000;
+    config->codec = TSDB_ENC_GORILLA;
+    config->enabled = 1;
+
+    const char *env = getenv("SENSOR_TSDB");
+    if (env != NULL) {
+        tsdb_config_t parsed = *config;
+        if (tsdb_config_parse(env, &parsed) == -1) {
+            fprintf(stderr, "SENSOR_TSDB inválido: %s (usando padrões)\n",
+                    env);
+        } else {
+            *config = parsed;
+        }
+    }
+}
+
+void tsdb_config_format(const tsdb_config_t *config, char *buf, size_t len)
+{
+    if (!config->enabled) {
+        snprintf(buf, len, "desativado");
+        return;
+    }
+    snprintf(buf, len,
+             "%s, segmentos de %llu KiB, retenção %llu KiB / %u s, "
+             "troca a cada %u s, sync a cada %u ms, %s",
+             config->dir, (unsigned long long) (config->segment_bytes >> 10),
+             (unsigned long long) (config->max_bytes >> 10),
+             config->max_age_s, config->rotate_s, config->sync_ms,
+             config->codec == TSDB_ENC_GORILLA ? "gorilla" : "sem compressão");
+}
+
+// ---------------------------------------------------------------------------
+// Diretório
+
+static int segment_filter(const struct dirent *entry)
+{
+    size_t len = strlen(entry->d_name);
+    return strncmp(entry->d_name, "seg-", 4) == 0 && len > 9 &&
+           strcmp(entry->d_name + len - 5, ".tsdb") == 0;
+}
+
+int tsdb_list_segments(const char *dir, char ***paths)
+{
+    struct dirent **entries;
+    // Números com zeros à esquerda: ordem alfabética = ordem de criação
+    int n = scandir(dir, &entries, segment_filter, alphasort);
+    if (n < 0) {
+        return -1;
+    }
+
+    *paths = calloc((size_t) n + 1, sizeof(char *));
+    for (int i = 0; i < n; i++) {
+        if (*paths != NULL) {
+            size_t len = strlen(dir) + strlen(entries[i]->d_name) + 2;
+            (*paths)[i] = malloc(len);
+            if ((*paths)[i] != NULL) {
+                snprintf((*paths)[i], len, "%s/%s", dir, entries[i]->d_name);
+            }
+        }
+        free(entries[i]);
+    }
+    free(entries);
+    if (*paths == NULL) {
+        return -1;
+    }
+    return n;
+}
+
+void tsdb_list_free(char **paths, int n)
+{
+    for (int i = 0; i < n; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+}
+
+static int mkdir_p(const char *dir)
+{
+    char path[TSDB_PATH_LEN];
+    snprintf(path, sizeof(path), "%s", dir);
+    for (char *p = path + 1; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path, 0755) == -1 && errno != EEXIST) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+    return mkdir(path, 0755) == -1 && errno != EEXIST ? -1 : 0;
+}
+
+// Trava o diretório para este escritor. O flock é solto pelo kernel se o
+// processo morrer; um escritor vivo (a instância anterior terminando de
+// fechar o histórico) o segura, e recover_segments não pode selar o
+// segmento que ele ainda grava. Retorna o fd da trava ou -1.
+static int dir_lock(const char *dir)
+{
+    char path[TSDB_PATH_LEN + 8];
+    snprintf(path, sizeof(path), "%s/" TSDB_LOCK_FILE, dir);
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        perror("Erro ao abrir trava do histórico");
+        return -1;
+    }
+
+    uint64_t deadline =
+        monotonic_ns() + (uint64_t) TSDB_LOCK_TIMEOUT_MS * 1000000ull;
+    while (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+        if (errno != EWOULDBLOCK || monotonic_ns() >= deadline) {
+            log_event(LOG_ERROR, COLOR_RED, "TSDB",
+                      "Histórico em %s em uso por outro processo", dir);
+            close(fd);
+            return -1;
+        }
+        msleep(10);
+    }
+    return fd;
+}
+
+// Sela segmentos deixados abertos por uma execução interrompida, mantendo
+// só os blocos que chegaram a ser sincronizados. Retorna o maior número de
+// segmento encontrado.
+static uint64_t recover_segments(const char *dir)
+{
+    char **paths;
+    int n = tsdb_list_segments(dir, &paths);
+    if (n < 0) {
+        return 0;
+    }
+
+    uint64_t max_seq = 0;
+    for (int i = 0; i < n; i++) {
+        int fd = open(paths[i], O_RDWR | O_CLOEXEC);
+        if (fd == -1) {
+            continue;
+        }
+        tsdb_header_t *h = mmap(NULL, TSDB_HEADER_SIZE,
+                                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (h == MAP_FAILED) {
+            continue;
+        }
+        if (memcmp(h->magic, TSDB_MAGIC, sizeof(h->magic)) == 0) {
+            if (h->seq > max_seq) {
+                max_seq = h->seq;
+            }
+            if (!atomic_load(&h->sealed)) {
+                uint32_t visible = atomic_load(&h->nchunks);
+                uint32_t synced = atomic_load(&h->synced_chunks);
+                atomic_store(&h->nchunks, synced);
+                atomic_store(&h->sealed, 1);
+                msync(h, TSDB_HEADER_SIZE, MS_SYNC);
+                log_event(LOG_WARN, COLOR_YELLOW, "TSDB",
+                          "Segmento interrompido %s selado com %u blocos "
+                          "(%u não sincronizados descartados)",
+                          paths[i], synced, visible - synced);
+            }
+        }
+        munmap(h, TSDB_HEADER_SIZE);
+    }
+    tsdb_list_free(paths, n);
+    return max_seq;
+}
+
+// Apaga os segmentos mais antigos (nunca o atual) acima dos limites
+static void apply_retention(tsdb_writer_t *w)
+{
+    if (w->config.max_bytes == 0 && w->config.max_age_s == 0) {
+        return;
+    }
+
+    char **paths;
+    int n = tsdb_list_segments(w->config.dir, &paths);
+    if (n < 0) {
+        return;
+    }
+
+    uint64_t total = 0;
+    struct stat st[n > 0 ? n : 1];
+    for (int i = 0; i < n; i++) {
+        if (stat(paths[i], &st[i]) == -1) {
+            memset(&st[i], 0, sizeof(st[i]));
+        }
+        total += (uint64_t) st[i].st_size;
+    }
+
+    time_t now = time(NULL);
+    for (int i = 0; i < n; i++) {
+        if (strcmp(paths[i], w->path) == 0) {
+            break; // Atual (e os posteriores, se houver) ficam
+        }
+        int over_size = w->config.max_bytes != 0 && total > w->config.max_bytes;
+        int too_old = w->config.max_age_s != 0 &&
+                      now - st[i].st_mtime > (time_t) w->config.max_age_s;
+        if (!over_size && !too_old) {
+            break;
+        }
+        if (unlink(paths[i]) == 0) {
+            total -= (uint64_t) st[i].st_size;
+            w->stats.removed++;
+            log_event(LOG_INFO, COLOR_YELLOW, "TSDB",
+                      "Retenção: %s removido (%s)", paths[i],
+                      over_size ? "limite de tamanho" : "limite de idade");
+        }
+    }
+    tsdb_list_free(paths, n);
+}
+
+// ---------------------------------------------------------------------------
+// Escrita
+
+static int segment_create(tsdb_writer_t *w)
+{
+    w->seq++;
+    snprintf(w->path, sizeof(w->path), "%s/seg-%016llu.tsdb", w->config.dir,
+             (unsigned long long) w->seq);
+
+    int fd = open(w->path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        perror("Erro ao criar segmento");
+        return -1;
+    }
+    // Reservar os blocos agora: sem espaço, falha aqui e não com SIGBUS
+    // ao escrever no mapeamento
+    int rc = posix_fallocate(fd, 0, (off_t) w->config.segment_bytes);
+    if (rc == EOPNOTSUPP || rc == EINVAL) {
+        rc = ftruncate(fd, (off_t) w->config.segment_bytes) == -1 ? errno : 0;
+    }
+    if (rc != 0) {
+        errno = rc;
+        perror("Erro ao reservar segmento");
+        close(fd);
+        unlink(w->path);
+        return -1;
+    }
+
+    char *map = mmap(NULL, w->config.segment_bytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("Erro ao mapear segmento");
+        close(fd);
+        unlink(w->path);
+        return -1;
+    }
+
+    tsdb_header_t *h = (tsdb_header_t *) map;
+    memcpy(h->magic, TSDB_MAGIC, sizeof(h->magic));
+    h->version = TSDB_VERSION;
+    h->header_size = TSDB_HEADER_SIZE;
+    h->file_size = w->config.segment_bytes;
+    h->seq = w->seq;
+    h->created_ns = realtime_ns();
+    atomic_store(&h->data_end, TSDB_HEADER_SIZE);
+    atomic_store(&h->t_min, INT64_MAX);
+    atomic_store(&h->t_max, INT64_MIN);
+
+    w->fd = fd;
+    w->map = map;
+    w->header = h;
+    w->opened_ns = monotonic_ns();
+    w->stats.segments++;
+    return 0;
+}
+
+// Persiste o que foi anexado e marca como durável
+static void segment_sync(tsdb_writer_t *w)
+{
+    tsdb_header_t *h = w->header;
+    uint32_t chunks = atomic_load_explicit(&h->nchunks, memory_order_relaxed);
+    if (chunks == atomic_load_explicit(&h->synced_chunks,
+                                       memory_order_relaxed)) {
+        return;
+    }
+
+    uint64_t start = monotonic_ns();
+    if (fdatasync(w->fd) == -1) {
+        perror("Erro em fdatasync do segmento");
+        return;
+    }
+    // Só depois dos dados: o cabeçalho vai para o disco no próximo ciclo
+    atomic_store_explicit(&h->synced_chunks, chunks, memory_order_relaxed);
+
+    uint64_t elapsed = monotonic_ns() - start;
+    w->stats.syncs++;
+    w->stats.sync_ns_total += elapsed;
+    if (elapsed > w->stats.sync_ns_max) {
+        w->stats.sync_ns_max = elapsed;
+    }
+}
+
+static void segment_seal(tsdb_writer_t *w)
+{
+    if (w->map == NULL) {
+        return;
+    }
+    segment_sync(w);
+    atomic_store(&w->header->sealed, 1);
+    msync(w->map, TSDB_HEADER_SIZE, MS_SYNC);
+    munmap(w->map, w->config.segment_bytes);
+    close(w->fd);
+    w->map = NULL;
+    w->header = NULL;
+    w->fd = -1;
+}
+
+static int segment_rotate(tsdb_writer_t *w)
+{
+    segment_seal(w);
+    if (segment_create(w) == -1) {
+        return -1;
+    }
+    apply_retention(w);
+    return 0;
+}
+
+static size_t align8(size_t bytes)
+{
+    return (bytes + 7) & ~(size_t) 7;
+}
+
+static void drop_chunk(tsdb_writer_t *w, tsdb_pending_t *p)
+{
+    w->stats.dropped_samples += p->count;
+    w->stats.dropped_chunks++;
+    p->count = 0;
+}
+
+// Grava o bloco pendente do sensor no segmento (trocando-o se cheio)
+static void write_chunk(tsdb_writer_t *w, uint32_t sensor_id)
+{
+    tsdb_pending_t *p = w->pending[sensor_id];
+    if (p->count == 0) {
+        return;
+    }
+    if (w->map == NULL) {
+        drop_chunk(w, p); // Criação do segmento falhou: sem onde gravar
+        return;
+    }
+
+    size_t raw = (size_t) p->count * (sizeof(int64_t) + sizeof(float));
+    size_t encoded = 0;
+    if (w->config.codec == TSDB_ENC_GORILLA) {
+        encoded = gorilla_encode_series(p->ts, p->values, p->count,
+                                        w->scratch, sizeof(w->scratch));
+    }
+    int packed = encoded > 0 && encoded < raw;
+    size_t bytes = align8(packed ? encoded : raw);
+    tsdb_header_t *h = w->header;
+    uint64_t end = atomic_load_explicit(&h->data_end, memory_order_relaxed);
+    uint32_t k = atomic_load_explicit(&h->nchunks, memory_order_relaxed);
+    if (end + bytes + (uint64_t) (k + 1) * sizeof(tsdb_index_t) >
+        w->config.segment_bytes) {
+        if (segment_rotate(w) == -1) {
+            drop_chunk(w, p);
+            return;
+        }
+        h = w->header;
+        end = TSDB_HEADER_SIZE;
+        k = 0;
+    }
+
+    tsdb_index_t entry = {.offset = end,
+                          .bytes = (uint32_t) bytes,
+                          .sensor_id = (int32_t) sensor_id,
+                          .count = (uint16_t) p->count,
+                          .type = p->type,
+                          .encoding = packed ? TSDB_ENC_GORILLA
+                                             : TSDB_ENC_RAW,
+                          .t_min = p->ts[0],
+                          .t_max = p->ts[0],
+                          .v_min = p->values[0],
+                          .v_max = p->values[0]};
+    for (uint32_t i = 1; i < p->count; i++) {
+        if (p->ts[i] < entry.t_min) {
+            entry.t_min = p->ts[i];
+        }
+        if (p->ts[i] > entry.t_max) {
+            entry.t_max = p->ts[i];
+        }
+        if (p->values[i] < entry.v_min) {
+            entry.v_min = p->values[i];
+        }
+        if (p->values[i] > entry.v_max) {
+            entry.v_max = p->values[i];
+        }
+    }
+
+    if (packed) {
+        memcpy(w->map + end, w->scratch, encoded);
+    } else {
+        memcpy(w->map + end, p->ts, p->count * sizeof(int64_t));
+        memcpy(w->map + end + p->count * sizeof(int64_t), p->values,
+               p->count * sizeof(float));
+    }
+    memcpy(w->map + w->config.segment_bytes -
+               (size_t) (k + 1) * sizeof(tsdb_index_t),
+           &entry, sizeof(entry));
+
+    atomic_store_explicit(&h->data_end, end + bytes, memory_order_relaxed);
+    atomic_store_explicit(&h->nsamples,
+                          atomic_load_explicit(&h->nsamples,
+                                               memory_order_relaxed) +
+                              p->count,
+                          memory_order_relaxed);
+    if (entry.t_min < atomic_load_explicit(&h->t_min, memory_order_relaxed)) {
+        atomic_store_explicit(&h->t_min, entry.t_min, memory_order_relaxed);
+    }
+    if (entry.t_max > atomic_load_explicit(&h->t_max, memory_order_relaxed)) {
+        atomic_store_explicit(&h->t_max, entry.t_max, memory_order_relaxed);
+    }
+    // Publica o bloco e a entrada do índice para leitores concorrentes
+    atomic_store_explicit(&h->nchunks, k + 1, memory_order_release);
+
+    w->stats.samples += p->count;
+    w->stats.chunks++;
+    p->count = 0;
+}
+
+tsdb_writer_t *tsdb_writer_open(const tsdb_config_t *config,
+                                uint32_t max_sensors)
+{
+    if (mkdir_p(config->dir) == -1) {
+        perror("Erro ao criar diretório do histórico");
+        return NULL;
+    }
+
+    tsdb_writer_t *w = calloc(1, sizeof(*w));
+    if (w == NULL) {
+        perror("Erro ao alocar escritor do histórico");
+        return NULL;
+    }
+    w->config = *config;
+    w->max_sensors = max_sensors;
+    w->fd = -1;
+    w->pending = calloc(max_sensors, sizeof(*w->pending));
+    w->dirty = calloc(max_sensors, sizeof(*w->dirty));
+    if (w->pending == NULL || w->dirty == NULL) {
+        perror("Erro ao alocar escritor do histórico");
+        free(w->pending);
+        free(w->dirty);
+        free(w);
+        return NULL;
+    }
+    w->lock_fd = dir_lock(config->dir);
+    if (w->lock_fd == -1) {
+        free(w->pending);
+        free(w->dirty);
+        free(w);
+        return NULL;
+    }
+
+    struct timespec mono;
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    w->clock_offset = realtime_ns() - ((int64_t) mono.tv_sec * 1000000000LL +
+                                       mono.tv_nsec);
+
+    w->seq = recover_segments(config->dir);
+    if (segment_create(w) == -1) {
+        close(w->lock_fd);
+        free(w->pending);
+        free(w->dirty);
+        free(w);
+        return NULL;
+    }
+    apply_retention(w);
+    w->last_sync_ns = monotonic_ns();
+    return w;
+}
+
+void tsdb_writer_append(tsdb_writer_t *w, const sensor_data_t *items,
+                        uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        const sensor_data_t *d = &items[i];
+        if (d->sensor_id < 0 || (uint32_t) d->sensor_id >= w->max_sensors) {
+            continue;
+        }
+        uint32_t id = (uint32_t) d->sensor_id;
+        tsdb_pending_t *p = w->pending[id];
+        if (p == NULL) {
+            p = calloc(1, sizeof(*p));
+            if (p == NULL) {
+                continue;
+            }
+            w->pending[id] = p;
+        }
+        if (!p->listed) {
+            p->listed = 1;
+            w->dirty[w->ndirty++] = id;
+        }
+
+        // Sem carimbo monotônico (FIFO antigo): resolução de segundos
+        p->ts[p->count] = d->t_created != 0
+                              ? (int64_t) d->t_created + w->clock_offset
+                              : (int64_t) d->timestamp * 1000000000LL;
+        p->values[p->count] = d->value;
+        p->type = (uint8_t) d->type;
+        if (++p->count == TSDB_CHUNK_MAX) {
+            // Continua na lista de pendentes (ignorado lá se vazio)
+            write_chunk(w, id);
+        }
+    }
+}
+
+int tsdb_writer_tick(tsdb_writer_t *w, uint64_t now_ns, int force)
+{
+    if (!force && now_ns - w->last_sync_ns < (uint64_t) w->config.sync_ms *
+                                                 1000000ull) {
+        return 0;
+    }
+    w->last_sync_ns = now_ns;
+
+    // Segmento anterior não pôde ser criado (sem espaço, nome ocupado):
+    // tenta de novo a cada ciclo, com o número seguinte
+    if (w->map == NULL && segment_create(w) == 0) {
+        apply_retention(w);
+    }
+
+    for (uint32_t i = 0; i < w->ndirty; i++) {
+        write_chunk(w, w->dirty[i]);
+        w->pending[w->dirty[i]]->listed = 0;
+    }
+    w->ndirty = 0;
+    if (w->map == NULL) {
+        return 0;
+    }
+    segment_sync(w);
+
+    if (w->config.rotate_s != 0 &&
+        now_ns - w->opened_ns >=
+            (uint64_t) w->config.rotate_s * 1000000000ull &&
+        atomic_load(&w->header->nchunks) > 0) {
+        segment_rotate(w);
+    }
+    return 1;
+}
+
+void tsdb_writer_stats(const tsdb_writer_t *w, tsdb_stats_t *out)
+{
+    *out = w->stats;
+}
+
+void tsdb_writer_close(tsdb_writer_t *w)
+{
+    if (w == NULL) {
+        return;
+    }
+    tsdb_writer_tick(w, monotonic_ns(), 1);
+    segment_seal(w);
+    close(w->lock_fd); // Solta a trava: o segmento já está selado
+    for (uint32_t i = 0; i < w->max_sensors; i++) {
+        free(w->pending[i]);
+    }
+    free(w->pending);
+    free(w->dirty);
+    free(w);
+}
+
+// ---------------------------------------------------------------------------
+// Leitura
+
+int tsdb_segment_open(tsdb_segment_t *seg, const char *path)
+{
+    memset(seg, 0, sizeof(*seg));
+    seg->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (seg->fd == -1) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(seg->fd, &st) == -1 || (size_t) st.st_size < TSDB_HEADER_SIZE) {
+        close(seg->fd);
+        errno = EINVAL;
+        return -1;
+    }
+    seg->size = (size_t) st.st_size;
+    void *map = mmap(NULL, seg->size, PROT_READ, MAP_SHARED, seg->fd, 0);
+    if (map == MAP_FAILED) {
+        close(seg->fd);
+        return -1;
+    }
+    seg->map = map;
+    seg->header = map;
+    if (memcmp(seg->header->magic, TSDB_MAGIC, sizeof(seg->header->magic)) !=
+            0 ||
+        seg->header->version != TSDB_VERSION ||
+        seg->header->file_size != seg->size) {
+        tsdb_segment_close(seg);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int tsdb_chunk_read(const tsdb_segment_t *seg, const tsdb_index_t *entry,
+                    int64_t *timestamps, float *values)
+{
+    if (entry->count > TSDB_CHUNK_MAX || entry->offset < TSDB_HEADER_SIZE ||
+        entry->offset + entry->bytes > seg->size) {
+        return -1;
+    }
+    const uint8_t *data = (const uint8_t *) seg->map + entry->offset;
+
+    switch (entry->encoding) {
+    case TSDB_ENC_RAW:
+        if ((size_t) entry->count * (sizeof(int64_t) + sizeof(float)) >
+            entry->bytes) {
+            return -1;
+        }
+        memcpy(timestamps, data, entry->count * sizeof(int64_t));
+        memcpy(values, data + entry->count * sizeof(int64_t),
+               entry->count * sizeof(float));
+        return entry->count;
+    case TSDB_ENC_GORILLA:
+        return gorilla_decode_series(data, entry->bytes, entry->count,
+                                     timestamps, values) == 0
+                   ? entry->count
+                   : -1;
+    default:
+        return -1;
+    }
+}
+
+void tsdb_segment_close(tsdb_segment_t *seg)
+{
+    if (seg->map != NULL) {
+        munmap((void *) seg->map, seg->size);
+    }
+    if (seg->fd >= 0) {
+        close(seg->fd);
+    }
+    memset(seg, 0, sizeof(*seg));
+    seg->fd = -1;
+}
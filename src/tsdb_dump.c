@@ -0,0 +1,199 @@
+#include "common.h"
+#include "tsdb.h"
+
+// Ferramenta de leitura do histórico: lista os segmentos ou imprime as
+// amostras (CSV) filtradas por sensor e intervalo de tempo. Os segmentos são
+// mapeados somente leitura; o índice é percorrido e só os blocos que passam
+// no filtro são lidos, então arquivos grandes não são carregados inteiros.
+// Funciona com o data_processor em execução (lê os blocos já publicados).
+
+typedef struct {
+    int sensor_id; // 0 = todos
+    int64_t from_ns;
+    int64_t to_ns;
+} dump_filter_t;
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s [-d dir] [-l] [-s sensor_id] [-f desde] [-t até] "
+            "[segmento...]\n",
+            prog);
+    fprintf(stderr, "\n  -d  diretório do histórico (padrão: %s)\n",
+            TSDB_DEFAULT_DIR);
+    fprintf(stderr, "  -l  lista os segmentos em vez das amostras\n");
+    fprintf(stderr, "  -s  só as amostras do sensor\n");
+    fprintf(stderr, "  -f  -t  intervalo em segundos Unix, ou relativo a "
+                    "agora com '-' (ex.: -f -60)\n");
+    fprintf(stderr, "\n  Saída: timestamp_ns,sensor_id,tipo,valor (em ordem "
+                    "de bloco)\n");
+}
+
+// Segundos Unix ou, com sinal negativo, segundos antes de agora
+static int parse_time(const char *text, int64_t *out)
+{
+    char *end;
+    double seconds = strtod(text, &end);
+    if (end == text || *end != '\0') {
+        return -1;
+    }
+    if (seconds < 0) {
+        seconds += (double) time(NULL);
+    }
+    *out = (int64_t) (seconds * 1e9);
+    return 0;
+}
+
+static void format_time(int64_t ns, char *buf, size_t len)
+{
+    if (ns == INT64_MAX || ns == INT64_MIN) {
+        snprintf(buf, len, "-");
+        return;
+    }
+    time_t seconds = (time_t) (ns / 1000000000LL);
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+    size_t n = strftime(buf, len, "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf(buf + n, len - n, ".%03lld",
+             (long long) (ns % 1000000000LL / 1000000));
+}
+
+static void list_segment(const char *path, const tsdb_segment_t *seg)
+{
+    const tsdb_header_t *h = seg->header;
+    char from[40];
+    char to[40];
+    format_time(atomic_load(&((tsdb_header_t *) h)->t_min), from,
+                sizeof(from));
+    format_time(atomic_load(&((tsdb_header_t *) h)->t_max), to, sizeof(to));
+    uint32_t chunks = tsdb_segment_chunks(seg);
+    uint64_t data = atomic_load(&((tsdb_header_t *) h)->data_end) -
+                    TSDB_HEADER_SIZE;
+    uint64_t index = (uint64_t) chunks * sizeof(tsdb_index_t);
+    uint64_t samples = atomic_load(&((tsdb_header_t *) h)->nsamples);
+
+    // Bytes por amostra: dados dos blocos e, à parte, o custo do índice
+    printf("%-40s %6llu %-8s %8u %10llu %7.1f%% %6.2f %6.2f  %s → %s\n",
+           path, (unsigned long long) h->seq,
+           atomic_load(&((tsdb_header_t *) h)->sealed) ? "selado" : "aberto",
+           chunks, (unsigned long long) samples,
+           100.0 * (double) (TSDB_HEADER_SIZE + data + index) /
+               (double) h->file_size,
+           samples > 0 ? (double) data / (double) samples : 0.0,
+           samples > 0 ? (double) index / (double) samples : 0.0, from, to);
+}
+
+static uint64_t dump_segment(const tsdb_segment_t *seg,
+                             const dump_filter_t *filter)
+{
+    uint64_t printed = 0;
+    uint32_t chunks = tsdb_segment_chunks(seg);
+    for (uint32_t k = 0; k < chunks; k++) {
+        const tsdb_index_t *entry = tsdb_segment_index(seg, k);
+        if ((filter->sensor_id != 0 && entry->sensor_id != filter->sensor_id) ||
+            entry->t_max < filter->from_ns || entry->t_min > filter->to_ns) {
+            continue;
+        }
+
+        int64_t ts[TSDB_CHUNK_MAX];
+        float values[TSDB_CHUNK_MAX];
+        int count = tsdb_chunk_read(seg, entry, ts, values);
+        if (count < 0) {
+            fprintf(stderr, "Bloco %u corrompido (sensor %d), ignorado\n", k,
+                    entry->sensor_id);
+            continue;
+        }
+        const char *type = sensor_type_name((sensor_type_t) entry->type);
+        for (int i = 0; i < count; i++) {
+            if (ts[i] < filter->from_ns || ts[i] > filter->to_ns) {
+                continue;
+            }
+            printf("%lld,%d,%s,%.3f\n", (long long) ts[i], entry->sensor_id,
+                   type, (double) values[i]);
+            printed++;
+        }
+    }
+    return printed;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *dir = TSDB_DEFAULT_DIR;
+    int list = 0;
+    dump_filter_t filter = {.sensor_id = 0,
+                            .from_ns = INT64_MIN,
+                            .to_ns = INT64_MAX};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:ls:f:t:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            dir = optarg;
+            break;
+        case 'l':
+            list = 1;
+            break;
+        case 's':
+            filter.sensor_id = atoi(optarg);
+            break;
+        case 'f':
+            if (parse_time(optarg, &filter.from_ns) == -1) {
+                usage(argv[0]);
+                exit(1);
+            }
+            break;
+        case 't':
+            if (parse_time(optarg, &filter.to_ns) == -1) {
+                usage(argv[0]);
+                exit(1);
+            }
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+
+    char **paths = argv + optind;
+    int n = argc - optind;
+    char **listed = NULL;
+    if (n == 0) {
+        n = tsdb_list_segments(dir, &listed);
+        if (n < 0) {
+            perror(dir);
+            exit(1);
+        }
+        paths = listed;
+    }
+
+    if (list) {
+        printf("%-40s %6s %-8s %8s %10s %8s %6s %6s  %s\n", "segmento",
+               "seq", "estado", "blocos", "amostras", "uso", "B/am", "B/ind",
+               "intervalo");
+    }
+    uint64_t total = 0;
+    int rc = 0;
+    for (int i = 0; i < n; i++) {
+        tsdb_segment_t seg;
+        if (tsdb_segment_open(&seg, paths[i]) == -1) {
+            perror(paths[i]);
+            rc = 1;
+            continue;
+        }
+        if (list) {
+            list_segment(paths[i], &seg);
+        } else {
+            total += dump_segment(&seg, &filter);
+        }
+        tsdb_segment_close(&seg);
+    }
+    if (!list) {
+        fprintf(stderr, "%llu amostras em %d segmentos\n",
+                (unsigned long long) total, n);
+    }
+
+    if (listed != NULL) {
+        tsdb_list_free(listed, n);
+    }
+    return rc;
+}